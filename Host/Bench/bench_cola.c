@@ -0,0 +1,193 @@
+/**
+  ******************************************************************************
+  * @file       bench_cola.c
+  * @author     MA Dingjie
+  * @version    V1.0.0
+  * @date       17-October-2016
+  * @brief      Records per second through the cola of cola.c.
+  *
+  *             A single thread stores as many records as fit then reads them
+  *             all, for each length; the text records of cola_guardar end
+  *             with '\n', the others are stored by cola_guardar_datos. Then
+  *             producers on threads of the host store records of \c lg
+  *             octets, storing again those dropped, while one consumer reads
+  *             them. The options, as \c name=value:
+  *              + \c records: records of each run
+  *              + \c producers: threads storing records in the last run
+  *              + \c lg: length of the records in the last run
+  *
+  *             The output is JSON, one object per run.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include "KNX_Host.h"
+#include "cola.h"
+
+/* Private constants ---------------------------------------------------------*/
+/** \brief Most producers. */
+#define BENCH_PRODUCERS         ((uint32_t)16)
+/** \brief Lengths of the records of the single thread runs. */
+static const uint16_t BENCH_LENGTHS[] = {8, 28, 64, 200, 1000};
+
+/* Private variables ---------------------------------------------------------*/
+static t_cola            cola;
+static uint8_t           record[COLA_RECORD_MAX], copy[COLA_RECORD_MAX];
+static uint32_t          threadRecords;
+static uint16_t          threadLength;
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief      Print the result of a run.
+  * @param      mode: name of the run.
+  * @param      lg: length of the records.
+  * @param      producers: threads storing.
+  * @param      records: records read.
+  * @param      us: time of the run.
+  */
+static void Bench_Print(const char *mode, uint32_t lg, uint32_t producers, uint32_t records, uint32_t us)
+{
+  printf("{\"bench\":\"cola\",\"mode\":\"%s\",\"lg\":%lu,\"producers\":%lu,"
+         "\"records\":%lu,\"us\":%lu,\"ns_per_record\":%.1f,\"records_per_s\":%.0f,"
+         "\"drops\":%lu}\n",
+         mode, (unsigned long)lg, (unsigned long)producers, (unsigned long)records,
+         (unsigned long)us, (records != 0U) ? (double)us * 1000.0 / records : 0.0,
+         (us != 0U) ? (double)records * 1000000.0 / us : 0.0,
+         (unsigned long)cola_perdidos(&cola));
+}
+
+/**
+  * @brief      Store and read records by batches from a single thread.
+  * @param      lg: length of the records, '\n' included for text.
+  * @param      records: records to store and read.
+  * @param      text: TRUE to use cola_guardar, FALSE cola_guardar_datos.
+  */
+static void Bench_Single(uint16_t lg, uint32_t records, uint8_t text)
+{
+  uint32_t batch = COLA_SIZE / (COLA_HEADER_SIZE + lg);
+  uint32_t done = 0, start, i;
+
+  memset(record, 'a', lg);
+  record[lg - 1U] = '\n';
+  cola_init(&cola);
+
+  start = KNX_Host_GetRunTime();
+  while(done < records)
+  {
+    for(i=0; i<batch; i++)
+    {
+      if(text == TRUE)
+      {
+        cola_guardar(&cola, record);
+      }
+      else
+      {
+        cola_guardar_datos(&cola, record, lg);
+      }
+    }
+    while(cola_leer(&cola, copy, sizeof(copy)) > 0)
+    {
+      done++;
+    }
+  }
+  Bench_Print((text == TRUE) ? "text" : "binary", lg, 1, done, KNX_Host_GetRunTime() - start);
+}
+
+/**
+  * @brief      Thread of a producer, stores again a record dropped.
+  * @param      argument: not used.
+  * @retval     NULL.
+  */
+static void *Bench_Produce(void *argument)
+{
+  uint8_t data[COLA_RECORD_MAX];
+  uint32_t i;
+
+  (void)argument;
+  memset(data, 'b', threadLength);
+  for(i=0; i<threadRecords; i++)
+  {
+    while(cola_guardar_datos(&cola, data, threadLength) == 0)
+    {
+      sched_yield();
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  * @brief      Producers on threads and one consumer.
+  * @param      producers: number of threads storing.
+  * @param      lg: length of the records.
+  * @param      records: records stored by all the threads.
+  */
+static void Bench_Threads(uint32_t producers, uint16_t lg, uint32_t records)
+{
+  pthread_t threads[BENCH_PRODUCERS];
+  uint32_t total, done = 0, start, i;
+
+  threadRecords = records / producers;
+  threadLength = lg;
+  total = threadRecords * producers;
+  cola_init(&cola);
+
+  start = KNX_Host_GetRunTime();
+  for(i=0; i<producers; i++)
+  {
+    pthread_create(&threads[i], NULL, Bench_Produce, NULL);
+  }
+  while(done < total)
+  {
+    if(cola_leer(&cola, copy, sizeof(copy)) > 0)
+    {
+      done++;
+    }
+    else
+    {
+      sched_yield();
+    }
+  }
+  for(i=0; i<producers; i++)
+  {
+    pthread_join(threads[i], NULL);
+  }
+  Bench_Print("threads", lg, producers, done, KNX_Host_GetRunTime() - start);
+}
+
+/**
+  * @brief      Entry point.
+  * @param      argc: number of arguments.
+  * @param      argv: options, as \c name=value.
+  * @retval     0 on success.
+  */
+int main(int argc, char **argv)
+{
+  uint32_t records, producers, lg, i;
+
+  KNX_Host_Init(argc, argv);
+  records = KNX_Host_GetOption("records", 2000000);
+  producers = KNX_Host_GetOption("producers", 4);
+  lg = KNX_Host_GetOption("lg", 28);
+  KNX_HOST_CHECK(records != 0U);
+  KNX_HOST_CHECK((producers >= 1U) && (producers <= BENCH_PRODUCERS));
+  KNX_HOST_CHECK((lg >= 1U) && (lg <= COLA_RECORD_MAX));
+  if(KNX_Host_GetFailures() != 0U)
+  {
+    KNX_Host_Exit();
+  }
+
+  for(i=0; i<sizeof(BENCH_LENGTHS) / sizeof(BENCH_LENGTHS[0]); i++)
+  {
+    Bench_Single(BENCH_LENGTHS[i], records, TRUE);
+    Bench_Single(BENCH_LENGTHS[i], records, FALSE);
+  }
+  Bench_Threads(producers, (uint16_t)lg, records);
+
+  KNX_Host_Exit();
+  return 0;
+}
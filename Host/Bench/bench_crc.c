@@ -0,0 +1,183 @@
+/**
+  ******************************************************************************
+  * @file       bench_crc.c
+  * @author     MA Dingjie
+  * @version    V1.0.0
+  * @date       17-October-2016
+  * @brief      Cost per frame of the CRC-16-CCITT of the CRC mode next to the
+  *             check octet of the parity path.
+  *
+  *             Frames of each length, from the shortest to ::FRAME_SIZE, are
+  *             drawn once with a valid check octet and their CRC, then
+  *             checked again and again four ways:
+  *              + \c parity: ::KNX_VerticalParity over the frame
+  *              + \c parity_rx: a running XOR octet by octet, as the RX
+  *                interrupt does
+  *              + \c crc: ::KNX_Crc16 over the frame
+  *              + \c crc_rx: ::KNX_Crc16_Update octet by octet, as the RX
+  *                interrupt does in CRC mode
+  *
+  *             The options, as \c name=value:
+  *              + \c frames: frames checked by each run
+  *              + \c seed: seed of the draws
+  *
+  *             The output is JSON, one object per run: the cost in ns of a
+  *             frame and of an octet, and the ratio to the parity run of the
+  *             same kind.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include "KNX_Host.h"
+#include "KNX_Aux.h"
+
+/* Private constants ---------------------------------------------------------*/
+/** \brief Frames drawn for each length, a power of 2. */
+#define BENCH_POOL              ((uint32_t)256U)
+
+/* Private types -------------------------------------------------------------*/
+/**
+  * @brief  A frame drawn and its CRC.
+  */
+typedef struct
+{
+  uint8_t  Datas[FRAME_SIZE];
+  uint16_t Crc;
+} Bench_Frame_t;
+
+/* Private variables ---------------------------------------------------------*/
+static Bench_Frame_t    pool[BENCH_POOL];
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief      Next number of a xorshift generator.
+  * @param      state: state of the generator, not 0.
+  * @retval     The number.
+  */
+static uint32_t Bench_Random(uint32_t *state)
+{
+  uint32_t x = *state;
+
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+
+  return x;
+}
+
+/**
+  * @brief      Draw the frames of a length.
+  * @param      length: octets of the frames, check octet included.
+  * @param      state: state of the generator.
+  */
+static void Bench_Draw(uint16_t length, uint32_t *state)
+{
+  uint32_t i;
+  uint16_t l;
+
+  for(i=0; i<BENCH_POOL; i++)
+  {
+    for(l=0; l<length - 1U; l++)
+    {
+      pool[i].Datas[l] = (uint8_t)Bench_Random(state);
+    }
+    pool[i].Datas[length - 1U] = (uint8_t)~KNX_VerticalParity(pool[i].Datas, (uint16_t)(length - 1U));
+    pool[i].Crc = KNX_Crc16(pool[i].Datas, length);
+  }
+}
+
+/**
+  * @brief      Check the frames of the pool one way.
+  * @param      mode: 0 parity, 1 parity_rx, 2 crc, 3 crc_rx.
+  * @param      length: octets of the frames.
+  * @param      frames: frames to check.
+  * @retval     Frames found faulty, 0 expected.
+  */
+static uint32_t Bench_Check(uint8_t mode, uint16_t length, uint32_t frames)
+{
+  const uint8_t *datas;
+  uint32_t i, bad = 0;
+  uint16_t l, crc;
+  uint8_t parity;
+
+  for(i=0; i<frames; i++)
+  {
+    datas = pool[i & (BENCH_POOL - 1U)].Datas;
+    switch(mode)
+    {
+      case 0:
+        bad += (KNX_VerticalParity((uint8_t *)datas, length) != 0xFFU) ? 1U : 0U;
+        break;
+      case 1:
+        parity = 0;
+        for(l=0; l<length; l++)
+        {
+          parity ^= datas[l];
+        }
+        bad += (parity != 0xFFU) ? 1U : 0U;
+        break;
+      case 2:
+        bad += (KNX_Crc16(datas, length) != pool[i & (BENCH_POOL - 1U)].Crc) ? 1U : 0U;
+        break;
+      default:
+        crc = KNX_CRC16_INIT;
+        for(l=0; l<length; l++)
+        {
+          crc = KNX_Crc16_Update(crc, datas[l]);
+        }
+        bad += (crc != pool[i & (BENCH_POOL - 1U)].Crc) ? 1U : 0U;
+        break;
+    }
+  }
+
+  return bad;
+}
+
+/**
+  * @brief      Entry point.
+  * @param      argc: number of arguments.
+  * @param      argv: options, as \c name=value.
+  * @retval     0 on success.
+  */
+int main(int argc, char **argv)
+{
+  static const char *names[] = {"parity", "parity_rx", "crc", "crc_rx"};
+  uint32_t frames, state, start, bad, us[4];
+  uint16_t length;
+  uint8_t mode;
+
+  KNX_Host_Init(argc, argv);
+  frames = KNX_Host_GetOption("frames", 2000000);
+  state = KNX_Host_GetOption("seed", 1);
+  KNX_HOST_CHECK(frames != 0U);
+  KNX_HOST_CHECK(state != 0U);
+  if(KNX_Host_GetFailures() != 0U)
+  {
+    KNX_Host_Exit();
+  }
+
+  for(length=FRAME_OVERHEAD; length<=FRAME_SIZE; length++)
+  {
+    Bench_Draw(length, &state);
+    for(mode=0; mode<4U; mode++)
+    {
+      start = KNX_Host_GetRunTime();
+      bad = Bench_Check(mode, length, frames);
+      us[mode] = KNX_Host_GetRunTime() - start;
+      KNX_HOST_CHECK(bad == 0U);
+
+      /** The CRC runs are compared to the parity run of the same kind. */
+      printf("{\"bench\":\"crc\",\"mode\":\"%s\",\"length\":%u,\"frames\":%lu,\"us\":%lu,"
+             "\"ns_per_frame\":%.2f,\"ns_per_octet\":%.3f,\"vs_parity\":%.2f,\"bad\":%lu}\n",
+             names[mode], (unsigned)length, (unsigned long)frames, (unsigned long)us[mode],
+             (double)us[mode] * 1000.0 / frames, (double)us[mode] * 1000.0 / frames / length,
+             (us[mode & 1U] != 0U) ? (double)us[mode] / us[mode & 1U] : 0.0,
+             (unsigned long)bad);
+    }
+  }
+
+  KNX_Host_Exit();
+  return 0;
+}
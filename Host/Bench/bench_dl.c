@@ -0,0 +1,298 @@
+/**
+  ******************************************************************************
+  * @file       bench_dl.c
+  * @author     MA Dingjie
+  * @version    V1.0.0
+  * @date       17-October-2016
+  * @brief      Throughput and latency of KNX_DL_Data_req and KNX_DL_Frame_rec
+  *             on a simulated bus.
+  *
+  *             Each device sends frames to the next one or to a group all of
+  *             them belong to, and receives the frames of the others. The
+  *             options, as \c name=value:
+  *              + \c nodes: devices on the bus, 2 to ::KNX_BUS_MAX_NODES
+  *              + \c frames: frames sent by each device
+  *              + \c lg, \c lg_max: length of the LSDU, drawn between both
+  *              + \c system, \c urgent, \c normal, \c low: weights of the
+  *                priorities
+  *              + \c group: percent of the frames sent to the group
+  *              + \c period: ms between two requests of a device, 0 to send
+  *                back to back
+  *              + \c seed: seed of the draws
+  *
+  *             The output is JSON, one object per line: the options, the
+  *             ::KNX_DL_Report of each device, then the counters of the bus.
+  *             The latencies are those of the frames confirmed. The run
+  *             fails if more than ::BENCH_MAX_ERRORS permille of the
+  *             requests were refused or not confirmed, its figures would
+  *             then be those of a line losing frames.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include "KNX_Host.h"
+#include "KNX_Addr.h"
+#include "KNX_Frame.h"
+
+/* Private constants ---------------------------------------------------------*/
+/** \brief Individual address of the first device, the next ones follow. */
+#define BENCH_ADDRESS           ((uint16_t)0x1101U)
+/** \brief Group address all the devices belong to. */
+#define BENCH_GROUP             ((uint16_t)0x0A01U)
+/** \brief Priority of the tasks receiving, above ::KNX_DL_TxTask. */
+#define BENCH_RX_PRIORITY       (tskIDLE_PRIORITY + 3)
+/** \brief Most requests refused or not confirmed, in permille. */
+#define BENCH_MAX_ERRORS        ((uint32_t)10U)
+
+/* Private types -------------------------------------------------------------*/
+/**
+  * @brief  Options of the benchmark.
+  */
+typedef struct
+{
+  uint32_t Nodes;
+  uint32_t Frames;
+  uint32_t LgMin;
+  uint32_t LgMax;
+  uint32_t Weights[4];          /*!< System, normal, urgent, low: the order of
+                                     the priority field                       */
+  uint32_t Group;
+  uint32_t Period;
+  uint32_t Seed;
+} Bench_Options_t;
+
+/* Private variables ---------------------------------------------------------*/
+static Bench_Options_t  options;
+static KNX_Bus_t        bus;
+static KNX_Host_Node_t  nodes[KNX_BUS_MAX_NODES];
+static TaskHandle_t     mainTask;
+static uint32_t         requestErrors;
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief      Next number of a xorshift generator.
+  * @param      state: state of the generator, not 0.
+  * @retval     The number.
+  */
+static uint32_t Bench_Random(uint32_t *state)
+{
+  uint32_t x = *state;
+
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+
+  return x;
+}
+
+/**
+  * @brief      Draw the priority field of a frame from the weights.
+  * @param      state: state of the generator.
+  * @retval     Priority field, 0 to 3.
+  */
+static uint8_t Bench_Priority(uint32_t *state)
+{
+  uint32_t total = 0, draw;
+  uint8_t i;
+
+  for(i=0; i<4U; i++)
+  {
+    total += options.Weights[i];
+  }
+  if(total == 0U)
+  {
+    return 1;
+  }
+
+  draw = Bench_Random(state) % total;
+  for(i=0; i<3U; i++)
+  {
+    if(draw < options.Weights[i])
+    {
+      break;
+    }
+    draw -= options.Weights[i];
+  }
+
+  return i;
+}
+
+/**
+  * @brief      Task sending the frames of a device.
+  * @param      argument: index of the device.
+  */
+static void Bench_SendTask(void *argument)
+{
+  uint32_t index = (uint32_t)(uintptr_t)argument;
+  KNX_Host_Node_t *node = &nodes[index];
+  uint32_t state = options.Seed * 2654435761U + index + 1U;
+  uint8_t lsdu[FRAME_SIZE - FRAME_OVERHEAD];
+  uint8_t lg, group, i;
+  uint16_t da;
+  uint32_t n;
+
+  for(n=0; n<options.Frames; n++)
+  {
+    lg = (uint8_t)(options.LgMin + Bench_Random(&state) % (options.LgMax - options.LgMin + 1U));
+    for(i=0; i<lg; i++)
+    {
+      lsdu[i] = (uint8_t)Bench_Random(&state);
+    }
+    group = (Bench_Random(&state) % 100U < options.Group) ? TRUE : FALSE;
+    da = (group == TRUE) ? BENCH_GROUP : (uint16_t)(BENCH_ADDRESS + (index + 1U) % options.Nodes);
+
+    if(KNX_DL_Data_req(&node->DL, 1, group, da, Bench_Priority(&state), lsdu, lg) != DL_ERROR_NONE)
+    {
+      taskENTER_CRITICAL();
+      requestErrors++;
+      taskEXIT_CRITICAL();
+    }
+    if(options.Period != 0U)
+    {
+      vTaskDelay(pdMS_TO_TICKS(options.Period));
+    }
+  }
+
+  xTaskNotifyGive(mainTask);
+  vTaskDelete(NULL);
+}
+
+/**
+  * @brief      Task receiving the frames of a device.
+  * @param      argument: index of the device.
+  */
+static void Bench_ReceiveTask(void *argument)
+{
+  KNX_Host_Node_t *node = &nodes[(uint32_t)(uintptr_t)argument];
+  KNX_Frame_t *frame;
+
+  for(;;)
+  {
+    if(KNX_DL_Frame_rec(&node->DL, &frame) == DL_ERROR_NONE)
+    {
+      KNX_Frame_Release(frame);
+    }
+  }
+}
+
+/**
+  * @brief      Main task of the benchmark.
+  * @param      argument: not used.
+  */
+static void Bench_Task(void *argument)
+{
+  KNX_Bus_Stats_t stats;
+  DL_TxStats_t tx[DL_TX_PRIORITIES];
+  char report[512];
+  uint32_t i, utilisation, requests, failed = 0;
+  uint8_t rank;
+
+  (void)argument;
+  mainTask = xTaskGetCurrentTaskHandle();
+
+  options.Nodes = KNX_Host_GetOption("nodes", 4);
+  options.Frames = KNX_Host_GetOption("frames", 50);
+  options.LgMin = KNX_Host_GetOption("lg", 2);
+  options.LgMax = KNX_Host_GetOption("lg_max", options.LgMin);
+  options.Weights[0] = KNX_Host_GetOption("system", 0);
+  options.Weights[1] = KNX_Host_GetOption("normal", 80);
+  options.Weights[2] = KNX_Host_GetOption("urgent", 10);
+  options.Weights[3] = KNX_Host_GetOption("low", 10);
+  options.Group = KNX_Host_GetOption("group", 50);
+  options.Period = KNX_Host_GetOption("period", 0);
+  options.Seed = KNX_Host_GetOption("seed", 1);
+  KNX_HOST_CHECK((options.Nodes >= 2U) && (options.Nodes <= KNX_BUS_MAX_NODES));
+  KNX_HOST_CHECK((options.LgMin <= options.LgMax) && (options.LgMax <= FRAME_SIZE - FRAME_OVERHEAD));
+  if(KNX_Host_GetFailures() != 0U)
+  {
+    KNX_Host_Exit();
+  }
+
+  printf("{\"bench\":\"dl\",\"nodes\":%lu,\"frames\":%lu,\"lg\":%lu,\"lg_max\":%lu,"
+         "\"system\":%lu,\"normal\":%lu,\"urgent\":%lu,\"low\":%lu,"
+         "\"group\":%lu,\"period\":%lu,\"seed\":%lu}\n",
+         (unsigned long)options.Nodes, (unsigned long)options.Frames,
+         (unsigned long)options.LgMin, (unsigned long)options.LgMax,
+         (unsigned long)options.Weights[0], (unsigned long)options.Weights[1],
+         (unsigned long)options.Weights[2], (unsigned long)options.Weights[3],
+         (unsigned long)options.Group, (unsigned long)options.Period,
+         (unsigned long)options.Seed);
+
+  KNX_Bus_Init(&bus);
+  for(i=0; i<options.Nodes; i++)
+  {
+    KNX_HOST_CHECK(KNX_Host_InitNode(&bus, &nodes[i], (uint16_t)(BENCH_ADDRESS + i)) == DL_ERROR_NONE);
+    if(KNX_Host_GetFailures() != 0U)
+    {
+      KNX_Host_Exit();
+    }
+    KNX_Addr_AddGroup(&nodes[i].DL.Addr, BENCH_GROUP);
+    KNX_DL_ResetPerf(&nodes[i].DL);
+  }
+  for(i=0; i<options.Nodes; i++)
+  {
+    xTaskCreate(Bench_ReceiveTask, "Bench RX", KNX_HOST_TASK_STACK,
+                (void *)(uintptr_t)i, BENCH_RX_PRIORITY, NULL);
+  }
+  for(i=0; i<options.Nodes; i++)
+  {
+    xTaskCreate(Bench_SendTask, "Bench TX", KNX_HOST_TASK_STACK,
+                (void *)(uintptr_t)i, KNX_HOST_TASK_PRIORITY, NULL);
+  }
+
+  for(i=0; i<options.Nodes; i++)
+  {
+    ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+  }
+  /** Let the last frames reach their receivers. */
+  vTaskDelay(pdMS_TO_TICKS(100));
+
+  for(i=0; i<options.Nodes; i++)
+  {
+    if(KNX_DL_Report(&nodes[i].DL, report, sizeof(report)) != 0U)
+    {
+      fputs(report, stdout);
+    }
+    KNX_DL_GetTxStats(&nodes[i].DL, tx);
+    for(rank=0; rank<DL_TX_PRIORITIES; rank++)
+    {
+      failed += tx[rank].Failed;
+    }
+  }
+
+  KNX_Bus_GetStats(&bus, &stats);
+  utilisation = (stats.Elapsed != 0U) ? (uint32_t)((uint64_t)stats.BusyTime * 1000U / stats.Elapsed) : 0U;
+  printf("{\"bus\":{\"ms\":%lu,\"frames\":%lu,\"collisions\":%lu,\"repeats\":%lu,"
+         "\"acks\":%lu,\"nacks\":%lu,\"busys\":%lu,\"no_acks\":%lu,\"failed\":%lu,"
+         "\"utilisation_permille\":%lu,\"lat_us\":{\"min\":%lu,\"max\":%lu,\"mean\":%lu}},"
+         "\"request_errors\":%lu}\n",
+         (unsigned long)(stats.Elapsed / 1000U), (unsigned long)stats.Frames,
+         (unsigned long)stats.Collisions, (unsigned long)stats.Repeats,
+         (unsigned long)stats.Acks, (unsigned long)stats.Nacks,
+         (unsigned long)stats.Busys, (unsigned long)stats.NoAcks,
+         (unsigned long)stats.Failed, (unsigned long)utilisation,
+         (unsigned long)stats.LatencyMin, (unsigned long)stats.LatencyMax,
+         (unsigned long)((stats.LatencyCount != 0U) ? stats.LatencySum / stats.LatencyCount : 0U),
+         (unsigned long)requestErrors);
+
+  requests = options.Nodes * options.Frames;
+  KNX_HOST_CHECK((uint64_t)requestErrors * 1000U <= (uint64_t)requests * BENCH_MAX_ERRORS);
+  KNX_HOST_CHECK((uint64_t)failed * 1000U <= (uint64_t)requests * BENCH_MAX_ERRORS);
+  KNX_HOST_CHECK(stats.LatencyCount != 0U);
+
+  KNX_Host_Exit();
+}
+
+/**
+  * @brief      Entry point.
+  * @param      argc: number of arguments.
+  * @param      argv: options, as \c name=value.
+  * @retval     0 on success.
+  */
+int main(int argc, char **argv)
+{
+  KNX_Host_Run(Bench_Task, argc, argv);
+  return 0;
+}
@@ -0,0 +1,331 @@
+/**
+  ******************************************************************************
+  * @file       bench_frame.c
+  * @author     MA Dingjie
+  * @version    V1.0.0
+  * @date       17-October-2016
+  * @brief      Cycles per frame of the validation of the frames received:
+  *             byte by byte in the RX interrupt against the passes over the
+  *             whole frame once it is assembled.
+  *
+  *             Each octet is handed to a function of its own, called through
+  *             a pointer as the interrupt would be, which stores it and
+  *             works out the length of the frame from its length octet:
+  *              + \c passes: the octets are only stored; the frame is then
+  *                checked as KNX_DL_CheckFrame did before the validation
+  *                moved to the RX interrupt: the CTRL octet, a pass of
+  *                ::KNX_VerticalParity over the frame, the length against
+  *                octet 5
+  *              + \c incremental: as KNX_Ph_AssembleByte, a running XOR and
+  *                the length octet checked as the octets land, the
+  *                ::KNX_Frame_t::Verdict is known with the last one and only
+  *                tested afterwards
+  *
+  *             Both runs see the same frames, of each length from the
+  *             shortest to ::FRAME_SIZE, then of lengths drawn, with a share
+  *             of them corrupted. The options, as \c name=value:
+  *              + \c frames: frames checked by each run
+  *              + \c bad: frames corrupted in permille in the last runs
+  *              + \c seed: seed of the draws
+  *
+  *             The output is JSON, one object per run: the cycles of
+  *             ::KNX_GetCycles per frame, on the host a cycle is a ns, and
+  *             the frames found faulty, which must be the frames corrupted.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include "KNX_Host.h"
+#include "KNX_Aux.h"
+#include "KNX_Frame.h"
+
+/* Private constants ---------------------------------------------------------*/
+/** \brief Frames drawn for a run, a power of 2. */
+#define BENCH_POOL              ((uint32_t)256U)
+
+/* Private types -------------------------------------------------------------*/
+/**
+  * @brief  State of the assembly of a frame, as ::PH_Assembler_t.
+  */
+typedef struct
+{
+  uint8_t  Datas[FRAME_SIZE];
+  uint16_t Length;
+  uint16_t Expected;
+  uint8_t  Parity;
+  uint8_t  Verdict;
+} Bench_Assembler_t;
+
+/**
+  * @brief  A frame drawn.
+  */
+typedef struct
+{
+  uint8_t  Datas[FRAME_SIZE];
+  uint16_t Length;
+  uint8_t  Bad;                 /*!< TRUE if an octet was corrupted           */
+} Bench_Frame_t;
+
+/* Private variables ---------------------------------------------------------*/
+static Bench_Frame_t    pool[BENCH_POOL];
+static Bench_Assembler_t assembler;
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief      Next number of a xorshift generator.
+  * @param      state: state of the generator, not 0.
+  * @retval     The number.
+  */
+static uint32_t Bench_Random(uint32_t *state)
+{
+  uint32_t x = *state;
+
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+
+  return x;
+}
+
+/**
+  * @brief      Draw the frames of a run.
+  * @param      length: octets of the frames, 0 to draw them.
+  * @param      bad: frames corrupted in permille.
+  * @param      state: state of the generator.
+  * @retval     Frames of the pool corrupted.
+  */
+static uint32_t Bench_Draw(uint16_t length, uint32_t bad, uint32_t *state)
+{
+  Bench_Frame_t *frame;
+  uint32_t i, corrupted = 0;
+  uint16_t l;
+
+  for(i=0; i<BENCH_POOL; i++)
+  {
+    frame = &pool[i];
+    frame->Length = (length != 0U) ? length
+                    : (uint16_t)(FRAME_OVERHEAD + Bench_Random(state) % (FRAME_SIZE - FRAME_OVERHEAD + 1U));
+    for(l=0; l<frame->Length - 1U; l++)
+    {
+      frame->Datas[l] = (uint8_t)Bench_Random(state);
+    }
+    /** A standard data frame, with its length in octet 5. */
+    frame->Datas[0] = (uint8_t)((frame->Datas[0] & 0x2CU) | FRAME_CTRL_STANDARD | FRAME_CTRL_DATA);
+    frame->Datas[FRAME_LENGTH_OCTET] = (uint8_t)((frame->Datas[FRAME_LENGTH_OCTET] & 0xF0U)
+                                                 | (frame->Length - FRAME_OVERHEAD));
+    frame->Datas[frame->Length - 1U] = (uint8_t)~KNX_VerticalParity(frame->Datas, (uint16_t)(frame->Length - 1U));
+    frame->Bad = FALSE;
+    if(Bench_Random(state) % 1000U < bad)
+    {
+      /** An octet of the LSDU or the check octet, so the length holds. */
+      frame->Datas[FRAME_LENGTH_OCTET + 1U + Bench_Random(state) % (frame->Length - FRAME_LENGTH_OCTET - 1U)] ^= 0x10U;
+      frame->Bad = TRUE;
+      corrupted++;
+    }
+  }
+
+  return corrupted;
+}
+
+/**
+  * @brief      Start the assembly of a frame.
+  */
+static void Bench_Start(void)
+{
+  assembler.Length = 0;
+  assembler.Expected = 0;
+  assembler.Parity = 0;
+  assembler.Verdict = FRAME_VERDICT_OK;
+}
+
+/**
+  * @brief      An octet received, only stored.
+  * @param      data: the octet.
+  * @retval     TRUE once the frame is complete.
+  */
+static uint8_t Bench_StoreByte(uint8_t data)
+{
+  assembler.Datas[assembler.Length] = data;
+  assembler.Length++;
+
+  if((assembler.Expected == 0U) && (assembler.Length == FRAME_LENGTH_OCTET + 1U))
+  {
+    assembler.Expected = FRAME_OVERHEAD + (data & 0x0FU);
+  }
+
+  return (assembler.Length == assembler.Expected) ? TRUE : FALSE;
+}
+
+/**
+  * @brief      An octet received, stored and checked as it lands.
+  * @param      data: the octet.
+  * @retval     TRUE once the frame is complete.
+  */
+static uint8_t Bench_CheckByte(uint8_t data)
+{
+  assembler.Datas[assembler.Length] = data;
+  assembler.Length++;
+  assembler.Parity ^= data;
+
+  if(assembler.Expected == 0U)
+  {
+    if((assembler.Datas[0] & FRAME_CTRL_STANDARD) == FRAME_CTRL_STANDARD)
+    {
+      if(assembler.Length == FRAME_LENGTH_OCTET + 1U)
+      {
+        assembler.Expected = FRAME_OVERHEAD + (data & 0x0FU);
+      }
+    }
+    if(assembler.Expected > FRAME_SIZE)
+    {
+      assembler.Verdict |= FRAME_VERDICT_LENGTH;
+    }
+  }
+
+  if(assembler.Length == assembler.Expected)
+  {
+    /** The check octet is the inverted XOR of the others. */
+    if(assembler.Parity != 0xFFU)
+    {
+      assembler.Verdict |= FRAME_VERDICT_PARITY;
+    }
+    return TRUE;
+  }
+
+  return FALSE;
+}
+
+/**
+  * @brief      Check a frame assembled by passes over it.
+  * @retval     TRUE if the frame is valid.
+  */
+static uint8_t Bench_CheckPasses(void)
+{
+  uint8_t ctrl = assembler.Datas[0];
+
+  if(assembler.Length < 7U)
+  {
+    return FALSE;
+  }
+  if(((ctrl & FRAME_CTRL_DATA) != FRAME_CTRL_DATA) || ((ctrl & 0x03U) != 0U))
+  {
+    return FALSE;
+  }
+  if((uint8_t)~KNX_VerticalParity(assembler.Datas, (uint16_t)(assembler.Length - 1U))
+     != assembler.Datas[assembler.Length - 1U])
+  {
+    return FALSE;
+  }
+  if(assembler.Length != (assembler.Datas[FRAME_LENGTH_OCTET] & 0x0FU) + FRAME_OVERHEAD)
+  {
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/**
+  * @brief      Assemble and check frames of the pool one way.
+  * @param      incremental: TRUE to check the octets as they land.
+  * @param      frames: frames to check.
+  * @param      cycles: cycles of ::KNX_GetCycles of the run.
+  * @retval     Frames found faulty.
+  */
+static uint32_t Bench_Run(uint8_t incremental, uint32_t frames, uint32_t *cycles)
+{
+  uint8_t (*receive)(uint8_t) = (incremental == TRUE) ? Bench_CheckByte : Bench_StoreByte;
+  const Bench_Frame_t *frame;
+  uint32_t i, start, faulty = 0;
+  uint16_t l;
+  uint8_t valid;
+
+  start = KNX_GetCycles();
+  for(i=0; i<frames; i++)
+  {
+    frame = &pool[i & (BENCH_POOL - 1U)];
+    Bench_Start();
+    for(l=0; l<frame->Length; l++)
+    {
+      if(receive(frame->Datas[l]) == TRUE)
+      {
+        break;
+      }
+    }
+    valid = (incremental == TRUE) ? ((assembler.Verdict == FRAME_VERDICT_OK) ? TRUE : FALSE)
+                                  : Bench_CheckPasses();
+    if(valid == FALSE)
+    {
+      faulty++;
+    }
+  }
+  *cycles = KNX_GetCycles() - start;
+
+  return faulty;
+}
+
+/**
+  * @brief      Run both ways on the frames drawn and print them.
+  * @param      length: octets of the frames, 0 for lengths drawn.
+  * @param      bad: frames corrupted in permille.
+  * @param      frames: frames checked by each run.
+  * @param      state: state of the generator.
+  */
+static void Bench_Compare(uint16_t length, uint32_t bad, uint32_t frames, uint32_t *state)
+{
+  static const char *names[] = {"passes", "incremental"};
+  uint32_t corrupted, expected, faulty, cycles[2];
+  uint8_t mode;
+
+  corrupted = Bench_Draw(length, bad, state);
+  /** The frames of the pool are checked frames / BENCH_POOL times each. */
+  expected = corrupted * (frames / BENCH_POOL);
+  for(mode=0; mode<2U; mode++)
+  {
+    faulty = Bench_Run(mode, frames, &cycles[mode]);
+    KNX_HOST_CHECK(faulty == expected);
+    printf("{\"bench\":\"frame\",\"mode\":\"%s\",\"length\":%u,\"bad_permille\":%lu,"
+           "\"frames\":%lu,\"cycles_per_frame\":%.2f,\"vs_passes\":%.2f,\"faulty\":%lu}\n",
+           names[mode], (unsigned)length, (unsigned long)bad, (unsigned long)frames,
+           (double)cycles[mode] / frames,
+           (cycles[0] != 0U) ? (double)cycles[mode] / cycles[0] : 0.0,
+           (unsigned long)faulty);
+  }
+}
+
+/**
+  * @brief      Entry point.
+  * @param      argc: number of arguments.
+  * @param      argv: options, as \c name=value.
+  * @retval     0 on success.
+  */
+int main(int argc, char **argv)
+{
+  uint32_t frames, bad, state;
+  uint16_t length;
+
+  KNX_Host_Init(argc, argv);
+  frames = KNX_Host_GetOption("frames", 2000000);
+  bad = KNX_Host_GetOption("bad", 100);
+  state = KNX_Host_GetOption("seed", 1);
+  /** Whole passes over the pool, so the frames found faulty are known. */
+  frames -= frames % BENCH_POOL;
+  KNX_HOST_CHECK(frames != 0U);
+  KNX_HOST_CHECK(bad <= 1000U);
+  KNX_HOST_CHECK(state != 0U);
+  if(KNX_Host_GetFailures() != 0U)
+  {
+    KNX_Host_Exit();
+  }
+
+  for(length=FRAME_OVERHEAD; length<=FRAME_SIZE; length++)
+  {
+    Bench_Compare(length, 0, frames, &state);
+  }
+  Bench_Compare(0, 0, frames, &state);
+  Bench_Compare(0, bad, frames, &state);
+
+  KNX_Host_Exit();
+  return 0;
+}
@@ -0,0 +1,217 @@
+/**
+  ******************************************************************************
+  * @file       bench_timer.c
+  * @author     MA Dingjie
+  * @version    V1.0.0
+  * @date       17-October-2016
+  * @brief      Cost of the timers of KNX_Timer.c with many of them armed, and
+  *             check that each expires on its tick.
+  *
+  *             The timers are armed on a wheel of their own, which starts
+  *             just before the 32-bit wrap of its count. One in ten has a
+  *             delay beyond the span of the wheel, one in seven is periodic,
+  *             one in thirteen is cancelled before it expires. The options,
+  *             as \c name=value:
+  *              + \c timers: timers armed
+  *              + \c ticks: ticks of the run, it must cover the longest delay
+  *              + \c seed: seed of the draws
+  *
+  *             The output is a JSON object: the options, the expiries, and
+  *             the cost in ns of a tick, of a tick with no timer armed, of
+  *             arming and of cancelling a timer.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include "KNX_Host.h"
+#include "KNX_Timer.h"
+
+/* Private constants ---------------------------------------------------------*/
+/** \brief Count of the wheel at the start, the run goes through its wrap. */
+#define BENCH_START             ((uint32_t)0xFFFFF000U)
+/** \brief Longest delay of the timers within the span of the wheel. */
+#define BENCH_SHORT_DELAY       ((uint32_t)300000U)
+/** \brief Longest delay of the timers beyond the span of the wheel. */
+#define BENCH_LONG_DELAY        ((uint32_t)30000000U)
+/** \brief Longest period of the periodic timers. */
+#define BENCH_PERIOD            ((uint32_t)5000U)
+/** \brief Ticks run with no timer armed. */
+#define BENCH_IDLE_TICKS        ((uint32_t)10000000U)
+
+/* Private types -------------------------------------------------------------*/
+/**
+  * @brief  A timer of the benchmark and its expected expiry.
+  */
+typedef struct
+{
+  KNX_Timer_t Timer;
+  uint32_t    Expected;         /*!< Tick of the next expiry                 */
+  uint32_t    Fired;            /*!< Expiries                                */
+  uint8_t     Cancelled;        /*!< TRUE if stopped before its expiry       */
+} Bench_Timer_t;
+
+/* Private variables ---------------------------------------------------------*/
+static KNX_Timer_Wheel_t wheel;
+static Bench_Timer_t    *timers;
+static uint32_t          late;
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief      Next number of a xorshift generator.
+  * @param      state: state of the generator, not 0.
+  * @retval     The number.
+  */
+static uint32_t Bench_Random(uint32_t *state)
+{
+  uint32_t x = *state;
+
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+
+  return x;
+}
+
+/**
+  * @brief      Callback of the timers, checks the tick of the expiry.
+  * @param      timer: the timer expired.
+  * @param      woken: not used.
+  */
+static void Bench_Expired(KNX_Timer_t *timer, BaseType_t *woken)
+{
+  Bench_Timer_t *bench = (Bench_Timer_t *)timer->Context;
+
+  (void)woken;
+  if(wheel.Now != bench->Expected)
+  {
+    late++;
+  }
+  bench->Fired++;
+  bench->Expected = wheel.Now + timer->Period;
+}
+
+/**
+  * @brief      ns per operation.
+  * @param      us: time of the operations in us.
+  * @param      count: number of operations.
+  * @retval     The cost of one operation in ns.
+  */
+static double Bench_Ns(uint32_t us, uint32_t count)
+{
+  return (count != 0U) ? (double)us * 1000.0 / (double)count : 0.0;
+}
+
+/**
+  * @brief      Main task of the benchmark.
+  * @param      argument: not used.
+  */
+static void Bench_Task(void *argument)
+{
+  uint32_t count, ticks, state, delay, period, i, k, missed = 0, extra = 0;
+  uint32_t start, tickUs, idleUs, startUs, stopUs;
+
+  (void)argument;
+  count = KNX_Host_GetOption("timers", 20000);
+  ticks = KNX_Host_GetOption("ticks", BENCH_LONG_DELAY + 1000000U);
+  state = KNX_Host_GetOption("seed", 1);
+  KNX_HOST_CHECK(count != 0U);
+  KNX_HOST_CHECK(state != 0U);
+  timers = calloc((count != 0U) ? count : 1U, sizeof(Bench_Timer_t));
+  KNX_HOST_CHECK(timers != NULL);
+  if(KNX_Host_GetFailures() != 0U)
+  {
+    KNX_Host_Exit();
+  }
+
+  /** With no timer armed, a tick only counts. */
+  KNX_Timer_InitWheel(&wheel);
+  start = KNX_Host_GetRunTime();
+  for(k=0; k<BENCH_IDLE_TICKS; k++)
+  {
+    KNX_Timer_Tick(&wheel);
+  }
+  idleUs = KNX_Host_GetRunTime() - start;
+
+  KNX_Timer_InitWheel(&wheel);
+  wheel.Now = BENCH_START;
+  for(i=0; i<count; i++)
+  {
+    KNX_Timer_Init(&timers[i].Timer, Bench_Expired, &timers[i]);
+    delay = 1U + Bench_Random(&state) % (((i % 10U) == 0U) ? BENCH_LONG_DELAY : BENCH_SHORT_DELAY);
+    period = ((i % 7U) == 0U) ? 1U + Bench_Random(&state) % BENCH_PERIOD : 0U;
+    timers[i].Expected = wheel.Now + delay;
+    KNX_Timer_Start(&wheel, &timers[i].Timer, delay, period);
+  }
+  for(i=0; i<count; i+=13U)
+  {
+    KNX_Timer_Stop(&wheel, &timers[i].Timer);
+    timers[i].Cancelled = TRUE;
+  }
+
+  start = KNX_Host_GetRunTime();
+  for(k=0; k<ticks; k++)
+  {
+    KNX_Timer_Tick(&wheel);
+  }
+  tickUs = KNX_Host_GetRunTime() - start;
+
+  for(i=0; i<count; i++)
+  {
+    if(timers[i].Cancelled == TRUE)
+    {
+      extra += timers[i].Fired;
+    }
+    else if(timers[i].Fired == 0U)
+    {
+      missed++;
+    }
+    else if((timers[i].Timer.Period == 0U) && (timers[i].Fired != 1U))
+    {
+      extra += timers[i].Fired - 1U;
+    }
+  }
+  KNX_HOST_CHECK(late == 0U);
+  KNX_HOST_CHECK(missed == 0U);
+  KNX_HOST_CHECK(extra == 0U);
+
+  /** Arming again a timer armed unlinks it first, as a restart does. */
+  start = KNX_Host_GetRunTime();
+  for(i=0; i<count; i++)
+  {
+    KNX_Timer_Start(&wheel, &timers[i].Timer, 1U + (i * 7919U) % BENCH_SHORT_DELAY, 0);
+  }
+  startUs = KNX_Host_GetRunTime() - start;
+  start = KNX_Host_GetRunTime();
+  for(i=0; i<count; i++)
+  {
+    KNX_Timer_Stop(&wheel, &timers[i].Timer);
+  }
+  stopUs = KNX_Host_GetRunTime() - start;
+  KNX_HOST_CHECK(wheel.Armed == 0U);
+
+  printf("{\"bench\":\"timer\",\"timers\":%lu,\"ticks\":%lu,\"expired\":%lu,"
+         "\"late\":%lu,\"missed\":%lu,\"extra\":%lu,\"tick_ns\":%.1f,"
+         "\"idle_tick_ns\":%.1f,\"start_ns\":%.1f,\"stop_ns\":%.1f}\n",
+         (unsigned long)count, (unsigned long)ticks, (unsigned long)wheel.Expired,
+         (unsigned long)late, (unsigned long)missed, (unsigned long)extra,
+         Bench_Ns(tickUs, ticks), Bench_Ns(idleUs, BENCH_IDLE_TICKS),
+         Bench_Ns(startUs, count), Bench_Ns(stopUs, count));
+
+  free(timers);
+  KNX_Host_Exit();
+}
+
+/**
+  * @brief      Entry point.
+  * @param      argc: number of arguments.
+  * @param      argv: options, as \c name=value.
+  * @retval     0 on success.
+  */
+int main(int argc, char **argv)
+{
+  KNX_Host_Run(Bench_Task, argc, argv);
+  return 0;
+}
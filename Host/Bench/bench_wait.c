@@ -0,0 +1,213 @@
+/**
+  ******************************************************************************
+  * @file       bench_wait.c
+  * @author     MA Dingjie
+  * @version    V1.0.0
+  * @date       17-October-2016
+  * @brief      CPU left to the other tasks by the waits of KNX_Ph.c under
+  *             steady traffic.
+  *
+  *             A task above the stack plays the TP-UART: every \c period ms
+  *             it puts a frame on the bus of the emulated TP-UART, which
+  *             forwards it to the line as a TP-UART2 does. The receiving
+  *             task waits for each frame in one of two ways:
+  *              + block: ::KNX_Ph_Data_rec, which sleeps on the semaphore
+  *                given by ::TPUart_isr, as all the waits of KNX_Ph.c do
+  *              + poll: a loop checking the frames received until a new one
+  *                is there, yielding between two checks, the way the waits
+  *                of KNX_Ph.c spun on KNX_CheckForTimeOut before
+  *
+  *             A task below the receiving one wakes up every tick and counts
+  *             its runs, as DebugTask would. Each mode runs for the same
+  *             time, the idle time of the scheduler is measured around it.
+  *             The options, as \c name=value:
+  *              + \c frames: frames sent in each mode, it lasts \c frames
+  *                periods
+  *              + \c period: ms between two frames
+  *              + \c lg: length of the LSDU
+  *
+  *             The output is JSON, one object per mode.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include "KNX_Host.h"
+#include "KNX_Aux.h"
+#include "KNX_Ph_TPUart.h"
+
+/* Private constants ---------------------------------------------------------*/
+/** \brief Priority of the task playing the TP-UART, above the stack. */
+#define BENCH_UART_PRIORITY     (configMAX_PRIORITIES - 1)
+/** \brief Priority of the receiving task. */
+#define BENCH_RX_PRIORITY       (tskIDLE_PRIORITY + 1)
+/** \brief Priority of the task counting its runs, below the receiving one. */
+#define BENCH_LOW_PRIORITY      (tskIDLE_PRIORITY)
+
+/* Private types -------------------------------------------------------------*/
+/**
+  * @brief  Ways of the receiving task to wait for a frame.
+  */
+typedef enum
+{
+  BENCH_WAIT_BLOCK = 0x00U,     /*!< Sleep in ::KNX_Ph_Data_rec               */
+  BENCH_WAIT_POLL  = 0x01U,     /*!< Check the frames received in a loop      */
+  BENCH_WAIT_NB    = 0x02U
+} Bench_Wait_t;
+
+/* Private variables ---------------------------------------------------------*/
+static const char * const BENCH_WAIT_NAMES[BENCH_WAIT_NB] = {"block", "poll"};
+
+static PH_Handle_t       line;
+static volatile Bench_Wait_t mode;
+static volatile uint8_t  sending;
+static volatile uint32_t sent, received, lowRuns;
+static uint32_t          frames, period, lg;
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief      Task sending a standard data frame every ::period ms while
+  *             ::sending, as the TP-UART does with the frames of the bus.
+  * @param      argument: not used.
+  */
+static void Bench_UartTask(void *argument)
+{
+  uint8_t frame[FRAME_SIZE] = {0};
+  uint16_t length = (uint16_t)(FRAME_OVERHEAD + lg);
+
+  (void)argument;
+  frame[0] = 0xBCU;
+  frame[1] = 0x11U;
+  frame[2] = 0x01U;
+  frame[3] = 0x11U;
+  frame[4] = 0x02U;
+  frame[FRAME_LENGTH_OCTET] = (uint8_t)(0x60U | lg);
+  for(;;)
+  {
+    if(sending == TRUE)
+    {
+      frame[FRAME_LENGTH_OCTET + 1U]++;
+      frame[length - 1U] = (uint8_t)~KNX_VerticalParity(frame, (uint16_t)(length - 1U));
+      if(KNX_PH_TPUart_EmuBusFrame(&line.TPUart, frame, length) == TPUart_OK)
+      {
+        sent++;
+      }
+    }
+    vTaskDelay(pdMS_TO_TICKS(period));
+  }
+}
+
+/**
+  * @brief      Task receiving the frames, waiting the way of ::mode.
+  * @param      argument: not used.
+  */
+static void Bench_ReceiveTask(void *argument)
+{
+  uint8_t frame[FRAME_SIZE];
+  uint16_t length;
+  PH_Stats_t stats;
+
+  (void)argument;
+  for(;;)
+  {
+    if(mode == BENCH_WAIT_POLL)
+    {
+      KNX_Ph_GetStats(&line, &stats);
+      while((stats.RxFrames == received) && (mode == BENCH_WAIT_POLL))
+      {
+        taskYIELD();
+        KNX_Ph_GetStats(&line, &stats);
+      }
+    }
+    if(KNX_Ph_Data_rec(&line, frame, &length) == PH_ERROR_NONE)
+    {
+      received++;
+    }
+  }
+}
+
+/**
+  * @brief      Task below the receiving one, runs once per tick if it can.
+  * @param      argument: not used.
+  */
+static void Bench_LowTask(void *argument)
+{
+  (void)argument;
+  for(;;)
+  {
+    lowRuns++;
+    vTaskDelay(1);
+  }
+}
+
+/**
+  * @brief      Main task of the benchmark.
+  * @param      argument: not used.
+  */
+static void Bench_Task(void *argument)
+{
+  uint32_t start, idle, elapsed, ticks, runs, count, frameCount;
+  Bench_Wait_t wait;
+
+  (void)argument;
+  frames = KNX_Host_GetOption("frames", 200);
+  period = KNX_Host_GetOption("period", 10);
+  lg = KNX_Host_GetOption("lg", 4);
+  KNX_HOST_CHECK(frames != 0U);
+  KNX_HOST_CHECK(period != 0U);
+  KNX_HOST_CHECK(lg <= FRAME_SIZE - FRAME_OVERHEAD);
+
+  KNX_HOST_CHECK(KNX_Ph_Init(&line) == PH_ERROR_NONE);
+  if(KNX_Host_GetFailures() != 0U)
+  {
+    KNX_Host_Exit();
+  }
+  xTaskCreate(Bench_UartTask, "Bench UART", KNX_HOST_TASK_STACK, NULL, BENCH_UART_PRIORITY, NULL);
+  xTaskCreate(Bench_ReceiveTask, "Bench RX", KNX_HOST_TASK_STACK, NULL, BENCH_RX_PRIORITY, NULL);
+  xTaskCreate(Bench_LowTask, "Bench low", KNX_HOST_TASK_STACK, NULL, BENCH_LOW_PRIORITY, NULL);
+
+  for(wait=BENCH_WAIT_BLOCK; wait<BENCH_WAIT_NB; wait++)
+  {
+    mode = wait;
+    count = received;
+    frameCount = sent;
+    runs = lowRuns;
+    ticks = xTaskGetTickCount();
+    idle = KNX_Host_GetIdleTime();
+    start = KNX_Host_GetRunTime();
+    sending = TRUE;
+    vTaskDelay(pdMS_TO_TICKS(frames * period));
+    sending = FALSE;
+    elapsed = KNX_Host_GetRunTime() - start;
+    idle = KNX_Host_GetIdleTime() - idle;
+    ticks = xTaskGetTickCount() - ticks;
+    runs = lowRuns - runs;
+    /** Let the last frame be taken before the next mode. */
+    vTaskDelay(pdMS_TO_TICKS(period + 50U));
+    count = received - count;
+    frameCount = sent - frameCount;
+
+    printf("{\"bench\":\"wait\",\"wait\":\"%s\",\"frames\":%lu,\"period\":%lu,\"lg\":%lu,"
+           "\"sent\":%lu,\"received\":%lu,\"ms\":%lu,\"idle_permille\":%lu,\"low_runs\":%lu,\"ticks\":%lu}\n",
+           BENCH_WAIT_NAMES[wait], (unsigned long)frames, (unsigned long)period,
+           (unsigned long)lg, (unsigned long)frameCount, (unsigned long)count, (unsigned long)(elapsed / 1000U),
+           (unsigned long)((elapsed != 0U) ? (uint64_t)idle * 1000U / elapsed : 0U),
+           (unsigned long)runs, (unsigned long)ticks);
+    KNX_HOST_CHECK(count != 0U);
+    KNX_HOST_CHECK(count == frameCount);
+  }
+
+  KNX_Host_Exit();
+}
+
+/**
+  * @brief      Entry point.
+  * @param      argc: number of arguments.
+  * @param      argv: options, as \c name=value.
+  * @retval     0 on success.
+  */
+int main(int argc, char **argv)
+{
+  KNX_Host_Run(Bench_Task, argc, argv);
+  return 0;
+}
@@ -0,0 +1,85 @@
+/**
+  ******************************************************************************
+  * @file       FreeRTOSConfig.h
+  * @author     MA Dingjie
+  * @version    V1.0.0
+  * @date       17-October-2016
+  * @brief      FreeRTOS configuration of the host programs, for the POSIX port
+  *             of the kernel (portable/ThirdParty/GCC/Posix). Each task is a
+  *             thread, only one of them runs at a time, and the tick is a
+  *             timer signal at ::configTICK_RATE_HZ.
+  ******************************************************************************
+  */
+
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Scheduler -----------------------------------------------------------------*/
+#define configUSE_PREEMPTION                    1
+#define configUSE_TIME_SLICING                  1
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION 0
+#define configIDLE_SHOULD_YIELD                 1
+/** 1 ms ticks, the timer of \ref KNX_Aux advances with ::vApplicationTickHook */
+#define configTICK_RATE_HZ                      1000
+#define configUSE_16_BIT_TICKS                  0
+/** Above the tasks of the stack: the emulated TP-UARTs and the tasks playing
+  * the hardware in the tests run at configMAX_PRIORITIES - 1, the simulated
+  * bus at configMAX_PRIORITIES - 2 */
+#define configMAX_PRIORITIES                    8
+/** In words of StackType_t, a thread of the POSIX port needs more than a task
+  * of the target */
+#define configMINIMAL_STACK_SIZE                ((unsigned short)4096)
+#define configMAX_TASK_NAME_LEN                 16
+
+/* Memory, heap_3: malloc and free of the host -------------------------------*/
+#define configSUPPORT_DYNAMIC_ALLOCATION        1
+#define configSUPPORT_STATIC_ALLOCATION         0
+#define configTOTAL_HEAP_SIZE                   ((size_t)(1024 * 1024))
+
+/* Synchronization -----------------------------------------------------------*/
+#define configUSE_MUTEXES                       1
+#define configUSE_RECURSIVE_MUTEXES             0
+#define configUSE_COUNTING_SEMAPHORES           1
+#define configUSE_TASK_NOTIFICATIONS            1
+#define configQUEUE_REGISTRY_SIZE               0
+#define configUSE_QUEUE_SETS                    0
+#define configUSE_TIMERS                        0
+#define configUSE_CO_ROUTINES                   0
+
+/* Hooks ---------------------------------------------------------------------*/
+#define configUSE_IDLE_HOOK                     0
+/** Calls KNX_systick_isr, as the SysTick interrupt of the target does */
+#define configUSE_TICK_HOOK                     1
+#define configUSE_MALLOC_FAILED_HOOK            0
+#define configCHECK_FOR_STACK_OVERFLOW          0
+
+/* Run time statistics, in us of the host, for the idle time of the
+   benchmarks ----------------------------------------------------------------*/
+#define configGENERATE_RUN_TIME_STATS           1
+#define configUSE_TRACE_FACILITY                0
+#define configUSE_STATS_FORMATTING_FUNCTIONS    0
+extern uint32_t KNX_Host_GetRunTime(void);
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE()        KNX_Host_GetRunTime()
+
+/* Optional functions --------------------------------------------------------*/
+#define INCLUDE_vTaskPrioritySet                1
+#define INCLUDE_uxTaskPriorityGet               1
+#define INCLUDE_vTaskDelete                     1
+#define INCLUDE_vTaskSuspend                    1
+#define INCLUDE_vTaskDelayUntil                 1
+#define INCLUDE_xTaskDelayUntil                 1
+#define INCLUDE_vTaskDelay                      1
+#define INCLUDE_xTaskGetSchedulerState          1
+#define INCLUDE_xTaskGetCurrentTaskHandle       1
+#define INCLUDE_xTaskGetIdleTaskHandle          1
+#define INCLUDE_uxTaskGetStackHighWaterMark     0
+
+/* Asserts -------------------------------------------------------------------*/
+extern void vAssertCalled(const char *file, unsigned long line);
+#define configASSERT(x)         if((x) == 0) vAssertCalled(__FILE__, __LINE__)
+
+#endif /* FREERTOS_CONFIG_H */
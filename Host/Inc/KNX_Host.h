@@ -0,0 +1,135 @@
+/**
+  ******************************************************************************
+  * @file       KNX_Host.h
+  * @author     MA Dingjie
+  * @version    V1.0.0
+  * @date       17-October-2016
+  * @brief      This file contains definitions and prototypes of functions for
+  *             the harness of the host programs: tests and benchmarks of the
+  *             stack on the FreeRTOS POSIX port.
+  ******************************************************************************
+  */
+
+#ifndef __KNX_HOST
+#define __KNX_HOST
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "KNX_def.h"
+#include "KNX_Ph.h"
+#include "KNX_DL.h"
+#include "KNX_Bus.h"
+
+/** @addtogroup KNX_Host
+  * @{
+  */
+
+/* Exported constants --------------------------------------------------------*/
+/** @defgroup KNX_Host_Exported_Constants KNX Host Exported Constants
+  * @{
+  */
+
+/** \brief Priority of the main task of a program, below ::KNX_DL_TxTask so
+  *        a request is taken as soon as it is queued. */
+#define KNX_HOST_TASK_PRIORITY  (tskIDLE_PRIORITY + 1)
+/** \brief Stack of the main task of a program, in words. */
+#define KNX_HOST_TASK_STACK     (configMINIMAL_STACK_SIZE * 2)
+
+/**
+  * @}
+  */
+
+/* Exported macros -----------------------------------------------------------*/
+/** @defgroup KNX_Host_Exported_Macros KNX Host Exported Macros
+  * @{
+  */
+
+/** \brief Check a condition of a test, a failure is printed and counted by
+  *        ::KNX_Host_Check. */
+#define KNX_HOST_CHECK(cond)    KNX_Host_Check((cond) ? TRUE : FALSE, #cond, __FILE__, __LINE__)
+
+/**
+  * @}
+  */
+
+/* Exported types ------------------------------------------------------------*/
+/** @defgroup KNX_Host_Exported_Types KNX Host Exported Types
+  * @{
+  */
+
+/**
+  * @brief  A device of the simulated bus: a line and its data link layer.
+  */
+typedef struct
+{
+  PH_Handle_t           Ph;             /*!< Physical layer of the device     */
+  DL_Handle_t           DL;             /*!< Data link layer of the device    */
+} KNX_Host_Node_t;
+
+/**
+  * @}
+  */
+
+/* Exported functions --------------------------------------------------------*/
+/** @addtogroup KNX_Host_Exported_Functions
+  * @{
+  */
+
+/** @addtogroup KNX_Host_Exported_Functions_Group1
+  * @{
+  */
+
+/* Program functions  *********************************************************/
+void     KNX_Host_Init(int argc, char **argv);
+void     KNX_Host_Run(TaskFunction_t main, int argc, char **argv);
+uint32_t KNX_Host_GetOption(const char *name, uint32_t value);
+void     KNX_Host_Check(uint8_t ok, const char *cond, const char *file, int line);
+uint32_t KNX_Host_GetFailures(void);
+void     KNX_Host_Exit(void);
+/**
+  * @}
+  */
+
+/** @addtogroup KNX_Host_Exported_Functions_Group2
+  * @{
+  */
+
+/* Node functions  ************************************************************/
+#if KNX_PH_TPUART_BACKEND == KNX_PH_TPUART_EMU
+uint8_t  KNX_Host_InitNode(KNX_Bus_t *bus, KNX_Host_Node_t *node, uint16_t individual);
+#endif
+uint16_t KNX_Host_BuildFrame(uint8_t *frame, uint8_t priority, uint16_t sa, uint16_t da, uint8_t group, const uint8_t *lsdu, uint8_t lg);
+/**
+  * @}
+  */
+
+/** @addtogroup KNX_Host_Exported_Functions_Group3
+  * @{
+  */
+
+/* Measure functions  *********************************************************/
+uint32_t KNX_Host_GetRunTime(void);
+uint32_t KNX_Host_GetIdleTime(void);
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KNX_HOST */
@@ -0,0 +1,18 @@
+/**
+  ******************************************************************************
+  * @file       stm32f4xx.h
+  * @author     MA Dingjie
+  * @version    V1.0.0
+  * @date       17-October-2016
+  * @brief      Host mock of the CMSIS device header, the peripherals are
+  *             those of stm32f4xx_hal.h.
+  ******************************************************************************
+  */
+
+#ifndef __STM32F4xx_H
+#define __STM32F4xx_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+
+#endif /* __STM32F4xx_H */
@@ -0,0 +1,482 @@
+/**
+  ******************************************************************************
+  * @file       stm32f4xx_hal.h
+  * @author     MA Dingjie
+  * @version    V1.0.0
+  * @date       17-October-2016
+  * @brief      Host mock of the part of the STM32F4 HAL used by the stack:
+  *             the TP-UART on USART3, driven by interrupts, KNX_Ph_TPUart.c,
+  *             or by DMA, KNX_Ph_TPUart_DMA.c, and the debug UART on USART2.
+  *
+  *             The registers of USART2, USART3, DMA1 Streams 1 and 3, GPIOD,
+  *             RCC, the NVIC and the DWT of the core are variables, with the bits of the reference
+  *             manual, and the HAL functions write them as the real ones do.
+  *             The hardware side is played by the HAL_Mock_* functions: the
+  *             TP-UART sends octets, which land in DR or which the reception
+  *             stream writes into memory; the line goes idle; the UART sends
+  *             the octets written into DR or drains the transmission stream.
+  *             Each event raises the flags of the peripheral and calls the
+  *             handler set with ::HAL_Mock_SetIRQHandler when its interrupt
+  *             is enabled, as the NVIC would.
+  *
+  *             The cycle counter of the DWT does not run, it only moves
+  *             when a test writes it.
+  *
+  *             The addresses of the streams are wider than their 32 bits
+  *             registers on the host, they are kept as uintptr_t.
+  ******************************************************************************
+  */
+
+#ifndef __STM32F4xx_HAL_H
+#define __STM32F4xx_HAL_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stddef.h>
+
+/** @addtogroup HAL_Mock
+  * @{
+  */
+
+/* Exported types ------------------------------------------------------------*/
+/** @defgroup HAL_Mock_Exported_Types HAL Mock Exported Types
+  * @{
+  */
+
+/**
+  * @brief  HAL Status structures definition
+  */
+typedef enum
+{
+  HAL_OK       = 0x00U,
+  HAL_ERROR    = 0x01U,
+  HAL_BUSY     = 0x02U,
+  HAL_TIMEOUT  = 0x03U
+} HAL_StatusTypeDef;
+
+/**
+  * @brief  HAL Lock structures definition
+  */
+typedef enum
+{
+  HAL_UNLOCKED = 0x00U,
+  HAL_LOCKED   = 0x01U
+} HAL_LockTypeDef;
+
+/**
+  * @brief  Interrupt lines used by the stack.
+  */
+typedef enum
+{
+  DMA1_Stream1_IRQn     = 12,   /*!< DMA1 Stream 1 global Interrupt           */
+  DMA1_Stream3_IRQn     = 14,   /*!< DMA1 Stream 3 global Interrupt           */
+  USART2_IRQn           = 38,   /*!< USART2 global Interrupt                  */
+  USART3_IRQn           = 39,   /*!< USART3 global Interrupt                  */
+  HAL_MOCK_IRQn_NB      = 82
+} IRQn_Type;
+
+/**
+  * @brief  Universal Synchronous Asynchronous Receiver Transmitter
+  */
+typedef struct
+{
+  volatile uint32_t SR;         /*!< USART Status register                    */
+  volatile uint32_t DR;         /*!< USART Data register                      */
+  volatile uint32_t BRR;        /*!< USART Baud rate register                 */
+  volatile uint32_t CR1;        /*!< USART Control register 1                 */
+  volatile uint32_t CR2;        /*!< USART Control register 2                 */
+  volatile uint32_t CR3;        /*!< USART Control register 3                 */
+  volatile uint32_t GTPR;       /*!< USART Guard time and prescaler register  */
+} USART_TypeDef;
+
+/**
+  * @brief  DMA Stream Controller, with its flags of LISR/HISR
+  */
+typedef struct
+{
+  volatile uint32_t CR;         /*!< DMA stream x configuration register      */
+  volatile uint32_t NDTR;       /*!< DMA stream x number of data register     */
+  volatile uintptr_t PAR;       /*!< DMA stream x peripheral address register */
+  volatile uintptr_t M0AR;      /*!< DMA stream x memory 0 address register   */
+  volatile uintptr_t M1AR;      /*!< DMA stream x memory 1 address register   */
+  volatile uint32_t FCR;        /*!< DMA stream x FIFO control register       */
+  volatile uint32_t ISR;        /*!< Flags of the stream in LISR/HISR, shifted
+                                     to the bits of stream 0                  */
+  uint32_t          Reload;     /*!< NDTR written before the enable, reloaded
+                                     by a circular stream, inside the DMA     */
+} DMA_Stream_TypeDef;
+
+/**
+  * @brief  General Purpose I/O
+  */
+typedef struct
+{
+  volatile uint32_t MODER;      /*!< GPIO port mode register                  */
+  volatile uint32_t ODR;        /*!< GPIO port output data register           */
+} GPIO_TypeDef;
+
+/**
+  * @brief  Structure type to access the Core Debug Register (CoreDebug)
+  */
+typedef struct
+{
+  volatile uint32_t DEMCR;      /*!< Debug Exception and Monitor Control Register */
+} CoreDebug_Type;
+
+/**
+  * @brief  Structure type to access the Data Watchpoint and Trace Register (DWT)
+  */
+typedef struct
+{
+  volatile uint32_t CTRL;       /*!< Control Register                         */
+  volatile uint32_t CYCCNT;     /*!< Cycle Count Register                     */
+} DWT_Type;
+
+/**
+  * @brief  Reset and Clock Control
+  */
+typedef struct
+{
+  volatile uint32_t AHB1ENR;    /*!< RCC AHB1 peripheral clock register       */
+  volatile uint32_t APB1ENR;    /*!< RCC APB1 peripheral clock enable register */
+} RCC_TypeDef;
+
+/**
+  * @brief  DMA Configuration Structure definition
+  */
+typedef struct
+{
+  uint32_t Channel;
+  uint32_t Direction;
+  uint32_t PeriphInc;
+  uint32_t MemInc;
+  uint32_t PeriphDataAlignment;
+  uint32_t MemDataAlignment;
+  uint32_t Mode;
+  uint32_t Priority;
+  uint32_t FIFOMode;
+  uint32_t FIFOThreshold;
+  uint32_t MemBurst;
+  uint32_t PeriphBurst;
+} DMA_InitTypeDef;
+
+/**
+  * @brief  HAL DMA State structures definition
+  */
+typedef enum
+{
+  HAL_DMA_STATE_RESET   = 0x00U,
+  HAL_DMA_STATE_READY   = 0x01U,
+  HAL_DMA_STATE_BUSY    = 0x02U
+} HAL_DMA_StateTypeDef;
+
+/**
+  * @brief  DMA handle Structure definition
+  */
+typedef struct __DMA_HandleTypeDef
+{
+  DMA_Stream_TypeDef    *Instance;
+  DMA_InitTypeDef       Init;
+  HAL_LockTypeDef       Lock;
+  volatile HAL_DMA_StateTypeDef State;
+  void                  *Parent;
+  void                  (*XferCpltCallback)(struct __DMA_HandleTypeDef *hdma);
+  void                  (*XferHalfCpltCallback)(struct __DMA_HandleTypeDef *hdma);
+  volatile uint32_t     ErrorCode;
+} DMA_HandleTypeDef;
+
+/**
+  * @brief UART Init Structure definition
+  */
+typedef struct
+{
+  uint32_t BaudRate;
+  uint32_t WordLength;
+  uint32_t StopBits;
+  uint32_t Parity;
+  uint32_t Mode;
+  uint32_t HwFlowCtl;
+  uint32_t OverSampling;
+} UART_InitTypeDef;
+
+/**
+  * @brief HAL UART State structures definition
+  */
+typedef enum
+{
+  HAL_UART_STATE_RESET          = 0x00U,
+  HAL_UART_STATE_READY          = 0x20U,
+  HAL_UART_STATE_BUSY           = 0x24U,
+  HAL_UART_STATE_BUSY_TX        = 0x21U,
+  HAL_UART_STATE_BUSY_RX        = 0x22U,
+  HAL_UART_STATE_BUSY_TX_RX     = 0x23U,
+  HAL_UART_STATE_TIMEOUT        = 0xA0U,
+  HAL_UART_STATE_ERROR          = 0xE0U
+} HAL_UART_StateTypeDef;
+
+/**
+  * @brief  UART handle Structure definition
+  */
+typedef struct
+{
+  USART_TypeDef         *Instance;
+  UART_InitTypeDef      Init;
+  uint8_t               *pTxBuffPtr;
+  uint16_t              TxXferSize;
+  volatile uint16_t     TxXferCount;
+  uint8_t               *pRxBuffPtr;
+  uint16_t              RxXferSize;
+  volatile uint16_t     RxXferCount;
+  DMA_HandleTypeDef     *hdmatx;
+  DMA_HandleTypeDef     *hdmarx;
+  HAL_LockTypeDef       Lock;
+  volatile HAL_UART_StateTypeDef gState;
+  volatile HAL_UART_StateTypeDef RxState;
+  volatile uint32_t     ErrorCode;
+} UART_HandleTypeDef;
+
+/**
+  * @brief  Interrupt routine set with ::HAL_Mock_SetIRQHandler.
+  */
+typedef void (*HAL_Mock_IRQHandler_t)(void);
+
+/**
+  * @brief  State of an interrupt line of the mocked NVIC.
+  */
+typedef struct
+{
+  uint32_t              Priority;       /*!< Set by HAL_NVIC_SetPriority      */
+  uint8_t               Enabled;        /*!< Set by HAL_NVIC_EnableIRQ        */
+  HAL_Mock_IRQHandler_t Handler;        /*!< Called when the line fires       */
+} HAL_Mock_IRQ_t;
+
+/**
+  * @}
+  */
+
+/* Exported constants --------------------------------------------------------*/
+/** @defgroup HAL_Mock_Exported_Constants HAL Mock Exported Constants
+  * @{
+  */
+
+/** @defgroup HAL_Mock_Registers Bits of the registers
+  * @{
+  */
+#define USART_SR_IDLE           ((uint32_t)0x00000010U)
+#define USART_SR_RXNE           ((uint32_t)0x00000020U)
+#define USART_SR_TC             ((uint32_t)0x00000040U)
+#define USART_SR_TXE            ((uint32_t)0x00000080U)
+#define USART_CR1_RE            ((uint32_t)0x00000004U)
+#define USART_CR1_TE            ((uint32_t)0x00000008U)
+#define USART_CR1_IDLEIE        ((uint32_t)0x00000010U)
+#define USART_CR1_RXNEIE        ((uint32_t)0x00000020U)
+#define USART_CR1_TCIE          ((uint32_t)0x00000040U)
+#define USART_CR1_TXEIE         ((uint32_t)0x00000080U)
+#define USART_CR1_PEIE          ((uint32_t)0x00000100U)
+#define USART_CR1_PS            ((uint32_t)0x00000200U)
+#define USART_CR1_PCE           ((uint32_t)0x00000400U)
+#define USART_CR1_M             ((uint32_t)0x00001000U)
+#define USART_CR1_UE            ((uint32_t)0x00002000U)
+#define USART_CR3_EIE           ((uint32_t)0x00000001U)
+#define USART_CR3_DMAR          ((uint32_t)0x00000040U)
+#define USART_CR3_DMAT          ((uint32_t)0x00000080U)
+
+#define DMA_SxCR_EN             ((uint32_t)0x00000001U)
+#define DMA_SxCR_TEIE           ((uint32_t)0x00000004U)
+#define DMA_SxCR_HTIE           ((uint32_t)0x00000008U)
+#define DMA_SxCR_TCIE           ((uint32_t)0x00000010U)
+#define DMA_SxCR_DIR            ((uint32_t)0x000000C0U)
+#define DMA_SxCR_CIRC           ((uint32_t)0x00000100U)
+#define DMA_SxCR_MINC           ((uint32_t)0x00000400U)
+#define DMA_SxCR_PL             ((uint32_t)0x00030000U)
+#define DMA_SxCR_CHSEL          ((uint32_t)0x0E000000U)
+#define DMA_FLAG_HTIF0_4        ((uint32_t)0x00000010U)
+#define DMA_FLAG_TCIF0_4        ((uint32_t)0x00000020U)
+
+#define RCC_AHB1ENR_DMA1EN      ((uint32_t)0x00200000U)
+
+#define CoreDebug_DEMCR_TRCENA_Msk      ((uint32_t)0x01000000U)
+#define DWT_CTRL_CYCCNTENA_Msk          ((uint32_t)0x00000001U)
+/**
+  * @}
+  */
+
+/** @defgroup HAL_Mock_Init_Values Values of the Init structures
+  * @{
+  */
+#define DMA_CHANNEL_4           ((uint32_t)0x08000000U)
+#define DMA_PERIPH_TO_MEMORY    ((uint32_t)0x00000000U)
+#define DMA_MEMORY_TO_PERIPH    ((uint32_t)0x00000040U)
+#define DMA_PINC_DISABLE        ((uint32_t)0x00000000U)
+#define DMA_MINC_ENABLE         ((uint32_t)0x00000400U)
+#define DMA_PDATAALIGN_BYTE     ((uint32_t)0x00000000U)
+#define DMA_MDATAALIGN_BYTE     ((uint32_t)0x00000000U)
+#define DMA_NORMAL              ((uint32_t)0x00000000U)
+#define DMA_CIRCULAR            ((uint32_t)0x00000100U)
+#define DMA_PRIORITY_MEDIUM     ((uint32_t)0x00010000U)
+#define DMA_PRIORITY_HIGH       ((uint32_t)0x00020000U)
+#define DMA_FIFOMODE_DISABLE    ((uint32_t)0x00000000U)
+
+#define UART_WORDLENGTH_8B      ((uint32_t)0x00000000U)
+#define UART_WORDLENGTH_9B      USART_CR1_M
+#define UART_STOPBITS_1         ((uint32_t)0x00000000U)
+#define UART_PARITY_NONE        ((uint32_t)0x00000000U)
+#define UART_PARITY_EVEN        USART_CR1_PCE
+#define UART_MODE_TX_RX         (USART_CR1_TE | USART_CR1_RE)
+#define UART_HWCONTROL_NONE     ((uint32_t)0x00000000U)
+#define UART_OVERSAMPLING_16    ((uint32_t)0x00000000U)
+#define UART_FLAG_IDLE          USART_SR_IDLE
+#define UART_FLAG_TC            USART_SR_TC
+#define UART_IT_IDLE            USART_CR1_IDLEIE
+#define UART_IT_RXNE            USART_CR1_RXNEIE
+#define UART_IT_TC              USART_CR1_TCIE
+
+#define HAL_UART_ERROR_NONE     ((uint32_t)0x00000000U)
+
+#define GPIO_PIN_7              ((uint16_t)0x0080U)
+#define GPIO_PIN_12             ((uint16_t)0x1000U)
+/** Green LED of the board, a user constant of CubeMX */
+#define LD4_Pin                 GPIO_PIN_12
+/**
+  * @}
+  */
+
+/**
+  * @brief  GPIO Bit SET and Bit RESET enumeration
+  */
+typedef enum
+{
+  GPIO_PIN_RESET = 0,
+  GPIO_PIN_SET
+} GPIO_PinState;
+
+/** \brief APB1 clock of the mock, gives ::USART_TypeDef::BRR. */
+#define HAL_MOCK_APB1_CLOCK     ((uint32_t)42000000U)
+
+/**
+  * @}
+  */
+
+/* Exported variables --------------------------------------------------------*/
+/** @defgroup HAL_Mock_Exported_Variables HAL Mock Exported Variables
+  * @brief    The peripherals, reset to 0 by ::HAL_Mock_Reset.
+  * @{
+  */
+extern USART_TypeDef      HAL_Mock_USART2;
+extern USART_TypeDef      HAL_Mock_USART3;
+extern DMA_Stream_TypeDef HAL_Mock_DMA1_Stream1;
+extern DMA_Stream_TypeDef HAL_Mock_DMA1_Stream3;
+extern GPIO_TypeDef       HAL_Mock_GPIOD;
+extern RCC_TypeDef        HAL_Mock_RCC;
+extern CoreDebug_Type     HAL_Mock_CoreDebug;
+extern DWT_Type           HAL_Mock_DWT;
+extern HAL_Mock_IRQ_t     HAL_Mock_NVIC[HAL_MOCK_IRQn_NB];
+/** \brief Clock of the core as in system_stm32f4xx.c, not reset. */
+extern uint32_t           SystemCoreClock;
+
+#define USART2                  (&HAL_Mock_USART2)
+#define USART3                  (&HAL_Mock_USART3)
+#define DMA1_Stream1            (&HAL_Mock_DMA1_Stream1)
+#define DMA1_Stream3            (&HAL_Mock_DMA1_Stream3)
+#define GPIOD                   (&HAL_Mock_GPIOD)
+#define RCC                     (&HAL_Mock_RCC)
+#define CoreDebug               (&HAL_Mock_CoreDebug)
+#define DWT                     (&HAL_Mock_DWT)
+/**
+  * @}
+  */
+
+/* Exported macros -----------------------------------------------------------*/
+/** @defgroup HAL_Mock_Exported_Macros HAL Mock Exported Macros
+  * @{
+  */
+#define __IO                    volatile
+
+#define SET_BIT(REG, BIT)       ((REG) |= (BIT))
+#define CLEAR_BIT(REG, BIT)     ((REG) &= ~(BIT))
+#define READ_BIT(REG, BIT)      ((REG) & (BIT))
+
+#define __HAL_RCC_DMA1_CLK_ENABLE()     (RCC->AHB1ENR |= RCC_AHB1ENR_DMA1EN)
+
+#define __HAL_LINKDMA(__HANDLE__, __PPP_DMA_FIELD__, __DMA_HANDLE__)          \
+  do {                                                                        \
+    (__HANDLE__)->__PPP_DMA_FIELD__ = &(__DMA_HANDLE__);                      \
+    (__DMA_HANDLE__).Parent = (__HANDLE__);                                   \
+  } while(0)
+
+#define __HAL_DMA_GET_COUNTER(__HANDLE__)       ((__HANDLE__)->Instance->NDTR)
+
+#define __HAL_UART_GET_FLAG(__HANDLE__, __FLAG__)                             \
+  (((__HANDLE__)->Instance->SR & (__FLAG__)) == (__FLAG__))
+
+/** The hardware clears IDLE on a read of SR then DR, the mock does it here. */
+#define __HAL_UART_CLEAR_IDLEFLAG(__HANDLE__)                                 \
+  do {                                                                        \
+    (void)(__HANDLE__)->Instance->SR;                                         \
+    (void)(__HANDLE__)->Instance->DR;                                         \
+    (__HANDLE__)->Instance->SR &= ~USART_SR_IDLE;                             \
+  } while(0)
+
+#define __HAL_UART_ENABLE_IT(__HANDLE__, __INTERRUPT__)                       \
+  ((__HANDLE__)->Instance->CR1 |= (__INTERRUPT__))
+#define __HAL_UART_DISABLE_IT(__HANDLE__, __INTERRUPT__)                      \
+  ((__HANDLE__)->Instance->CR1 &= ~(__INTERRUPT__))
+/**
+  * @}
+  */
+
+/* Exported functions --------------------------------------------------------*/
+/** @defgroup HAL_Mock_Exported_Functions HAL Mock Exported Functions
+  * @{
+  */
+
+/** @defgroup HAL_Mock_Exported_Functions_Group1 HAL Functions
+  * @brief    Same as the HAL, on the registers of the mock.
+  * @{
+  */
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma);
+void              HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma);
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UART_Receive_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size);
+void              HAL_UART_IRQHandler(UART_HandleTypeDef *huart);
+void              HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+void              HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+void              HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority);
+void              HAL_NVIC_EnableIRQ(IRQn_Type IRQn);
+void              HAL_NVIC_DisableIRQ(IRQn_Type IRQn);
+/**
+  * @}
+  */
+
+/** @defgroup HAL_Mock_Exported_Functions_Group2 Hardware Functions
+  * @brief    The side of the peripherals, for the tests.
+  * @{
+  */
+void     HAL_Mock_Reset(void);
+void     HAL_Mock_SetIRQHandler(IRQn_Type IRQn, HAL_Mock_IRQHandler_t handler);
+void     HAL_Mock_SetCharTime(uint32_t us);
+uint16_t HAL_Mock_UART_Receive(USART_TypeDef *uart, const uint8_t *data, uint16_t size);
+void     HAL_Mock_UART_Idle(USART_TypeDef *uart);
+uint16_t HAL_Mock_UART_Transmit(USART_TypeDef *uart, uint8_t *data, uint16_t size);
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __STM32F4xx_HAL_H */
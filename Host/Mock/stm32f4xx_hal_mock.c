@@ -0,0 +1,689 @@
+/**
+  ******************************************************************************
+  * @file       stm32f4xx_hal_mock.c
+  * @author     MA Dingjie
+  * @version    V1.0.0
+  * @date       17-October-2016
+  * @brief      Host mock of the STM32F4 HAL, see stm32f4xx_hal.h.
+  *             This file provides functions to manage following functionalities:
+  *              + HAL functions on the registers of the mock
+  *              + Hardware side: reception, idle line and transmission of the
+  *                UART, octet by octet through DR or through its DMA streams,
+  *                with their interrupts
+  *
+  *             A stream only moves octets from the HAL_Mock_UART_* functions,
+  *             one at a time, raising its half transfer and transfer complete
+  *             flags on the way. USART3 has the streams of the target,
+  *             DMA1 Stream 1 to receive and Stream 3 to send, USART2 none.
+  *             The interrupt handlers run inside the HAL_Mock_UART_* calls,
+  *             from the task of the test which plays the hardware.
+  *
+  *             The time of a character set with ::HAL_Mock_SetCharTime is
+  *             spent before each octet received lands and before the idle
+  *             line, so that the octets come at the pace of the line. It is
+  *             0 after ::HAL_Mock_Reset: no time passes.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include <time.h>
+#include "stm32f4xx_hal.h"
+
+/** @addtogroup HAL_Mock
+  * @{
+  */
+
+/* Private constants ---------------------------------------------------------*/
+/** @defgroup HAL_Mock_Private_Constants HAL Mock Private Constants
+  * @{
+  */
+/** \brief Value of DR while no octet is written, wider than an octet. */
+#define HAL_MOCK_DR_EMPTY       ((uint32_t)0x00010000U)
+/**
+  * @}
+  */
+
+/* Private variables ---------------------------------------------------------*/
+/** \brief us spent by a character on the line, see ::HAL_Mock_SetCharTime. */
+static uint32_t HAL_Mock_CharTime;
+
+/* Exported variables --------------------------------------------------------*/
+USART_TypeDef      HAL_Mock_USART2;
+USART_TypeDef      HAL_Mock_USART3;
+DMA_Stream_TypeDef HAL_Mock_DMA1_Stream1;
+DMA_Stream_TypeDef HAL_Mock_DMA1_Stream3;
+GPIO_TypeDef       HAL_Mock_GPIOD;
+RCC_TypeDef        HAL_Mock_RCC;
+CoreDebug_Type     HAL_Mock_CoreDebug;
+DWT_Type           HAL_Mock_DWT;
+HAL_Mock_IRQ_t     HAL_Mock_NVIC[HAL_MOCK_IRQn_NB];
+uint32_t           SystemCoreClock = 168000000U;
+
+/* Private function prototypes -----------------------------------------------*/
+/** @defgroup HAL_Mock_Private_Functions HAL Mock Private Functions
+  * @{
+  */
+static void      HAL_Mock_Fire(IRQn_Type IRQn);
+static uint64_t  HAL_Mock_Now(void);
+static void      HAL_Mock_WaitUntil(uint64_t ns);
+static DMA_Stream_TypeDef *HAL_Mock_UARTStream(USART_TypeDef *uart, uint32_t direction);
+static IRQn_Type HAL_Mock_StreamIRQn(DMA_Stream_TypeDef *stream);
+static void      HAL_Mock_StreamEvent(DMA_Stream_TypeDef *stream);
+static void      HAL_Mock_UARTEvent(USART_TypeDef *uart);
+static void      HAL_Mock_DMA_Start_IT(DMA_HandleTypeDef *hdma, uintptr_t src, uintptr_t dst, uint16_t size);
+static void      UART_DMATransmitCplt(DMA_HandleTypeDef *hdma);
+/**
+  * @}
+  */
+
+/* Exported functions --------------------------------------------------------*/
+/** @addtogroup HAL_Mock_Exported_Functions
+  * @{
+  */
+
+/** @addtogroup HAL_Mock_Exported_Functions_Group1
+  * @{
+  */
+
+/**
+  * @brief      Configure a stream from the Init of its handle, the stream
+  *             left disabled.
+  * @param      hdma: DMA handle, Instance and Init set.
+  * @retval     HAL_OK, or HAL_ERROR without Instance.
+  */
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma)
+{
+  if((hdma == NULL) || (hdma->Instance == NULL))
+  {
+    return HAL_ERROR;
+  }
+
+  hdma->State = HAL_DMA_STATE_BUSY;
+  hdma->Instance->CR = hdma->Init.Channel | hdma->Init.Direction
+                     | hdma->Init.PeriphInc | hdma->Init.MemInc
+                     | hdma->Init.PeriphDataAlignment | hdma->Init.MemDataAlignment
+                     | hdma->Init.Mode | hdma->Init.Priority;
+  hdma->Instance->FCR = hdma->Init.FIFOMode;
+  hdma->Instance->ISR = 0;
+  hdma->ErrorCode = 0;
+  hdma->State = HAL_DMA_STATE_READY;
+
+  return HAL_OK;
+}
+
+/**
+  * @brief      Interrupt of a stream: clear its flags and call the callbacks.
+  *             A stream in normal mode is over at the transfer complete.
+  * @param      hdma: DMA handle.
+  */
+void HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma)
+{
+  DMA_Stream_TypeDef *stream = hdma->Instance;
+
+  if(((stream->ISR & DMA_FLAG_HTIF0_4) != 0U) && ((stream->CR & DMA_SxCR_HTIE) != 0U))
+  {
+    stream->ISR &= ~DMA_FLAG_HTIF0_4;
+    if(hdma->XferHalfCpltCallback != NULL)
+    {
+      hdma->XferHalfCpltCallback(hdma);
+    }
+  }
+
+  if(((stream->ISR & DMA_FLAG_TCIF0_4) != 0U) && ((stream->CR & DMA_SxCR_TCIE) != 0U))
+  {
+    stream->ISR &= ~DMA_FLAG_TCIF0_4;
+    if((stream->CR & DMA_SxCR_CIRC) == 0U)
+    {
+      stream->CR &= ~(DMA_SxCR_TCIE | DMA_SxCR_HTIE | DMA_SxCR_TEIE);
+      hdma->State = HAL_DMA_STATE_READY;
+    }
+    if(hdma->XferCpltCallback != NULL)
+    {
+      hdma->XferCpltCallback(hdma);
+    }
+  }
+}
+
+/**
+  * @brief      Configure and enable a UART from the Init of its handle.
+  * @param      huart: UART handle, Instance and Init set.
+  * @retval     HAL_OK, or HAL_ERROR without Instance.
+  */
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart)
+{
+  if((huart == NULL) || (huart->Instance == NULL) || (huart->Init.BaudRate == 0U))
+  {
+    return HAL_ERROR;
+  }
+
+  huart->gState = HAL_UART_STATE_BUSY;
+  huart->Instance->CR1 &= ~USART_CR1_UE;
+  huart->Instance->CR2 = huart->Init.StopBits;
+  huart->Instance->CR1 = huart->Init.WordLength | huart->Init.Parity
+                       | huart->Init.Mode | huart->Init.OverSampling;
+  huart->Instance->CR3 = huart->Init.HwFlowCtl;
+  /** Oversampling by 16: the mantissa and the fraction of USARTDIV in 16th. */
+  huart->Instance->BRR = (HAL_MOCK_APB1_CLOCK + huart->Init.BaudRate / 2U) / huart->Init.BaudRate;
+  huart->Instance->CR1 |= USART_CR1_UE;
+
+  huart->ErrorCode = HAL_UART_ERROR_NONE;
+  huart->gState = HAL_UART_STATE_READY;
+  huart->RxState = HAL_UART_STATE_READY;
+
+  return HAL_OK;
+}
+
+/**
+  * @brief      Send a buffer with the transmission stream. The transfer is
+  *             over, ::UART_HandleTypeDef::gState back to ready, once the UART
+  *             has sent the last octet.
+  * @param      huart: UART handle, hdmatx linked.
+  * @param      pData: octets to send, valid until the end of the transfer.
+  * @param      Size: number of octets.
+  * @retval     HAL_OK, HAL_BUSY if a transfer is ongoing, HAL_ERROR if no
+  *             octet is given.
+  */
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+  if(huart->gState != HAL_UART_STATE_READY)
+  {
+    return HAL_BUSY;
+  }
+  if((pData == NULL) || (Size == 0U))
+  {
+    return HAL_ERROR;
+  }
+
+  huart->pTxBuffPtr = pData;
+  huart->TxXferSize = Size;
+  huart->TxXferCount = Size;
+  huart->gState = HAL_UART_STATE_BUSY_TX;
+
+  huart->hdmatx->XferCpltCallback = UART_DMATransmitCplt;
+  huart->hdmatx->XferHalfCpltCallback = NULL;
+  HAL_Mock_DMA_Start_IT(huart->hdmatx, (uintptr_t)pData, (uintptr_t)&huart->Instance->DR, Size);
+
+  huart->Instance->SR &= ~USART_SR_TC;
+  huart->Instance->CR3 |= USART_CR3_DMAT;
+
+  return HAL_OK;
+}
+
+/**
+  * @brief      Receive into a buffer with the reception stream, for ever if
+  *             the stream is circular.
+  * @param      huart: UART handle, hdmarx linked.
+  * @param      pData: buffer written by the stream.
+  * @param      Size: size of the buffer.
+  * @retval     HAL_OK, HAL_BUSY if a reception is ongoing, HAL_ERROR if no
+  *             buffer is given.
+  */
+HAL_StatusTypeDef HAL_UART_Receive_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+  if(huart->RxState != HAL_UART_STATE_READY)
+  {
+    return HAL_BUSY;
+  }
+  if((pData == NULL) || (Size == 0U))
+  {
+    return HAL_ERROR;
+  }
+
+  huart->pRxBuffPtr = pData;
+  huart->RxXferSize = Size;
+  huart->RxState = HAL_UART_STATE_BUSY_RX;
+
+  /** Nothing to do at the half and at the end of a circular reception. */
+  huart->hdmarx->XferCpltCallback = NULL;
+  huart->hdmarx->XferHalfCpltCallback = NULL;
+  HAL_Mock_DMA_Start_IT(huart->hdmarx, (uintptr_t)&huart->Instance->DR, (uintptr_t)pData, Size);
+
+  huart->Instance->CR3 |= USART_CR3_DMAR;
+
+  return HAL_OK;
+}
+
+/**
+  * @brief      Interrupt of a UART, as UART_Receive_IT and UART_Transmit_IT
+  *             of the HAL: the octet received is stored and the reception
+  *             is over once the buffer is full; the next octet is sent, and
+  *             the transmission is over once the last one has left. The
+  *             idle line is left to the user, as in the HAL.
+  * @param      huart: UART handle.
+  */
+void HAL_UART_IRQHandler(UART_HandleTypeDef *huart)
+{
+  USART_TypeDef *uart = huart->Instance;
+
+  if(((uart->SR & USART_SR_RXNE) != 0U) && ((uart->CR1 & USART_CR1_RXNEIE) != 0U)
+     && (huart->RxState == HAL_UART_STATE_BUSY_RX))
+  {
+    *huart->pRxBuffPtr++ = (uint8_t)uart->DR;
+    uart->SR &= ~USART_SR_RXNE;
+    if(--huart->RxXferCount == 0U)
+    {
+      uart->CR1 &= ~(USART_CR1_RXNEIE | USART_CR1_PEIE);
+      uart->CR3 &= ~USART_CR3_EIE;
+      huart->RxState = HAL_UART_STATE_READY;
+    }
+  }
+
+  if(((uart->SR & USART_SR_TXE) != 0U) && ((uart->CR1 & USART_CR1_TXEIE) != 0U)
+     && (huart->gState == HAL_UART_STATE_BUSY_TX))
+  {
+    uart->DR = *huart->pTxBuffPtr++;
+    uart->SR &= ~(USART_SR_TXE | USART_SR_TC);
+    if(--huart->TxXferCount == 0U)
+    {
+      uart->CR1 &= ~USART_CR1_TXEIE;
+      uart->CR1 |= USART_CR1_TCIE;
+    }
+  }
+
+  if(((uart->SR & USART_SR_TC) != 0U) && ((uart->CR1 & USART_CR1_TCIE) != 0U))
+  {
+    uart->CR1 &= ~USART_CR1_TCIE;
+    huart->gState = HAL_UART_STATE_READY;
+  }
+}
+
+/**
+  * @brief      Set or clear a pin.
+  * @param      GPIOx: the port.
+  * @param      GPIO_Pin: the pin.
+  * @param      PinState: GPIO_PIN_SET or GPIO_PIN_RESET.
+  */
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+  if(PinState != GPIO_PIN_RESET)
+  {
+    GPIOx->ODR |= GPIO_Pin;
+  }
+  else
+  {
+    GPIOx->ODR &= ~(uint32_t)GPIO_Pin;
+  }
+}
+
+/**
+  * @brief      Toggle a pin.
+  * @param      GPIOx: the port.
+  * @param      GPIO_Pin: the pin.
+  */
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+  GPIOx->ODR ^= GPIO_Pin;
+}
+
+/**
+  * @brief      Set the priority of an interrupt line.
+  * @param      IRQn: the line.
+  * @param      PreemptPriority: the priority.
+  * @param      SubPriority: not used, no group of priorities.
+  */
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority)
+{
+  (void)SubPriority;
+  HAL_Mock_NVIC[IRQn].Priority = PreemptPriority;
+}
+
+/**
+  * @brief      Enable an interrupt line.
+  * @param      IRQn: the line.
+  */
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+  HAL_Mock_NVIC[IRQn].Enabled = 1;
+}
+
+/**
+  * @brief      Disable an interrupt line.
+  * @param      IRQn: the line.
+  */
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+  HAL_Mock_NVIC[IRQn].Enabled = 0;
+}
+/**
+  * @}
+  */
+
+/** @addtogroup HAL_Mock_Exported_Functions_Group2
+  * @{
+  */
+
+/**
+  * @brief      Reset all the peripherals and the interrupt lines, the
+  *             handlers set are kept.
+  */
+void HAL_Mock_Reset(void)
+{
+  uint16_t i;
+
+  memset(&HAL_Mock_USART2, 0, sizeof(HAL_Mock_USART2));
+  HAL_Mock_USART2.SR = USART_SR_TXE | USART_SR_TC;
+  memset(&HAL_Mock_USART3, 0, sizeof(HAL_Mock_USART3));
+  HAL_Mock_USART3.SR = USART_SR_TXE | USART_SR_TC;
+  memset(&HAL_Mock_DMA1_Stream1, 0, sizeof(HAL_Mock_DMA1_Stream1));
+  memset(&HAL_Mock_DMA1_Stream3, 0, sizeof(HAL_Mock_DMA1_Stream3));
+  memset(&HAL_Mock_GPIOD, 0, sizeof(HAL_Mock_GPIOD));
+  memset(&HAL_Mock_RCC, 0, sizeof(HAL_Mock_RCC));
+  memset(&HAL_Mock_CoreDebug, 0, sizeof(HAL_Mock_CoreDebug));
+  memset(&HAL_Mock_DWT, 0, sizeof(HAL_Mock_DWT));
+  for(i=0; i<HAL_MOCK_IRQn_NB; i++)
+  {
+    HAL_Mock_NVIC[i].Priority = 0;
+    HAL_Mock_NVIC[i].Enabled = 0;
+  }
+  HAL_Mock_CharTime = 0;
+}
+
+/**
+  * @brief      Set the time of a character on the line, spent by
+  *             ::HAL_Mock_UART_Receive before each octet and by
+  *             ::HAL_Mock_UART_Idle before the idle line.
+  * @param      us: time of a character in us, 0 for none.
+  */
+void HAL_Mock_SetCharTime(uint32_t us)
+{
+  HAL_Mock_CharTime = us;
+}
+
+/**
+  * @brief      Set the routine called when an interrupt line fires, the
+  *             IRQHandler of the vector table.
+  * @param      IRQn: the line.
+  * @param      handler: the routine, NULL for none.
+  */
+void HAL_Mock_SetIRQHandler(IRQn_Type IRQn, HAL_Mock_IRQHandler_t handler)
+{
+  HAL_Mock_NVIC[IRQn].Handler = handler;
+}
+
+/**
+  * @brief      Octets sent by the TP-UART. With the reception enabled, each
+  *             is written into memory by the reception stream if it runs,
+  *             else lands in DR and raises RXNE; an octet not read before
+  *             the next one is lost, as on an overrun. Each octet lands a
+  *             character after the previous one, see ::HAL_Mock_SetCharTime.
+  * @param      uart: the UART receiving.
+  * @param      data: the octets.
+  * @param      size: number of octets.
+  * @retval     Number of octets taken by the UART.
+  */
+uint16_t HAL_Mock_UART_Receive(USART_TypeDef *uart, const uint8_t *data, uint16_t size)
+{
+  DMA_Stream_TypeDef *stream = HAL_Mock_UARTStream(uart, DMA_PERIPH_TO_MEMORY);
+  uint64_t start = HAL_Mock_Now();
+  uint16_t i;
+
+  if((uart->CR1 & (USART_CR1_UE | USART_CR1_RE)) != (USART_CR1_UE | USART_CR1_RE))
+  {
+    return 0;
+  }
+
+  for(i=0; i<size; i++)
+  {
+    /* On a fixed schedule, the time of the handlers is not added up */
+    HAL_Mock_WaitUntil(start + (uint64_t)(i + 1U) * HAL_Mock_CharTime * 1000U);
+    uart->DR = data[i];
+    if((stream != NULL) && ((uart->CR3 & USART_CR3_DMAR) != 0U) && (stream->NDTR != 0U)
+       && ((stream->CR & (DMA_SxCR_EN | DMA_SxCR_DIR)) == (DMA_SxCR_EN | DMA_PERIPH_TO_MEMORY)))
+    {
+      ((uint8_t *)stream->M0AR)[stream->Reload - stream->NDTR] = data[i];
+      stream->NDTR--;
+      HAL_Mock_StreamEvent(stream);
+    }
+    else
+    {
+      uart->SR |= USART_SR_RXNE;
+      HAL_Mock_UARTEvent(uart);
+    }
+  }
+
+  return size;
+}
+
+/**
+  * @brief      The TP-UART stops talking: a frame of idle, the IDLE flag set
+  *             a character later.
+  * @param      uart: the UART receiving.
+  */
+void HAL_Mock_UART_Idle(USART_TypeDef *uart)
+{
+  HAL_Mock_WaitUntil(HAL_Mock_Now() + (uint64_t)HAL_Mock_CharTime * 1000U);
+  uart->SR |= USART_SR_IDLE;
+  HAL_Mock_UARTEvent(uart);
+}
+
+/**
+  * @brief      The UART sends the octets of its transmission stream while it
+  *             is enabled, else the octets written into DR by its interrupt
+  *             while TXE is enabled. Once the last one has left, TC fires.
+  * @param      uart: the UART sending.
+  * @param      data: buffer for the octets sent.
+  * @param      size: most octets to send.
+  * @retval     Number of octets sent.
+  */
+uint16_t HAL_Mock_UART_Transmit(USART_TypeDef *uart, uint8_t *data, uint16_t size)
+{
+  DMA_Stream_TypeDef *stream = HAL_Mock_UARTStream(uart, DMA_MEMORY_TO_PERIPH);
+  uint16_t n = 0;
+
+  while((stream != NULL) && (n < size) && (stream->NDTR != 0U)
+        && ((stream->CR & (DMA_SxCR_EN | DMA_SxCR_DIR)) == (DMA_SxCR_EN | DMA_MEMORY_TO_PERIPH))
+        && ((uart->CR1 & (USART_CR1_UE | USART_CR1_TE)) == (USART_CR1_UE | USART_CR1_TE))
+        && ((uart->CR3 & USART_CR3_DMAT) != 0U))
+  {
+    data[n] = ((const uint8_t *)stream->M0AR)[stream->Reload - stream->NDTR];
+    uart->DR = data[n];
+    stream->NDTR--;
+    n++;
+    HAL_Mock_StreamEvent(stream);
+    if((stream->CR & DMA_SxCR_EN) == 0U)
+    {
+      /** The last octet leaves the shift register. */
+      uart->SR |= USART_SR_TC;
+      HAL_Mock_UARTEvent(uart);
+    }
+  }
+
+  while((n < size) && ((uart->CR1 & (USART_CR1_UE | USART_CR1_TE)) == (USART_CR1_UE | USART_CR1_TE))
+        && ((uart->CR1 & USART_CR1_TXEIE) != 0U))
+  {
+    uart->DR = HAL_MOCK_DR_EMPTY;
+    uart->SR |= USART_SR_TXE;
+    HAL_Mock_UARTEvent(uart);
+    if(uart->DR == HAL_MOCK_DR_EMPTY)
+    {
+      break;
+    }
+    data[n] = (uint8_t)uart->DR;
+    n++;
+    /** The octet leaves the shift register, DR is empty again. */
+    uart->SR |= USART_SR_TXE;
+    if((uart->CR1 & USART_CR1_TXEIE) == 0U)
+    {
+      uart->SR |= USART_SR_TC;
+      HAL_Mock_UARTEvent(uart);
+    }
+  }
+
+  return n;
+}
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/** @addtogroup HAL_Mock_Private_Functions
+  * @{
+  */
+
+/**
+  * @brief      Call the handler of an interrupt line, if it is enabled.
+  * @param      IRQn: the line.
+  */
+static void HAL_Mock_Fire(IRQn_Type IRQn)
+{
+  if((HAL_Mock_NVIC[IRQn].Enabled != 0U) && (HAL_Mock_NVIC[IRQn].Handler != NULL))
+  {
+    HAL_Mock_NVIC[IRQn].Handler();
+  }
+}
+
+/**
+  * @brief      Time of the host.
+  * @retval     ns of CLOCK_MONOTONIC.
+  */
+static uint64_t HAL_Mock_Now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000U + (uint64_t)ts.tv_nsec;
+}
+
+/**
+  * @brief      Spend the time of the line, spinning as the hardware would
+  *             while the task playing it keeps the CPU.
+  * @param      ns: time to wait for, see ::HAL_Mock_Now.
+  */
+static void HAL_Mock_WaitUntil(uint64_t ns)
+{
+  while(HAL_Mock_Now() < ns)
+  {
+  }
+}
+
+/**
+  * @brief      Stream of a UART.
+  * @param      uart: the UART.
+  * @param      direction: DMA_PERIPH_TO_MEMORY to receive,
+  *             DMA_MEMORY_TO_PERIPH to send.
+  * @retval     The stream, NULL if the UART has none.
+  */
+static DMA_Stream_TypeDef *HAL_Mock_UARTStream(USART_TypeDef *uart, uint32_t direction)
+{
+  if(uart != USART3)
+  {
+    return NULL;
+  }
+
+  return (direction == DMA_PERIPH_TO_MEMORY) ? DMA1_Stream1 : DMA1_Stream3;
+}
+
+/**
+  * @brief      Interrupt line of a stream.
+  * @param      stream: the stream.
+  * @retval     Its line.
+  */
+static IRQn_Type HAL_Mock_StreamIRQn(DMA_Stream_TypeDef *stream)
+{
+  return (stream == DMA1_Stream1) ? DMA1_Stream1_IRQn : DMA1_Stream3_IRQn;
+}
+
+/**
+  * @brief      A stream has moved an octet: raise the half transfer or the
+  *             transfer complete flag, reload or stop the stream, fire its
+  *             interrupt if enabled.
+  * @param      stream: the stream.
+  */
+static void HAL_Mock_StreamEvent(DMA_Stream_TypeDef *stream)
+{
+  uint32_t flags = 0;
+
+  if(stream->NDTR == 0U)
+  {
+    flags = DMA_FLAG_TCIF0_4;
+    if((stream->CR & DMA_SxCR_CIRC) != 0U)
+    {
+      stream->NDTR = stream->Reload;
+    }
+    else
+    {
+      stream->CR &= ~DMA_SxCR_EN;
+    }
+  }
+  else if(stream->NDTR == stream->Reload / 2U)
+  {
+    flags = DMA_FLAG_HTIF0_4;
+  }
+  stream->ISR |= flags;
+
+  if(((flags == DMA_FLAG_HTIF0_4) && ((stream->CR & DMA_SxCR_HTIE) != 0U))
+     || ((flags == DMA_FLAG_TCIF0_4) && ((stream->CR & DMA_SxCR_TCIE) != 0U)))
+  {
+    HAL_Mock_Fire(HAL_Mock_StreamIRQn(stream));
+  }
+}
+
+/**
+  * @brief      Fire the interrupt of a UART if one of its flags is enabled.
+  * @param      uart: the UART.
+  */
+static void HAL_Mock_UARTEvent(USART_TypeDef *uart)
+{
+  if((((uart->SR & USART_SR_IDLE) != 0U) && ((uart->CR1 & USART_CR1_IDLEIE) != 0U))
+     || (((uart->SR & USART_SR_RXNE) != 0U) && ((uart->CR1 & USART_CR1_RXNEIE) != 0U))
+     || (((uart->SR & USART_SR_TXE) != 0U) && ((uart->CR1 & USART_CR1_TXEIE) != 0U))
+     || (((uart->SR & USART_SR_TC) != 0U) && ((uart->CR1 & USART_CR1_TCIE) != 0U)))
+  {
+    HAL_Mock_Fire((uart == USART2) ? USART2_IRQn : USART3_IRQn);
+  }
+}
+
+/**
+  * @brief      Program and enable a stream with its interrupts.
+  * @param      hdma: DMA handle.
+  * @param      src: address read.
+  * @param      dst: address written.
+  * @param      size: number of octets.
+  */
+static void HAL_Mock_DMA_Start_IT(DMA_HandleTypeDef *hdma, uintptr_t src, uintptr_t dst, uint16_t size)
+{
+  DMA_Stream_TypeDef *stream = hdma->Instance;
+
+  hdma->State = HAL_DMA_STATE_BUSY;
+  stream->CR &= ~DMA_SxCR_EN;
+  stream->NDTR = size;
+  stream->Reload = size;
+  if((stream->CR & DMA_SxCR_DIR) == DMA_MEMORY_TO_PERIPH)
+  {
+    stream->PAR = dst;
+    stream->M0AR = src;
+  }
+  else
+  {
+    stream->PAR = src;
+    stream->M0AR = dst;
+  }
+  stream->ISR = 0;
+  stream->CR |= DMA_SxCR_TCIE | DMA_SxCR_HTIE | DMA_SxCR_TEIE;
+  stream->CR |= DMA_SxCR_EN;
+}
+
+/**
+  * @brief      End of the transmission stream: the UART interrupt tells when
+  *             the last octet is sent.
+  * @param      hdma: DMA handle of the transmission.
+  */
+static void UART_DMATransmitCplt(DMA_HandleTypeDef *hdma)
+{
+  UART_HandleTypeDef *huart = (UART_HandleTypeDef *)hdma->Parent;
+
+  huart->TxXferCount = 0;
+  huart->Instance->CR3 &= ~USART_CR3_DMAT;
+  huart->Instance->CR1 |= USART_CR1_TCIE;
+}
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
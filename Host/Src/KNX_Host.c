@@ -0,0 +1,278 @@
+/**
+  ******************************************************************************
+  * @file       KNX_Host.c
+  * @author     MA Dingjie
+  * @version    V1.0.0
+  * @date       17-October-2016
+  * @brief      Harness of the host programs.
+  *             This file provides functions to manage following functionalities:
+  *              + Start of the scheduler, options and checks of a program
+  *              + Devices on the simulated bus
+  *              + Run time and idle time
+  *              + Hooks of the FreeRTOS POSIX port
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "KNX_Host.h"
+#include "KNX_Aux.h"
+#include "KNX_Addr.h"
+#include "cola.h"
+#include "debug.h"
+
+/** @defgroup KNX_Host KNX Host
+  * @brief    Each program has a main task, run by ::KNX_Host_Run once the
+  *           scheduler has started, which ends the program with
+  *           ::KNX_Host_Exit. The options are given as \c name=value on the
+  *           command line.
+  * @{
+  */
+
+/* Private variables ---------------------------------------------------------*/
+/** @defgroup KNX_Host_Private_Variables KNX Host Private Variables
+  * @{
+  */
+/** \brief Command line of the program. */
+static int    KNX_HOST_ARGC;
+static char **KNX_HOST_ARGV;
+/** \brief Checks done and failed. */
+static uint32_t KNX_HOST_CHECKS, KNX_HOST_FAILURES;
+/**
+  * @}
+  */
+
+/* Exported functions --------------------------------------------------------*/
+/** @defgroup KNX_Host_Exported_Functions KNX Host Exported Functions
+  * @{
+  */
+
+/** @defgroup KNX_Host_Exported_Functions_Group1 Program Functions
+  * @{
+  */
+
+/**
+  * @brief      Take the command line, for a program whose threads are not
+  *             FreeRTOS tasks. ::KNX_Host_Run does it.
+  * @param      argc: number of arguments of the command line.
+  * @param      argv: arguments of the command line.
+  */
+void KNX_Host_Init(int argc, char **argv)
+{
+  KNX_HOST_ARGC = argc;
+  KNX_HOST_ARGV = argv;
+  setvbuf(stdout, NULL, _IOLBF, 0);
+
+  /** No DebugTask: the debug messages fill ::colaDebug, then are dropped. */
+  cola_init(&colaDebug);
+}
+
+/**
+  * @brief      Start the scheduler with the main task of the program. Never
+  *             returns.
+  * @param      main: main task of the program.
+  * @param      argc: number of arguments of the command line.
+  * @param      argv: arguments of the command line.
+  */
+void KNX_Host_Run(TaskFunction_t main, int argc, char **argv)
+{
+  KNX_Host_Init(argc, argv);
+
+  if(xTaskCreate(main, "Host", KNX_HOST_TASK_STACK, NULL, KNX_HOST_TASK_PRIORITY, NULL) != pdPASS)
+  {
+    fprintf(stderr, "***ERROR*** main task failed to start\n");
+    exit(EXIT_FAILURE);
+  }
+  vTaskStartScheduler();
+
+  /** Only reached if the scheduler fails to start. */
+  exit(EXIT_FAILURE);
+}
+
+/**
+  * @brief      Get an option of the command line, given as \c name=value.
+  * @param      name: the option.
+  * @param      value: value if the option is not given.
+  * @retval     The value of the option.
+  */
+uint32_t KNX_Host_GetOption(const char *name, uint32_t value)
+{
+  size_t length = strlen(name);
+  int i;
+
+  for(i=1; i<KNX_HOST_ARGC; i++)
+  {
+    if((strncmp(KNX_HOST_ARGV[i], name, length) == 0) && (KNX_HOST_ARGV[i][length] == '='))
+    {
+      return (uint32_t)strtoul(&KNX_HOST_ARGV[i][length + 1U], NULL, 0);
+    }
+  }
+
+  return value;
+}
+
+/**
+  * @brief      Count a check of a test, print it if it failed. Use
+  *             ::KNX_HOST_CHECK.
+  * @param      ok: TRUE if the check passed.
+  * @param      cond: text of the condition.
+  * @param      file: source file of the check.
+  * @param      line: line of the check.
+  */
+void KNX_Host_Check(uint8_t ok, const char *cond, const char *file, int line)
+{
+  KNX_HOST_CHECKS++;
+  if(ok != TRUE)
+  {
+    KNX_HOST_FAILURES++;
+    fprintf(stderr, "%s:%d: check failed: %s\n", file, line, cond);
+  }
+}
+
+/**
+  * @brief      Number of checks failed so far.
+  * @retval     The number of failures.
+  */
+uint32_t KNX_Host_GetFailures(void)
+{
+  return KNX_HOST_FAILURES;
+}
+
+/**
+  * @brief      End the program, with a failure if a check failed. The
+  *             counts of checks go to stderr, stdout is left to the results.
+  */
+void KNX_Host_Exit(void)
+{
+  if(KNX_HOST_CHECKS != 0U)
+  {
+    fprintf(stderr, "%s: %lu checks, %lu failed\n", KNX_HOST_ARGV[0],
+           (unsigned long)KNX_HOST_CHECKS, (unsigned long)KNX_HOST_FAILURES);
+  }
+  fflush(stdout);
+  exit((KNX_HOST_FAILURES == 0U) ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+/**
+  * @}
+  */
+
+/** @defgroup KNX_Host_Exported_Functions_Group2 Node Functions
+  * @{
+  */
+
+#if KNX_PH_TPUART_BACKEND == KNX_PH_TPUART_EMU
+/**
+  * @brief      Start a device: attach its TP-UART to the bus, then
+  *             initialize its line and its data link layer.
+  * @param      bus: the bus, initialized, NULL for a TP-UART alone whose
+  *             frames are all acknowledged.
+  * @param      node: the device, zeroed before the first call.
+  * @param      individual: individual address of the device.
+  * @retval     Error code, See \ref DL_Error_Code.
+  */
+uint8_t KNX_Host_InitNode(KNX_Bus_t *bus, KNX_Host_Node_t *node, uint16_t individual)
+{
+  if((bus != NULL) && (KNX_Bus_Attach(bus, &node->Ph.TPUart) != BUS_ERROR_NONE))
+  {
+    return DL_ERROR_INIT;
+  }
+  if(KNX_Ph_Init(&node->Ph) != PH_ERROR_NONE)
+  {
+    return DL_ERROR_INIT;
+  }
+
+  node->DL.Ph = &node->Ph;
+  KNX_Addr_Init(&node->DL.Addr, individual);
+
+  return KNX_DL_Init(&node->DL);
+}
+#endif /* KNX_PH_TPUART_BACKEND == KNX_PH_TPUART_EMU */
+
+/**
+  * @brief      Build a standard frame as ::KNX_DL_Data_req does, check octet
+  *             included.
+  * @param      frame: buffer of ::FRAME_SIZE octets for the frame.
+  * @param      priority: priority field, 0 to 3.
+  * @param      sa: source address.
+  * @param      da: destination address.
+  * @param      group: TRUE for a group address.
+  * @param      lsdu: octets of the LSDU.
+  * @param      lg: number of octets of \b lsdu, at most ::FRAME_SIZE - 8.
+  * @retval     Length of the frame.
+  */
+uint16_t KNX_Host_BuildFrame(uint8_t *frame, uint8_t priority, uint16_t sa, uint16_t da, uint8_t group, const uint8_t *lsdu, uint8_t lg)
+{
+  frame[0] = (uint8_t)(FRAME_CTRL_STANDARD | FRAME_CTRL_NOT_REPEATED | BIT4 | ((priority & 0x03U) << 2));
+  frame[1] = (uint8_t)(sa >> 8);
+  frame[2] = (uint8_t)sa;
+  frame[3] = (uint8_t)(da >> 8);
+  frame[4] = (uint8_t)da;
+  frame[5] = (uint8_t)(((group == TRUE) ? FRAME_AT_GROUP : 0U) | (lg & 0x0FU));
+  frame[6] = (lg != 0U) ? lsdu[0] : 0U;
+  memcpy(&frame[7], lsdu, lg);
+  frame[7U + lg] = (uint8_t)~KNX_VerticalParity(frame, (uint16_t)(7U + lg));
+
+  return (uint16_t)(FRAME_OVERHEAD + lg);
+}
+/**
+  * @}
+  */
+
+/** @defgroup KNX_Host_Exported_Functions_Group3 Measure Functions
+  * @{
+  */
+
+/**
+  * @brief      Counter of the run time statistics of FreeRTOS.
+  * @retval     Time of the host in us, wraps around every 71 minutes.
+  */
+uint32_t KNX_Host_GetRunTime(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)((uint64_t)ts.tv_sec * 1000000U + (uint64_t)ts.tv_nsec / 1000U);
+}
+
+/**
+  * @brief      Time the scheduler had no task to run.
+  * @retval     Time in us since the start of the scheduler.
+  */
+uint32_t KNX_Host_GetIdleTime(void)
+{
+  return (uint32_t)ulTaskGetIdleRunTimeCounter();
+}
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/* FreeRTOS hooks ------------------------------------------------------------*/
+/**
+  * @brief      Tick hook of FreeRTOS, the SysTick interrupt of the host.
+  */
+void vApplicationTickHook(void)
+{
+  KNX_systick_isr();
+}
+
+/**
+  * @brief      Failed configASSERT of FreeRTOS.
+  * @param      file: source file.
+  * @param      line: line of the assert.
+  */
+void vAssertCalled(const char *file, unsigned long line)
+{
+  fprintf(stderr, "***ERROR*** assert failed at %s:%lu\n", file, line);
+  abort();
+}
+
+/**
+  * @}
+  */
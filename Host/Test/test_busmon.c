@@ -0,0 +1,402 @@
+/**
+  ******************************************************************************
+  * @file       test_busmon.c
+  * @author     MA Dingjie
+  * @version    V1.0.0
+  * @date       17-October-2016
+  * @brief      Test of the bus monitor mode on a saturated line: every frame
+  *             of the bus reaches the capture ring, none is dropped.
+  *
+  *             Devices send back to back to the next one, which acknowledges,
+  *             so a frame is always waiting for the line. A line alone is
+  *             attached to the bus and put in bus monitor mode with
+  *             ::KNX_Ph_ActivateBusmon; the main task reads its records with
+  *             ::KNX_Ph_Monitor_rec every \c period ms, as a task logging
+  *             the capture would. The LSDU of a frame starts with a sequence
+  *             number of its sender, so a frame missing from the capture is
+  *             seen. On a saturated line the devices with the highest
+  *             addresses lose the arbitrations and some of their requests
+  *             fail, as on a real line, so only the frames acknowledged are
+  *             sure to have been on the bus. Checked:
+  *              + the line was saturated: the frames of the bus, each with
+  *                its ack and the idle time before the next one, fill
+  *                between ::TEST_SATURATED and 1000 permille of the time of
+  *                the bus while the devices send
+  *              + at least ::TEST_CONFIRMED permille of the requests are
+  *                confirmed, the losers of the arbitrations get their turn
+  *              + as many records as frames on the bus, repetitions
+  *                included, each a whole frame with its check octet
+  *              + every frame acknowledged is in the capture, the sequence
+  *                numbers of a device increase, a number is seen again only
+  *                in a repetition
+  *              + the timestamps increase
+  *              + no overrun of the TP-UART, of the RX channel or of the
+  *                capture ring, no frame dropped by the assembly
+  *
+  *             The options, as \c name=value:
+  *              + \c nodes: devices sending, 2 to ::KNX_BUS_MAX_NODES - 1
+  *              + \c seconds: time of the traffic
+  *              + \c lg, \c lg_max: length of the LSDU, drawn between both,
+  *                at least 2 for the sequence number
+  *              + \c period: ms between two reads of the capture
+  *              + \c crc: 1 to receive the frames with their CRC
+  *              + \c seed: seed of the draws
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include "KNX_Host.h"
+#include "KNX_Aux.h"
+#include "KNX_Frame.h"
+
+/* Private constants ---------------------------------------------------------*/
+/** \brief Individual address of the first device, the next ones follow. */
+#define TEST_ADDRESS            ((uint16_t)0x1101U)
+/** \brief Priority of the tasks receiving, above ::KNX_DL_TxTask. */
+#define TEST_RX_PRIORITY        (tskIDLE_PRIORITY + 3)
+/** \brief Least occupation of the line in permille for a saturated line. */
+#define TEST_SATURATED          ((uint32_t)950U)
+/** \brief Least part of the requests confirmed, in permille. */
+#define TEST_CONFIRMED          ((uint32_t)900U)
+/** \brief Sequence numbers of a device, it stops sending after the last. */
+#define TEST_SEQUENCES          ((uint32_t)65536U)
+
+/* Private types -------------------------------------------------------------*/
+/**
+  * @brief  Options of the test.
+  */
+typedef struct
+{
+  uint32_t Nodes;
+  uint32_t Seconds;
+  uint32_t LgMin;
+  uint32_t LgMax;
+  uint32_t Period;
+  uint32_t Crc;
+  uint32_t Seed;
+} Test_Options_t;
+
+/* Private variables ---------------------------------------------------------*/
+static Test_Options_t   options;
+static KNX_Bus_t        bus;
+static KNX_Host_Node_t  nodes[KNX_BUS_MAX_NODES - 1];
+static PH_Handle_t      monitor;
+static KNX_Ph_Capture_t capture;
+static TaskHandle_t     mainTask;
+static volatile uint8_t sending;
+static uint32_t         sent[KNX_BUS_MAX_NODES - 1];
+/** \brief Bit of each sequence number acknowledged, set by its sender. */
+static uint8_t          acked[KNX_BUS_MAX_NODES - 1][TEST_SEQUENCES / 8U];
+/** \brief Bit of each sequence number in the capture. */
+static uint8_t          captured[KNX_BUS_MAX_NODES - 1][TEST_SEQUENCES / 8U];
+/** \brief Last sequence number captured of each device, plus 1. */
+static uint32_t         next[KNX_BUS_MAX_NODES - 1];
+
+/** \brief Counts of the records read. */
+static struct
+{
+  uint32_t Records;
+  uint32_t Repeats;
+  uint32_t Bad;                 /*!< Not a whole frame, or a bad flag         */
+  uint32_t Disorders;           /*!< Sequence numbers not increasing          */
+  uint32_t Backwards;           /*!< Timestamps lower than the previous one   */
+  uint32_t LastTimestamp;
+} seen;
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief      Next number of a xorshift generator.
+  * @param      state: state of the generator, not 0.
+  * @retval     The number.
+  */
+static uint32_t Test_Random(uint32_t *state)
+{
+  uint32_t x = *state;
+
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+
+  return x;
+}
+
+/**
+  * @brief      Task sending the frames of a device while ::sending, until
+  *             its last sequence number.
+  * @param      argument: index of the device.
+  */
+static void Test_SendTask(void *argument)
+{
+  uint32_t index = (uint32_t)(uintptr_t)argument;
+  uint32_t state = options.Seed * 2654435761U + index + 1U;
+  uint8_t lsdu[FRAME_SIZE - FRAME_OVERHEAD];
+  uint8_t lg, i, ret, late = FALSE;
+
+  while((sending == TRUE) && (sent[index] < TEST_SEQUENCES))
+  {
+    lg = (uint8_t)(options.LgMin + Test_Random(&state) % (options.LgMax - options.LgMin + 1U));
+    lsdu[0] = (uint8_t)(sent[index] >> 8);
+    lsdu[1] = (uint8_t)sent[index];
+    for(i=2; i<lg; i++)
+    {
+      lsdu[i] = (uint8_t)Test_Random(&state);
+    }
+    ret = KNX_DL_Data_req(&nodes[index].DL, 1, FALSE, (uint16_t)(TEST_ADDRESS + (index + 1U) % options.Nodes),
+                          (uint8_t)(Test_Random(&state) & 3U), lsdu, lg);
+    if(ret == DL_ERROR_NONE)
+    {
+      /** After a timeout the frame stays pending in the TP-UART, the
+          confirmation may be its own: the number is not sure. */
+      if(late == FALSE)
+      {
+        acked[index][sent[index] / 8U] |= (uint8_t)(1U << (sent[index] % 8U));
+      }
+      late = FALSE;
+    }
+    else
+    {
+      /** Lost the arbitrations, or left pending by the TP-UART: the number
+          is used anyway and the device lets the others send. */
+      if(ret == DL_ERROR_TIMEOUT)
+      {
+        late = TRUE;
+      }
+      vTaskDelay(1);
+    }
+    sent[index]++;
+  }
+
+  xTaskNotifyGive(mainTask);
+  vTaskDelete(NULL);
+}
+
+/**
+  * @brief      Task receiving the frames of a device, so it acknowledges.
+  * @param      argument: index of the device.
+  */
+static void Test_ReceiveTask(void *argument)
+{
+  KNX_Host_Node_t *node = &nodes[(uint32_t)(uintptr_t)argument];
+  KNX_Frame_t *frame;
+
+  for(;;)
+  {
+    if(KNX_DL_Frame_rec(&node->DL, &frame) == DL_ERROR_NONE)
+    {
+      KNX_Frame_Release(frame);
+    }
+  }
+}
+
+/**
+  * @brief      Check a record of the capture and count it.
+  * @param      record: the record.
+  */
+static void Test_Record(KNX_Ph_Capture_Record_t *record)
+{
+  uint16_t sa, length;
+  uint32_t index, seq;
+
+  seen.Records++;
+  if((int32_t)(record->Timestamp - seen.LastTimestamp) < 0)
+  {
+    seen.Backwards++;
+  }
+  seen.LastTimestamp = record->Timestamp;
+
+  length = FRAME_OVERHEAD + (record->Datas[FRAME_LENGTH_OCTET] & 0x0FU);
+  if((record->Flags != PH_CAPTURE_FRAME) || (record->Length != length) || (length < FRAME_OVERHEAD + 2U)
+     || (record->Datas[length - 1U] != (uint8_t)~KNX_VerticalParity(record->Datas, (uint16_t)(length - 1U))))
+  {
+    seen.Bad++;
+    return;
+  }
+  sa = (uint16_t)((record->Datas[1] << 8) | record->Datas[2]);
+  index = (uint32_t)(uint16_t)(sa - TEST_ADDRESS);
+  if(index >= options.Nodes)
+  {
+    seen.Bad++;
+    return;
+  }
+  seq = ((uint32_t)record->Datas[7] << 8) | record->Datas[8];
+  if((record->Datas[0] & FRAME_CTRL_NOT_REPEATED) == 0U)
+  {
+    seen.Repeats++;
+  }
+  if((seq + 1U < next[index])
+     || ((seq + 1U == next[index]) && ((record->Datas[0] & FRAME_CTRL_NOT_REPEATED) != 0U)))
+  {
+    /** Only a repetition may carry the last number again. */
+    seen.Disorders++;
+  }
+  next[index] = seq + 1U;
+  captured[index][seq / 8U] |= (uint8_t)(1U << (seq % 8U));
+}
+
+/**
+  * @brief      Read the records of the capture until none is left.
+  */
+static void Test_Drain(void)
+{
+  KNX_Ph_Capture_Record_t record;
+
+  while(KNX_Ph_Monitor_rec(&monitor, &record, 1) == PH_ERROR_NONE)
+  {
+    Test_Record(&record);
+  }
+}
+
+/**
+  * @brief      Main task of the test, the reader of the capture.
+  * @param      argument: not used.
+  */
+static void Test_Task(void *argument)
+{
+  KNX_Bus_Stats_t start, stop, last;
+  KNX_Bus_NodeStats_t node;
+  PH_Stats_t stats;
+  TickType_t end;
+  uint32_t i, seq, frames, total = 0, confirmed = 0, missing = 0, occupation, elapsed;
+
+  (void)argument;
+  mainTask = xTaskGetCurrentTaskHandle();
+
+  options.Nodes = KNX_Host_GetOption("nodes", 4);
+  options.Seconds = KNX_Host_GetOption("seconds", 2);
+  options.LgMin = KNX_Host_GetOption("lg", 2);
+  options.LgMax = KNX_Host_GetOption("lg_max", FRAME_SIZE - FRAME_OVERHEAD);
+  options.Period = KNX_Host_GetOption("period", 100);
+  options.Crc = KNX_Host_GetOption("crc", 0);
+  options.Seed = KNX_Host_GetOption("seed", 1);
+  KNX_HOST_CHECK((options.Nodes >= 2U) && (options.Nodes <= KNX_BUS_MAX_NODES - 1U));
+  KNX_HOST_CHECK(options.Seconds != 0U);
+  KNX_HOST_CHECK((options.LgMin >= 2U) && (options.LgMin <= options.LgMax)
+                 && (options.LgMax <= FRAME_SIZE - FRAME_OVERHEAD));
+  if(KNX_Host_GetFailures() != 0U)
+  {
+    KNX_Host_Exit();
+  }
+
+  /** The monitor first, it is attached to the bus without a data link. */
+  KNX_Bus_Init(&bus);
+  KNX_HOST_CHECK(KNX_Bus_Attach(&bus, &monitor.TPUart) == BUS_ERROR_NONE);
+  KNX_HOST_CHECK(KNX_Ph_Init(&monitor) == PH_ERROR_NONE);
+  KNX_HOST_CHECK(KNX_Ph_Reset(&monitor) == PH_ERROR_NONE);
+  if(options.Crc != 0U)
+  {
+    KNX_HOST_CHECK(KNX_Ph_ActivateCRC(&monitor) == PH_ERROR_NONE);
+  }
+  KNX_HOST_CHECK(KNX_Ph_ActivateBusmon(&monitor, &capture) == PH_ERROR_NONE);
+  for(i=0; i<options.Nodes; i++)
+  {
+    KNX_HOST_CHECK(KNX_Host_InitNode(&bus, &nodes[i], (uint16_t)(TEST_ADDRESS + i)) == DL_ERROR_NONE);
+  }
+  if(KNX_Host_GetFailures() != 0U)
+  {
+    KNX_Host_Exit();
+  }
+  for(i=0; i<options.Nodes; i++)
+  {
+    xTaskCreate(Test_ReceiveTask, "Test RX", KNX_HOST_TASK_STACK,
+                (void *)(uintptr_t)i, TEST_RX_PRIORITY, NULL);
+  }
+
+  /** Traffic for the time asked, the capture read every period. */
+  KNX_Bus_GetStats(&bus, &start);
+  sending = TRUE;
+  for(i=0; i<options.Nodes; i++)
+  {
+    xTaskCreate(Test_SendTask, "Test TX", KNX_HOST_TASK_STACK,
+                (void *)(uintptr_t)i, KNX_HOST_TASK_PRIORITY, NULL);
+  }
+  end = xTaskGetTickCount() + pdMS_TO_TICKS(options.Seconds * 1000U);
+  while((int32_t)(end - xTaskGetTickCount()) > 0)
+  {
+    vTaskDelay(pdMS_TO_TICKS((options.Period != 0U) ? options.Period : 1U));
+    Test_Drain();
+  }
+  KNX_Bus_GetStats(&bus, &stop);
+  sending = FALSE;
+  for(i=0; i<options.Nodes; i++)
+  {
+    ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+  }
+  /** The last frames and their repetitions, until the bus is quiet. */
+  KNX_Bus_GetStats(&bus, &last);
+  do
+  {
+    frames = last.Frames;
+    vTaskDelay(pdMS_TO_TICKS(200));
+    Test_Drain();
+    KNX_Bus_GetStats(&bus, &last);
+  } while(last.Frames != frames);
+  KNX_Ph_GetStats(&monitor, &stats);
+  KNX_Bus_GetNodeStats(&bus, 0, &node);
+  for(i=0; i<options.Nodes; i++)
+  {
+    total += sent[i];
+    for(seq=0; seq<sent[i]; seq++)
+    {
+      if((acked[i][seq / 8U] & (1U << (seq % 8U))) != 0U)
+      {
+        confirmed++;
+        if((captured[i][seq / 8U] & (1U << (seq % 8U))) == 0U)
+        {
+          missing++;
+        }
+      }
+    }
+  }
+  /** Each frame takes its octets, the ack with the gap before it and the
+      idle time before the next frame, counted by the bus as its time
+      goes. */
+  elapsed = stop.Elapsed - start.Elapsed;
+  occupation = (elapsed != 0U) ? (uint32_t)((uint64_t)(stop.SlotTime - start.SlotTime) * 1000U / elapsed) : 0U;
+
+  printf("{\"test\":\"busmon\",\"nodes\":%lu,\"seconds\":%lu,\"lg\":%lu,\"lg_max\":%lu,"
+         "\"period\":%lu,\"crc\":%lu,\"requests\":%lu,\"confirmed\":%lu,\"bus_frames\":%lu,"
+         "\"records\":%lu,\"repeats\":%lu,\"bad\":%lu,\"missing\":%lu,\"disorders\":%lu,"
+         "\"backwards\":%lu,\"occupation_permille\":%lu,\"max_level\":%lu,"
+         "\"capture_overruns\":%lu,\"rx_overruns\":%lu,\"tpuart_overruns\":%lu}\n",
+         (unsigned long)options.Nodes, (unsigned long)options.Seconds,
+         (unsigned long)options.LgMin, (unsigned long)options.LgMax,
+         (unsigned long)options.Period, (unsigned long)options.Crc,
+         (unsigned long)total, (unsigned long)confirmed, (unsigned long)last.Frames,
+         (unsigned long)seen.Records, (unsigned long)seen.Repeats, (unsigned long)seen.Bad,
+         (unsigned long)missing, (unsigned long)seen.Disorders, (unsigned long)seen.Backwards,
+         (unsigned long)occupation, (unsigned long)capture.MaxLevel, (unsigned long)stats.CaptureOverruns,
+         (unsigned long)KNX_Ph_GetRxOverruns(&monitor), (unsigned long)node.Overruns);
+
+  KNX_HOST_CHECK(seen.Records != 0U);
+  KNX_HOST_CHECK(seen.Records == last.Frames);
+  KNX_HOST_CHECK(stats.Captured == seen.Records);
+  KNX_HOST_CHECK(seen.Bad == 0U);
+  KNX_HOST_CHECK((uint64_t)confirmed * 1000U >= (uint64_t)total * TEST_CONFIRMED);
+  KNX_HOST_CHECK(missing == 0U);
+  KNX_HOST_CHECK(seen.Disorders == 0U);
+  KNX_HOST_CHECK(seen.Backwards == 0U);
+  KNX_HOST_CHECK((occupation >= TEST_SATURATED) && (occupation <= 1000U));
+  KNX_HOST_CHECK(stats.CaptureOverruns == 0U);
+  KNX_HOST_CHECK(KNX_Ph_GetRxOverruns(&monitor) == 0U);
+  KNX_HOST_CHECK(node.Overruns == 0U);
+  KNX_HOST_CHECK(stats.RxFrameTruncated == 0U);
+  KNX_HOST_CHECK(stats.RxFrameCrcErrors == 0U);
+  KNX_HOST_CHECK(stats.RxFrameParityErrors == 0U);
+  KNX_HOST_CHECK(stats.RxFrameNoBuffer == 0U);
+
+  KNX_Host_Exit();
+}
+
+/**
+  * @brief      Entry point.
+  * @param      argc: number of arguments.
+  * @param      argv: options, as \c name=value.
+  * @retval     0 on success.
+  */
+int main(int argc, char **argv)
+{
+  KNX_Host_Run(Test_Task, argc, argv);
+  return 0;
+}
@@ -0,0 +1,311 @@
+/**
+  ******************************************************************************
+  * @file       test_cola.c
+  * @author     MA Dingjie
+  * @version    V1.0.0
+  * @date       17-October-2016
+  * @brief      Stress test of the lock-free cola of cola.c: producers on
+  *             threads of the host, truly concurrent, and a single consumer.
+  *
+  *             Each record carries its producer, its sequence number and
+  *             bytes drawn from both, any value '\n' and 0 included, on
+  *             lengths up to ::COLA_RECORD_MAX. The consumer checks every
+  *             record it takes. The indices of the cola run over 16 bits,
+  *             the runs go through their wrap many times. Phases:
+  *              + limits: longest record, record too long, buffer too small
+  *              + retry: the producers store again a record dropped, no
+  *                record is lost and each producer's come in order
+  *              + full: the consumer pauses, the producers drop the records
+  *                which don't fit; what is taken plus what is dropped is
+  *                what was sent, and the drops are those of ::cola_perdidos
+  *
+  *             The options, as \c name=value:
+  *              + \c producers: threads storing records, 1 to ::TEST_PRODUCERS
+  *              + \c records: records stored by each producer in a phase
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include "KNX_Host.h"
+#include "cola.h"
+
+/* Private constants ---------------------------------------------------------*/
+/** \brief Most producers. */
+#define TEST_PRODUCERS          ((uint32_t)16)
+/** \brief Octets before the bytes of a record: producer and sequence. */
+#define TEST_RECORD_HEADER      ((uint32_t)5)
+/** \brief Longest bytes of most records. */
+#define TEST_RECORD_SHORT       ((uint32_t)200)
+/** \brief Longest bytes of the other records. */
+#define TEST_RECORD_LONG        (COLA_SIZE / 4U)
+/** \brief Records taken between two pauses of the consumer in the full
+  *        phase. */
+#define TEST_PAUSE_EVERY        ((uint32_t)64)
+/** \brief Time in us without any record taken after which a phase stops,
+  *        the cola is stuck. */
+#define TEST_STALL              ((uint32_t)2000000U)
+
+/* Private types -------------------------------------------------------------*/
+/**
+  * @brief  A producer.
+  */
+typedef struct
+{
+  pthread_t Thread;
+  uint8_t   Id;
+  uint8_t   Retry;              /*!< TRUE to store again a record dropped    */
+  uint32_t  Records;            /*!< Records to store                        */
+  uint32_t  Drops;              /*!< Stores which failed, cola full          */
+} Test_Producer_t;
+
+/* Private variables ---------------------------------------------------------*/
+static t_cola          cola;
+static Test_Producer_t producers[TEST_PRODUCERS];
+static volatile uint32_t finished;
+static volatile uint8_t  stop;
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief      Bytes of a record, a function of its producer and sequence.
+  * @param      record: buffer of ::COLA_RECORD_MAX octets.
+  * @param      id: the producer.
+  * @param      seq: sequence number of the record.
+  * @retval     Length of the record.
+  */
+static uint16_t Test_Record(uint8_t *record, uint8_t id, uint32_t seq)
+{
+  uint32_t x = (seq + 1U) * 2654435761U ^ ((uint32_t)id << 24);
+  uint32_t length, i;
+
+  x = (x != 0U) ? x : 1U;
+  x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+  /** One in a hundred takes up to a quarter of the cola. Longer ones would
+    * starve behind the short records of the others, see ::Test_Limits. */
+  length = ((x % 100U) == 0U) ? TEST_RECORD_LONG / 2U + x % (TEST_RECORD_LONG / 2U)
+                              : x % TEST_RECORD_SHORT;
+
+  record[0] = id;
+  record[1] = (uint8_t)seq;
+  record[2] = (uint8_t)(seq >> 8);
+  record[3] = (uint8_t)(seq >> 16);
+  record[4] = (uint8_t)(seq >> 24);
+  for(i=0; i<length; i++)
+  {
+    x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+    record[TEST_RECORD_HEADER + i] = (uint8_t)x;
+  }
+
+  return (uint16_t)(TEST_RECORD_HEADER + length);
+}
+
+/**
+  * @brief      Thread of a producer.
+  * @param      argument: the producer.
+  * @retval     NULL.
+  */
+static void *Test_Produce(void *argument)
+{
+  Test_Producer_t *producer = (Test_Producer_t *)argument;
+  uint8_t record[COLA_RECORD_MAX];
+  uint16_t length;
+  uint32_t seq;
+
+  for(seq=0; (seq < producer->Records) && (stop == FALSE); seq++)
+  {
+    length = Test_Record(record, producer->Id, seq);
+    while(cola_guardar_datos(&cola, record, length) == 0)
+    {
+      producer->Drops++;
+      if((producer->Retry == FALSE) || (stop == TRUE))
+      {
+        break;
+      }
+      sched_yield();
+    }
+  }
+  __atomic_add_fetch(&finished, 1U, __ATOMIC_RELEASE);
+
+  return NULL;
+}
+
+/**
+  * @brief      Run a phase: start the producers and take their records.
+  * @param      count: number of producers.
+  * @param      records: records stored by each.
+  * @param      retry: TRUE if a record dropped is stored again.
+  * @param      pause: TRUE if the consumer pauses now and then.
+  * @param      taken: pointer to store the records taken.
+  * @param      drops: pointer to store the stores which failed.
+  * @retval     Records wrong: bad bytes, out of order, or lost in the retry
+  *             phase, and 1 more if the cola got stuck.
+  */
+static uint32_t Test_Phase(uint32_t count, uint32_t records, uint8_t retry, uint8_t pause,
+                           uint32_t *taken, uint32_t *drops)
+{
+  static uint8_t record[COLA_RECORD_MAX], expected[COLA_RECORD_MAX];
+  int32_t next[TEST_PRODUCERS];
+  struct timespec nap = {0, 200000};
+  uint32_t i, seq, done, progress, bad = 0, total = 0;
+  uint16_t length;
+  int16_t res;
+
+  cola_init(&cola);
+  finished = 0;
+  stop = FALSE;
+  for(i=0; i<count; i++)
+  {
+    producers[i].Id = (uint8_t)i;
+    producers[i].Retry = retry;
+    producers[i].Records = records;
+    producers[i].Drops = 0;
+    next[i] = 0;
+  }
+  for(i=0; i<count; i++)
+  {
+    pthread_create(&producers[i].Thread, NULL, Test_Produce, &producers[i]);
+  }
+
+  /** Take records until all the producers are done and the cola is empty:
+    * the count of the producers done is read before the cola. */
+  progress = KNX_Host_GetRunTime();
+  do
+  {
+    done = __atomic_load_n(&finished, __ATOMIC_ACQUIRE);
+    res = cola_leer(&cola, record, sizeof(record));
+    if(res <= 0)
+    {
+      if(res < 0)
+      {
+        bad++;
+      }
+      if((stop == FALSE) && (KNX_Host_GetRunTime() - progress > TEST_STALL))
+      {
+        stop = TRUE;
+        bad++;
+      }
+      sched_yield();
+      continue;
+    }
+    progress = KNX_Host_GetRunTime();
+
+    total++;
+    seq = record[1] | (record[2] << 8) | (record[3] << 16) | ((uint32_t)record[4] << 24);
+    if(record[0] >= count || (int32_t)seq < next[record[0]] || (retry == TRUE && (int32_t)seq != next[record[0]]))
+    {
+      bad++;
+      continue;
+    }
+    length = Test_Record(expected, record[0], seq);
+    if(length != (uint16_t)res || memcmp(record, expected, length) != 0)
+    {
+      bad++;
+    }
+    next[record[0]] = (int32_t)seq + 1;
+
+    if(pause == TRUE && (total % TEST_PAUSE_EVERY) == 0U)
+    {
+      nanosleep(&nap, NULL);
+    }
+  } while(done != count || res != 0);
+
+  for(i=0; i<count; i++)
+  {
+    pthread_join(producers[i].Thread, NULL);
+  }
+  *drops = 0;
+  for(i=0; i<count; i++)
+  {
+    *drops += producers[i].Drops;
+    if(retry == TRUE && next[i] != (int32_t)records)
+    {
+      bad++;
+    }
+  }
+  *taken = total;
+
+  return bad;
+}
+
+/**
+  * @brief      Limits of a single record, no thread.
+  */
+static void Test_Limits(void)
+{
+  static uint8_t record[COLA_RECORD_MAX + 1U], copy[COLA_RECORD_MAX];
+  uint32_t i;
+
+  for(i=0; i<sizeof(record); i++)
+  {
+    record[i] = (uint8_t)(i * 7U);
+  }
+
+  /** The longest record fills the empty cola, nothing more fits. */
+  cola_init(&cola);
+  KNX_HOST_CHECK(cola_guardar_datos(&cola, record, 0) == 0);
+  KNX_HOST_CHECK(cola_guardar_datos(&cola, record, COLA_RECORD_MAX + 1U) == 0);
+  KNX_HOST_CHECK(cola_guardar_datos(&cola, record, COLA_RECORD_MAX) == 1);
+  KNX_HOST_CHECK(cola_guardar_datos(&cola, record, 1) == 0);
+  KNX_HOST_CHECK(cola_perdidos(&cola) == 1U);
+  KNX_HOST_CHECK(cola_peek(&cola) == COLA_RECORD_MAX);
+  KNX_HOST_CHECK(cola_leer(&cola, copy, sizeof(copy)) == (int16_t)COLA_RECORD_MAX);
+  KNX_HOST_CHECK(memcmp(copy, record, COLA_RECORD_MAX) == 0);
+  KNX_HOST_CHECK(cola_leer(&cola, copy, sizeof(copy)) == 0);
+
+  /** A record longer than the buffer of the reader is skipped. */
+  KNX_HOST_CHECK(cola_guardar_datos(&cola, record, 100) == 1);
+  KNX_HOST_CHECK(cola_guardar_datos(&cola, &record[1], 3) == 1);
+  KNX_HOST_CHECK(cola_leer(&cola, copy, 10) == -1);
+  KNX_HOST_CHECK(cola_leer(&cola, copy, 10) == 3);
+  KNX_HOST_CHECK(memcmp(copy, &record[1], 3) == 0);
+  KNX_HOST_CHECK(cola_peek(&cola) == 0U);
+}
+
+/**
+  * @brief      Entry point.
+  * @param      argc: number of arguments.
+  * @param      argv: options, as \c name=value.
+  * @retval     0 on success.
+  */
+int main(int argc, char **argv)
+{
+  uint32_t count, records, bad, taken, drops;
+
+  KNX_Host_Init(argc, argv);
+  count = KNX_Host_GetOption("producers", 4);
+  records = KNX_Host_GetOption("records", 100000);
+  KNX_HOST_CHECK((count >= 1U) && (count <= TEST_PRODUCERS));
+  KNX_HOST_CHECK(records != 0U);
+  if(KNX_Host_GetFailures() != 0U)
+  {
+    KNX_Host_Exit();
+  }
+
+  Test_Limits();
+
+  bad = Test_Phase(count, records, TRUE, FALSE, &taken, &drops);
+  printf("{\"test\":\"cola\",\"phase\":\"retry\",\"producers\":%lu,\"records\":%lu,"
+         "\"taken\":%lu,\"drops\":%lu,\"bad\":%lu}\n",
+         (unsigned long)count, (unsigned long)records, (unsigned long)taken,
+         (unsigned long)drops, (unsigned long)bad);
+  KNX_HOST_CHECK(bad == 0U);
+  KNX_HOST_CHECK(taken == count * records);
+  KNX_HOST_CHECK(drops == cola_perdidos(&cola));
+
+  bad = Test_Phase(count, records, FALSE, TRUE, &taken, &drops);
+  printf("{\"test\":\"cola\",\"phase\":\"full\",\"producers\":%lu,\"records\":%lu,"
+         "\"taken\":%lu,\"drops\":%lu,\"bad\":%lu}\n",
+         (unsigned long)count, (unsigned long)records, (unsigned long)taken,
+         (unsigned long)drops, (unsigned long)bad);
+  KNX_HOST_CHECK(bad == 0U);
+  KNX_HOST_CHECK(drops != 0U);
+  KNX_HOST_CHECK(taken + drops == count * records);
+  KNX_HOST_CHECK(drops == cola_perdidos(&cola));
+
+  KNX_Host_Exit();
+  return 0;
+}
@@ -0,0 +1,352 @@
+/**
+  ******************************************************************************
+  * @file       test_log.c
+  * @author     MA Dingjie
+  * @version    V1.0.0
+  * @date       17-October-2016
+  * @brief      Test of the stream of the debug UART of KNX_Log.c: records
+  *             encoded by ::KNX_Log_Encode, as the target sends them, and
+  *             decoded by ::KNX_Log_Decode, as knx_log does from a capture.
+  *
+  *             Phases:
+  *              + round trip: every message, times going through the 32-bit
+  *                wrap and now and then back, the time and text of each line
+  *              + framing: the delimiter is only at the end of a record
+  *              + resync: the stream is started in the middle of a record,
+  *                an octet is lost or changed to the delimiter, noise comes
+  *                between two records, a delimiter is lost; only the lines
+  *                of the records hit are wrong, the others are decoded again
+  *
+  *             The options, as \c name=value:
+  *              + \c records: records of the stream
+  *              + \c seed: seed of the draws
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "KNX_Host.h"
+#include "KNX_Log.h"
+
+/* Private constants ---------------------------------------------------------*/
+/** \brief Longest line of text. */
+#define TEST_TEXT_SIZE          ((uint16_t)128)
+/** \brief Line expected reporting a bad record. */
+#define TEST_BAD                ((int32_t)-1)
+/** \brief Line expected of a record hit, it may be anything. */
+#define TEST_ANY                ((int32_t)-2)
+
+/* Private types -------------------------------------------------------------*/
+/**
+  * @brief  A record of the stream and where it is on the wire.
+  */
+typedef struct
+{
+  uint8_t  Record[KNX_LOG_RECORD_MAX];
+  uint8_t  Length;
+  uint64_t Time;                /*!< Time expected on its line, in us        */
+  uint32_t Offset;              /*!< First octet of its frame                */
+  uint8_t  Size;                /*!< Octets of its frame                     */
+} Test_Record_t;
+
+/* Private variables ---------------------------------------------------------*/
+static Test_Record_t    *records;
+static uint8_t          *wire, *copy;
+static uint32_t          wireLength;
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief      Next number of a xorshift generator.
+  * @param      state: state of the generator, not 0.
+  * @retval     The number.
+  */
+static uint32_t Test_Random(uint32_t *state)
+{
+  uint32_t x = *state;
+
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+
+  return x;
+}
+
+/**
+  * @brief      Draw the records and encode them in ::wire.
+  * @param      count: number of records.
+  * @param      state: state of the generator.
+  */
+static void Test_Encode(uint32_t count, uint32_t *state)
+{
+  KNX_Log_Stream_t stream;
+  uint32_t timestamp = 0xFFFFFF00U - 1000U * count, last = 0, step, i;
+  uint64_t time = 0;
+  uint8_t id, nargs, j;
+
+  KNX_Log_InitStream(&stream);
+  wireLength = 0;
+  for(i=0; i<count; i++)
+  {
+    /** Short steps, one in eight back, and one in 64 of any size: the
+      * delta takes up to 5 octets. */
+    step = Test_Random(state) >> (Test_Random(state) % 32U);
+    if((i % 64U) == 63U)
+    {
+      timestamp += step;
+    }
+    else
+    {
+      timestamp += ((i % 8U) == 7U) ? 0U - (step % 5000U) : step % 2000U;
+    }
+    time += (uint64_t)(int64_t)(int32_t)(timestamp - last);
+    last = timestamp;
+
+    id = (uint8_t)(i % (uint32_t)KNX_LOG_COUNT);
+    /** The number of arguments is not exported, one octet for all but the
+      * first message, as in ::KNX_LOG_MESSAGES. */
+    nargs = (id == (uint8_t)LOG_DEBUG_START) ? 0U : 1U;
+    records[i].Record[0] = id;
+    records[i].Record[1] = (uint8_t)timestamp;
+    records[i].Record[2] = (uint8_t)(timestamp >> 8);
+    records[i].Record[3] = (uint8_t)(timestamp >> 16);
+    records[i].Record[4] = (uint8_t)(timestamp >> 24);
+    for(j=0; j<nargs; j++)
+    {
+      /** The delimiter as an argument one time in four. */
+      records[i].Record[5U + j] = ((Test_Random(state) % 4U) == 0U) ? 0U : (uint8_t)Test_Random(state);
+    }
+    records[i].Length = (uint8_t)(5U + nargs);
+    records[i].Time = time;
+    records[i].Offset = wireLength;
+    records[i].Size = KNX_Log_Encode(&stream, records[i].Record, records[i].Length, &wire[wireLength]);
+    KNX_HOST_CHECK(records[i].Size != 0U);
+    KNX_HOST_CHECK(records[i].Size <= KNX_LOG_WIRE_MAX);
+    wireLength += records[i].Size;
+  }
+
+  /** Not a record of the stream: nothing on the wire, the time is kept. */
+  KNX_HOST_CHECK(KNX_Log_Encode(&stream, records[0].Record, 4, &wire[wireLength]) == 0U);
+  KNX_HOST_CHECK(KNX_Log_Encode(&stream, records[1].Record, (uint16_t)(records[1].Length + 1U), &wire[wireLength]) == 0U);
+}
+
+/**
+  * @brief      Decode a stream, as knx_log does, and check each line against
+  *             the record expected.
+  * @param      data: the octets of the stream.
+  * @param      length: number of octets.
+  * @param      expected: index of the record of each line, ::TEST_BAD or
+  *             ::TEST_ANY.
+  * @param      lines: number of lines expected.
+  * @param      timed: TRUE to check the time of the lines too, FALSE once a
+  *             record is lost.
+  * @retval     Number of lines not as expected.
+  */
+static uint32_t Test_Decode(const uint8_t *data, uint32_t length, const int32_t *expected, uint32_t lines, uint8_t timed)
+{
+  KNX_Log_Stream_t stream;
+  char text[TEST_TEXT_SIZE], prefix[32], line[TEST_TEXT_SIZE];
+  const char *body;
+  uint32_t offset = 0, count = 0, wrong = 0;
+  uint16_t used, n, chunk;
+  Test_Record_t *record;
+
+  KNX_Log_InitStream(&stream);
+  while(offset < length)
+  {
+    /** The octets come by small chunks, as from a serial line. */
+    chunk = (uint16_t)(((length - offset) < 64U) ? (length - offset) : 64U);
+    n = KNX_Log_Decode(&stream, &data[offset], chunk, &used, text, sizeof(text));
+    if(used == 0U)
+    {
+      if(chunk == length - offset)
+      {
+        break;
+      }
+      n = KNX_Log_Decode(&stream, &data[offset], (uint16_t)(length - offset), &used, text, sizeof(text));
+      if(used == 0U)
+      {
+        break;
+      }
+    }
+    offset += used;
+    if(n == 0U)
+    {
+      continue;
+    }
+
+    if(count >= lines)
+    {
+      wrong++;
+      continue;
+    }
+    if(expected[count] == TEST_ANY)
+    {
+      count++;
+      continue;
+    }
+    if(expected[count] == TEST_BAD)
+    {
+      wrong += (strncmp(text, "[Log]", 5) == 0) ? 0U : 1U;
+      count++;
+      continue;
+    }
+
+    record = &records[expected[count]];
+    body = strstr(text, "] ");
+    snprintf(prefix, sizeof(prefix), "[%lu.%06lu] ", (unsigned long)(record->Time / 1000000U),
+             (unsigned long)(record->Time % 1000000U));
+    if((body == NULL) || ((timed == TRUE) && (strncmp(text, prefix, strlen(prefix)) != 0)))
+    {
+      wrong++;
+    }
+    else if(record->Record[0] == (uint8_t)LOG_PH_SEND)
+    {
+      snprintf(line, sizeof(line), "] [KNX PH]Data sent: %02X\r\n", (unsigned int)record->Record[5]);
+      wrong += (strcmp(body, line) == 0) ? 0U : 1U;
+    }
+    else
+    {
+      wrong += (strncmp(body, "] [", 3) == 0) ? 0U : 1U;
+    }
+    count++;
+  }
+
+  return wrong + ((count == lines) ? 0U : 1U);
+}
+
+/**
+  * @brief      Entry point.
+  * @param      argc: number of arguments.
+  * @param      argv: options, as \c name=value.
+  * @retval     0 on success.
+  */
+int main(int argc, char **argv)
+{
+  int32_t *expected;
+  uint32_t count, state, i, k, delimiters, offset, length, lines, cut;
+  uint32_t wrong[6];
+
+  KNX_Host_Init(argc, argv);
+  count = KNX_Host_GetOption("records", 100000);
+  state = KNX_Host_GetOption("seed", 1);
+  KNX_HOST_CHECK(count >= 16U);
+  KNX_HOST_CHECK(state != 0U);
+  records = calloc(count, sizeof(Test_Record_t));
+  wire = malloc((size_t)count * KNX_LOG_WIRE_MAX + 1U);
+  copy = malloc((size_t)count * KNX_LOG_WIRE_MAX + 16U);
+  expected = malloc((size_t)count * sizeof(int32_t));
+  KNX_HOST_CHECK((records != NULL) && (wire != NULL) && (copy != NULL) && (expected != NULL));
+  if(KNX_Host_GetFailures() != 0U)
+  {
+    KNX_Host_Exit();
+  }
+
+  Test_Encode(count, &state);
+
+  /** Framing: one delimiter per record, its last octet. */
+  delimiters = 0;
+  for(i=0; i<wireLength; i++)
+  {
+    delimiters += (wire[i] == KNX_LOG_DELIMITER) ? 1U : 0U;
+  }
+  KNX_HOST_CHECK(delimiters == count);
+  for(i=0; i<count; i++)
+  {
+    KNX_HOST_CHECK(wire[records[i].Offset + records[i].Size - 1U] == KNX_LOG_DELIMITER);
+  }
+
+  /** Round trip. */
+  for(i=0; i<count; i++)
+  {
+    expected[i] = (int32_t)i;
+  }
+  wrong[0] = Test_Decode(wire, wireLength, expected, count, TRUE);
+  KNX_HOST_CHECK(wrong[0] == 0U);
+
+  /** Started in the middle of the first record. */
+  expected[0] = TEST_ANY;
+  wrong[1] = Test_Decode(&wire[2], wireLength - 2U, expected, count, FALSE);
+  KNX_HOST_CHECK(wrong[1] == 0U);
+
+  /** An octet lost in the record k. */
+  k = count / 2U;
+  for(i=0; i<count; i++)
+  {
+    expected[i] = (int32_t)i;
+  }
+  expected[k] = TEST_ANY;
+  offset = records[k].Offset + records[k].Size / 2U;
+  memcpy(copy, wire, offset);
+  memcpy(&copy[offset], &wire[offset + 1U], wireLength - offset - 1U);
+  wrong[2] = Test_Decode(copy, wireLength - 1U, expected, count, FALSE);
+  KNX_HOST_CHECK(wrong[2] == 0U);
+
+  /** An octet changed to the delimiter: the record k is cut in two. */
+  lines = 0;
+  for(i=0; i<count; i++)
+  {
+    if(i == k)
+    {
+      expected[lines++] = TEST_ANY;
+    }
+    expected[lines++] = (i == k) ? TEST_ANY : (int32_t)i;
+  }
+  memcpy(copy, wire, wireLength);
+  copy[records[k].Offset + 1U] = KNX_LOG_DELIMITER;
+  wrong[3] = Test_Decode(copy, wireLength, expected, lines, FALSE);
+  KNX_HOST_CHECK(wrong[3] == 0U);
+
+  /** Noise between two records, longer than a record: a bad record. */
+  lines = 0;
+  for(i=0; i<count; i++)
+  {
+    if(i == k)
+    {
+      expected[lines++] = TEST_BAD;
+    }
+    expected[lines++] = (int32_t)i;
+  }
+  offset = records[k].Offset;
+  length = KNX_LOG_WIRE_MAX + 3U;
+  memcpy(copy, wire, offset);
+  for(i=0; i<length; i++)
+  {
+    copy[offset + i] = (uint8_t)(0x41U + i);
+  }
+  copy[offset + length - 1U] = KNX_LOG_DELIMITER;
+  memcpy(&copy[offset + length], &wire[offset], wireLength - offset);
+  wrong[4] = Test_Decode(copy, wireLength + length, expected, lines, TRUE);
+  KNX_HOST_CHECK(wrong[4] == 0U);
+
+  /** A delimiter lost: the records k and k + 1 make a bad one. */
+  lines = 0;
+  for(i=0; i<count; i++)
+  {
+    if(i != k + 1U)
+    {
+      expected[lines++] = (i == k) ? TEST_BAD : (int32_t)i;
+    }
+  }
+  cut = records[k].Offset + records[k].Size - 1U;
+  memcpy(copy, wire, cut);
+  memcpy(&copy[cut], &wire[cut + 1U], wireLength - cut - 1U);
+  wrong[5] = Test_Decode(copy, wireLength - 1U, expected, lines, FALSE);
+  KNX_HOST_CHECK(wrong[5] == 0U);
+
+  printf("{\"test\":\"log\",\"records\":%lu,\"octets\":%lu,\"octets_per_record\":%.2f,"
+         "\"wrong\":{\"round_trip\":%lu,\"mid_start\":%lu,\"lost\":%lu,"
+         "\"delimiter\":%lu,\"noise\":%lu,\"lost_delimiter\":%lu}}\n",
+         (unsigned long)count, (unsigned long)wireLength, (double)wireLength / count,
+         (unsigned long)wrong[0], (unsigned long)wrong[1], (unsigned long)wrong[2],
+         (unsigned long)wrong[3], (unsigned long)wrong[4], (unsigned long)wrong[5]);
+
+  free(expected);
+  free(copy);
+  free(wire);
+  free(records);
+  KNX_Host_Exit();
+  return 0;
+}
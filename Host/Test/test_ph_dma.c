@@ -0,0 +1,548 @@
+/**
+  ******************************************************************************
+  * @file       test_ph_dma.c
+  * @author     MA Dingjie
+  * @version    V1.0.0
+  * @date       17-October-2016
+  * @brief      Test of the DMA backend of the TP-UART, KNX_Ph_TPUart_DMA.c,
+  *             on the mock of the HAL in Host/Mock.
+  *
+  *             The TP-UART is a task above the stack: it sends octets to
+  *             USART3, which the reception stream writes into the circular
+  *             buffer of the backend, and drains the transmission stream.
+  *             The handlers of USART3 and of the two streams are those the
+  *             backend asks for, they run when the mock raises their flags.
+  *             Phases:
+  *              + init: the registers of USART3, of the streams, of the baud
+  *                rate pin and of the NVIC after ::KNX_Ph_Init
+  *              + frames: bursts of one to three frames, each burst ended by
+  *                an idle line, many times around the buffer; every frame
+  *                comes once and in order, the interrupts are only those of
+  *                the half and complete transfers and of the idle lines
+  *              + truncated: the start of a frame then an idle line, the
+  *                frame is dropped and the next one comes
+  *              + tx: ::KNX_Ph_SendData and ::KNX_Ph_Data_req through the
+  *                transmission stream, they return once the transfer is
+  *                over, the second one on the L_Data_confirm
+  *              + ack: a frame addressed to the line is acknowledged from the
+  *                interrupt through the transmission stream
+  *              + busy: frames not taken up to ::KNX_PH_ACK_BUSY_LEVEL, then
+  *                a frame addressed to the line; the interrupt answers busy
+  *                from the level of the queue it sees
+  *              + paced: frames one by one at the pace of the line, each
+  *                ended by an idle line, so that they straddle the half and
+  *                complete transfers; none is dropped by the gap between two
+  *                bytes, and the time between the first and the last byte of
+  *                a frame is that of its characters
+  *
+  *             The options, as \c name=value:
+  *              + \c frames: frames of the frames phase
+  *              + \c seed: seed of the draws
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include "stm32f4xx_hal.h"
+#include "KNX_Host.h"
+#include "KNX_Aux.h"
+#include "KNX_Ph_TPUart.h"
+#include "KNX_Addr.h"
+
+/* Private constants ---------------------------------------------------------*/
+/** \brief Timeout of the requests, in ms. */
+#define TEST_TIMEOUT            ((uint32_t)1000U)
+/** \brief Individual address of the line in the ack phase. */
+#define TEST_ADDRESS            ((uint16_t)0x1101U)
+/** \brief Group address of the frames, not acknowledged. */
+#define TEST_GROUP              ((uint16_t)0x0901U)
+/** \brief Most frames of a burst, under ::KNX_PH_FRAME_QUEUE_SIZE. */
+#define TEST_BURST              ((uint32_t)3U)
+/** \brief Frames of the paced phase, several turns of the buffer. */
+#define TEST_PACED              ((uint32_t)16U)
+/** \brief Slack on the time of a paced frame, in us: the clock of the host
+  *        jitters, within what the gap between two bytes tolerates. */
+#define TEST_PACED_SLACK        (KNX_PH_FRAME_GAP_US - KNX_PH_TPUART_CHAR_US)
+/** \brief Priority of the task playing the TP-UART, above the stack. */
+#define TEST_TPUART_PRIORITY    (configMAX_PRIORITIES - 1)
+
+/* Private types -------------------------------------------------------------*/
+/**
+  * @brief  Phases run by the TP-UART.
+  */
+typedef enum
+{
+  TEST_TPUART_FRAMES    = 0x00U, /*!< Bursts of frames                        */
+  TEST_TPUART_TRUNCATED = 0x01U, /*!< The start of a frame, then a frame      */
+  TEST_TPUART_TX        = 0x02U, /*!< Drain a byte, then a frame and confirm  */
+  TEST_TPUART_ACK       = 0x03U, /*!< A frame to the line, drain the ack      */
+  TEST_TPUART_BUSY      = 0x04U, /*!< Frames, one to the line, drain the ack  */
+  TEST_TPUART_PACED     = 0x05U  /*!< Frames at the pace of the line          */
+} Test_TPUart_t;
+
+/* Private variables ---------------------------------------------------------*/
+static PH_Handle_t      line;
+static KNX_Addr_t       addr;
+static TaskHandle_t     mainTask;
+static uint32_t         frames;
+static uint32_t         seed;
+static Test_TPUart_t    phase;
+static volatile uint32_t taken;
+static uint32_t         bursts, octets;
+static uint8_t          wire[1U + 2U * FRAME_SIZE];
+static uint16_t         wireLength;
+static volatile uint32_t uartIrqs, dmaIrqs;
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief      Next number of a xorshift generator.
+  * @param      state: state of the generator, not 0.
+  * @retval     The number.
+  */
+static uint32_t Test_Random(uint32_t *state)
+{
+  uint32_t x = *state;
+
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+
+  return x;
+}
+
+/**
+  * @brief      Next frame of the draws, a standard frame to ::TEST_GROUP.
+  * @param      state: state of the generator.
+  * @param      frame: buffer of ::FRAME_SIZE octets.
+  * @retval     Length of the frame.
+  */
+static uint16_t Test_Frame(uint32_t *state, uint8_t *frame)
+{
+  uint16_t length, i;
+
+  length = (uint16_t)(FRAME_OVERHEAD + Test_Random(state) % (FRAME_SIZE - FRAME_OVERHEAD + 1U));
+  frame[0] = (uint8_t)(0xB0U | ((Test_Random(state) & 3U) << 2));
+  frame[1] = (uint8_t)Test_Random(state);
+  frame[2] = (uint8_t)Test_Random(state);
+  frame[3] = (uint8_t)(TEST_GROUP >> 8);
+  frame[4] = (uint8_t)TEST_GROUP;
+  frame[FRAME_LENGTH_OCTET] = (uint8_t)(0xE0U | (length - FRAME_OVERHEAD));
+  for(i=FRAME_LENGTH_OCTET + 1U; i<length - 1U; i++)
+  {
+    frame[i] = (uint8_t)Test_Random(state);
+  }
+  frame[length - 1U] = (uint8_t)~KNX_VerticalParity(frame, (uint16_t)(length - 1U));
+
+  return length;
+}
+
+/**
+  * @brief      Address a frame of the draws to a device.
+  * @param      frame: the frame.
+  * @param      length: its length.
+  * @param      da: individual address of the device.
+  */
+static void Test_Address(uint8_t *frame, uint16_t length, uint16_t da)
+{
+  frame[3] = (uint8_t)(da >> 8);
+  frame[4] = (uint8_t)da;
+  frame[FRAME_LENGTH_OCTET] &= 0x7FU;
+  frame[length - 1U] = (uint8_t)~KNX_VerticalParity(frame, (uint16_t)(length - 1U));
+}
+
+/**
+  * @brief      USART3_IRQHandler of the target.
+  */
+static void Test_USART3_IRQHandler(void)
+{
+  uartIrqs++;
+  HAL_UART_IRQHandler(&line.TPUart.huart);
+  TPUart_isr(&line.TPUart);
+}
+
+/**
+  * @brief      IRQ handler of the reception stream.
+  */
+static void Test_DMA1_Stream1_IRQHandler(void)
+{
+  dmaIrqs++;
+  HAL_DMA_IRQHandler(&line.TPUart.hdma_rx);
+  TPUart_isr(&line.TPUart);
+}
+
+/**
+  * @brief      IRQ handler of the transmission stream.
+  */
+static void Test_DMA1_Stream3_IRQHandler(void)
+{
+  HAL_DMA_IRQHandler(&line.TPUart.hdma_tx);
+}
+
+/**
+  * @brief      The TP-UART sends octets then stops talking.
+  * @param      data: the octets.
+  * @param      size: number of octets.
+  */
+static void Test_Send(const uint8_t *data, uint16_t size)
+{
+  KNX_HOST_CHECK(HAL_Mock_UART_Receive(USART3, data, size) == size);
+  HAL_Mock_UART_Idle(USART3);
+}
+
+/**
+  * @brief      The TP-UART takes the next octets sent by the line, waiting
+  *             for them, after those of ::wire.
+  * @param      size: octets to take.
+  */
+static void Test_Drain(uint16_t size)
+{
+  TickType_t start = xTaskGetTickCount();
+  uint16_t end = (uint16_t)(wireLength + size);
+
+  while((wireLength < end) && (xTaskGetTickCount() - start < pdMS_TO_TICKS(TEST_TIMEOUT)))
+  {
+    wireLength += HAL_Mock_UART_Transmit(USART3, &wire[wireLength], (uint16_t)(end - wireLength));
+    if(wireLength < end)
+    {
+      vTaskDelay(1);
+    }
+  }
+}
+
+/**
+  * @brief      Task of the TP-UART, runs ::phase then notifies the main task.
+  * @param      argument: not used.
+  */
+static void Test_TPUartTask(void *argument)
+{
+  uint8_t frame[FRAME_SIZE], burst[TEST_BURST * FRAME_SIZE], confirm = L_Data_confirm_success;
+  uint32_t state = seed, draw = seed + 1U, sent = 0, n, i;
+  uint16_t length, size;
+
+  (void)argument;
+  wireLength = 0;
+  switch(phase)
+  {
+    case TEST_TPUART_FRAMES:
+      while(sent < frames)
+      {
+        n = 1U + Test_Random(&draw) % TEST_BURST;
+        n = (n > frames - sent) ? frames - sent : n;
+        size = 0;
+        for(i=0; i<n; i++)
+        {
+          size += Test_Frame(&state, &burst[size]);
+        }
+        /** The frames of the previous burst are taken, the queue has room. */
+        for(i=0; (taken != sent) && (i < TEST_TIMEOUT); i++)
+        {
+          vTaskDelay(pdMS_TO_TICKS(1));
+        }
+        if(taken != sent)
+        {
+          break;
+        }
+        Test_Send(burst, size);
+        sent += n;
+        bursts++;
+        octets += size;
+      }
+      break;
+
+    case TEST_TPUART_TRUNCATED:
+      length = Test_Frame(&state, frame);
+      Test_Send(frame, (uint16_t)(length / 2U));
+      length = Test_Frame(&state, frame);
+      Test_Send(frame, length);
+      break;
+
+    case TEST_TPUART_TX:
+      Test_Drain(1);
+      length = Test_Frame(&state, frame);
+      Test_Drain((uint16_t)(2U * length));
+      Test_Send(&confirm, 1);
+      break;
+
+    case TEST_TPUART_ACK:
+      length = Test_Frame(&state, frame);
+      Test_Address(frame, length, TEST_ADDRESS);
+      Test_Send(frame, length);
+      Test_Drain(1);
+      break;
+
+    case TEST_TPUART_PACED:
+      HAL_Mock_SetCharTime(KNX_PH_TPUART_CHAR_US);
+      while(sent < TEST_PACED)
+      {
+        length = Test_Frame(&state, frame);
+        for(i=0; (taken != sent) && (i < TEST_TIMEOUT); i++)
+        {
+          vTaskDelay(pdMS_TO_TICKS(1));
+        }
+        if(taken != sent)
+        {
+          break;
+        }
+        Test_Send(frame, length);
+        sent++;
+      }
+      HAL_Mock_SetCharTime(0);
+      break;
+
+    case TEST_TPUART_BUSY:
+    default:
+      size = 0;
+      for(i=0; i<KNX_PH_ACK_BUSY_LEVEL; i++)
+      {
+        size += Test_Frame(&state, &burst[size]);
+      }
+      Test_Send(burst, size);
+      length = Test_Frame(&state, frame);
+      Test_Address(frame, length, TEST_ADDRESS);
+      Test_Send(frame, length);
+      Test_Drain(1);
+      break;
+  }
+
+  xTaskNotifyGive(mainTask);
+  vTaskDelete(NULL);
+}
+
+/**
+  * @brief      Start the TP-UART on a phase.
+  * @param      tpuart: the phase.
+  */
+static void Test_StartTPUart(Test_TPUart_t tpuart)
+{
+  phase = tpuart;
+  xTaskCreate(Test_TPUartTask, "Test TP-UART", KNX_HOST_TASK_STACK, NULL, TEST_TPUART_PRIORITY, NULL);
+}
+
+/**
+  * @brief      Receive the next frame and compare it with the next one of
+  *             the draws.
+  * @param      state: state of the generator.
+  * @retval     TRUE if the frame came and is the one expected.
+  */
+static uint8_t Test_Receive(uint32_t *state)
+{
+  uint8_t expected[FRAME_SIZE], frame[FRAME_SIZE];
+  uint16_t length = Test_Frame(state, expected), received;
+
+  if(KNX_Ph_Data_rec(&line, frame, &received) != PH_ERROR_NONE)
+  {
+    return FALSE;
+  }
+
+  return ((received == length) && (memcmp(frame, expected, length) == 0)) ? TRUE : FALSE;
+}
+
+/**
+  * @brief      Main task of the test, the user of the line.
+  * @param      argument: not used.
+  */
+static void Test_Task(void *argument)
+{
+  uint8_t frame[FRAME_SIZE];
+  uint32_t state, bad, irqs, truncated, span, late;
+  uint16_t length, i;
+  PH_Stats_t stats;
+  KNX_Frame_t *rx;
+
+  (void)argument;
+  mainTask = xTaskGetCurrentTaskHandle();
+
+  /** Init: what HAL_UART_MspInit does on the target, then the line. */
+  HAL_Mock_Reset();
+  HAL_Mock_SetIRQHandler(USART3_IRQn, Test_USART3_IRQHandler);
+  HAL_Mock_SetIRQHandler(DMA1_Stream1_IRQn, Test_DMA1_Stream1_IRQHandler);
+  HAL_Mock_SetIRQHandler(DMA1_Stream3_IRQn, Test_DMA1_Stream3_IRQHandler);
+  HAL_NVIC_SetPriority(USART3_IRQn, 5, 0);
+  HAL_NVIC_EnableIRQ(USART3_IRQn);
+  KNX_HOST_CHECK(KNX_Ph_Init(&line) == PH_ERROR_NONE);
+  if(KNX_Host_GetFailures() != 0U)
+  {
+    KNX_Host_Exit();
+  }
+  KNX_HOST_CHECK(line.TPUart.Instance == USART3);
+  KNX_HOST_CHECK((RCC->AHB1ENR & RCC_AHB1ENR_DMA1EN) != 0U);
+  KNX_HOST_CHECK(USART3->CR1 == (USART_CR1_UE | USART_CR1_M | USART_CR1_PCE | USART_CR1_TE
+                                 | USART_CR1_RE | USART_CR1_IDLEIE));
+  KNX_HOST_CHECK(USART3->CR3 == USART_CR3_DMAR);
+  KNX_HOST_CHECK(USART3->BRR == HAL_MOCK_APB1_CLOCK / 9600U);
+  KNX_HOST_CHECK(DMA1_Stream1->CR == (DMA_CHANNEL_4 | DMA_PERIPH_TO_MEMORY | DMA_SxCR_MINC | DMA_SxCR_CIRC
+                                      | DMA_PRIORITY_HIGH | DMA_SxCR_TCIE | DMA_SxCR_HTIE
+                                      | DMA_SxCR_TEIE | DMA_SxCR_EN));
+  KNX_HOST_CHECK(DMA1_Stream1->NDTR == KNX_PH_TPUART_DMA_RX_SIZE);
+  KNX_HOST_CHECK(DMA1_Stream1->PAR == (uintptr_t)&USART3->DR);
+  KNX_HOST_CHECK(DMA1_Stream1->M0AR == (uintptr_t)line.TPUart.RxBuffer);
+  KNX_HOST_CHECK(DMA1_Stream3->CR == (DMA_CHANNEL_4 | DMA_MEMORY_TO_PERIPH | DMA_SxCR_MINC | DMA_PRIORITY_MEDIUM));
+  KNX_HOST_CHECK((GPIOD->ODR & GPIO_PIN_7) != 0U);
+  KNX_HOST_CHECK((HAL_Mock_NVIC[DMA1_Stream1_IRQn].Enabled != 0U) && (HAL_Mock_NVIC[DMA1_Stream1_IRQn].Priority == 5U));
+  KNX_HOST_CHECK((HAL_Mock_NVIC[DMA1_Stream3_IRQn].Enabled != 0U) && (HAL_Mock_NVIC[DMA1_Stream3_IRQn].Priority == 5U));
+  KNX_HOST_CHECK(KNX_PH_TPUart_GetTxState(&line.TPUart) == TPUart_OK);
+  printf("{\"test\":\"ph_dma\",\"phase\":\"init\",\"cr1\":\"0x%04lX\",\"rx_cr\":\"0x%08lX\",\"tx_cr\":\"0x%08lX\"}\n",
+         (unsigned long)USART3->CR1, (unsigned long)DMA1_Stream1->CR, (unsigned long)DMA1_Stream3->CR);
+
+  /** Frames: every frame in order, the interrupts at the half and complete
+      transfers and at the idle lines only. */
+  state = seed;
+  bad = 0;
+  Test_StartTPUart(TEST_TPUART_FRAMES);
+  while(taken < frames)
+  {
+    if(Test_Receive(&state) == FALSE)
+    {
+      bad++;
+      break;
+    }
+    taken++;
+  }
+  ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  KNX_Ph_GetStats(&line, &stats);
+  printf("{\"test\":\"ph_dma\",\"phase\":\"frames\",\"frames\":%lu,\"taken\":%lu,\"octets\":%lu,"
+         "\"turns\":%lu,\"bursts\":%lu,\"uart_irqs\":%lu,\"dma_irqs\":%lu,\"bad\":%lu}\n",
+         (unsigned long)frames, (unsigned long)taken, (unsigned long)octets,
+         (unsigned long)(octets / KNX_PH_TPUART_DMA_RX_SIZE), (unsigned long)bursts,
+         (unsigned long)uartIrqs, (unsigned long)dmaIrqs, (unsigned long)bad);
+  KNX_HOST_CHECK(bad == 0U);
+  KNX_HOST_CHECK(taken == frames);
+  KNX_HOST_CHECK(stats.RxFrames == frames);
+  KNX_HOST_CHECK(stats.RxFrameTruncated == 0U);
+  KNX_HOST_CHECK(uartIrqs == bursts);
+  KNX_HOST_CHECK(dmaIrqs == octets / (KNX_PH_TPUART_DMA_RX_SIZE / 2U));
+  KNX_HOST_CHECK(line.TPUart.RxIndice == octets % KNX_PH_TPUART_DMA_RX_SIZE);
+
+  /** Truncated: dropped at the idle line, the next frame comes. */
+  state = seed;
+  Test_StartTPUart(TEST_TPUART_TRUNCATED);
+  Test_Frame(&state, frame);
+  KNX_HOST_CHECK(Test_Receive(&state) == TRUE);
+  ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  KNX_Ph_GetStats(&line, &stats);
+  KNX_HOST_CHECK(stats.RxFrameTruncated == 1U);
+  KNX_HOST_CHECK(stats.RxFrames == frames + 1U);
+  printf("{\"test\":\"ph_dma\",\"phase\":\"truncated\",\"truncated\":%lu,\"frames\":%lu}\n",
+         (unsigned long)stats.RxFrameTruncated, (unsigned long)stats.RxFrames);
+
+  /** Tx: each request returns at the end of its transfer. */
+  state = seed;
+  Test_StartTPUart(TEST_TPUART_TX);
+  KNX_HOST_CHECK(KNX_Ph_SendData(&line, U_State_request, TEST_TIMEOUT) == PH_ERROR_NONE);
+  KNX_HOST_CHECK((wireLength >= 1U) && (wire[0] == U_State_request));
+  KNX_HOST_CHECK(KNX_PH_TPUart_GetTxState(&line.TPUart) == TPUart_OK);
+  length = Test_Frame(&state, frame);
+  KNX_HOST_CHECK(KNX_Ph_Data_req(&line, frame, length) == PH_ERROR_NONE);
+  KNX_HOST_CHECK(wireLength == 1U + 2U * length);
+  bad = 0;
+  for(i=0; i<length; i++)
+  {
+    bad += (wire[2U * i + 2U] == frame[i]) ? 0U : 1U;
+  }
+  KNX_HOST_CHECK(bad == 0U);
+  KNX_HOST_CHECK(wire[1] == U_L_DataStart);
+  KNX_HOST_CHECK(wire[2U * length - 1U] == (uint8_t)(U_L_DataEnd | length));
+  KNX_HOST_CHECK((USART3->CR3 & USART_CR3_DMAT) == 0U);
+  KNX_HOST_CHECK((USART3->CR1 & USART_CR1_TCIE) == 0U);
+  ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  printf("{\"test\":\"ph_dma\",\"phase\":\"tx\",\"octets\":%lu,\"bad\":%lu}\n",
+         (unsigned long)wireLength, (unsigned long)bad);
+
+  /** Ack: sent by the interrupt as soon as the frame is addressed. */
+  KNX_Addr_Init(&addr, TEST_ADDRESS);
+  KNX_Ph_SetAddr(&line, &addr);
+  Test_StartTPUart(TEST_TPUART_ACK);
+  KNX_HOST_CHECK(KNX_Ph_Data_rec(&line, frame, &length) == PH_ERROR_NONE);
+  ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  KNX_Ph_GetStats(&line, &stats);
+  KNX_HOST_CHECK((wireLength == 1U) && (wire[0] == U_AckInformation_ACK));
+  KNX_HOST_CHECK(stats.Acks == 1U);
+  KNX_HOST_CHECK(KNX_PH_TPUart_GetTxState(&line.TPUart) == TPUart_OK);
+  printf("{\"test\":\"ph_dma\",\"phase\":\"ack\",\"acks\":%lu,\"ack\":\"0x%02X\"}\n",
+         (unsigned long)stats.Acks, wire[0]);
+
+  /** Busy: the queue at its high water mark when the frame is addressed. */
+  Test_StartTPUart(TEST_TPUART_BUSY);
+  ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  KNX_Ph_GetStats(&line, &stats);
+  KNX_HOST_CHECK((wireLength == 1U) && (wire[0] == U_AckInformation_Busy));
+  KNX_HOST_CHECK(stats.AcksBusy == 1U);
+  for(i=0; i<=KNX_PH_ACK_BUSY_LEVEL; i++)
+  {
+    KNX_HOST_CHECK(KNX_Ph_Data_rec(&line, frame, &length) == PH_ERROR_NONE);
+  }
+  KNX_HOST_CHECK(stats.RxFrameOverruns == 0U);
+  printf("{\"test\":\"ph_dma\",\"phase\":\"busy\",\"level\":%lu,\"acks_busy\":%lu,\"ack\":\"0x%02X\"}\n",
+         (unsigned long)KNX_PH_ACK_BUSY_LEVEL, (unsigned long)stats.AcksBusy, wire[0]);
+
+  /** Paced: the bytes of a frame dated from their place in the buffer, the
+      gap between two of them is a character whatever the interrupt. */
+  state = seed;
+  bad = 0;
+  late = 0;
+  taken = 0;
+  irqs = dmaIrqs;
+  truncated = stats.RxFrameTruncated;
+  Test_StartTPUart(TEST_TPUART_PACED);
+  while(taken < TEST_PACED)
+  {
+    length = Test_Frame(&state, frame);
+    if(KNX_Ph_Frame_rec(&line, &rx, TEST_TIMEOUT) != PH_ERROR_NONE)
+    {
+      bad++;
+      break;
+    }
+    if((rx->Length != length) || (memcmp(rx->Datas, frame, length) != 0))
+    {
+      bad++;
+    }
+    /** A character per byte after the first, within ::TEST_PACED_SLACK. */
+    span = rx->EndTimestamp - rx->Timestamp;
+    if((span + TEST_PACED_SLACK < (length - 1U) * KNX_PH_TPUART_CHAR_US)
+       || (span > (length - 1U) * KNX_PH_TPUART_CHAR_US + TEST_PACED_SLACK))
+    {
+      late++;
+    }
+    KNX_Frame_Release(rx);
+    taken++;
+  }
+  ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  KNX_Ph_GetStats(&line, &stats);
+  irqs = dmaIrqs - irqs;
+  truncated = stats.RxFrameTruncated - truncated;
+  printf("{\"test\":\"ph_dma\",\"phase\":\"paced\",\"frames\":%lu,\"taken\":%lu,\"char_us\":%lu,"
+         "\"dma_irqs\":%lu,\"truncated\":%lu,\"late\":%lu,\"bad\":%lu}\n",
+         (unsigned long)TEST_PACED, (unsigned long)taken, (unsigned long)KNX_PH_TPUART_CHAR_US,
+         (unsigned long)irqs, (unsigned long)truncated, (unsigned long)late, (unsigned long)bad);
+  KNX_HOST_CHECK(bad == 0U);
+  KNX_HOST_CHECK(taken == TEST_PACED);
+  KNX_HOST_CHECK(truncated == 0U);
+  KNX_HOST_CHECK(irqs != 0U);
+  KNX_HOST_CHECK(late == 0U);
+
+  KNX_Host_Exit();
+}
+
+/**
+  * @brief      Entry point.
+  * @param      argc: number of arguments.
+  * @param      argv: options, as \c name=value.
+  * @retval     0 on success.
+  */
+int main(int argc, char **argv)
+{
+  KNX_Host_Init(argc, argv);
+  frames = KNX_Host_GetOption("frames", 2000);
+  seed = KNX_Host_GetOption("seed", 1);
+  KNX_HOST_CHECK(frames != 0U);
+  KNX_HOST_CHECK(seed != 0U);
+  if(KNX_Host_GetFailures() != 0U)
+  {
+    KNX_Host_Exit();
+  }
+
+  KNX_Host_Run(Test_Task, argc, argv);
+  return 0;
+}
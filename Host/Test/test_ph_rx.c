@@ -0,0 +1,393 @@
+/**
+  ******************************************************************************
+  * @file       test_ph_rx.c
+  * @author     MA Dingjie
+  * @version    V1.0.0
+  * @date       17-October-2016
+  * @brief      Test of the receive ring buffers of the physical layer,
+  *             KNX_Ph_Buffer.c, fed through the RX interrupt path from a
+  *             simulated UART.
+  *
+  *             The simulated UART is a task at the priority of the emulated
+  *             TP-UART: for each byte it fills the receive register of the
+  *             line, ::TPUart_Emu_t::HostRx, and runs ::TPUart_isr, as an
+  *             RXNE interrupt would. The bytes are services of the TP-UART
+  *             which go to the data channel. Phases:
+  *              + ring: a ::KNX_Ph_Buffer_t alone, producer and consumer on
+  *                threads of the host, the consumer mixing single and bulk
+  *                reads; every byte comes once and in order, the bytes
+  *                dropped are those counted as overruns
+  *              + drain: bursts of the UART, no more than the ring holds,
+  *                taken by ::KNX_Ph_RecData and ::KNX_Ph_RecDatas; every
+  *                byte comes in order, no overrun
+  *              + overrun: a burst of three rings while the consumer does
+  *                not read; the first bytes are kept, the others counted
+  *              + wake: a task sleeping in ::KNX_Ph_RecData is woken by the
+  *                byte, well before its timeout
+  *
+  *             The options, as \c name=value:
+  *              + \c bytes: bytes of the ring and drain phases
+  *              + \c seed: seed of the draws
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include "KNX_Host.h"
+
+/* Private constants ---------------------------------------------------------*/
+/** \brief Timeout of the reads, in ms. */
+#define TEST_TIMEOUT            ((uint32_t)1000U)
+/** \brief Delay of the byte of the wake phase, in ms. */
+#define TEST_WAKE_DELAY         ((uint32_t)20U)
+
+/* Private types -------------------------------------------------------------*/
+/**
+  * @brief  Phases run by the simulated UART.
+  */
+typedef enum
+{
+  TEST_UART_DRAIN   = 0x00U,    /*!< Bursts which fit in the ring             */
+  TEST_UART_OVERRUN = 0x01U,    /*!< One burst of three rings                 */
+  TEST_UART_WAKE    = 0x02U     /*!< One byte after ::TEST_WAKE_DELAY         */
+} Test_Uart_t;
+
+/* Private variables ---------------------------------------------------------*/
+static PH_Handle_t      line;
+static TaskHandle_t     mainTask;
+static uint8_t          bytes[256];
+static uint32_t         byteCount;
+static uint32_t         seed;
+static uint32_t         total;
+static Test_Uart_t      phase;
+
+static KNX_Ph_Buffer_t  ring;
+static uint8_t         *ringDropped;
+static volatile uint32_t ringFull;
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief      Next number of a xorshift generator.
+  * @param      state: state of the generator, not 0.
+  * @retval     The number.
+  */
+static uint32_t Test_Random(uint32_t *state)
+{
+  uint32_t x = *state;
+
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+
+  return x;
+}
+
+/**
+  * @brief      Byte of the sequence: a service which goes to the data
+  *             channel, any of them.
+  * @param      state: state of the generator of the sequence.
+  * @retval     The byte.
+  */
+static uint8_t Test_Byte(uint32_t *state)
+{
+  return bytes[Test_Random(state) % byteCount];
+}
+
+/**
+  * @brief      Thread producing the bytes of the ring phase, as the UART
+  *             interrupt does: a byte dropped is lost.
+  * @param      argument: not used.
+  * @retval     NULL.
+  */
+static void *Test_RingProduce(void *argument)
+{
+  uint32_t state = seed, i;
+
+  (void)argument;
+  for(i=0; i<total; i++)
+  {
+    if(KNX_Ph_Buffer_Put(&ring, (uint8_t)i) != PH_BUFFER_OK)
+    {
+      /** Marked before the next byte is put, so seen by the consumer
+        * before it. */
+      ringDropped[i] = TRUE;
+      ringFull++;
+    }
+    if((Test_Random(&state) % 64U) == 0U)
+    {
+      sched_yield();
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  * @brief      Ring phase, before the scheduler: the consumer takes the bytes
+  *             one by one or by blocks and checks they are in order, the
+  *             ones dropped left out.
+  */
+static void Test_Ring(void)
+{
+  pthread_t producer;
+  uint8_t block[KNX_PH_BUFFER_SIZE], data;
+  uint32_t state = seed + 1U, next = 0, taken = 0, bad = 0;
+  uint16_t n, i;
+  uint8_t done = FALSE;
+
+  ringDropped = calloc(total, 1);
+  KNX_HOST_CHECK(ringDropped != NULL);
+  if(ringDropped == NULL)
+  {
+    return;
+  }
+  KNX_Ph_Buffer_Init(&ring);
+  ringFull = 0;
+  pthread_create(&producer, NULL, Test_RingProduce, NULL);
+  while(done == FALSE || KNX_Ph_Buffer_Count(&ring) != 0U)
+  {
+    done = (taken + ringFull >= total) ? TRUE : FALSE;
+    if((Test_Random(&state) & 1U) == 0U)
+    {
+      n = (KNX_Ph_Buffer_Get(&ring, &data) == PH_BUFFER_OK) ? 1U : 0U;
+      block[0] = data;
+    }
+    else
+    {
+      n = KNX_Ph_Buffer_Read(&ring, block, (uint16_t)(1U + Test_Random(&state) % KNX_PH_BUFFER_SIZE));
+    }
+    for(i=0; i<n; i++)
+    {
+      /** The byte following the previous one, the dropped ones skipped. */
+      while((next < total) && (ringDropped[next] == TRUE))
+      {
+        next++;
+      }
+      bad += ((next < total) && (block[i] == (uint8_t)next)) ? 0U : 1U;
+      next++;
+    }
+    taken += n;
+    if(n == 0U)
+    {
+      sched_yield();
+    }
+  }
+  pthread_join(producer, NULL);
+  free(ringDropped);
+
+  printf("{\"test\":\"ph_rx\",\"phase\":\"ring\",\"bytes\":%lu,\"taken\":%lu,"
+         "\"overruns\":%lu,\"max_level\":%lu,\"bad\":%lu}\n",
+         (unsigned long)total, (unsigned long)taken,
+         (unsigned long)KNX_Ph_Buffer_GetOverruns(&ring),
+         (unsigned long)ring.MaxLevel, (unsigned long)bad);
+  KNX_HOST_CHECK(bad == 0U);
+  KNX_HOST_CHECK(taken + ringFull == total);
+  KNX_HOST_CHECK(KNX_Ph_Buffer_GetOverruns(&ring) == ringFull);
+  KNX_HOST_CHECK(ring.MaxLevel <= KNX_PH_BUFFER_SIZE);
+}
+
+/**
+  * @brief      One byte on the line, like an RXNE interrupt.
+  * @param      data: the byte.
+  */
+static void Test_Fire(uint8_t data)
+{
+  KNX_Ph_Buffer_Put(&line.TPUart.Emu.HostRx, data);
+  TPUart_isr(&line.TPUart);
+}
+
+/**
+  * @brief      Task of the simulated UART, runs ::phase then notifies the
+  *             main task.
+  * @param      argument: not used.
+  */
+static void Test_UartTask(void *argument)
+{
+  KNX_Ph_Buffer_t *data = &line.RxChannels[PH_CHANNEL_DATA].Buffer;
+  uint32_t state = seed, draw = seed + 2U, sent = 0, burst, i;
+
+  (void)argument;
+  switch(phase)
+  {
+    case TEST_UART_DRAIN:
+      while(sent < total)
+      {
+        burst = 1U + Test_Random(&draw) % KNX_PH_BUFFER_SIZE;
+        burst = (burst > total - sent) ? total - sent : burst;
+        /** Wait for the room of the burst, the UART does not overrun. */
+        while(KNX_PH_BUFFER_SIZE - KNX_Ph_Buffer_Count(data) < burst)
+        {
+          vTaskDelay(1);
+        }
+        for(i=0; i<burst; i++)
+        {
+          Test_Fire(Test_Byte(&state));
+        }
+        sent += burst;
+      }
+      break;
+
+    case TEST_UART_OVERRUN:
+      for(i=0; i<3U * KNX_PH_BUFFER_SIZE; i++)
+      {
+        Test_Fire(Test_Byte(&state));
+      }
+      break;
+
+    case TEST_UART_WAKE:
+    default:
+      vTaskDelay(pdMS_TO_TICKS(TEST_WAKE_DELAY));
+      Test_Fire(Test_Byte(&state));
+      break;
+  }
+
+  xTaskNotifyGive(mainTask);
+  vTaskDelete(NULL);
+}
+
+/**
+  * @brief      Start the simulated UART on a phase.
+  * @param      uart: the phase.
+  */
+static void Test_StartUart(Test_Uart_t uart)
+{
+  phase = uart;
+  xTaskCreate(Test_UartTask, "Test UART", KNX_HOST_TASK_STACK, NULL,
+              KNX_PH_TPUART_EMU_PRIORITY, NULL);
+}
+
+/**
+  * @brief      Main task of the test, the consumer of the line.
+  * @param      argument: not used.
+  */
+static void Test_Task(void *argument)
+{
+  uint8_t block[3U * KNX_PH_BUFFER_SIZE], data;
+  uint32_t state, draw, taken, bad, i, start, waited;
+  uint16_t length;
+
+  (void)argument;
+  mainTask = xTaskGetCurrentTaskHandle();
+  KNX_HOST_CHECK(KNX_Ph_Init(&line) == PH_ERROR_NONE);
+  if(KNX_Host_GetFailures() != 0U)
+  {
+    KNX_Host_Exit();
+  }
+
+  /** Drain: single and bulk reads, every byte in order. */
+  state = seed;
+  draw = seed + 3U;
+  taken = 0;
+  bad = 0;
+  Test_StartUart(TEST_UART_DRAIN);
+  while(taken < total)
+  {
+    if((Test_Random(&draw) & 1U) == 0U)
+    {
+      if(KNX_Ph_RecData(&line, &data, TEST_TIMEOUT) != PH_ERROR_NONE)
+      {
+        break;
+      }
+      bad += (data == Test_Byte(&state)) ? 0U : 1U;
+      taken++;
+    }
+    else
+    {
+      length = (uint16_t)(1U + Test_Random(&draw) % KNX_PH_BUFFER_SIZE);
+      if(KNX_Ph_RecDatas(&line, block, &length, TEST_TIMEOUT) != PH_ERROR_NONE)
+      {
+        break;
+      }
+      for(i=0; i<length; i++)
+      {
+        bad += (block[i] == Test_Byte(&state)) ? 0U : 1U;
+      }
+      taken += length;
+    }
+  }
+  ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  printf("{\"test\":\"ph_rx\",\"phase\":\"drain\",\"bytes\":%lu,\"taken\":%lu,"
+         "\"overruns\":%lu,\"max_level\":%lu,\"bad\":%lu}\n",
+         (unsigned long)total, (unsigned long)taken,
+         (unsigned long)KNX_Ph_GetRxOverruns(&line),
+         (unsigned long)line.RxChannels[PH_CHANNEL_DATA].Buffer.MaxLevel,
+         (unsigned long)bad);
+  KNX_HOST_CHECK(bad == 0U);
+  KNX_HOST_CHECK(taken == total);
+  KNX_HOST_CHECK(KNX_Ph_GetRxOverruns(&line) == 0U);
+
+  /** Overrun: the ring keeps the first bytes, counts the others. */
+  state = seed;
+  Test_StartUart(TEST_UART_OVERRUN);
+  ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  KNX_HOST_CHECK(KNX_Ph_Buffer_Count(&line.RxChannels[PH_CHANNEL_DATA].Buffer) == KNX_PH_BUFFER_SIZE);
+  KNX_HOST_CHECK(KNX_Ph_GetRxOverruns(&line) == 2U * KNX_PH_BUFFER_SIZE);
+  length = sizeof(block);
+  KNX_HOST_CHECK(KNX_Ph_RecDatas(&line, block, &length, TEST_TIMEOUT) == PH_ERROR_NONE);
+  KNX_HOST_CHECK(length == KNX_PH_BUFFER_SIZE);
+  bad = 0;
+  for(i=0; i<length; i++)
+  {
+    bad += (block[i] == Test_Byte(&state)) ? 0U : 1U;
+  }
+  KNX_HOST_CHECK(bad == 0U);
+  KNX_HOST_CHECK(KNX_Ph_RecData(&line, &data, TEST_WAKE_DELAY) == PH_ERROR_TIMEOUT);
+  printf("{\"test\":\"ph_rx\",\"phase\":\"overrun\",\"bytes\":%lu,\"taken\":%lu,"
+         "\"overruns\":%lu,\"bad\":%lu}\n",
+         (unsigned long)(3U * KNX_PH_BUFFER_SIZE), (unsigned long)length,
+         (unsigned long)KNX_Ph_GetRxOverruns(&line), (unsigned long)bad);
+
+  /** Wake: the reader sleeps until the byte. */
+  state = seed;
+  Test_StartUart(TEST_UART_WAKE);
+  start = KNX_Host_GetRunTime();
+  KNX_HOST_CHECK(KNX_Ph_RecData(&line, &data, TEST_TIMEOUT) == PH_ERROR_NONE);
+  waited = KNX_Host_GetRunTime() - start;
+  KNX_HOST_CHECK(data == Test_Byte(&state));
+  KNX_HOST_CHECK(waited < TEST_TIMEOUT * 1000U / 2U);
+  ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  printf("{\"test\":\"ph_rx\",\"phase\":\"wake\",\"delay_us\":%lu,\"waited_us\":%lu}\n",
+         (unsigned long)(TEST_WAKE_DELAY * 1000U), (unsigned long)waited);
+
+  KNX_Host_Exit();
+}
+
+/**
+  * @brief      Entry point.
+  * @param      argc: number of arguments.
+  * @param      argv: options, as \c name=value.
+  * @retval     0 on success.
+  */
+int main(int argc, char **argv)
+{
+  uint32_t i;
+
+  KNX_Host_Init(argc, argv);
+  total = KNX_Host_GetOption("bytes", 100000);
+  seed = KNX_Host_GetOption("seed", 1);
+  KNX_HOST_CHECK(total != 0U);
+  KNX_HOST_CHECK(seed != 0U);
+  if(KNX_Host_GetFailures() != 0U)
+  {
+    KNX_Host_Exit();
+  }
+
+  /** The bytes which are neither a CTRL octet nor another service. */
+  byteCount = 0;
+  for(i=0; i<256U; i++)
+  {
+    if(((i & FRAME_CTRL_MASK) != FRAME_CTRL_DATA) && (KNX_Ph_Classify((uint8_t)i) == PH_CHANNEL_DATA))
+    {
+      bytes[byteCount++] = (uint8_t)i;
+    }
+  }
+
+  Test_Ring();
+  KNX_Host_Run(Test_Task, argc, argv);
+  return 0;
+}
@@ -0,0 +1,121 @@
+/**
+  ******************************************************************************
+  * @file       knx_log.c
+  * @author     MA Dingjie
+  * @version    V1.0.0
+  * @date       17-October-2016
+  * @brief      Decoder of the debug UART: reads a capture of the octets sent
+  *             by DebugTask and prints the messages of \ref KNX_Log as text,
+  *             one line per record, with ::KNX_Log_Decode.
+  *
+  *             The capture is a file, or the standard input if none is given
+  *             or it is \c -, so a serial line can be read as it comes:
+  *              + build/knx_log capture.bin
+  *              + cat /dev/ttyUSB0 | build/knx_log
+  *
+  *             It may start in the middle of a record and may miss octets:
+  *             the decoding starts again at the next delimiter. The counts of
+  *             records, bad records and octets skipped go to stderr at the
+  *             end.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "KNX_Log.h"
+
+/* Private constants ---------------------------------------------------------*/
+/** \brief Size of the buffer of the octets read. */
+#define TOOL_BUFFER_SIZE        ((uint16_t)4096)
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t           buffer[TOOL_BUFFER_SIZE];
+static char              text[256];
+
+/**
+  * @brief      Entry point.
+  * @param      argc: number of arguments.
+  * @param      argv: the capture file, none or \c - for the standard input.
+  * @retval     0 on success, 1 if the capture can't be read.
+  */
+int main(int argc, char **argv)
+{
+  KNX_Log_Stream_t stream;
+  FILE *capture = stdin;
+  unsigned long records = 0, bad = 0, skipped = 0;
+  uint16_t length = 0, offset, used, n;
+  ssize_t got;
+
+  if((argc > 2) || ((argc == 2) && (strcmp(argv[1], "-h") == 0)))
+  {
+    fprintf(stderr, "usage: %s [capture|-]\n", argv[0]);
+    return 1;
+  }
+  if((argc == 2) && (strcmp(argv[1], "-") != 0))
+  {
+    capture = fopen(argv[1], "rb");
+    if(capture == NULL)
+    {
+      perror(argv[1]);
+      return 1;
+    }
+  }
+
+  KNX_Log_InitStream(&stream);
+  do
+  {
+    /** read rather than fread: a line comes out as soon as its record. */
+    got = read(fileno(capture), &buffer[length], (size_t)(TOOL_BUFFER_SIZE - length));
+    if(got < 0)
+    {
+      perror((capture == stdin) ? "stdin" : argv[1]);
+      return 1;
+    }
+    length = (uint16_t)(length + got);
+
+    offset = 0;
+    for(;;)
+    {
+      n = KNX_Log_Decode(&stream, &buffer[offset], (uint16_t)(length - offset), &used, text, sizeof(text));
+      if(used == 0U)
+      {
+        break;
+      }
+      if(n != 0U)
+      {
+        fputs(text, stdout);
+        fflush(stdout);
+        if(strncmp(text, "[Log]", 5) == 0)
+        {
+          bad++;
+        }
+        else
+        {
+          records++;
+        }
+      }
+      else if((used > 1U) || (buffer[offset] != KNX_LOG_DELIMITER))
+      {
+        /** Octets without a delimiter where one should be. */
+        skipped += used;
+      }
+      offset = (uint16_t)(offset + used);
+    }
+
+    /** Keep the start of the record not complete yet. */
+    memmove(buffer, &buffer[offset], (size_t)(length - offset));
+    length = (uint16_t)(length - offset);
+  } while(got != 0);
+
+  if(capture != stdin)
+  {
+    fclose(capture);
+  }
+  skipped += length;
+
+  fprintf(stderr, "%lu records, %lu bad, %lu octets skipped\n", records, bad, skipped);
+
+  return 0;
+}
@@ -0,0 +1,118 @@
+/**
+  ******************************************************************************
+  * @file       KNX_Addr.h
+  * @author     MA Dingjie
+  * @version    V1.0.0
+  * @date       17-October-2016
+  * @brief      This file contains definitions and prototypes of functions for
+  *             the addresses a device answers to on a line.
+  ******************************************************************************
+  */
+
+#ifndef __KNX_ADDR
+#define __KNX_ADDR
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "KNX_def.h"
+
+/** @addtogroup KNX_Lib
+  * @{
+  */
+
+/** @addtogroup KNX_Addr
+  * @{
+  */
+
+/* Exported constants --------------------------------------------------------*/
+/** @defgroup KNX_Addr_Exported_Constants KNX Addr Exported Constants
+  * @{
+  */
+/** \brief Number of 32 bits words of the group address bitmap, one bit for
+  *        each of the 65536 group addresses. */
+#define KNX_ADDR_GROUP_WORDS    ((uint32_t)(65536U / 32U))
+/** \brief Group address of the broadcast frames. */
+#define KNX_ADDR_BROADCAST      ((uint16_t)0x0000U)
+/**
+  * @}
+  */
+
+/* Exported types ------------------------------------------------------------*/
+/** @defgroup KNX_Addr_Exported_Types KNX Addr Exported Types
+  * @{
+  */
+
+/**
+  * @brief  Addresses of a device on a line: its individual address and the
+  *         group addresses it is member of. The bitmap takes 8 KB but answers
+  *         in constant time, from the RX interrupt.
+  */
+typedef struct
+{
+  uint16_t Individual;                          /*!< Individual address      */
+  uint32_t Groups[KNX_ADDR_GROUP_WORDS];        /*!< Bit set for each group
+                                                     address of the device   */
+} KNX_Addr_t;
+/**
+  * @}
+  */
+
+/* Exported macros -----------------------------------------------------------*/
+/** @defgroup KNX_Addr_Exported_Macros KNX Addr Exported Macros
+  * @{
+  */
+/** \brief TRUE if the device is member of the group address \b ga. */
+#define KNX_ADDR_IS_GROUP(addr, ga)     \
+  ((((addr)->Groups[(uint16_t)(ga) >> 5] >> ((ga) & 0x1FU)) & 1U) != 0U)
+/**
+  * @}
+  */
+
+/* Exported functions --------------------------------------------------------*/
+/** @addtogroup KNX_Addr_Exported_Functions
+  * @{
+  */
+
+/** @addtogroup KNX_Addr_Exported_Functions_Group1
+  * @{
+  */
+
+/* Initialization functions ***************************************************/
+void KNX_Addr_Init(KNX_Addr_t *addr, uint16_t individual);
+void KNX_Addr_AddGroup(KNX_Addr_t *addr, uint16_t ga);
+void KNX_Addr_RemoveGroup(KNX_Addr_t *addr, uint16_t ga);
+/**
+  * @}
+  */
+
+/** @addtogroup KNX_Addr_Exported_Functions_Group2
+  * @{
+  */
+
+/* Look up functions, usable from interrupts  *********************************/
+uint8_t KNX_Addr_Match(const KNX_Addr_t *addr, uint16_t da, uint8_t group);
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KNX_ADDR */
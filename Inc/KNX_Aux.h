@@ -42,6 +42,9 @@
 /**
   * @}
   */
+
+/** \brief Initial value of a CRC-16-CCITT */
+#define KNX_CRC16_INIT          ((uint16_t)0xFFFFU)
     
 /**
   * @}
@@ -61,6 +64,17 @@ typedef enum
   TIMER_RUNNING         = 0x01U,        /*!< Timer is running                 */
   TIMER_PAUSE           = 0x02U         /*!< Timer is paused                  */
 } TIMER_Status_t;
+
+/**
+  * @brief  A timeout, owned by the waiting task, usually on its stack. The
+  *         start and the duration don't change, so any number of tasks can
+  *         wait at once and a check reads the timer once.
+  */
+typedef struct
+{
+  uint32_t Start;               /*!< Tick of ::KNX_Deadline_Init              */
+  uint32_t Ticks;               /*!< Ticks to wait, ::KNX_MAX_DELAY forever   */
+} KNX_Deadline_t;
 /**
   * @}
   */
@@ -90,6 +104,13 @@ uint32_t KNX_ResetTimer(void);
 TIMER_Status_t KNX_GetTimerState(void);
 
 uint8_t KNX_CheckForTimeOut(uint32_t * const timeOnEntering, uint32_t * const pxTicksToWait);
+void KNX_Deadline_Init(KNX_Deadline_t *deadline, uint32_t timeout);
+uint32_t KNX_Deadline_Remaining(const KNX_Deadline_t *deadline);
+uint8_t KNX_Deadline_Expired(const KNX_Deadline_t *deadline);
+
+void KNX_InitCycles(void);
+uint32_t KNX_GetCycles(void);
+uint32_t KNX_GetMicros(void);
 
 void KNX_systick_isr(void);
 /**
@@ -104,6 +125,15 @@ uint8_t KNX_VerticalParity(uint8_t *datas, uint16_t length);
   * @}
   */
 
+/** @addtogroup KNX_Aux_Exported_Functions_Group4
+  * @{
+  */
+uint16_t KNX_Crc16_Update(uint16_t crc, uint8_t data);
+uint16_t KNX_Crc16(const uint8_t *datas, uint16_t length);
+/**
+  * @}
+  */
+
 /**
   * @}
   */
@@ -0,0 +1,229 @@
+/**
+  ******************************************************************************
+  * @file       KNX_Bus.h
+  * @author     MA Dingjie
+  * @version    V1.0.0
+  * @date       17-October-2016
+  * @brief      This file contains definitions and prototypes of functions for
+  *             the simulated KNX TP1 bus linking emulated TP-UARTs, host
+  *             builds only.
+  ******************************************************************************
+  */
+
+#ifndef __KNX_BUS
+#define __KNX_BUS
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "KNX_def.h"
+#include "KNX_Ph_TPUart.h"
+
+#if KNX_PH_TPUART_BACKEND == KNX_PH_TPUART_EMU
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+/** @addtogroup KNX_Lib
+  * @{
+  */
+
+/** @addtogroup KNX_Bus
+  * @{
+  */
+
+/* Exported constants --------------------------------------------------------*/
+/** @defgroup KNX_Bus_Exported_Constants KNX Bus Exported Constants
+  * @{
+  */
+
+/** @defgroup KNX_Bus_Error_Code KNX Bus Error Code
+  * @{
+  */
+#define BUS_ERROR_NONE          ((uint8_t)0x00U)   /*!< No error              */
+#define BUS_ERROR_INIT          ((uint8_t)0x01U)   /*!< Initialization error  */
+#define BUS_ERROR_FULL          ((uint8_t)0x02U)   /*!< No room for a node    */
+/**
+  * @}
+  */
+
+/** @defgroup KNX_Bus_Timing KNX Bus Timing
+  * @brief    TP1 timing in bit times of 1/9600 s, a character is 11 bits
+  *           and 2 bits of pause.
+  * @{
+  */
+#define KNX_BUS_CHAR_BITS       ((uint32_t)13)     /*!< Character of a frame  */
+#define KNX_BUS_ACK_GAP_BITS    ((uint32_t)15)     /*!< End of frame to ack   */
+#define KNX_BUS_ACK_BITS        ((uint32_t)13)     /*!< Ack character         */
+#define KNX_BUS_IDLE_BITS       ((uint32_t)50)     /*!< Line free before a
+                                                        frame                 */
+#define KNX_BUS_BUSY_BITS       ((uint32_t)150)    /*!< Wait after a busy ack */
+/** \brief Duration of \b bits bit times in us. */
+#define KNX_BUS_BITS_TO_US(bits)        ((uint32_t)(((bits) * 1000000U) / 9600U))
+/**
+  * @}
+  */
+
+/** \brief Max number of nodes on a bus. */
+#ifndef KNX_BUS_MAX_NODES
+#define KNX_BUS_MAX_NODES       ((uint8_t)16)
+#endif
+/** \brief Repetitions of a frame not acknowledged, as after U_MxRstCnt. */
+#ifndef KNX_BUS_REPEATS
+#define KNX_BUS_REPEATS         ((uint8_t)3)
+#endif
+/** \brief Width of a bin of the latency histogram, in us. */
+#ifndef KNX_BUS_LATENCY_BIN
+#define KNX_BUS_LATENCY_BIN     ((uint32_t)5000)
+#endif
+/** \brief Number of bins of the latency histogram, the last one holds the
+  *        latencies beyond. */
+#ifndef KNX_BUS_LATENCY_BINS
+#define KNX_BUS_LATENCY_BINS    ((uint16_t)32)
+#endif
+/** \brief Priority of the task of the bus, below the emulated TP-UARTs. */
+#ifndef KNX_BUS_TASK_PRIORITY
+#define KNX_BUS_TASK_PRIORITY   (configMAX_PRIORITIES - 2)
+#endif
+/** \brief Stack of the task of the bus, in words. */
+#ifndef KNX_BUS_TASK_STACK
+#define KNX_BUS_TASK_STACK      (configMINIMAL_STACK_SIZE + 128)
+#endif
+/**
+  * @}
+  */
+
+/* Exported types ------------------------------------------------------------*/
+/** @defgroup KNX_Bus_Exported_Types KNX Bus Exported Types
+  * @{
+  */
+
+/**
+  * @brief  Counters of a node.
+  */
+typedef struct
+{
+  uint32_t Requests;            /*!< Frames handed by the TP-UART             */
+  uint32_t Confirmed;           /*!< Frames acknowledged                      */
+  uint32_t Failed;              /*!< Frames given up after the repetitions    */
+  uint32_t Repeats;             /*!< Repetitions sent                         */
+  uint32_t ArbitrationLost;     /*!< Arbitrations lost to another node        */
+  uint32_t Overruns;            /*!< Frames of the bus the TP-UART had no room
+                                     for                                      */
+} KNX_Bus_NodeStats_t;
+
+/**
+  * @brief  Counters of a bus. The times are in us of simulated bus time.
+  */
+typedef struct
+{
+  uint32_t Frames;              /*!< Frames sent, repetitions included        */
+  uint32_t Collisions;          /*!< Arbitrations with several nodes          */
+  uint32_t Repeats;             /*!< Repetitions                              */
+  uint32_t Acks;                /*!< Frames acknowledged                      */
+  uint32_t Nacks;               /*!< Frames negatively acknowledged           */
+  uint32_t Busys;               /*!< Frames answered busy                     */
+  uint32_t NoAcks;              /*!< Frames nobody acknowledged               */
+  uint32_t Failed;              /*!< Frames given up after the repetitions    */
+  uint32_t BusyTime;            /*!< Time with a frame or an ack on the line  */
+  uint32_t SlotTime;            /*!< Time taken by the frames, each with its
+                                     ack and the idle line after it           */
+  uint32_t Elapsed;             /*!< Time since ::KNX_Bus_Init                */
+  uint32_t LatencyCount;        /*!< Frames acknowledged in the latencies     */
+  uint32_t LatencyMin;          /*!< Shortest request to confirmation         */
+  uint32_t LatencyMax;          /*!< Longest request to confirmation          */
+  uint64_t LatencySum;          /*!< Sum of the latencies                     */
+  uint32_t Latency[KNX_BUS_LATENCY_BINS]; /*!< Histogram of the latencies,
+                                     bins of ::KNX_BUS_LATENCY_BIN            */
+} KNX_Bus_Stats_t;
+
+struct KNX_Bus;
+
+/**
+  * @brief  A device on the bus, one per emulated TP-UART.
+  */
+typedef struct
+{
+  struct KNX_Bus        *Bus;           /*!< Bus of the node                  */
+  TPUart_Handle_t       *TPUart;        /*!< Emulated TP-UART of the device   */
+  uint8_t               Pending;        /*!< TRUE while ::Frame waits for the
+                                             bus                              */
+  uint8_t               Repeats;        /*!< Repetitions of ::Frame so far    */
+  uint8_t               Sending;        /*!< TRUE while ::Frame is on the line */
+  uint8_t               Frame[FRAME_SIZE]; /*!< Frame to send                 */
+  uint16_t              Length;         /*!< Octets of ::Frame                */
+  uint32_t              Requested;      /*!< Time of the request, in us       */
+  uint32_t              ReadyAt;        /*!< Bus time before which ::Frame
+                                             doesn't contend, in us           */
+  KNX_Bus_NodeStats_t   Stats;          /*!< Counters of the node             */
+} KNX_Bus_Node_t;
+
+/**
+  * @brief  A simulated TP1 line. Time runs on the us of ::KNX_GetMicros: the
+  *         bus computes the duration of each frame in bit times and the
+  *         task sleeps until the line would be free again, so the stacks of
+  *         the nodes see the timing of a real line.
+  */
+typedef struct KNX_Bus
+{
+  KNX_Bus_Node_t        Nodes[KNX_BUS_MAX_NODES]; /*!< Devices of the bus     */
+  uint8_t               NodeCount;      /*!< Devices attached                 */
+  SemaphoreHandle_t     Wake;           /*!< Given for each new request       */
+  TaskHandle_t          Task;           /*!< Task of the bus                  */
+  uint32_t              Now;            /*!< Bus time, in us                  */
+  uint32_t              Start;          /*!< Time of ::KNX_Bus_Init, in us    */
+  KNX_Bus_Stats_t       Stats;          /*!< Counters of the bus              */
+} KNX_Bus_t;
+/**
+  * @}
+  */
+
+/* Exported functions --------------------------------------------------------*/
+/** @addtogroup KNX_Bus_Exported_Functions
+  * @{
+  */
+
+/** @addtogroup KNX_Bus_Exported_Functions_Group1
+  * @{
+  */
+
+/* Initialization functions ***************************************************/
+uint8_t KNX_Bus_Init(KNX_Bus_t *bus);
+uint8_t KNX_Bus_Attach(KNX_Bus_t *bus, TPUart_Handle_t *htpuart);
+/**
+  * @}
+  */
+
+/** @addtogroup KNX_Bus_Exported_Functions_Group2
+  * @{
+  */
+
+/* State functions  ***********************************************************/
+void KNX_Bus_GetStats(KNX_Bus_t *bus, KNX_Bus_Stats_t *stats);
+void KNX_Bus_GetNodeStats(KNX_Bus_t *bus, uint8_t node, KNX_Bus_NodeStats_t *stats);
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#endif /* KNX_PH_TPUART_BACKEND == KNX_PH_TPUART_EMU */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KNX_BUS */
@@ -20,6 +20,15 @@
 /* Includes ------------------------------------------------------------------*/
 #include <stdio.h>
 #include <stdint.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "KNX_Frame.h"
+#include "KNX_Ph.h"
+#include "KNX_Addr.h"
+#include "KNX_Histogram.h"
+#include "KNX_Timer.h"
    
 /** @addtogroup KNX_Lib
   * @{
@@ -48,6 +57,89 @@
 #define DL_ERROR_FRAME          ((uint8_t)0x06U)   /*!< Frame error           */
 #define DL_ERROR_ADDRESS        ((uint8_t)0x06U)   /*!< Address error         */
 #define DL_ERROR_BUSY           ((uint8_t)0x06U)   /*!< Busy                  */
+#define DL_ERROR_NO_BUFFER      ((uint8_t)0x07U)   /*!< Frame pool exhausted  */
+#define DL_ERROR_DUPLICATE      ((uint8_t)0x08U)   /*!< Repetition dropped    */
+/**
+  * @}
+  */
+
+/** \brief Max number of consumers of the frames received, can be overridden
+  *        at build time. */
+#ifndef KNX_DL_MAX_CONSUMERS
+#define KNX_DL_MAX_CONSUMERS    ((uint8_t)4)
+#endif
+
+/** @defgroup DL_Tx_Scheduling Data Link Layer Transmit Scheduling
+  * @brief    The frames to send wait in one queue per priority, drained by
+  *           ::KNX_DL_TxTask. They can be overridden at build time.
+  * @{
+  */
+/** \brief Number of priorities: system, urgent, normal and low. */
+#define DL_TX_PRIORITIES        ((uint8_t)4)
+/** \brief Depth of each transmit queue. */
+#ifndef KNX_DL_TX_QUEUE_SIZE
+#define KNX_DL_TX_QUEUE_SIZE    ((uint32_t)8)
+#endif
+/** \brief Time in ms after which a frame waiting is sent before the frames
+  *        of higher priorities, so none starves. Measured by a timer of
+  *        \ref KNX_Timer armed for each request. */
+#ifndef KNX_DL_TX_AGING
+#define KNX_DL_TX_AGING         ((uint32_t)200)
+#endif
+/** \brief Priority of ::KNX_DL_TxTask. */
+#ifndef KNX_DL_TX_TASK_PRIORITY
+#define KNX_DL_TX_TASK_PRIORITY (tskIDLE_PRIORITY + 2)
+#endif
+/** \brief Stack size of ::KNX_DL_TxTask in words. */
+#ifndef KNX_DL_TX_TASK_STACK
+#define KNX_DL_TX_TASK_STACK    (configMINIMAL_STACK_SIZE + 64)
+#endif
+/** \brief Bit of the task notification set by ::KNX_DL_TxTask once a
+  *        request is done. The top bit, so the counts of the notifications
+  *        given to the same task by vTaskNotifyGive are left alone. */
+#ifndef KNX_DL_TX_NOTIFY_BIT
+#define KNX_DL_TX_NOTIFY_BIT    ((uint32_t)0x80000000U)
+#endif
+/**
+  * @}
+  */
+
+/** @defgroup DL_Duplicates Data Link Layer Duplicate Suppression
+  * @brief    A repetition of a frame already received is dropped. They can
+  *           be overridden at build time.
+  * @{
+  */
+/** \brief Number of entries of the cache of the frames received, must be a
+  *        power of 2. */
+#ifndef KNX_DL_DUP_CACHE_SIZE
+#define KNX_DL_DUP_CACHE_SIZE   ((uint32_t)16)
+#endif
+/** \brief Time in ms during which a repetition is recognized. */
+#ifndef KNX_DL_DUP_WINDOW
+#define KNX_DL_DUP_WINDOW       ((uint32_t)1000)
+#endif
+/**
+  * @}
+  */
+
+/** @defgroup DL_Backpressure Data Link Layer Backpressure
+  * @brief    Fill levels, in percent of the deepest filled queue among the
+  *           frame queue of the PH and the consumers, that enter and leave
+  *           ::DL_BUSY. They can be overridden at build time.
+  * @{
+  */
+#ifndef KNX_DL_BUSY_HIGH_WATER
+#define KNX_DL_BUSY_HIGH_WATER  ((uint32_t)75)
+#endif
+#ifndef KNX_DL_BUSY_LOW_WATER
+#define KNX_DL_BUSY_LOW_WATER   ((uint32_t)25)
+#endif
+/** \brief Period, in ms, at which the busy mode of the TP-UART is renewed
+  *        by ::KNX_DL_TxTask on a timer of \ref KNX_Timer: it ends by itself
+  *        after 700 ms. */
+#ifndef KNX_DL_BUSY_REFRESH
+#define KNX_DL_BUSY_REFRESH     ((uint32_t)500)
+#endif
 /**
   * @}
   */
@@ -74,6 +166,113 @@ typedef enum
   DL_STOP       = 0x04U,        /*!< Stop Mode                                */
   DL_BUSY       = 0x05U         /*!< Busy Mode                                */
 } DL_Status_t;
+
+/**
+  * @brief  A request to send a frame, queued by ::KNX_DL_Data_req. It lives
+  *         on the stack of the requesting task until ::KNX_DL_TX_NOTIFY_BIT
+  *         is set.
+  */
+typedef struct
+{
+  KNX_Frame_t           *Frame;         /*!< Frame to send                    */
+  TaskHandle_t          Task;           /*!< Task notified at the end         */
+  uint32_t              Enqueued;       /*!< Time of the request in us        */
+  KNX_Timer_t           Aging;          /*!< Expires after ::KNX_DL_TX_AGING  */
+  volatile uint8_t      Aged;           /*!< TRUE once ::Aging has expired    */
+  uint8_t               Result;         /*!< See \ref DL_Error_Code           */
+} DL_TxRequest_t;
+
+/**
+  * @brief  Counters of a transmit queue. The times are in us.
+  */
+typedef struct
+{
+  uint32_t              Requests;       /*!< Frames queued                    */
+  uint32_t              Rejected;       /*!< Requests refused, queue full     */
+  uint32_t              Sent;           /*!< Frames confirmed by the bus      */
+  uint32_t              Failed;         /*!< Frames not confirmed             */
+  uint32_t              Aged;           /*!< Frames sent before higher
+                                             priorities after ::KNX_DL_TX_AGING*/
+  uint16_t              Depth;          /*!< Frames waiting                   */
+  uint16_t              MaxDepth;       /*!< Highest number of frames waiting */
+  uint32_t              WaitMax;        /*!< Worst time in the queue          */
+  uint64_t              WaitSum;        /*!< Sum of the times in the queue    */
+  uint32_t              LatencyMax;     /*!< Worst time from the request to
+                                             the confirmation                 */
+  uint64_t              LatencySum;     /*!< Sum of the times from the
+                                             request to the confirmation      */
+} DL_TxStats_t;
+
+/**
+  * @brief  Performance counters of a line, since ::KNX_DL_Init or
+  *         ::KNX_DL_ResetPerf. The cycles are those of ::KNX_GetCycles.
+  */
+typedef struct
+{
+  uint32_t              Since;          /*!< Tick of the start                */
+  KNX_Histogram_t       TxLatency;      /*!< Request to confirmation of the
+                                             frames confirmed, in us          */
+  uint32_t              TxFrames;       /*!< Frames built by ::KNX_DL_Data_req */
+  uint64_t              TxCycles;       /*!< Cycles to build and queue them   */
+  uint32_t              RxFrames;       /*!< Frames checked by
+                                             ::KNX_DL_Frame_rec               */
+  uint64_t              RxCycles;       /*!< Cycles to check and dispatch them */
+} DL_PerfStats_t;
+
+/**
+  * @brief  An entry of the cache of the frames received. The header is kept
+  *         besides the hash, so two frames colliding on the hash are only
+  *         taken for each other if they also come from the same device to
+  *         the same destination.
+  */
+typedef struct
+{
+  uint32_t              Hash;           /*!< Hash of the frame, 0 if unused   */
+  uint32_t              Tick;           /*!< Tick of the reception            */
+  uint16_t              Sa;             /*!< Source address                   */
+  uint16_t              Da;             /*!< Destination address              */
+  uint8_t               Ctrl;           /*!< CTRL octet, repeat bit set       */
+} DL_DupEntry_t;
+
+/**
+  * @brief  DL Handle structure definition, one per line. ::Ph and ::Addr
+  *         are set by the user before ::KNX_DL_Init, with ::KNX_Addr_Init and
+  *         ::KNX_Addr_AddGroup; the rest is private to the data link layer.
+  */
+typedef struct
+{
+  PH_Handle_t           *Ph;            /*!< Physical layer of the line       */
+  KNX_Addr_t            Addr;           /*!< Individual and group addresses of
+                                             the device on the line           */
+  DL_Status_t           State;          /*!< Current state of the line        */
+  QueueHandle_t         Consumers[KNX_DL_MAX_CONSUMERS]; /*!< Queues registered
+                                             with ::KNX_DL_AddConsumer        */
+  uint8_t               ConsumersNb;    /*!< Number of entries used in
+                                             ::Consumers                      */
+  uint32_t              ConsumerDrops;  /*!< Frames not handed to a consumer
+                                             because its queue was full or
+                                             the frame had no owner left      */
+  uint32_t              BusyEntries;    /*!< Number of times ::DL_BUSY was
+                                             entered                          */
+  uint32_t              BusyTime;       /*!< Time spent in ::DL_BUSY in ms,
+                                             the ongoing period excluded      */
+  uint32_t              BusySince;      /*!< Tick when ::DL_BUSY was entered  */
+  KNX_Timer_t           BusyTimer;      /*!< Expires every
+                                             ::KNX_DL_BUSY_REFRESH in ::DL_BUSY */
+  volatile uint8_t      BusyRenew;      /*!< Set by ::BusyTimer, the busy mode
+                                             is renewed by ::KNX_DL_TxTask    */
+  QueueHandle_t         TxQueues[DL_TX_PRIORITIES]; /*!< Requests of type
+                                             \c DL_TxRequest_t*, from system
+                                             to low priority                  */
+  SemaphoreHandle_t     TxSemaphore;    /*!< Counts the requests queued       */
+  TaskHandle_t          TxTask;         /*!< ::KNX_DL_TxTask of the line      */
+  DL_TxStats_t          TxStats[DL_TX_PRIORITIES]; /*!< Counters of
+                                             ::TxQueues                       */
+  DL_DupEntry_t         DupCache[KNX_DL_DUP_CACHE_SIZE]; /*!< Frames received
+                                             lately, indexed by their hash    */
+  uint32_t              DupDrops;       /*!< Repetitions dropped              */
+  DL_PerfStats_t        Perf;           /*!< Performance counters             */
+} DL_Handle_t;
 /**
   * @}
   */
@@ -88,7 +287,7 @@ typedef enum
   */
 
 /* Initialization functions  **************************************************/
-uint8_t KNX_DL_Init(void);
+uint8_t KNX_DL_Init(DL_Handle_t *hdl);
 /**
   * @}
   */
@@ -98,8 +297,11 @@ uint8_t KNX_DL_Init(void);
   */
 
 /* Services functions  ********************************************************/
-uint8_t KNX_DL_Data_req(uint8_t Tx_FT, uint8_t Tx_AT, uint16_t Tx_DA, uint8_t Tx_Pri, uint8_t *Tx_LSDU, uint8_t Tx_LG);
-uint8_t KNX_DL_Data_rec(uint8_t *Rx_FT, uint8_t *Rx_AT, uint16_t *Rx_SA, uint8_t *Rx_Pri, uint8_t *Rx_LSDU, uint8_t *Rx_LG);
+uint8_t KNX_DL_Data_req(DL_Handle_t *hdl, uint8_t Tx_FT, uint8_t Tx_AT, uint16_t Tx_DA, uint8_t Tx_Pri, uint8_t *Tx_LSDU, uint8_t Tx_LG);
+uint8_t KNX_DL_Data_rec(DL_Handle_t *hdl, uint8_t *Rx_FT, uint8_t *Rx_AT, uint16_t *Rx_SA, uint8_t *Rx_Pri, uint8_t *Rx_LSDU, uint8_t *Rx_LG);
+uint8_t KNX_DL_Frame_rec(DL_Handle_t *hdl, KNX_Frame_t **frame);
+uint8_t KNX_DL_AddConsumer(DL_Handle_t *hdl, QueueHandle_t queue);
+void    KNX_DL_TxTask(void *argument);
 /**
   * @}
   */
@@ -109,7 +311,14 @@ uint8_t KNX_DL_Data_rec(uint8_t *Rx_FT, uint8_t *Rx_AT, uint16_t *Rx_SA, uint8_t
   */
 
 /* State functions  **********************************************************/
-DL_Status_t KNX_DL_GetState(void);
+DL_Status_t KNX_DL_GetState(DL_Handle_t *hdl);
+uint32_t    KNX_DL_GetConsumerDrops(DL_Handle_t *hdl);
+uint32_t    KNX_DL_GetBusyEntries(DL_Handle_t *hdl);
+uint32_t    KNX_DL_GetBusyTime(DL_Handle_t *hdl);
+void        KNX_DL_GetTxStats(DL_Handle_t *hdl, DL_TxStats_t stats[DL_TX_PRIORITIES]);
+uint32_t    KNX_DL_GetDuplicateDrops(DL_Handle_t *hdl);
+void        KNX_DL_ResetPerf(DL_Handle_t *hdl);
+uint16_t    KNX_DL_Report(DL_Handle_t *hdl, char *buffer, uint16_t size);
 /**
   * @}
   */
@@ -0,0 +1,155 @@
+/**
+  ******************************************************************************
+  * @file       KNX_Frame.h
+  * @author     MA Dingjie
+  * @version    V1.0.0
+  * @date       17-October-2016
+  * @brief      This file contains definitions and prototypes of functions for
+  *             the pool of frame buffers shared by the KNX layers.
+  ******************************************************************************
+  */
+
+#ifndef __KNX_FRAME
+#define __KNX_FRAME
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "KNX_def.h"
+
+/** @addtogroup KNX_Lib
+  * @{
+  */
+
+/** @addtogroup KNX_Frame_Pool
+  * @{
+  */
+
+/* Exported constants --------------------------------------------------------*/
+/** @defgroup KNX_Frame_Pool_Exported_Constants KNX Frame Pool Exported Constants
+  * @{
+  */
+/** \brief Number of frame buffers in the pool, can be overridden at build
+  *        time. */
+#ifndef KNX_FRAME_POOL_SIZE
+#define KNX_FRAME_POOL_SIZE     ((uint16_t)16)
+#endif
+
+/** \brief Most owners of a buffer, the range of ::KNX_Frame_t::RefCount. */
+#define KNX_FRAME_REF_MAX       ((uint8_t)0xFFU)
+
+/** @defgroup KNX_Frame_Verdict KNX Frame Verdict
+  * @brief    Faults found by the RX interrupt while the frame was assembled,
+  *           in ::KNX_Frame_t::Verdict.
+  * @{
+  */
+#define FRAME_VERDICT_OK        ((uint8_t)0x00U)   /*!< Frame valid           */
+#define FRAME_VERDICT_LENGTH    ((uint8_t)0x01U)   /*!< Length octet beyond
+                                                        FRAME_SIZE            */
+#define FRAME_VERDICT_PARITY    ((uint8_t)0x02U)   /*!< Check octet mismatch  */
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/* Exported types ------------------------------------------------------------*/
+/** @defgroup KNX_Frame_Pool_Exported_Types KNX Frame Pool Exported Types
+  * @{
+  */
+
+/**
+  * @brief  A frame buffer of the pool. It is handed between the layers and
+  *         the consumers as a pointer; each owner holds one reference and the
+  *         buffer goes back to the pool when the last one is released.
+  */
+typedef struct KNX_Frame
+{
+  struct KNX_Frame *Next;       /*!< Next free buffer, owned by the pool      */
+  volatile uint8_t RefCount;    /*!< Number of owners, 0 when free            */
+  uint16_t Length;              /*!< Number of octets in ::Datas              */
+  uint32_t Timestamp;           /*!< us of the first octet received, 0 for a
+                                     frame built by a task                    */
+  uint32_t EndTimestamp;        /*!< us of the last octet received            */
+  uint8_t  Verdict;             /*!< See \ref KNX_Frame_Verdict               */
+  uint8_t  Ack;                 /*!< U_AckInformation answered by the RX
+                                     interrupt, 0 if the frame was not acked  */
+  uint8_t  Datas[FRAME_SIZE];   /*!< Octets of the frame, CTRL to checksum    */
+} KNX_Frame_t;
+
+/**
+  * @brief  Counters of the pool.
+  */
+typedef struct
+{
+  uint32_t Allocs;              /*!< Successful allocations                   */
+  uint32_t Exhausted;           /*!< Allocations failed, pool empty           */
+  uint32_t RetainFailed;        /*!< Owners refused, ::KNX_FRAME_REF_MAX
+                                     reached or buffer free                   */
+  uint16_t InUse;               /*!< Buffers currently allocated              */
+  uint16_t MaxInUse;            /*!< Highest number of buffers allocated      */
+} KNX_Frame_Stats_t;
+/**
+  * @}
+  */
+
+/* Exported functions --------------------------------------------------------*/
+/** @addtogroup KNX_Frame_Pool_Exported_Functions
+  * @{
+  */
+
+/** @addtogroup KNX_Frame_Pool_Exported_Functions_Group1
+  * @{
+  */
+
+/* Initialization functions ***************************************************/
+void KNX_Frame_Init(void);
+/**
+  * @}
+  */
+
+/** @addtogroup KNX_Frame_Pool_Exported_Functions_Group2
+  * @{
+  */
+
+/* Allocation functions, usable from tasks and interrupts  ********************/
+KNX_Frame_t *KNX_Frame_Alloc(void);
+uint8_t KNX_Frame_Retain(KNX_Frame_t *frame);
+void KNX_Frame_Release(KNX_Frame_t *frame);
+/**
+  * @}
+  */
+
+/** @addtogroup KNX_Frame_Pool_Exported_Functions_Group3
+  * @{
+  */
+
+/* State functions  ***********************************************************/
+void KNX_Frame_GetStats(KNX_Frame_Stats_t *stats);
+uint8_t KNX_Frame_IsExhausted(void);
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KNX_FRAME */
@@ -0,0 +1,109 @@
+/**
+  ******************************************************************************
+  * @file       KNX_Histogram.h
+  * @author     MA Dingjie
+  * @version    V1.0.0
+  * @date       17-October-2016
+  * @brief      This file contains definitions and prototypes of functions for
+  *             the histograms of latencies with percentiles.
+  ******************************************************************************
+  */
+
+#ifndef __KNX_HISTOGRAM
+#define __KNX_HISTOGRAM
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/** @addtogroup KNX_Lib
+  * @{
+  */
+
+/** @addtogroup KNX_Histogram
+  * @{
+  */
+
+/* Exported constants --------------------------------------------------------*/
+/** @defgroup KNX_Histogram_Exported_Constants KNX Histogram Exported Constants
+  * @brief    The values below ::KNX_HISTOGRAM_LINEAR have a bucket each,
+  *           above each power of 2 is split in ::KNX_HISTOGRAM_SUB buckets,
+  *           so a percentile is off by 1/8 at most.
+  * @{
+  */
+#define KNX_HISTOGRAM_SUB_BITS  ((uint32_t)3)
+#define KNX_HISTOGRAM_SUB       ((uint32_t)1 << KNX_HISTOGRAM_SUB_BITS)
+#define KNX_HISTOGRAM_LINEAR    ((uint32_t)2 * KNX_HISTOGRAM_SUB)
+#define KNX_HISTOGRAM_BUCKETS   (KNX_HISTOGRAM_LINEAR + (32U - KNX_HISTOGRAM_SUB_BITS - 1U) * KNX_HISTOGRAM_SUB)
+/**
+  * @}
+  */
+
+/* Exported types ------------------------------------------------------------*/
+/** @defgroup KNX_Histogram_Exported_Types KNX Histogram Exported Types
+  * @{
+  */
+
+/**
+  * @brief  Histogram of 32 bits values, about 1 KB. Not protected: the
+  *         caller serializes the records and the reads.
+  */
+typedef struct
+{
+  uint32_t Count;               /*!< Values recorded                          */
+  uint32_t Min;                 /*!< Smallest value                           */
+  uint32_t Max;                 /*!< Largest value                            */
+  uint64_t Sum;                 /*!< Sum of the values                        */
+  uint32_t Buckets[KNX_HISTOGRAM_BUCKETS]; /*!< Values per bucket             */
+} KNX_Histogram_t;
+/**
+  * @}
+  */
+
+/* Exported functions --------------------------------------------------------*/
+/** @addtogroup KNX_Histogram_Exported_Functions
+  * @{
+  */
+
+/** @addtogroup KNX_Histogram_Exported_Functions_Group1
+  * @{
+  */
+
+/* Initialization functions ***************************************************/
+void     KNX_Histogram_Init(KNX_Histogram_t *hist);
+/**
+  * @}
+  */
+
+/** @addtogroup KNX_Histogram_Exported_Functions_Group2
+  * @{
+  */
+
+/* Record and read functions  *************************************************/
+void     KNX_Histogram_Record(KNX_Histogram_t *hist, uint32_t value);
+uint32_t KNX_Histogram_Percentile(const KNX_Histogram_t *hist, uint32_t perMille);
+uint32_t KNX_Histogram_Mean(const KNX_Histogram_t *hist);
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KNX_HISTOGRAM */
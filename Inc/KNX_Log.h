@@ -0,0 +1,167 @@
+/**
+  ******************************************************************************
+  * @file       KNX_Log.h
+  * @author     MA Dingjie
+  * @version    V1.0.0
+  * @date       17-October-2016
+  * @brief      This file contains definitions and prototypes of functions for
+  *             the debug messages logged in binary and formatted on the host.
+  ******************************************************************************
+  */
+
+#ifndef __KNX_LOG
+#define __KNX_LOG
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "KNX_def.h"
+
+/** @addtogroup KNX_Lib
+  * @{
+  */
+
+/** @addtogroup KNX_Log
+  * @{
+  */
+
+/* Exported constants --------------------------------------------------------*/
+/** @defgroup KNX_Log_Exported_Constants KNX Log Exported Constants
+  * @{
+  */
+
+/** @defgroup KNX_Log_Messages KNX Log Messages
+  * @brief    The table of the messages: identifier, number of octets of
+  *           arguments and format. Only the identifier and the arguments go
+  *           through the debug UART, the format is applied by
+  *           ::KNX_Log_Decode on the host. New messages are added at the end
+  *           so the identifiers of a running decoder stay valid.
+  * @{
+  */
+#define KNX_LOG_MESSAGES(X)                                                    \
+  X(LOG_DEBUG_START,    0, "[Debug]Started.")                                  \
+  X(LOG_DEBUG_LOST,     1, "[Debug]%u messages lost.")                         \
+  X(LOG_PH_STATE,       1, "[KNX PH]KNX_PH_STATE changed to %02X.")            \
+  X(LOG_PH_SEND,        1, "[KNX PH]Data sent: %02X")                          \
+  X(LOG_PH_RECEIVE,     1, "[KNX PH]Data received: %02X")                      \
+  X(LOG_PH_ERROR,       1, "[KNX PH]Error code: %02X")                         \
+  X(LOG_AUX_ERROR,      1, "[Aux]Error Code: %02X")
+/**
+  * @}
+  */
+
+/** \brief Max number of octets of arguments of a message. */
+#define KNX_LOG_ARGS_MAX        ((uint8_t)4)
+/** \brief Max size of a record in ::colaDebug: identifier, time in us and
+  *        arguments. */
+#define KNX_LOG_RECORD_MAX      ((uint8_t)(1U + 4U + KNX_LOG_ARGS_MAX))
+/** \brief Max size of a record before its framing: identifier, time delta
+  *        on up to 5 octets and arguments. */
+#define KNX_LOG_PAYLOAD_MAX     ((uint8_t)(1U + 5U + KNX_LOG_ARGS_MAX))
+/** \brief Max size of a record on the debug UART: the record framed with
+  *        COBS, one more octet below 254, and the delimiter. */
+#define KNX_LOG_WIRE_MAX        ((uint8_t)(KNX_LOG_PAYLOAD_MAX + 2U))
+/** \brief Octet ending each record on the debug UART, found nowhere else. */
+#define KNX_LOG_DELIMITER       ((uint8_t)0x00U)
+
+/** @defgroup KNX_Log_Error_Code KNX Log Error Code
+  * @{
+  */
+#define LOG_OK                  ((uint8_t)0x00U)   /*!< No error              */
+#define LOG_FULL                ((uint8_t)0x01U)   /*!< Record dropped        */
+#define LOG_UNKNOWN             ((uint8_t)0x02U)   /*!< Unknown identifier    */
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/* Exported types ------------------------------------------------------------*/
+/** @defgroup KNX_Log_Exported_Types KNX Log Exported Types
+  * @{
+  */
+
+/**
+  * @brief  Identifiers of the messages of ::KNX_LOG_MESSAGES.
+  */
+typedef enum
+{
+#define KNX_LOG_ID(id, args, format)    id,
+  KNX_LOG_MESSAGES(KNX_LOG_ID)
+#undef KNX_LOG_ID
+  KNX_LOG_COUNT                 /*!< Number of messages                       */
+} KNX_Log_Id_t;
+
+/**
+  * @brief  One end of the stream of the debug UART. A record is the
+  *         identifier, the time elapsed since the previous record in us
+  *         zigzag encoded on 7 bits per octet from the least significant, bit
+  *         7 set on all but the last octet, then the arguments. On the wire it
+  *         is framed with COBS (Consistent Overhead Byte Stuffing) and ended
+  *         by ::KNX_LOG_DELIMITER, so a decoder which starts in the middle of
+  *         the stream or loses octets finds the next record at the next
+  *         delimiter. The time of the records after a lost one is off by the
+  *         delta of the lost one.
+  */
+typedef struct
+{
+  uint32_t Last;                /*!< Time of the previous record, in us       */
+  uint64_t Time;                /*!< Time of the previous record since the
+                                     start of the stream, in us               */
+} KNX_Log_Stream_t;
+/**
+  * @}
+  */
+
+/* Exported functions --------------------------------------------------------*/
+/** @addtogroup KNX_Log_Exported_Functions
+  * @{
+  */
+
+/** @addtogroup KNX_Log_Exported_Functions_Group1
+  * @{
+  */
+
+/* Log functions  *************************************************************/
+uint8_t  KNX_Log(KNX_Log_Id_t id, uint8_t arg);
+uint8_t  KNX_Log_Write(KNX_Log_Id_t id, const uint8_t *args);
+/**
+  * @}
+  */
+
+/** @addtogroup KNX_Log_Exported_Functions_Group2
+  * @{
+  */
+
+/* Stream functions  **********************************************************/
+void     KNX_Log_InitStream(KNX_Log_Stream_t *stream);
+uint8_t  KNX_Log_Encode(KNX_Log_Stream_t *stream, const uint8_t *record, uint16_t length, uint8_t *wire);
+#ifdef KNX_HOST
+uint16_t KNX_Log_Decode(KNX_Log_Stream_t *stream, const uint8_t *wire, uint16_t length, uint16_t *used, char *text, uint16_t size);
+#endif
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KNX_LOG */
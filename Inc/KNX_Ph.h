@@ -20,7 +20,16 @@
 /* Includes ------------------------------------------------------------------*/
 #include <stdio.h>
 #include <stdint.h>
+#include "FreeRTOS.h"
+#include "semphr.h"
 #include "debug.h"
+#include "KNX_def.h"
+#include "KNX_Ph_Buffer.h"
+#include "KNX_Ph_Capture.h"
+#include "KNX_Ph_Trace.h"
+#include "KNX_Frame.h"
+#include "KNX_Ph_TPUart.h"
+#include "KNX_Addr.h"
 
 /** @addtogroup KNX_Lib
   * @{
@@ -55,6 +64,44 @@
   * @}
   */
 
+/** @defgroup PH_Frame_Assembly Physical Layer Frame Assembly
+  * @brief    Frames are assembled in the RX interrupt, these can be
+  *           overridden at build time.
+  * @{
+  */
+/** \brief Silence on the line, in ::TBIT, after which a frame not yet
+  *        completed is dropped. 30 bits: more than the 13 bits of a
+  *        character, less than the 50 bits between two frames. */
+#ifndef KNX_PH_FRAME_GAP_TBIT
+#define KNX_PH_FRAME_GAP_TBIT   ((uint32_t)30)
+#endif
+/** \brief ::KNX_PH_FRAME_GAP_TBIT in us, compared with the time stamps of
+  *        the bytes. */
+#define KNX_PH_FRAME_GAP_US     (KNX_PH_FRAME_GAP_TBIT * TBIT)
+/** \brief Number of complete frames waiting for the upper layer, must be a
+  *        power of 2. */
+#ifndef KNX_PH_FRAME_QUEUE_SIZE
+#define KNX_PH_FRAME_QUEUE_SIZE ((uint32_t)4)
+#endif
+/** \brief Frames waiting in the queue from which the RX interrupt answers
+  *        busy to a frame addressed to the device, 75 % of the queue as
+  *        KNX_DL_BUSY_HIGH_WATER. The sender repeats it later instead of
+  *        the frame being dropped by a full queue. */
+#ifndef KNX_PH_ACK_BUSY_LEVEL
+#define KNX_PH_ACK_BUSY_LEVEL   (KNX_PH_FRAME_QUEUE_SIZE * 3U / 4U)
+#endif
+/** \brief Longest wait for the confirm of a frame sent, in ms. On a loaded
+  *        line the frame may lose the arbitration many times before it is
+  *        sent, the TP-UART only confirms it then. */
+#ifndef KNX_PH_CONFIRM_TIMEOUT
+#define KNX_PH_CONFIRM_TIMEOUT  ((uint32_t)3000)
+#endif
+/** \brief Speed of ::KNX_Ph_Replay without waiting between the records. */
+#define KNX_PH_REPLAY_FAST      ((uint32_t)0)
+/**
+  * @}
+  */
+
 /**
   * @}
   */
@@ -94,6 +141,124 @@ typedef enum
                                               Nack, Busy, Addressed           */
   Ph_None               = 0xffU         /*!< None request                     */
 } PH_Request_t;
+
+/**
+  * @brief  PH Receive Channel Enumeration definition. The bytes received
+  *         outside a frame are routed by type, so a task waiting for one type
+  *         never consumes the others.
+  */
+typedef enum
+{
+  PH_CHANNEL_RESET      = 0x00U,        /*!< ::Reset_indication               */
+  PH_CHANNEL_STATE      = 0x01U,        /*!< ::State_indication               */
+  PH_CHANNEL_CONFIRM    = 0x02U,        /*!< L_Data_confirm                   */
+  PH_CHANNEL_DATA       = 0x03U,        /*!< Any other byte                   */
+  PH_CHANNEL_NB         = 0x04U         /*!< Number of channels               */
+} PH_Channel_t;
+
+/**
+  * @brief  A receive channel: its bytes and the semaphore given by the RX
+  *         interrupt for each of them.
+  */
+typedef struct
+{
+  KNX_Ph_Buffer_t Buffer;       /*!< Bytes of the channel                     */
+  SemaphoreHandle_t Semaphore;  /*!< Given for each byte stored               */
+} PH_RxChannel_t;
+
+/**
+  * @brief  State of the frame assembly done in the RX interrupt.
+  */
+typedef struct
+{
+  KNX_Frame_t *Frame;           /*!< Frame being assembled, NULL between two
+                                     frames                                   */
+  uint16_t Expected;            /*!< Total length, 0 while not yet known      */
+  uint8_t  Discard;             /*!< TRUE to drop the bytes until a silence   */
+  uint32_t LastByte;            /*!< us of the last byte received             */
+  uint8_t  Parity;              /*!< XOR of the octets of ::Frame, 0xFF once
+                                     the check octet is in for a valid frame  */
+  uint16_t Crc;                 /*!< CRC-16-CCITT of the octets of ::Frame    */
+  uint16_t CrcRx;               /*!< CRC received after the frame             */
+  uint8_t  CrcOctets;           /*!< Octets of ::CrcRx received               */
+} PH_Assembler_t;
+
+/**
+  * @brief  Counters of the physical layer.
+  */
+typedef struct
+{
+  uint32_t RxOverruns;          /*!< Bytes dropped, receive buffer full       */
+  uint32_t RxFrames;            /*!< Frames completed by the RX interrupt     */
+  uint32_t RxFrameOverruns;     /*!< Frames dropped, frame queue full         */
+  uint32_t RxFrameTruncated;    /*!< Frames dropped, cut by a silence         */
+  uint32_t RxFrameTooLong;      /*!< Frames dropped, longer than FRAME_SIZE  */
+  uint32_t RxFrameNoBuffer;     /*!< Frames dropped, frame pool exhausted     */
+  uint32_t RxFrameCrcErrors;    /*!< Frames dropped, CRC mismatch             */
+  uint32_t RxFrameParityErrors; /*!< Frames dropped, check octet mismatch     */
+  uint32_t Acks;                /*!< Acks sent by the RX interrupt            */
+  uint32_t Nacks;               /*!< Of ::Acks, nacks of faulty headers       */
+  uint32_t AckDeferred;         /*!< Acks delayed by a transfer ongoing       */
+  uint32_t AcksBusy;            /*!< Frames answered busy by the RX interrupt */
+  uint32_t AckCyclesMax;        /*!< Worst delay in core cycles between the
+                                     interrupt receiving the address and the
+                                     ack handed to the UART                   */
+  uint32_t IsrCyclesMax;        /*!< Worst duration in core cycles of the
+                                     UART interrupt                           */
+  uint32_t Captured;            /*!< Records stored in monitor mode           */
+  uint32_t CaptureOverruns;     /*!< Records dropped, capture ring full       */
+} PH_Stats_t;
+
+/**
+  * @brief  PH Handle structure definition, one per line. Only ::TPUart is
+  *         set by the user before ::KNX_Ph_Init, the rest is private to the
+  *         supervisor.
+  */
+typedef struct PH_Handle
+{
+  TPUart_Handle_t       TPUart;         /*!< TP-UART of the line              */
+  PH_Status_t           State;          /*!< Current state of the line        */
+  volatile uint8_t      TxFlag;         /*!< Set while a task waits for the
+                                             end of a transfer                */
+  SemaphoreHandle_t     TxSemaphore;    /*!< Given by knx_uart_isr_tx at the
+                                             end of a transfer                */
+  SemaphoreHandle_t     TxMutex;        /*!< To send one data at a time       */
+  SemaphoreHandle_t     FrameSemaphore; /*!< Given for each complete frame    */
+  BaseType_t            xHigherPriorityTaskWoken; /*!< Yield the interrupt    */
+  PH_RxChannel_t        RxChannels[PH_CHANNEL_NB]; /*!< Bytes received outside
+                                             a frame, see ::PH_Channel_t      */
+  uint8_t               RxByte;         /*!< Character received from UART     */
+  uint32_t              RxTimestamp;    /*!< us of ::RxByte, stamped by the RX
+                                             interrupt                        */
+  PH_Assembler_t        Assembler;      /*!< Frame assembly of the RX
+                                             interrupt                        */
+  KNX_Frame_t           *FrameQueue[KNX_PH_FRAME_QUEUE_SIZE]; /*!< Complete
+                                             frames, each slot owns a
+                                             reference on its frame           */
+  volatile uint32_t     FrameHead;      /*!< Free running write indice of
+                                             ::FrameQueue, ISR only           */
+  volatile uint32_t     FrameTail;      /*!< Free running read indice of
+                                             ::FrameQueue, task only          */
+  PH_Stats_t            Stats;          /*!< Counters of the line             */
+  const KNX_Addr_t      *Addr;          /*!< Addresses acknowledged by the RX
+                                             interrupt, NULL for none         */
+  uint8_t               AckBusy;        /*!< TRUE to answer busy instead of
+                                             ack                              */
+  uint8_t               AckByte;        /*!< Ack service being sent           */
+  volatile uint8_t      AckPending;     /*!< Ack waiting for the end of a
+                                             transfer                         */
+  uint32_t              AckCycles;      /*!< Cycle count when the address of
+                                             the frame was received           */
+  uint32_t              IsrCycles;      /*!< Cycle count at the interrupt
+                                             entry                            */
+  KNX_Ph_Capture_t      *Capture;       /*!< Ring filled in ::PH_MONITOR      */
+  KNX_Ph_Trace_t        *Trace;         /*!< Bytes to and from the TP-UART,
+                                             NULL for none                    */
+  uint8_t               CrcMode;        /*!< TRUE once the TP-UART follows
+                                             each frame with its CRC          */
+  uint8_t               TxPending;      /*!< TRUE from a frame sent until its
+                                             confirm is consumed, or a reset  */
+} PH_Handle_t;
 /**
   * @}
   */
@@ -108,7 +273,7 @@ typedef enum
   */
 
 /* Initialization functions  **************************************************/
-uint8_t KNX_Ph_Init(void);
+uint8_t KNX_Ph_Init(PH_Handle_t *hph);
 /**
   * @}
   */
@@ -118,10 +283,12 @@ uint8_t KNX_Ph_Init(void);
 */
 
 /* Send/Receive functions  ***************************************************/
-uint8_t KNX_Ph_SendData(uint8_t data, uint32_t timeout);
-uint8_t KNX_Ph_RecData(uint8_t *data, uint32_t timeout);
-uint8_t KNX_Ph_WaitFor(uint8_t res, uint32_t timeout);
-uint8_t KNX_Ph_WaitForWithMask(uint8_t *res, uint8_t resMask, uint32_t timeout);
+uint8_t KNX_Ph_SendData(PH_Handle_t *hph, uint8_t data, uint32_t timeout);
+uint8_t KNX_Ph_RecData(PH_Handle_t *hph, uint8_t *data, uint32_t timeout);
+uint8_t KNX_Ph_RecDatas(PH_Handle_t *hph, uint8_t *datas, uint16_t *length, uint32_t timeout);
+uint8_t KNX_Ph_WaitFor(PH_Handle_t *hph, uint8_t res, uint32_t timeout);
+uint8_t KNX_Ph_WaitForWithMask(PH_Handle_t *hph, uint8_t *res, uint8_t resMask, uint32_t timeout);
+PH_Channel_t KNX_Ph_Classify(uint8_t data);
 /**
   * @}
   */
@@ -131,10 +298,17 @@ uint8_t KNX_Ph_WaitForWithMask(uint8_t *res, uint8_t resMask, uint32_t timeout);
 */
 
 /* Services functions  ********************************************************/
-uint8_t KNX_Ph_Reset(void);
-uint8_t KNX_Ph_State(uint8_t *res);
-uint8_t KNX_Ph_Data_req(uint8_t *frame, uint16_t length);
-uint8_t KNX_Ph_Data_rec(uint8_t *frame, uint16_t *length);
+uint8_t KNX_Ph_Reset(PH_Handle_t *hph);
+uint8_t KNX_Ph_State(PH_Handle_t *hph, uint8_t *res);
+uint8_t KNX_Ph_Data_req(PH_Handle_t *hph, uint8_t *frame, uint16_t length);
+uint8_t KNX_Ph_Data_rec(PH_Handle_t *hph, uint8_t *frame, uint16_t *length);
+uint8_t KNX_Ph_Frame_rec(PH_Handle_t *hph, KNX_Frame_t **frame, uint32_t timeout);
+uint8_t KNX_Ph_ActivateBusmon(PH_Handle_t *hph, KNX_Ph_Capture_t *capture);
+uint8_t KNX_Ph_ActivateBusyMode(PH_Handle_t *hph);
+uint8_t KNX_Ph_ResetBusyMode(PH_Handle_t *hph);
+uint8_t KNX_Ph_ActivateCRC(PH_Handle_t *hph);
+uint8_t KNX_Ph_Monitor_rec(PH_Handle_t *hph, KNX_Ph_Capture_Record_t *record, uint32_t timeout);
+uint8_t KNX_Ph_Replay(PH_Handle_t *hph, const uint8_t *datas, uint32_t length, uint32_t speed);
 /**
   * @}
   */
@@ -144,7 +318,13 @@ uint8_t KNX_Ph_Data_rec(uint8_t *frame, uint16_t *length);
   */
 
 /* State functions  **********************************************************/
-PH_Status_t KNX_Ph_GetState(void);
+PH_Status_t KNX_Ph_GetState(PH_Handle_t *hph);
+uint32_t    KNX_Ph_GetRxOverruns(PH_Handle_t *hph);
+uint32_t    KNX_Ph_GetFrameCount(PH_Handle_t *hph);
+void        KNX_Ph_GetStats(PH_Handle_t *hph, PH_Stats_t *stats);
+void        KNX_Ph_SetAddr(PH_Handle_t *hph, const KNX_Addr_t *addr);
+void        KNX_Ph_SetAckBusy(PH_Handle_t *hph, uint8_t busy);
+void        KNX_Ph_SetTrace(PH_Handle_t *hph, KNX_Ph_Trace_t *trace);
 /**
   * @}
   */
@@ -0,0 +1,135 @@
+/**
+  ******************************************************************************
+  * @file       KNX_Ph_Buffer.h
+  * @author     MA Dingjie
+  * @version    V1.0.0
+  * @date       12-October-2016
+  * @brief      This file contains definitions and prototypes of functions for
+  *             the receive ring buffer of the physical layer.
+  ******************************************************************************
+  */
+
+#ifndef __KNX_Ph_BUFFER
+#define __KNX_Ph_BUFFER
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/** @addtogroup KNX_PH
+  * @{
+  */
+
+/** @addtogroup KNX_PH_Buffer
+  * @{
+  */
+
+/* Exported constants --------------------------------------------------------*/
+/** @defgroup KNX_PH_Buffer_Exported_Constants KNX PH Buffer Exported Constants
+  * @{
+  */
+
+/** \brief Depth of a ring buffer in bytes, must be a power of 2. It can be
+  *        overridden at build time. */
+#ifndef KNX_PH_BUFFER_SIZE
+#define KNX_PH_BUFFER_SIZE      ((uint32_t)64)
+#endif
+
+/** \brief Mask applied to the free running indices. */
+#define KNX_PH_BUFFER_MASK      (KNX_PH_BUFFER_SIZE - 1U)
+
+/** @defgroup PH_Buffer_Error_Code Ring Buffer Error Code
+  * @{
+  */
+#define PH_BUFFER_OK            ((uint8_t)0x00U)   /*!< No error              */
+#define PH_BUFFER_EMPTY         ((uint8_t)0x01U)   /*!< Nothing to read       */
+#define PH_BUFFER_FULL          ((uint8_t)0x02U)   /*!< Data dropped, overrun */
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/* Exported types ------------------------------------------------------------*/
+/** @defgroup KNX_PH_Buffer_Exported_Types KNX PH Buffer Exported Types
+  * @{
+  */
+
+/**
+  * @brief  Single producer, single consumer ring buffer. ::Head is only
+  *         written by the producer (the UART interrupt) and ::Tail only by the
+  *         consumer (the supervisor functions), so no lock is needed.
+  */
+typedef struct
+{
+  volatile uint32_t Head;               /*!< Free running write indice        */
+  volatile uint32_t Tail;               /*!< Free running read indice         */
+  volatile uint32_t Overruns;           /*!< Bytes dropped because it was full*/
+  volatile uint32_t MaxLevel;           /*!< Highest filling level seen       */
+  uint8_t Datas[KNX_PH_BUFFER_SIZE];    /*!< Storage of the bytes             */
+} KNX_Ph_Buffer_t;
+/**
+  * @}
+  */
+
+/* Exported functions --------------------------------------------------------*/
+/** @addtogroup KNX_PH_Buffer_Exported_Functions
+  * @{
+  */
+
+/** @addtogroup KNX_PH_Buffer_Exported_Functions_Group1
+  * @{
+  */
+
+/* Initialization functions ***************************************************/
+void     KNX_Ph_Buffer_Init(KNX_Ph_Buffer_t *buf);
+void     KNX_Ph_Buffer_Flush(KNX_Ph_Buffer_t *buf);
+/**
+  * @}
+  */
+
+/** @addtogroup KNX_PH_Buffer_Exported_Functions_Group2
+  * @{
+  */
+
+/* Put/Get functions  *********************************************************/
+uint8_t  KNX_Ph_Buffer_Put(KNX_Ph_Buffer_t *buf, uint8_t data);
+uint8_t  KNX_Ph_Buffer_Get(KNX_Ph_Buffer_t *buf, uint8_t *data);
+uint16_t KNX_Ph_Buffer_Read(KNX_Ph_Buffer_t *buf, uint8_t *datas, uint16_t size);
+/**
+  * @}
+  */
+
+/** @addtogroup KNX_PH_Buffer_Exported_Functions_Group3
+  * @{
+  */
+
+/* State functions  ***********************************************************/
+uint32_t KNX_Ph_Buffer_Count(KNX_Ph_Buffer_t *buf);
+uint32_t KNX_Ph_Buffer_GetOverruns(KNX_Ph_Buffer_t *buf);
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KNX_Ph_BUFFER */
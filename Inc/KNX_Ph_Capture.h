@@ -0,0 +1,158 @@
+/**
+  ******************************************************************************
+  * @file       KNX_Ph_Capture.h
+  * @author     MA Dingjie
+  * @version    V1.0.0
+  * @date       17-October-2016
+  * @brief      This file contains definitions and prototypes of functions for
+  *             the capture ring of the bus monitor mode.
+  ******************************************************************************
+  */
+
+#ifndef __KNX_Ph_CAPTURE
+#define __KNX_Ph_CAPTURE
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "KNX_def.h"
+
+/** @addtogroup KNX_PH
+  * @{
+  */
+
+/** @addtogroup KNX_PH_Capture
+  * @{
+  */
+
+/* Exported constants --------------------------------------------------------*/
+/** @defgroup KNX_PH_Capture_Exported_Constants KNX PH Capture Exported Constants
+  * @{
+  */
+
+/** \brief Number of records of a capture ring, must be a power of 2. It can
+  *        be overridden at build time. A saturated line at 9600 baud carries
+  *        less than 30 frames and 30 acks per second. */
+#ifndef KNX_PH_CAPTURE_SIZE
+#define KNX_PH_CAPTURE_SIZE     ((uint32_t)128)
+#endif
+
+/** \brief Mask applied to the free running indices. */
+#define KNX_PH_CAPTURE_MASK     (KNX_PH_CAPTURE_SIZE - 1U)
+
+/** @defgroup PH_Capture_Flags Capture Record Flags
+  * @{
+  */
+#define PH_CAPTURE_FRAME        ((uint8_t)0x01U)   /*!< Frame from its CTRL octet */
+#define PH_CAPTURE_TRUNCATED    ((uint8_t)0x02U)   /*!< Frame cut by a silence    */
+#define PH_CAPTURE_PARITY       ((uint8_t)0x04U)   /*!< Check octet mismatch      */
+/**
+  * @}
+  */
+
+/** @defgroup PH_Capture_Error_Code Capture Ring Error Code
+  * @{
+  */
+#define PH_CAPTURE_OK           ((uint8_t)0x00U)   /*!< No error              */
+#define PH_CAPTURE_EMPTY        ((uint8_t)0x01U)   /*!< Nothing to read       */
+#define PH_CAPTURE_FULL         ((uint8_t)0x02U)   /*!< Record dropped        */
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/* Exported types ------------------------------------------------------------*/
+/** @defgroup KNX_PH_Capture_Exported_Types KNX PH Capture Exported Types
+  * @{
+  */
+
+/**
+  * @brief  A record of the bus: a frame, or a single character such as an
+  *         ack sent by another device.
+  */
+typedef struct
+{
+  uint32_t Timestamp;           /*!< Reception of the first octet in us, see
+                                     ::KNX_GetMicros                          */
+  uint8_t  Flags;               /*!< See \ref PH_Capture_Flags                */
+  uint8_t  Length;              /*!< Number of octets in ::Datas              */
+  uint8_t  Datas[FRAME_SIZE];   /*!< Octets as received                       */
+} KNX_Ph_Capture_Record_t;
+
+/**
+  * @brief  Single producer, single consumer ring of records. ::Head is only
+  *         written by the UART interrupt and ::Tail only by the task reading
+  *         the capture, so no lock is needed.
+  */
+typedef struct
+{
+  volatile uint32_t Head;               /*!< Free running write indice        */
+  volatile uint32_t Tail;               /*!< Free running read indice         */
+  volatile uint32_t Overruns;           /*!< Records dropped, ring full       */
+  volatile uint32_t MaxLevel;           /*!< Highest filling level seen       */
+  KNX_Ph_Capture_Record_t Records[KNX_PH_CAPTURE_SIZE]; /*!< Storage          */
+} KNX_Ph_Capture_t;
+/**
+  * @}
+  */
+
+/* Exported functions --------------------------------------------------------*/
+/** @addtogroup KNX_PH_Capture_Exported_Functions
+  * @{
+  */
+
+/** @addtogroup KNX_PH_Capture_Exported_Functions_Group1
+  * @{
+  */
+
+/* Initialization functions ***************************************************/
+void     KNX_Ph_Capture_Init(KNX_Ph_Capture_t *cap);
+/**
+  * @}
+  */
+
+/** @addtogroup KNX_PH_Capture_Exported_Functions_Group2
+  * @{
+  */
+
+/* Put/Get functions  *********************************************************/
+uint8_t  KNX_Ph_Capture_Put(KNX_Ph_Capture_t *cap, uint32_t timestamp, uint8_t flags, const uint8_t *datas, uint16_t length);
+uint8_t  KNX_Ph_Capture_Get(KNX_Ph_Capture_t *cap, KNX_Ph_Capture_Record_t *record);
+/**
+  * @}
+  */
+
+/** @addtogroup KNX_PH_Capture_Exported_Functions_Group3
+  * @{
+  */
+
+/* State functions  ***********************************************************/
+uint32_t KNX_Ph_Capture_Count(KNX_Ph_Capture_t *cap);
+uint32_t KNX_Ph_Capture_GetOverruns(KNX_Ph_Capture_t *cap);
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KNX_Ph_CAPTURE */
@@ -18,6 +18,7 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include <stdint.h>
+#include "KNX_def.h"
 
 /** @addtogroup KNX_PH
   * @{
@@ -27,6 +28,63 @@
   * @{
   */
 
+/* Exported constants --------------------------------------------------------*/
+/** @defgroup KNX_TPUart_Backend KNX TPUart Backends
+  * @brief    Transport used to talk to the TP-UART, selected at build time
+  *           with ::KNX_PH_TPUART_BACKEND. All of them implement the
+  *           KNX_PH_TPUart_* functions.
+  * @{
+  */
+#define KNX_PH_TPUART_IT        1       /*!< Interrupt per byte, KNX_Ph_TPUart.c */
+#define KNX_PH_TPUART_DMA       2       /*!< Circular DMA and idle line,
+                                             KNX_Ph_TPUart_DMA.c               */
+#define KNX_PH_TPUART_EMU       3       /*!< TP-UART2 emulated in a task,
+                                             KNX_Ph_TPUart_EMU.c               */
+
+#ifndef KNX_PH_TPUART_BACKEND
+#ifdef KNX_HOST
+#define KNX_PH_TPUART_BACKEND   KNX_PH_TPUART_EMU
+#else
+#define KNX_PH_TPUART_BACKEND   KNX_PH_TPUART_IT
+#endif
+#endif
+
+/** \brief Size of the circular DMA reception buffer, a half of it must be
+  *        received well before the interrupt is served. */
+#ifndef KNX_PH_TPUART_DMA_RX_SIZE
+#define KNX_PH_TPUART_DMA_RX_SIZE       ((uint16_t)64)
+#endif
+/** \brief Time of a character from the TP-UART in us: start, 8 data, parity
+  *        and stop bits at 9600 bauds. The bytes drained from the DMA ring
+  *        are dated back from their place with it. */
+#define KNX_PH_TPUART_CHAR_US           ((uint32_t)11U * TBIT)
+
+/** \brief Priority of the task of the emulator, it stands for the UART
+  *        interrupt. */
+#ifndef KNX_PH_TPUART_EMU_PRIORITY
+#define KNX_PH_TPUART_EMU_PRIORITY      (configMAX_PRIORITIES - 1)
+#endif
+/** \brief Stack of the task of the emulator, in words. */
+#ifndef KNX_PH_TPUART_EMU_STACK
+#define KNX_PH_TPUART_EMU_STACK         (configMINIMAL_STACK_SIZE + 128)
+#endif
+/** \brief Answer of the emulator to U_ProductID_request. */
+#ifndef KNX_PH_TPUART_EMU_PRODUCT_ID
+#define KNX_PH_TPUART_EMU_PRODUCT_ID    ((uint8_t)0x40U)
+#endif
+/**
+  * @}
+  */
+
+#if KNX_PH_TPUART_BACKEND == KNX_PH_TPUART_EMU
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "KNX_Ph_Buffer.h"
+#else
+#include "stm32f4xx_hal.h"
+#endif
+
 /* Exported types ------------------------------------------------------------*/
 /** @defgroup KNX_TPUart_Exported_Types KNX TPUart Exported Types
   * @brief    TPUart Status Enumeration
@@ -42,6 +100,95 @@ typedef enum
   TPUart_ERROR    = 0x01U,      /*!< Error                                    */
   TPUart_BUSY     = 0x02U,      /*!< Busy                                     */
 } TPUart_Status_t;
+
+struct PH_Handle;
+struct TPUart_Handle;
+
+#if KNX_PH_TPUART_BACKEND == KNX_PH_TPUART_EMU
+/**
+  * @brief  Bus seen by an emulated TP-UART: sends a frame and returns
+  *         ::TPUart_OK if it was acknowledged, ::TPUart_ERROR if not, or
+  *         ::TPUart_BUSY if the result is given later with
+  *         ::KNX_PH_TPUart_EmuConfirm. See ::TPUart_Emu_t::BusSend.
+  */
+typedef uint8_t (*TPUart_EmuBusSend_t)(struct TPUart_Handle *htpuart, const uint8_t *frame, uint16_t length);
+
+/**
+  * @brief  State of an emulated TP-UART2. Only ::BusSend and ::BusContext
+  *         are set by the user, the rest is private to the emulator.
+  */
+typedef struct
+{
+  const uint8_t         *TxData;        /*!< Octets sent by the host, valid
+                                             until served like a UART
+                                             transfer                         */
+  uint16_t              TxSize;         /*!< Octets of ::TxData left          */
+  KNX_Ph_Buffer_t       HostRx;         /*!< Octets for the host              */
+  KNX_Ph_Buffer_t       BusRx;          /*!< Frames of the bus for the host   */
+  SemaphoreHandle_t     Wake;           /*!< Given for each job of the task   */
+  TaskHandle_t          Task;           /*!< Task of the emulator             */
+  volatile uint8_t      TxBusy;         /*!< TRUE until ::TxData is served    */
+  uint8_t               Busmon;         /*!< TRUE in bus monitor mode         */
+  uint8_t               Busy;           /*!< TRUE in busy mode                */
+  uint8_t               Crc;            /*!< TRUE once the CRC is activated   */
+  volatile uint8_t      Ack;            /*!< Last U_AckInformation, 0 if none
+                                             since the last frame of the bus  */
+  uint16_t              Address;        /*!< Set by U_SetAddress              */
+  uint8_t               Service;        /*!< Service waiting for its argument
+                                             octets                           */
+  uint8_t               Arguments;      /*!< Argument octets still expected   */
+  uint8_t               Frame[FRAME_SIZE]; /*!< L_Data being received         */
+  uint16_t              FrameLength;    /*!< Octets of ::Frame received       */
+  uint8_t               FrameEnd;       /*!< TRUE if the octet expected is the
+                                             last one of ::Frame              */
+  uint8_t               Pending;        /*!< TRUE while the bus has a frame
+                                             not confirmed yet                */
+  volatile uint8_t      Confirm;        /*!< L_Data_confirm given by the bus,
+                                             0 if none                        */
+  TPUart_EmuBusSend_t   BusSend;        /*!< Frames sent to the bus, NULL for
+                                             a bus always acknowledging       */
+  void                  *BusContext;    /*!< Free for ::BusSend               */
+} TPUart_Emu_t;
+#endif
+
+/**
+  * @brief  TPUart Handle structure definition, one per line. ::Instance and
+  *         the baud rate pin are set by the user before
+  *         ::KNX_PH_TPUart_init, left to 0 they select USART3 and PD7. The
+  *         other members are managed by the backend. The emulator only
+  *         uses ::Emu.
+  */
+typedef struct TPUart_Handle
+{
+#if KNX_PH_TPUART_BACKEND == KNX_PH_TPUART_EMU
+  TPUart_Emu_t          Emu;            /*!< The emulated TP-UART2            */
+#else
+  USART_TypeDef         *Instance;      /*!< UART wired to the TP-UART        */
+  GPIO_TypeDef          *BaudPort;      /*!< Port of the pin which sets the
+                                             TP-UART2 to 9600 bauds           */
+  uint16_t              BaudPin;        /*!< Pin on ::BaudPort                */
+  UART_HandleTypeDef    huart;          /*!< HAL handle of the UART, to be
+                                             given to HAL_UART_IRQHandler     */
+#endif
+#if KNX_PH_TPUART_BACKEND == KNX_PH_TPUART_DMA
+  DMA_HandleTypeDef     hdma_rx;        /*!< Circular reception stream. Left
+                                             to 0, DMA1 Stream 1 Channel 4;
+                                             else Instance and Init.Channel
+                                             are set by the user, who also
+                                             enables the stream interrupt     */
+  DMA_HandleTypeDef     hdma_tx;        /*!< Transmission stream, same as
+                                             ::hdma_rx with DMA1 Stream 3     */
+  uint8_t               RxBuffer[KNX_PH_TPUART_DMA_RX_SIZE]; /*!< Written by
+                                             the reception DMA                */
+  uint16_t              RxIndice;       /*!< Next byte of ::RxBuffer to hand
+                                             over                             */
+  uint32_t              RxTime;         /*!< us of the byte last handed over  */
+  uint8_t               RxIdle;         /*!< Set while the bytes are drained
+                                             at an idle line                  */
+#endif
+  struct PH_Handle      *Parent;        /*!< Physical layer served, given to
+                                             the knx_uart_isr_* functions     */
+} TPUart_Handle_t;
 /**
   * @}
   */
@@ -56,7 +203,7 @@ typedef enum
   */
 
 /* Initialization functions ***************************************************/
-uint8_t KNX_PH_TPUart_init(void);
+uint8_t KNX_PH_TPUart_init(TPUart_Handle_t *htpuart);
 /**
   * @}
   */
@@ -66,8 +213,10 @@ uint8_t KNX_PH_TPUart_init(void);
   */
 
 /* Send/Receive functions  ***************************************************/
-uint8_t KNX_PH_TPUart_Send(uint8_t *data, uint16_t size);
-uint8_t KNX_PH_TPUart_Receive(uint8_t *data, uint16_t size);
+uint8_t KNX_PH_TPUart_Send(TPUart_Handle_t *htpuart, uint8_t *data, uint16_t size);
+uint8_t KNX_PH_TPUart_Receive(TPUart_Handle_t *htpuart, uint8_t *data, uint16_t size);
+uint32_t KNX_PH_TPUart_GetRxTime(TPUart_Handle_t *htpuart);
+uint8_t KNX_PH_TPUart_GetTxState(TPUart_Handle_t *htpuart);
 /**
   * @}
   */
@@ -76,7 +225,13 @@ uint8_t KNX_PH_TPUart_Receive(uint8_t *data, uint16_t size);
   * @{
   */
 /* UART Interrupt function  ***************************************************/
-void TPUart_isr(void);
+void TPUart_isr(TPUart_Handle_t *htpuart);
+#if KNX_PH_TPUART_BACKEND == KNX_PH_TPUART_EMU
+/* Emulated bus functions  ****************************************************/
+uint8_t KNX_PH_TPUart_EmuBusFrame(TPUart_Handle_t *htpuart, const uint8_t *frame, uint16_t length);
+uint8_t KNX_PH_TPUart_EmuGetAck(TPUart_Handle_t *htpuart);
+void KNX_PH_TPUart_EmuConfirm(TPUart_Handle_t *htpuart, uint8_t acked);
+#endif
 /**
   * @}
   */
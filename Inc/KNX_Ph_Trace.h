@@ -0,0 +1,201 @@
+/**
+  ******************************************************************************
+  * @file       KNX_Ph_Trace.h
+  * @author     MA Dingjie
+  * @version    V1.0.0
+  * @date       17-October-2016
+  * @brief      This file contains definitions and prototypes of functions for
+  *             the binary traces of the bytes exchanged with the TP-UART.
+  ******************************************************************************
+  */
+
+#ifndef __KNX_Ph_TRACE
+#define __KNX_Ph_TRACE
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "KNX_def.h"
+
+/** @addtogroup KNX_PH
+  * @{
+  */
+
+/** @addtogroup KNX_PH_Trace
+  * @{
+  */
+
+/* Exported constants --------------------------------------------------------*/
+/** @defgroup KNX_PH_Trace_Exported_Constants KNX PH Trace Exported Constants
+  * @{
+  */
+
+/** \brief Size in bytes of the ring of a trace, must be a power of 2. It can
+  *        be overridden at build time. A saturated line at 9600 baud fills
+  *        less than 2 KB per second. */
+#ifndef KNX_PH_TRACE_SIZE
+#define KNX_PH_TRACE_SIZE       ((uint32_t)4096)
+#endif
+
+/** \brief Mask applied to the free running indices. */
+#define KNX_PH_TRACE_MASK       (KNX_PH_TRACE_SIZE - 1U)
+
+/** \brief Bytes in the same direction closer than this, in us, share a
+  *        record. A character takes 1.15 ms at 9600 baud and the line is
+  *        silent at least 5 ms between two frames. */
+#ifndef KNX_PH_TRACE_COALESCE
+#define KNX_PH_TRACE_COALESCE   ((uint32_t)2500)
+#endif
+
+/** @defgroup PH_Trace_Format Trace Format
+  * @brief    A trace starts with the 4 octets "KNXT" and the version. Each
+  *           record is then:
+  *           - a header octet: ::PH_TRACE_TX for the bytes sent to the
+  *             TP-UART, and the number of bytes in ::PH_TRACE_LENGTH, or
+  *             ::PH_TRACE_GAP alone for records lost because the ring was
+  *             full;
+  *           - the time elapsed since the previous record in us, 7 bits per
+  *             octet from the least significant, bit 7 set on all but the
+  *             last octet;
+  *           - the bytes.
+  * @{
+  */
+#define PH_TRACE_VERSION        ((uint8_t)0x01U)   /*!< Version of the format */
+#define PH_TRACE_HEADER_SIZE    ((uint8_t)5)       /*!< Magic and version     */
+#define PH_TRACE_TX             ((uint8_t)0x80U)   /*!< Sent to the TP-UART   */
+#define PH_TRACE_GAP            ((uint8_t)0x40U)   /*!< Records lost          */
+#define PH_TRACE_LENGTH         ((uint8_t)0x3FU)   /*!< Number of bytes       */
+#define PH_TRACE_RECORD_MAX     ((uint8_t)0x3FU)   /*!< Bytes in a record     */
+#define PH_TRACE_DELTA_MAX      ((uint8_t)5)       /*!< Octets of a delta     */
+/**
+  * @}
+  */
+
+/** @defgroup PH_Trace_Error_Code Trace Error Code
+  * @{
+  */
+#define PH_TRACE_OK             ((uint8_t)0x00U)   /*!< No error              */
+#define PH_TRACE_END            ((uint8_t)0x01U)   /*!< No more record        */
+#define PH_TRACE_FULL           ((uint8_t)0x02U)   /*!< Record dropped        */
+#define PH_TRACE_FORMAT         ((uint8_t)0x03U)   /*!< Not a valid trace     */
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/* Exported types ------------------------------------------------------------*/
+/** @defgroup KNX_PH_Trace_Exported_Types KNX PH Trace Exported Types
+  * @{
+  */
+
+/**
+  * @brief  A trace being recorded. The bytes are gathered in ::Open, then
+  *         the record goes to the ring from which a task drains the trace
+  *         to its storage with ::KNX_Ph_Trace_Read. Written from the UART
+  *         interrupt and from the tasks sending, under a critical section.
+  */
+typedef struct
+{
+  volatile uint32_t Head;               /*!< Free running write indice        */
+  volatile uint32_t Tail;               /*!< Free running read indice         */
+  uint32_t Last;                        /*!< Time of the last record written,
+                                             in us                            */
+  uint32_t OpenTime;                    /*!< Time of the first byte of ::Open */
+  uint32_t OpenLast;                    /*!< Time of the last byte of ::Open  */
+  uint8_t  OpenFlags;                   /*!< Direction of ::Open              */
+  uint8_t  OpenLength;                  /*!< Bytes in ::Open                  */
+  uint8_t  Open[PH_TRACE_RECORD_MAX];   /*!< Record being gathered            */
+  uint8_t  Lost;                        /*!< TRUE if a gap is to be written   */
+  uint32_t Records;                     /*!< Records written                  */
+  uint32_t Drops;                       /*!< Records dropped, ring full       */
+  uint8_t  Datas[KNX_PH_TRACE_SIZE];    /*!< Storage                          */
+} KNX_Ph_Trace_t;
+
+/**
+  * @brief  A record read back from a trace.
+  */
+typedef struct
+{
+  uint64_t       Time;                  /*!< Time since the start of the
+                                             trace, in us                     */
+  uint8_t        Flags;                 /*!< ::PH_TRACE_TX or ::PH_TRACE_GAP  */
+  uint8_t        Length;                /*!< Number of bytes                  */
+  const uint8_t  *Datas;                /*!< The bytes, in the trace          */
+} KNX_Ph_Trace_Record_t;
+
+/**
+  * @brief  Position in a trace read back from memory.
+  */
+typedef struct
+{
+  const uint8_t  *Datas;                /*!< The trace                        */
+  uint32_t       Length;                /*!< Size of the trace                */
+  uint32_t       Offset;                /*!< Next record                      */
+  uint64_t       Time;                  /*!< Time of the last record, in us   */
+} KNX_Ph_Trace_Cursor_t;
+/**
+  * @}
+  */
+
+/* Exported functions --------------------------------------------------------*/
+/** @addtogroup KNX_PH_Trace_Exported_Functions
+  * @{
+  */
+
+/** @addtogroup KNX_PH_Trace_Exported_Functions_Group1
+  * @{
+  */
+
+/* Initialization functions ***************************************************/
+void     KNX_Ph_Trace_Init(KNX_Ph_Trace_t *trace, uint32_t timestamp);
+/**
+  * @}
+  */
+
+/** @addtogroup KNX_PH_Trace_Exported_Functions_Group2
+  * @{
+  */
+
+/* Record functions  **********************************************************/
+void     KNX_Ph_Trace_Record(KNX_Ph_Trace_t *trace, uint8_t flags, uint32_t timestamp, const uint8_t *datas, uint16_t length);
+void     KNX_Ph_Trace_Flush(KNX_Ph_Trace_t *trace);
+uint32_t KNX_Ph_Trace_Read(KNX_Ph_Trace_t *trace, uint8_t *datas, uint32_t size);
+uint32_t KNX_Ph_Trace_GetDrops(KNX_Ph_Trace_t *trace);
+/**
+  * @}
+  */
+
+/** @addtogroup KNX_PH_Trace_Exported_Functions_Group3
+  * @{
+  */
+
+/* Read back functions  *******************************************************/
+uint8_t  KNX_Ph_Trace_Open(KNX_Ph_Trace_Cursor_t *cursor, const uint8_t *datas, uint32_t length);
+uint8_t  KNX_Ph_Trace_Next(KNX_Ph_Trace_Cursor_t *cursor, KNX_Ph_Trace_Record_t *record);
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KNX_Ph_TRACE */
@@ -0,0 +1,170 @@
+/**
+  ******************************************************************************
+  * @file       KNX_Timer.h
+  * @author     MA Dingjie
+  * @version    V1.0.0
+  * @date       17-October-2016
+  * @brief      This file contains definitions and prototypes of functions for
+  *             the software timers driven by the tick of \ref KNX_Aux.
+  ******************************************************************************
+  */
+
+#ifndef __KNX_TIMER
+#define __KNX_TIMER
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "task.h"
+
+/** @addtogroup KNX_Lib
+  * @{
+  */
+
+/** @addtogroup KNX_Timer
+  * @{
+  */
+
+/* Exported constants --------------------------------------------------------*/
+/** @defgroup KNX_Timer_Exported_Constants KNX Timer Exported Constants
+  * @{
+  */
+
+/** @defgroup KNX_Timer_Error_Code KNX Timer Error Code
+  * @{
+  */
+#define TIMER_ERROR_NONE        ((uint8_t)0x00U)   /*!< No error              */
+#define TIMER_ERROR_PARAM       ((uint8_t)0x01U)   /*!< Wrong parameter       */
+#define TIMER_ERROR_IDLE        ((uint8_t)0x02U)   /*!< Timer not armed       */
+/**
+  * @}
+  */
+
+/** @defgroup KNX_Timer_Wheel KNX Timer Wheel
+  * @brief    ::KNX_TIMER_LEVELS wheels of ::KNX_TIMER_SLOTS slots: a timer
+  *           goes to the first wheel whose span covers its delay, and moves
+  *           down a wheel each time the one below turns over. With 4 wheels
+  *           of 64 slots, a timer fires within 2^24 ms, about 4.6 hours;
+  *           longer ones wait in the last wheel and are placed again.
+  * @{
+  */
+#define KNX_TIMER_SLOT_BITS     ((uint32_t)6)                           /*!< Bits of a wheel   */
+#define KNX_TIMER_SLOTS         ((uint32_t)1 << KNX_TIMER_SLOT_BITS)    /*!< Slots of a wheel  */
+#define KNX_TIMER_SLOT_MASK     (KNX_TIMER_SLOTS - 1U)                  /*!< Slot of a tick    */
+#define KNX_TIMER_LEVELS        ((uint32_t)4)                           /*!< Number of wheels  */
+/** \brief Longest delay placed as is, in ticks. */
+#define KNX_TIMER_SPAN          (((uint32_t)1 << (KNX_TIMER_SLOT_BITS * KNX_TIMER_LEVELS)) - 1U)
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/* Exported types ------------------------------------------------------------*/
+/** @defgroup KNX_Timer_Exported_Types KNX Timer Exported Types
+  * @{
+  */
+
+struct KNX_Timer;
+
+/**
+  * @brief  Function called when a timer expires, from the tick interrupt.
+  *         Set \b woken to pdTRUE after waking up a task from it.
+  */
+typedef void (*KNX_Timer_Callback_t)(struct KNX_Timer *timer, BaseType_t *woken);
+
+/**
+  * @brief  A timer, owned by the user. Arming and cancelling it take a
+  *         constant time whatever the number of timers armed.
+  */
+typedef struct KNX_Timer
+{
+  struct KNX_Timer      *Next;          /*!< Next timer of the slot           */
+  struct KNX_Timer      **Link;         /*!< Pointer to this timer in its
+                                             slot, NULL when not armed        */
+  uint32_t              Expiry;         /*!< Tick of the expiry               */
+  uint32_t              Period;         /*!< Ticks between two expiries, 0
+                                             for a single one                 */
+  KNX_Timer_Callback_t  Callback;       /*!< Called at the expiry             */
+  void                  *Context;       /*!< For the callback, the task of
+                                             ::KNX_Timer_Notify               */
+} KNX_Timer_t;
+
+/**
+  * @brief  The wheels of the timers.
+  */
+typedef struct
+{
+  KNX_Timer_t           *Slots[KNX_TIMER_LEVELS][KNX_TIMER_SLOTS]; /*!< Timers
+                                             per wheel and slot               */
+  volatile uint32_t     Now;            /*!< Ticks processed                  */
+  uint32_t              Armed;          /*!< Timers armed                     */
+  uint32_t              Expired;        /*!< Callbacks called                 */
+} KNX_Timer_Wheel_t;
+/**
+  * @}
+  */
+
+/* Exported variables --------------------------------------------------------*/
+/** @addtogroup KNX_Timer_Exported_Variables
+  * @{
+  */
+extern KNX_Timer_Wheel_t KNX_TimerWheel;
+/**
+  * @}
+  */
+
+/* Exported functions --------------------------------------------------------*/
+/** @addtogroup KNX_Timer_Exported_Functions
+  * @{
+  */
+
+/** @addtogroup KNX_Timer_Exported_Functions_Group1
+  * @{
+  */
+
+/* Initialization functions ***************************************************/
+void    KNX_Timer_InitWheel(KNX_Timer_Wheel_t *wheel);
+void    KNX_Timer_Init(KNX_Timer_t *timer, KNX_Timer_Callback_t callback, void *context);
+/**
+  * @}
+  */
+
+/** @addtogroup KNX_Timer_Exported_Functions_Group2
+  * @{
+  */
+
+/* Operation functions  *******************************************************/
+uint8_t  KNX_Timer_Start(KNX_Timer_Wheel_t *wheel, KNX_Timer_t *timer, uint32_t ticks, uint32_t period);
+uint8_t  KNX_Timer_Stop(KNX_Timer_Wheel_t *wheel, KNX_Timer_t *timer);
+uint8_t  KNX_Timer_IsArmed(KNX_Timer_t *timer);
+uint32_t KNX_Timer_Remaining(KNX_Timer_Wheel_t *wheel, KNX_Timer_t *timer);
+void     KNX_Timer_Tick(KNX_Timer_Wheel_t *wheel);
+void     KNX_Timer_Notify(KNX_Timer_t *timer, BaseType_t *woken);
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KNX_TIMER */
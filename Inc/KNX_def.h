@@ -19,6 +19,9 @@
 /* Includes ------------------------------------------------------------------*/
 #include <stdio.h>
 #include <stdint.h>
+#if defined(__ICCARM__)
+#include <intrinsics.h>
+#endif
 
 /** @addtogroup KNX_Lib
   * @{
@@ -62,6 +65,71 @@
   * @}
   */
 
+/** @defgroup KNX_Barrier Memory barrier
+  * @brief    Orders the memory accesses shared between an interrupt and a task.
+  * @{
+  */
+#if defined(__ICCARM__)
+#define KNX_MEMORY_BARRIER()            __DMB()
+#elif defined(__GNUC__)
+#define KNX_MEMORY_BARRIER()            __sync_synchronize()
+#else
+#define KNX_MEMORY_BARRIER()
+#endif
+/**
+  * @}
+  */
+
+/** @defgroup KNX_Atomic Compare and swap
+  * @brief    Atomic update of a word shared by tasks and interrupts without
+  *           masking them: KNX_CAS(ptr, expected, desired) stores \b desired
+  *           and returns non zero only if \b *ptr still holds \b expected.
+  *           A full memory barrier. LDREX/STREX on the Cortex-M4.
+  * @{
+  */
+#if defined(__ICCARM__)
+static inline uint32_t KNX_CompareAndSwap(volatile uint32_t *ptr, uint32_t expected, uint32_t desired)
+{
+  uint32_t ret = 0;
+  
+  __DMB();
+  if(__LDREX((unsigned long *)ptr) == expected)
+  {
+    ret = (__STREX(desired, (unsigned long *)ptr) == 0U);
+  }
+  else
+  {
+    __CLREX();
+  }
+  __DMB();
+  
+  return ret;
+}
+#define KNX_CAS(ptr, expected, desired) KNX_CompareAndSwap((ptr), (expected), (desired))
+#elif defined(__GNUC__)
+#define KNX_CAS(ptr, expected, desired) __sync_bool_compare_and_swap((ptr), (expected), (desired))
+#else
+#error "KNX_CAS is not defined for this compiler"
+#endif
+/**
+  * @}
+  */
+
+/** @defgroup KNX_Host Host build
+  * @brief    With \c KNX_HOST defined, the stack builds on a host with the
+  *           FreeRTOS POSIX port: no HAL, the TP-UART is emulated by
+  *           KNX_Ph_TPUart_EMU.c and the debug messages go to stdout.
+  * @{
+  */
+#ifdef KNX_HOST
+#ifndef __IO
+#define __IO                            volatile
+#endif
+#endif
+/**
+  * @}
+  */
+
 /** @defgroup UART_Control_To Field of Services to UART
   * @brief    Services to UART
   * @{
@@ -99,6 +167,7 @@
 #define L_Data_confirm_success          ((uint8_t)0x8BU)    /*!< Transmission succeed   */
 #define L_Data_confirm_failed           ((uint8_t)0x0BU)    /*!< Transmission failed    */
 #define L_Data_confirm_mask             ((uint8_t)0x0BU)    /*!< Transmission failed    */
+#define L_Data_confirm_filter           ((uint8_t)0x7FU)    /*!< Bits identifying a L_Data_confirm */
 /**
   * @}
   */
@@ -121,6 +190,8 @@
   */
 #define KNX_DEFAULT_TIMEOUT     ((TickType_t)500)               /*!< Default Timeout 500 ms*/
 #define KNX_MAX_DELAY           ((TickType_t)0xFFFFFFFFU)       /*!< Max Delay: Infinity   */
+/** \brief Convert a timeout in ms into FreeRTOS ticks, ::KNX_MAX_DELAY waits forever. */
+#define KNX_MS_TO_TICKS(ms)     (((ms) == KNX_MAX_DELAY) ? portMAX_DELAY : pdMS_TO_TICKS(ms))
 /**
   * @}
   */
@@ -131,6 +202,34 @@
   */
 /** \brief Max size of the frame */
 #define FRAME_SIZE 22
+/** \brief Mask of the CTRL octet bits identifying a L_Data frame */
+#define FRAME_CTRL_MASK                 ((uint8_t)0x53U)
+/** \brief Value of the masked CTRL octet of a L_Data frame: \c x0x1xx00 */
+#define FRAME_CTRL_DATA                 ((uint8_t)0x10U)
+/** \brief CTRL octet bit set for a standard frame, cleared for an extended one */
+#define FRAME_CTRL_STANDARD             BIT7
+/** \brief CTRL octet bit cleared when the frame is a repetition */
+#define FRAME_CTRL_NOT_REPEATED         BIT5
+/** \brief Octet holding the length of a standard frame (low nibble) */
+#define FRAME_LENGTH_OCTET              ((uint16_t)5)
+/** \brief Octet holding the length of an extended frame */
+#define FRAME_EXT_LENGTH_OCTET          ((uint16_t)6)
+/** \brief Octets of a standard frame besides the payload length */
+#define FRAME_OVERHEAD                  ((uint16_t)8)
+/** \brief Octets of an extended frame besides the payload length */
+#define FRAME_EXT_OVERHEAD              ((uint16_t)9)
+/** \brief First octet of the destination address of a standard frame */
+#define FRAME_DA_OCTET                  ((uint16_t)3)
+/** \brief First octet of the destination address of an extended frame */
+#define FRAME_EXT_DA_OCTET              ((uint16_t)4)
+/** \brief Octet holding the address type of a standard frame (bit 7) */
+#define FRAME_AT_OCTET                  ((uint16_t)5)
+/** \brief Octet holding the address type of an extended frame (bit 7) */
+#define FRAME_EXT_AT_OCTET              ((uint16_t)1)
+/** \brief Address type bit, set for a group address */
+#define FRAME_AT_GROUP                  BIT7
+/** \brief Octets received once the destination of any frame is known */
+#define FRAME_ADDRESSED_LENGTH          ((uint16_t)6)
 /**
   * @}
   */
@@ -17,8 +17,7 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include <stdint.h>
-#include "FreeRTOS.h"
-#include "semphr.h"
+#include "KNX_def.h"
 
 /** @addtogroup KNX_Lib
   * @{
@@ -36,8 +35,18 @@
 /** @defgroup Cola_Private_Define Cola Private Define
   * @{
   */
-/** \brief Max size of the t_cola.datos */
-#define COLA_SIZE 4*1024
+/** \brief Size of the t_cola.datos, a power of 2 up to 32 KB */
+#define COLA_SIZE               ((uint32_t)4096)
+/** \brief Mask applied to the indices to get a place of t_cola.datos */
+#define COLA_MASK               (COLA_SIZE - 1U)
+/** \brief The indices run freely over 16 bits */
+#define COLA_INDEX_MASK         ((uint32_t)0xFFFFU)
+/** \brief One writer copying, in the high half of t_cola.reserva */
+#define COLA_WRITER             ((uint32_t)0x10000U)
+/** \brief Octets of the length before each record */
+#define COLA_HEADER_SIZE        ((uint32_t)2)
+/** \brief Longest record */
+#define COLA_RECORD_MAX         ((uint16_t)(COLA_SIZE - COLA_HEADER_SIZE))
 /**
   * @}
   */
@@ -48,18 +57,24 @@
   */
 
 /**
-  * @brief       Cola Structure definition
+  * @brief       Cola Structure definition. Any number of tasks and
+  *              interrupts store records, a single task reads them. Each
+  *              record is its length on ::COLA_HEADER_SIZE octets followed
+  *              by its bytes, so the bytes can be anything. Nothing
+  *              blocks nor masks the interrupts: a writer reserves its
+  *              place with a compare and swap on #reserva, copies its
+  *              message, and the last writer leaving publishes all the places
+  *              reserved so far in #cola.
   */
 typedef struct
 {
-  /*huecos vacios de tamao COLA_SIZE, indice de lectura, indice de escritura */
-  uint32_t huecos;              /*!< Free places of #datos                    */
-  uint32_t cabeza;              /*!< The beginning indice of the new message  */
-  uint32_t cola;                /*!< The end indice of the new message        */
-  uint32_t items;               /*!< Items in the #datos                      */
-
-  SemaphoreHandle_t mutex;      /*!< The mutex to prevent the colision of
-                                      #cola_leer and #cola_guardar            */
+  volatile uint32_t reserva;    /*!< Free running write indice of the places
+                                     reserved, low half, and number of writers
+                                     copying, high half                       */
+  volatile uint32_t cola;       /*!< Free running indice up to which the
+                                     messages are complete                    */
+  volatile uint32_t cabeza;     /*!< Free running read indice                 */
+  volatile uint32_t perdidos;   /*!< Messages dropped, #datos full            */
 
   uint8_t datos[COLA_SIZE];     /*!< The buffer who stroes all messages       */
 }t_cola;
@@ -86,7 +101,10 @@ void cola_init(t_cola *p);
   */
 /* Save/Read cola functions ***************************************************/
 int16_t cola_guardar (t_cola *p, unsigned char *msg);
+int16_t cola_guardar_datos (t_cola *p, const uint8_t *datos, uint16_t l);
+uint16_t cola_peek (t_cola *p);
 int16_t cola_leer (t_cola *p, unsigned char *msg, uint32_t l);
+uint32_t cola_perdidos (t_cola *p);
 /**
   * @}
   */
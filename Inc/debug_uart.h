@@ -17,7 +17,9 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include <stdint.h>
+#ifndef KNX_HOST
 #include "stm32f4xx_hal.h"
+#endif
 
 /** @addtogroup KNX_Lib
   * @{
@@ -0,0 +1,108 @@
+/**
+  ******************************************************************************
+  * @file       KNX_Addr.c
+  * @author     MA Dingjie
+  * @version    V1.0.0
+  * @date       17-October-2016
+  * @brief      KNX addresses of the device.
+  *             This file provides functions to manage following functionalities:
+  *              + Individual address and group address membership
+  *              + Constant time look up of a destination address
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <string.h>
+#include "KNX_Addr.h"
+
+/** @addtogroup KNX_Lib
+  * @{
+  */
+
+/** @defgroup KNX_Addr KNX Addresses
+  * @brief    Tells whether a frame is addressed to the device, so the RX
+  *           interrupt can acknowledge it in time.
+  * @{
+  */
+
+/* Exported functions --------------------------------------------------------*/
+/** @defgroup KNX_Addr_Exported_Functions KNX Addr Exported Functions
+  * @{
+  */
+
+/** @defgroup KNX_Addr_Exported_Functions_Group1 Initialization Functions
+  * @{
+  */
+
+/**
+  * @brief      Set the individual address and clear the group addresses but
+  *             the broadcast one.
+  * @param      addr: addresses of the device.
+  * @param      individual: individual address.
+  */
+void KNX_Addr_Init(KNX_Addr_t *addr, uint16_t individual)
+{
+  addr->Individual = individual;
+  memset(addr->Groups, 0, sizeof(addr->Groups));
+  KNX_Addr_AddGroup(addr, KNX_ADDR_BROADCAST);
+}
+
+/**
+  * @brief      Make the device member of a group address.
+  * @param      addr: addresses of the device.
+  * @param      ga: group address.
+  */
+void KNX_Addr_AddGroup(KNX_Addr_t *addr, uint16_t ga)
+{
+  addr->Groups[ga >> 5] |= (uint32_t)1U << (ga & 0x1FU);
+}
+
+/**
+  * @brief      Remove the device from a group address.
+  * @param      addr: addresses of the device.
+  * @param      ga: group address.
+  */
+void KNX_Addr_RemoveGroup(KNX_Addr_t *addr, uint16_t ga)
+{
+  addr->Groups[ga >> 5] &= ~((uint32_t)1U << (ga & 0x1FU));
+}
+/**
+  * @}
+  */
+
+/** @defgroup KNX_Addr_Exported_Functions_Group2 Look Up Functions
+  * @{
+  */
+
+/**
+  * @brief      Whether a destination address is one of the device.
+  * @param      addr: addresses of the device.
+  * @param      da: destination address of the frame.
+  * @param      group: address type of the frame, 0 for individual.
+  * @retval     TRUE if the frame is addressed to the device, else FALSE.
+  */
+uint8_t KNX_Addr_Match(const KNX_Addr_t *addr, uint16_t da, uint8_t group)
+{
+  if(group != 0U)
+  {
+    return KNX_ADDR_IS_GROUP(addr, da) ? TRUE : FALSE;
+  }
+
+  return (da == addr->Individual) ? TRUE : FALSE;
+}
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
@@ -7,7 +7,8 @@
   * @brief      Auxiliary functions for KNX Library.
   *             This file provides functions to manage following functionalities:
   *              + Conversion functions from int to text and from text to int
-  *              + A basic timer
+  *              + A basic timer driving \ref KNX_Timer, and the cycle counter
+  *              + Vertical parity and CRC-16-CCITT
   ******************************************************************************
   */
 
@@ -15,9 +16,14 @@
 #include <stdint.h>
 #include <string.h>
 #include "KNX_Aux.h"
+#include "KNX_Timer.h"
 #include "KNX_def.h"
-#include "debug.h"
+#include "KNX_Log.h"
+#ifdef KNX_HOST
+#include <time.h>
+#else
 #include "stm32f4xx_hal.h"
+#endif
 
 /** @addtogroup KNX_Lib
   * @{
@@ -31,9 +37,52 @@
 /** @defgroup KNX_Aux_Private_Consts Auxiliary Private constants
   * @{
   */
+/** \brief Cycles of ::KNX_GetCycles in a us, on the host a cycle is a ns. */
+#ifdef KNX_HOST
+#define KNX_CYCLES_PER_US       ((uint32_t)1000U)
+#else
+#define KNX_CYCLES_PER_US       (SystemCoreClock / 1000000U)
+#endif
+
 /** \brief Table of hexadecimal numbers */
 static const char hex_num[] = {'0', '1', '2', '3', '4', '5', '6', '7' , '8', '9',
                                 'A', 'B', 'C', 'D', 'E', 'F'};
+
+/** \brief CRC-16-CCITT of each value of the high byte, polynomial 0x1021 */
+static const uint16_t crc16_table[256] = {
+  0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+  0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+  0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6,
+  0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
+  0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485,
+  0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
+  0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4,
+  0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
+  0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
+  0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
+  0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12,
+  0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
+  0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41,
+  0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
+  0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70,
+  0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
+  0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F,
+  0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
+  0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E,
+  0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
+  0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D,
+  0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+  0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C,
+  0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
+  0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB,
+  0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
+  0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
+  0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
+  0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9,
+  0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
+  0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8,
+  0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0
+};
 /**
   * @}
   */
@@ -46,11 +95,8 @@ static const char hex_num[] = {'0', '1', '2', '3', '4', '5', '6', '7' , '8', '9'
 volatile TIMER_Status_t timer_state;
 /** \brief Counter of the timer, the unit is ms */
 volatile uint32_t timer_tick;
-
-/** \brief Aux Error message. */
-static unsigned char Aux_Err_Msg[] = "[Aux]Error Code: XX\r\n";
-/** \brief ::Aux_Err_Msg digits indice. */
-#define AUX_ERROR_MSG_INDICE ((uint8_t)17)
+/** \brief Cycle counter at the last increment of ::timer_tick */
+static volatile uint32_t timer_cycles;
 /**
   * @}
   */
@@ -104,8 +150,7 @@ uint8_t text2int(unsigned char *msg, uint8_t *value)
     
     if(i == 15)                 /* didn't found the corresponding digit */
     {
-      int2text(AUX_ERROR_BIN, &Aux_Err_Msg[AUX_ERROR_MSG_INDICE]);
-      cola_guardar(&colaDebug, Aux_Err_Msg);
+      KNX_Log(LOG_AUX_ERROR, AUX_ERROR_BIN);
 
       return AUX_ERROR_BIN;
     }
@@ -121,8 +166,7 @@ uint8_t text2int(unsigned char *msg, uint8_t *value)
     
     if(i == 15)                 /* didn't found the corresponding digit */
     {
-      int2text(AUX_ERROR_BIN, &Aux_Err_Msg[AUX_ERROR_MSG_INDICE]);
-      cola_guardar(&colaDebug, Aux_Err_Msg);
+      KNX_Log(LOG_AUX_ERROR, AUX_ERROR_BIN);
       
       return AUX_ERROR_BIN;
     }
@@ -158,6 +202,7 @@ void KNX_StartTimer(void)
   
   /** Set timer counter to 0. */
   timer_tick = 0;
+  timer_cycles = KNX_GetCycles();
 }
 
 /**
@@ -210,7 +255,8 @@ TIMER_Status_t KNX_GetTimerState(void)
 }
 
 /**
- *  @brief      Check for time out or not. 
+ *  @brief      Check for time out or not. Kept for the users of the timer,
+ *              the stack waits on a ::KNX_Deadline_t.
  *  @param      timeOnEntering: Time on entering this function
  *  @param      ticksToWait: ticks to wait before time out
  *  @retval     0 for false, 1 for true.
@@ -238,13 +284,119 @@ uint8_t KNX_CheckForTimeOut(uint32_t * const timeOnEntering, uint32_t * const ti
 }
 
 /**
- *  @brief      Systick interrupt routines. 
+ *  @brief      Start a timeout from now.
+ *  @param      deadline: pointer to the deadline.
+ *  @param      timeout: ticks to wait, ::KNX_MAX_DELAY for ever.
+ */
+void KNX_Deadline_Init(KNX_Deadline_t *deadline, uint32_t timeout)
+{
+  deadline->Start = KNX_GetTick();
+  deadline->Ticks = timeout;
+}
+
+/**
+ *  @brief      Ticks left before a timeout, to sleep on a semaphore with
+ *              ::KNX_MS_TO_TICKS. Safe across the wrap around of the timer.
+ *  @param      deadline: pointer to the deadline.
+ *  @retval     Ticks left, 0 once expired, ::KNX_MAX_DELAY if it never
+ *              expires.
+ */
+uint32_t KNX_Deadline_Remaining(const KNX_Deadline_t *deadline)
+{
+  uint32_t elapsed;
+  
+  if(deadline->Ticks == KNX_MAX_DELAY)
+  {
+    return KNX_MAX_DELAY;
+  }
+  
+  elapsed = KNX_GetTick() - deadline->Start;
+  
+  return (elapsed < deadline->Ticks) ? deadline->Ticks - elapsed : 0U;
+}
+
+/**
+ *  @brief      Check for time out or not.
+ *  @param      deadline: pointer to the deadline.
+ *  @retval     0 for false, 1 for true.
+ */
+uint8_t KNX_Deadline_Expired(const KNX_Deadline_t *deadline)
+{
+  return (KNX_Deadline_Remaining(deadline) == 0U) ? 1U : 0U;
+}
+
+/**
+ *  @brief      Start the cycle counter of the core (DWT), used to measure
+ *              the short delays the timer can't resolve. Nothing to do on
+ *              the host.
+ */
+void KNX_InitCycles(void)
+{
+#ifndef KNX_HOST
+  /** Shared by all the lines, a running counter is left untouched. */
+  if((DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) == 0U)
+  {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  }
+#endif
+}
+
+/**
+ *  @brief      Get the cycle counter, it wraps around every 25 s at 168 MHz.
+ *              On the host, the monotonic clock in ns, wrapping around
+ *              every 4 s.
+ *  @retval     Cycles of the core since ::KNX_InitCycles.
+ */
+uint32_t KNX_GetCycles(void)
+{
+#ifdef KNX_HOST
+  struct timespec ts;
+  
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)((uint64_t)ts.tv_sec * 1000000000U + (uint64_t)ts.tv_nsec);
+#else
+  return DWT->CYCCNT;
+#endif
+}
+
+/**
+ *  @brief      Get the timer in us: the ms of the timer refined by the cycles
+ *              elapsed since its last tick. It wraps around every 71 minutes.
+ *              ::KNX_InitCycles must have been called.
+ *  @retval     Value of the timer in us.
+ */
+uint32_t KNX_GetMicros(void)
+{
+  uint32_t tick, us;
+  
+  /** Read again if the tick moved in between. */
+  do
+  {
+    tick = timer_tick;
+    us = (KNX_GetCycles() - timer_cycles) / KNX_CYCLES_PER_US;
+  } while(tick != timer_tick);
+  
+  if(us > 999U)
+  {
+    us = 999U;
+  }
+  
+  return tick * 1000U + us;
+}
+
+/**
+ *  @brief      Systick interrupt routines, also advance ::KNX_TimerWheel
+ *              while the timer runs.
  */
 void KNX_systick_isr(void)
 {
   if(timer_state == TIMER_RUNNING)
   {
+    timer_cycles = KNX_GetCycles();
     timer_tick++;
+    KNX_Timer_Tick(&KNX_TimerWheel);
   }
 }
 
@@ -275,6 +427,45 @@ uint8_t KNX_VerticalParity(uint8_t *datas, uint16_t length)
   return parity;
 }
 
+/**
+  * @}
+  */
+
+/** @defgroup KNX_Aux_Exported_Functions_Group4 KNX Auxiliary CRC-16-CCITT
+  * @{
+  */
+
+/**
+ *  @brief      Update a CRC-16-CCITT with one byte, one table look up. Start
+ *              from ::KNX_CRC16_INIT.
+ *  @param      crc: the CRC of the bytes before.
+ *  @param      data: the next byte.
+ *  @retval     The CRC including \b data.
+ */
+uint16_t KNX_Crc16_Update(uint16_t crc, uint8_t data)
+{
+  return (uint16_t)(crc << 8) ^ crc16_table[(uint8_t)(crc >> 8) ^ data];
+}
+
+/**
+ *  @brief      CRC-16-CCITT of a block of datas.
+ *  @param      *datas: the trame containing \c uint8_t datas.
+ *  @param      length: the length of the trame
+ *  @retval     The CRC of the datas.
+ */
+uint16_t KNX_Crc16(const uint8_t *datas, uint16_t length)
+{
+  uint16_t crc = KNX_CRC16_INIT;
+  uint16_t l;
+  
+  for (l = 0; l < length; l++)
+  {
+    crc = KNX_Crc16_Update(crc, datas[l]);
+  }
+  
+  return crc;
+}
+
 /**
   * @}
   */
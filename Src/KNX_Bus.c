@@ -0,0 +1,547 @@
+/**
+  ******************************************************************************
+  * @file       KNX_Bus.c
+  * @author     MA Dingjie
+  * @version    V1.0.0
+  * @date       17-October-2016
+  * @brief      Simulated KNX TP1 bus, for the load tests of host builds.
+  *             This file provides functions to manage following functionalities:
+  *              + Initialization functions
+  *              + Arbitration, acknowledges and repetitions
+  *              + Bus counters and latency histogram
+  *
+  *             Each node is an emulated TP-UART (\ref KNX_PH_TPUart, backend
+  *             ::KNX_PH_TPUART_EMU) running its own KNX_Ph/KNX_DL stack. The
+  *             frames the nodes send are put on the line by the task of the
+  *             bus: the nodes with a frame ready when the line becomes free
+  *             contend in a CSMA/CA arbitration where a 0 bit dominates, the
+  *             frame takes 13 bit times per octet, the receivers acknowledge
+  *             15 bit times after its end, and the line stays free 50 bit
+  *             times before the next one. A frame not acknowledged is
+  *             repeated with its repeat flag cleared, up to ::KNX_BUS_REPEATS
+  *             times, 150 bit times later if it was answered busy.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <string.h>
+#include "KNX_Bus.h"
+
+#if KNX_PH_TPUART_BACKEND == KNX_PH_TPUART_EMU
+#include "KNX_Aux.h"
+
+/** @addtogroup KNX_Lib
+  * @{
+  */
+
+/** @defgroup KNX_Bus KNX Simulated Bus
+  * @brief    TP1 line linking emulated TP-UARTs, with its timing.
+  * @{
+  */
+
+/* Private constants ---------------------------------------------------------*/
+/** @defgroup KNX_Bus_Private_Constants KNX Bus Private Constants
+  * @brief    Bits of a U_AckInformation.
+  * @{
+  */
+#define BUS_ACK_ADDRESSED       ((uint8_t)0x01U)   /*!< Addressed, acknowledged */
+#define BUS_ACK_BUSY            ((uint8_t)0x02U)   /*!< Busy                  */
+#define BUS_ACK_NACK            ((uint8_t)0x04U)   /*!< Not acknowledged      */
+/**
+  * @}
+  */
+
+/* Private function prototypes -----------------------------------------------*/
+static void     KNX_Bus_Task(void *argument);
+static uint8_t  KNX_Bus_Send(TPUart_Handle_t *htpuart, const uint8_t *frame, uint16_t length);
+static KNX_Bus_Node_t *KNX_Bus_Arbitrate(KNX_Bus_t *bus, uint8_t *contenders, uint32_t *wait);
+static uint8_t  KNX_Bus_Dominates(const KNX_Bus_Node_t *node, const KNX_Bus_Node_t *other);
+static uint8_t  KNX_Bus_Transmit(KNX_Bus_t *bus, KNX_Bus_Node_t *sender);
+static void     KNX_Bus_Complete(KNX_Bus_t *bus, KNX_Bus_Node_t *node, uint8_t acked, uint32_t end);
+static void     KNX_Bus_Pace(KNX_Bus_t *bus, TickType_t minimum);
+
+/* Exported functions --------------------------------------------------------*/
+/** @defgroup KNX_Bus_Exported_Functions KNX Bus Exported Functions
+  * @{
+  */
+
+/** @defgroup KNX_Bus_Exported_Functions_Group1 Initialization Functions
+  * @{
+  */
+
+/**
+  * @brief      Initialize a bus without nodes, the task of the bus is
+  *             created on the first call.
+  * @param      bus: the bus, zeroed before the first call.
+  * @retval     Error code, See \ref KNX_Bus_Error_Code.
+  */
+uint8_t KNX_Bus_Init(KNX_Bus_t *bus)
+{
+  KNX_InitCycles();
+  memset(bus->Nodes, 0, sizeof(bus->Nodes));
+  memset(&bus->Stats, 0, sizeof(bus->Stats));
+  bus->NodeCount = 0;
+  bus->Start = KNX_GetMicros();
+  bus->Now = bus->Start;
+
+  if(bus->Wake == NULL)
+  {
+    bus->Wake = xSemaphoreCreateBinary();
+    if(bus->Wake == NULL)
+    {
+      return BUS_ERROR_INIT;
+    }
+    if(xTaskCreate(KNX_Bus_Task, "KNX Bus", KNX_BUS_TASK_STACK,
+                   (void *)bus, KNX_BUS_TASK_PRIORITY, &bus->Task) != pdPASS)
+    {
+      return BUS_ERROR_INIT;
+    }
+  }
+
+  return BUS_ERROR_NONE;
+}
+
+/**
+  * @brief      Connect an emulated TP-UART to the bus, before the
+  *             ::KNX_Ph_Init of its line.
+  * @param      bus: the bus.
+  * @param      htpuart: TPUart handle of the node.
+  * @retval     Error code, See \ref KNX_Bus_Error_Code.
+  */
+uint8_t KNX_Bus_Attach(KNX_Bus_t *bus, TPUart_Handle_t *htpuart)
+{
+  KNX_Bus_Node_t *node;
+
+  if(bus->NodeCount >= KNX_BUS_MAX_NODES)
+  {
+    return BUS_ERROR_FULL;
+  }
+
+  node = &bus->Nodes[bus->NodeCount];
+  node->Bus = bus;
+  node->TPUart = htpuart;
+  htpuart->Emu.BusContext = node;
+  htpuart->Emu.BusSend = KNX_Bus_Send;
+  bus->NodeCount++;
+
+  return BUS_ERROR_NONE;
+}
+/**
+  * @}
+  */
+
+/** @defgroup KNX_Bus_Exported_Functions_Group2 State Functions
+  * @{
+  */
+
+/**
+  * @brief      Copy the counters of the bus. The utilisation of the line is
+  *             ::KNX_Bus_Stats_t::BusyTime over ::KNX_Bus_Stats_t::Elapsed,
+  *             its occupation ::KNX_Bus_Stats_t::SlotTime over it. Both
+  *             times only grow with the bus time, so between two copies
+  *             neither grows more than ::KNX_Bus_Stats_t::Elapsed.
+  * @param      bus: the bus.
+  * @param      stats: pointer to store the counters.
+  */
+void KNX_Bus_GetStats(KNX_Bus_t *bus, KNX_Bus_Stats_t *stats)
+{
+  uint32_t now = KNX_GetMicros();
+
+  taskENTER_CRITICAL();
+  *stats = bus->Stats;
+  if((int32_t)(bus->Now - now) > 0)
+  {
+    now = bus->Now;
+  }
+  taskEXIT_CRITICAL();
+  stats->Elapsed = now - bus->Start;
+}
+
+/**
+  * @brief      Copy the counters of a node.
+  * @param      bus: the bus.
+  * @param      node: index of the node, in the order of ::KNX_Bus_Attach.
+  * @param      stats: pointer to store the counters, zeroed for an unknown
+  *             node.
+  */
+void KNX_Bus_GetNodeStats(KNX_Bus_t *bus, uint8_t node, KNX_Bus_NodeStats_t *stats)
+{
+  if(node >= bus->NodeCount)
+  {
+    memset(stats, 0, sizeof(*stats));
+    return;
+  }
+
+  taskENTER_CRITICAL();
+  *stats = bus->Nodes[node].Stats;
+  taskEXIT_CRITICAL();
+}
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/* Private functions ---------------------------------------------------------*/
+/** @defgroup KNX_Bus_Private_Functions KNX Bus Private Functions
+  * @{
+  */
+
+/**
+  * @brief      Task of the bus: one frame on the line per turn, sleeps while
+  *             no node has one ready.
+  * @param      argument: the bus.
+  */
+static void KNX_Bus_Task(void *argument)
+{
+  KNX_Bus_t *bus = (KNX_Bus_t *)argument;
+  KNX_Bus_Node_t *sender;
+  uint32_t now, wait;
+  uint8_t contenders;
+
+  for(;;)
+  {
+    /** A free line doesn't run behind the real time. */
+    now = KNX_GetMicros();
+    if((int32_t)(now - bus->Now) > 0)
+    {
+      bus->Now = now;
+    }
+
+    sender = KNX_Bus_Arbitrate(bus, &contenders, &wait);
+    if(sender == NULL)
+    {
+      xSemaphoreTake(bus->Wake, (wait == KNX_MAX_DELAY) ? portMAX_DELAY
+                                : KNX_MS_TO_TICKS((wait + 999U) / 1000U));
+      continue;
+    }
+
+    if(contenders > 1U)
+    {
+      bus->Stats.Collisions++;
+    }
+    KNX_Bus_Transmit(bus, sender);
+  }
+}
+
+/**
+  * @brief      Hook of the emulated TP-UARTs, takes the frame of a node for
+  *             the task of the bus. Runs in the task of the TP-UART.
+  * @param      htpuart: TPUart handle of the node.
+  * @param      frame: octets of the frame, CTRL to checksum.
+  * @param      length: number of octets.
+  * @retval     ::TPUart_BUSY, the frame is confirmed by the bus later, or
+  *             ::TPUart_ERROR if it can't be taken.
+  */
+static uint8_t KNX_Bus_Send(TPUart_Handle_t *htpuart, const uint8_t *frame, uint16_t length)
+{
+  KNX_Bus_Node_t *node = (KNX_Bus_Node_t *)htpuart->Emu.BusContext;
+
+  if((length == 0U) || (length > FRAME_SIZE))
+  {
+    return TPUart_ERROR;
+  }
+
+  taskENTER_CRITICAL();
+  if(node->Pending == TRUE)
+  {
+    taskEXIT_CRITICAL();
+    return TPUart_ERROR;
+  }
+  memcpy(node->Frame, frame, length);
+  node->Length = length;
+  node->Repeats = 0;
+  node->Requested = KNX_GetMicros();
+  node->ReadyAt = node->Requested;
+  node->Stats.Requests++;
+  node->Pending = TRUE;
+  taskEXIT_CRITICAL();
+
+  xSemaphoreGive(node->Bus->Wake);
+
+  return TPUart_BUSY;
+}
+
+/**
+  * @brief      Arbitration between the nodes with a frame ready. The frames
+  *             start together and a node stops as soon as it reads a 0 on
+  *             the line while it sends a 1. Nodes sending the very same
+  *             frame never see each other and all win.
+  * @param      bus: the bus.
+  * @param      contenders: pointer to store the number of nodes contending.
+  * @param      wait: pointer to store the us until a frame waiting for a
+  *             repetition is ready, ::KNX_MAX_DELAY if none.
+  * @retval     The winner, NULL if no frame is ready. ::KNX_Bus_Node_t::Sending
+  *             is set for the winner and the nodes sending the same frame.
+  */
+static KNX_Bus_Node_t *KNX_Bus_Arbitrate(KNX_Bus_t *bus, uint8_t *contenders, uint32_t *wait)
+{
+  KNX_Bus_Node_t *winner = NULL;
+  KNX_Bus_Node_t *node;
+  uint8_t i;
+
+  *contenders = 0;
+  *wait = KNX_MAX_DELAY;
+
+  taskENTER_CRITICAL();
+  for(i=0; i<bus->NodeCount; i++)
+  {
+    node = &bus->Nodes[i];
+    node->Sending = FALSE;
+    if(node->Pending == FALSE)
+    {
+      continue;
+    }
+    if((int32_t)(node->ReadyAt - bus->Now) > 0)
+    {
+      if(node->ReadyAt - bus->Now < *wait)
+      {
+        *wait = node->ReadyAt - bus->Now;
+      }
+      continue;
+    }
+
+    node->Sending = TRUE;
+    (*contenders)++;
+    if((winner == NULL) || (KNX_Bus_Dominates(node, winner) == TRUE))
+    {
+      winner = node;
+    }
+  }
+  taskEXIT_CRITICAL();
+
+  for(i=0; i<bus->NodeCount; i++)
+  {
+    node = &bus->Nodes[i];
+    if((node->Sending == FALSE) || (node == winner))
+    {
+      continue;
+    }
+    if((node->Length != winner->Length)
+       || (memcmp(node->Frame, winner->Frame, node->Length) != 0))
+    {
+      node->Sending = FALSE;
+      node->Stats.ArbitrationLost++;
+    }
+  }
+
+  return winner;
+}
+
+/**
+  * @brief      Tell whether a frame wins the arbitration against another.
+  *             The octets go on the line LSB first, the first bit which
+  *             differs decides.
+  * @param      node: the node contending.
+  * @param      other: the node winning so far.
+  * @retval     TRUE if \b node wins, FALSE if \b other stays ahead.
+  */
+static uint8_t KNX_Bus_Dominates(const KNX_Bus_Node_t *node, const KNX_Bus_Node_t *other)
+{
+  uint16_t i, length;
+  uint8_t diff;
+
+  length = (node->Length < other->Length) ? node->Length : other->Length;
+  for(i=0; i<length; i++)
+  {
+    diff = node->Frame[i] ^ other->Frame[i];
+    if(diff != 0U)
+    {
+      /** Lowest bit which differs, the node with a 0 there wins. */
+      diff &= (uint8_t)(-diff);
+      return ((node->Frame[i] & diff) == 0U) ? TRUE : FALSE;
+    }
+  }
+
+  return FALSE;
+}
+
+/**
+  * @brief      Put the frame of the winner on the line, collect the
+  *             acknowledges and either confirm the senders or leave them a
+  *             repetition.
+  * @param      bus: the bus.
+  * @param      sender: the winner of the arbitration.
+  * @retval     TRUE if the frame was acknowledged.
+  */
+static uint8_t KNX_Bus_Transmit(KNX_Bus_t *bus, KNX_Bus_Node_t *sender)
+{
+  KNX_Bus_Node_t *node;
+  uint32_t duration, end, delay = 0;
+  uint8_t i, ack = 0, acked = FALSE;
+
+  bus->Stats.Frames++;
+
+  /** The frame, then every node not sending it receives it. */
+  duration = KNX_BUS_BITS_TO_US(sender->Length * KNX_BUS_CHAR_BITS);
+  bus->Now += duration;
+  bus->Stats.BusyTime += duration;
+  bus->Stats.SlotTime += duration;
+  KNX_Bus_Pace(bus, 0);
+  for(i=0; i<bus->NodeCount; i++)
+  {
+    node = &bus->Nodes[i];
+    if(node->Sending == TRUE)
+    {
+      continue;
+    }
+    if(KNX_PH_TPUart_EmuBusFrame(node->TPUart, sender->Frame, sender->Length) != TPUart_OK)
+    {
+      node->Stats.Overruns++;
+    }
+  }
+
+  /** The acknowledges of the receivers are sent together, a NACK
+      overrides a BUSY which overrides an ACK. */
+  duration = KNX_BUS_BITS_TO_US(KNX_BUS_ACK_BITS);
+  bus->Now += KNX_BUS_BITS_TO_US(KNX_BUS_ACK_GAP_BITS) + duration;
+  bus->Stats.BusyTime += duration;
+  bus->Stats.SlotTime += KNX_BUS_BITS_TO_US(KNX_BUS_ACK_GAP_BITS) + duration;
+  KNX_Bus_Pace(bus, 1);
+  for(i=0; i<bus->NodeCount; i++)
+  {
+    if(bus->Nodes[i].Sending == FALSE)
+    {
+      ack |= KNX_PH_TPUart_EmuGetAck(bus->Nodes[i].TPUart);
+    }
+  }
+  end = bus->Now;
+  bus->Now += KNX_BUS_BITS_TO_US(KNX_BUS_IDLE_BITS);
+  bus->Stats.SlotTime += KNX_BUS_BITS_TO_US(KNX_BUS_IDLE_BITS);
+
+  if((ack & BUS_ACK_NACK) != 0U)
+  {
+    bus->Stats.Nacks++;
+  }
+  else if((ack & BUS_ACK_BUSY) != 0U)
+  {
+    bus->Stats.Busys++;
+    delay = KNX_BUS_BITS_TO_US(KNX_BUS_BUSY_BITS);
+  }
+  else if((ack & BUS_ACK_ADDRESSED) != 0U)
+  {
+    bus->Stats.Acks++;
+    acked = TRUE;
+  }
+  else
+  {
+    bus->Stats.NoAcks++;
+  }
+
+  for(i=0; i<bus->NodeCount; i++)
+  {
+    node = &bus->Nodes[i];
+    if(node->Sending == FALSE)
+    {
+      continue;
+    }
+    node->Sending = FALSE;
+    if(acked == TRUE)
+    {
+      node->Stats.Confirmed++;
+      KNX_Bus_Complete(bus, node, TRUE, end);
+    }
+    else if(node->Repeats < KNX_BUS_REPEATS)
+    {
+      node->Repeats++;
+      /** The check octet follows the repeat bit, so the receivers do not
+          see a repetition as a parity error. */
+      if((node->Frame[0] & FRAME_CTRL_NOT_REPEATED) != 0U)
+      {
+        node->Frame[0] &= (uint8_t)~FRAME_CTRL_NOT_REPEATED;
+        node->Frame[node->Length - 1U] ^= FRAME_CTRL_NOT_REPEATED;
+      }
+      node->ReadyAt = bus->Now + delay;
+      node->Stats.Repeats++;
+      bus->Stats.Repeats++;
+    }
+    else
+    {
+      node->Stats.Failed++;
+      bus->Stats.Failed++;
+      KNX_Bus_Complete(bus, node, FALSE, end);
+    }
+  }
+
+  return acked;
+}
+
+/**
+  * @brief      Confirm the frame of a node and, if it was acknowledged,
+  *             count its latency, from the request to the end of its ack.
+  * @param      bus: the bus.
+  * @param      node: the node.
+  * @param      acked: TRUE if the frame was acknowledged.
+  * @param      end: bus time of the end of the frame, in us.
+  */
+static void KNX_Bus_Complete(KNX_Bus_t *bus, KNX_Bus_Node_t *node, uint8_t acked, uint32_t end)
+{
+  uint32_t latency = end - node->Requested;
+  uint32_t bin = latency / KNX_BUS_LATENCY_BIN;
+
+  if(bin >= KNX_BUS_LATENCY_BINS)
+  {
+    bin = KNX_BUS_LATENCY_BINS - 1U;
+  }
+
+  taskENTER_CRITICAL();
+  if(acked == TRUE)
+  {
+    if((bus->Stats.LatencyCount == 0U) || (latency < bus->Stats.LatencyMin))
+    {
+      bus->Stats.LatencyMin = latency;
+    }
+    if(latency > bus->Stats.LatencyMax)
+    {
+      bus->Stats.LatencyMax = latency;
+    }
+    bus->Stats.LatencySum += latency;
+    bus->Stats.LatencyCount++;
+    bus->Stats.Latency[bin]++;
+  }
+  node->Pending = FALSE;
+  taskEXIT_CRITICAL();
+
+  KNX_PH_TPUart_EmuConfirm(node->TPUart, acked);
+}
+
+/**
+  * @brief      Sleep until the real time reaches the bus time, so the nodes
+  *             see the line as slow as it is.
+  * @param      bus: the bus.
+  * @param      minimum: ticks to sleep at least, to let the nodes answer.
+  */
+static void KNX_Bus_Pace(KNX_Bus_t *bus, TickType_t minimum)
+{
+  int32_t ahead = (int32_t)(bus->Now - KNX_GetMicros());
+  TickType_t ticks = 0;
+
+  if(ahead > 0)
+  {
+    ticks = KNX_MS_TO_TICKS(((uint32_t)ahead + 999U) / 1000U);
+  }
+  if(ticks < minimum)
+  {
+    ticks = minimum;
+  }
+  if(ticks != 0U)
+  {
+    vTaskDelay(ticks);
+  }
+}
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#endif /* KNX_PH_TPUART_BACKEND == KNX_PH_TPUART_EMU */
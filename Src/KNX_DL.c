@@ -7,18 +7,25 @@
   * @brief      KNX Data Link Layer.
   *             This file provides functions to manage following functionalities:
   *              + Initialization functions
+  *              + Services functions, frames are passed as buffers of
+  *                \ref KNX_Frame_Pool
+  *              + Transmit queues per priority and their task
   *              + State functions
   ******************************************************************************
   */
 
 /* Includes ------------------------------------------------------------------*/
 #include <stdio.h>
+#include <string.h>
 #include "KNX_DL.h"
 #include "KNX_Ph.h"
+#include "KNX_Frame.h"
 #include "KNX_def.h"
 #include "KNX_Aux.h"
+#ifndef KNX_HOST
 #include "stm32f4xx_hal.h"
 #include "stm32f4xx.h"
+#endif
 
 /** @addtogroup KNX_Lib
   * @{
@@ -34,29 +41,13 @@
   */
 /** \brief Maximal times to retry the request in case of failure. */
 static const uint16_t retryTimes = 10;
-
-/** \brief The buffer to store the data before transmitted */
-uint8_t Tx_LPDU_Datas[FRAME_SIZE];
-/** \brief The length of the ::Tx_LPDU_Datas */
-uint16_t Tx_LPDU_Datas_length;
-/** \brief The buffer to store the data received */
-uint8_t Rx_LPDU_Datas[FRAME_SIZE];
-/** \brief The length of the ::Rx_LPDU_Datas */
-uint16_t Rx_LPDU_Datas_length;
-
-/** \brief Current address of the device. */
-static const uint16_t KNX_DL_SA = 0x0000;
-/**
-  * @}
-  */
-
-/* Private variables ---------------------------------------------------------*/
-/** @defgroup KNX_DL_Private_Variables KNX Data Link Layer Private Variables
-  * @{
-  */
-/** \brief Current state of KNX Data Link Layer. */
-static DL_Status_t KNX_DL_STATE;
-
+/** \brief Transmit queue of each value of the priority field: 00 system,
+  *        01 normal, 10 urgent and 11 low. */
+static const uint8_t KNX_DL_TX_RANK[4] = {0, 2, 1, 3};
+/** \brief Mask applied to a hash to index ::DL_Handle_t::DupCache. */
+#define KNX_DL_DUP_CACHE_MASK   (KNX_DL_DUP_CACHE_SIZE - 1U)
+/** \brief Compilation fails if ::KNX_DL_DUP_CACHE_SIZE is not a power of 2. */
+typedef char KNX_DL_DupCache_SizeCheck[((KNX_DL_DUP_CACHE_SIZE & KNX_DL_DUP_CACHE_MASK) == 0U) ? 1 : -1];
 /**
   * @}
   */
@@ -65,7 +56,16 @@ static DL_Status_t KNX_DL_STATE;
 /** @defgroup KNX_DL_Private_Functions KNX Data Link Layer Private Functions
   * @{
   */
-static void     KNX_DL_SetState(DL_Status_t state);
+static void     KNX_DL_SetState(DL_Handle_t *hdl, DL_Status_t state);
+static uint32_t KNX_DL_FillLevel(DL_Handle_t *hdl);
+static void     KNX_DL_Backpressure(DL_Handle_t *hdl);
+static uint8_t  KNX_DL_CheckFrame(DL_Handle_t *hdl, KNX_Frame_t *frame);
+static void     KNX_DL_Dispatch(DL_Handle_t *hdl, KNX_Frame_t *frame);
+static uint8_t  KNX_DL_TxSchedule(DL_Handle_t *hdl);
+static void     KNX_DL_AgingTimeout(KNX_Timer_t *timer, BaseType_t *woken);
+static void     KNX_DL_BusyTimeout(KNX_Timer_t *timer, BaseType_t *woken);
+static uint32_t KNX_DL_FrameHash(KNX_Frame_t *frame);
+static uint8_t  KNX_DL_IsDuplicate(DL_Handle_t *hdl, KNX_Frame_t *frame);
 /**
   * @}
   */
@@ -80,48 +80,64 @@ static void     KNX_DL_SetState(DL_Status_t state);
   */
 
 /**
-  * @brief      Initialize the \ref KNX_DL module.
+  * @brief      Initialize the \ref KNX_DL module for a line.
+  * @param      hdl: DL handle of the line, ::DL_Handle_t::Ph, already
+  *             initialized by ::KNX_Ph_Init, and ::DL_Handle_t::Addr set
+  *             by the user. The RX interrupt of the line acknowledges the
+  *             frames addressed to ::DL_Handle_t::Addr from then on. The
+  *             transmit queues and ::KNX_DL_TxTask are created on the first
+  *             call.
   * @retval     Error code, See \ref DL_Error_Code.
   */
-uint8_t KNX_DL_Init(void)
+uint8_t KNX_DL_Init(DL_Handle_t *hdl)
 {  
   uint8_t res;
   uint16_t i;
   
-  /** Set state to ::DL_POWER_ON */
-  KNX_DL_SetState(DL_POWER_ON);
-  
-  /** Initialize buffers */
-  for(i=0; i<FRAME_SIZE; i++)
+  if(hdl->TxTask == NULL)
   {
-    Tx_LPDU_Datas[i] = '\0';
-    Tx_LPDU_Datas_length = 0;
-    
-    Rx_LPDU_Datas[i] = '\0';
-    Rx_LPDU_Datas_length = 0;
+    for(i=0; i<DL_TX_PRIORITIES; i++)
+    {
+      hdl->TxQueues[i] = xQueueCreate(KNX_DL_TX_QUEUE_SIZE, sizeof(DL_TxRequest_t *));
+    }
+    hdl->TxSemaphore = xSemaphoreCreateCounting(DL_TX_PRIORITIES * KNX_DL_TX_QUEUE_SIZE, 0);
+    KNX_Timer_Init(&hdl->BusyTimer, KNX_DL_BusyTimeout, (void *)hdl);
+    if(xTaskCreate(KNX_DL_TxTask, "KNX DL TX", KNX_DL_TX_TASK_STACK,
+                   (void *)hdl, KNX_DL_TX_TASK_PRIORITY, &hdl->TxTask) != pdPASS)
+    {
+      return DL_ERROR_INIT;
+    }
   }
-    
+  KNX_Timer_Stop(&KNX_TimerWheel, &hdl->BusyTimer);
+  KNX_DL_ResetPerf(hdl);
+  
+  /** Set state to ::DL_POWER_ON */
+  KNX_DL_SetState(hdl, DL_POWER_ON);
+  KNX_Ph_SetAddr(hdl->Ph, &hdl->Addr);
+  
   /** Set state to ::DL_RESET */
-  KNX_DL_SetState(DL_RESET);
+  KNX_DL_SetState(hdl, DL_RESET);
 
   /** Send reset quest until reset indication is received */
   for(i=0; i<retryTimes; i++)
   {
-    if(KNX_Ph_Reset() == PH_ERROR_NONE)
+    if(KNX_Ph_Reset(hdl->Ph) == PH_ERROR_NONE)
     {
       /** Send state quest to confirm the state */
-      if(KNX_Ph_State(&res) == PH_ERROR_NONE && res == State_indication)
+      if(KNX_Ph_State(hdl->Ph, &res) == PH_ERROR_NONE && res == State_indication)
       {
+#ifndef KNX_HOST
         HAL_GPIO_TogglePin(GPIOD, LD4_Pin);
+#endif
         
-        KNX_DL_SetState(DL_NORMAL);
+        KNX_DL_SetState(hdl, DL_NORMAL);
 
         return DL_ERROR_NONE;
       }
     }
   }
    
-  KNX_DL_SetState(DL_POWER_ON);
+  KNX_DL_SetState(hdl, DL_POWER_ON);
    
   return DL_ERROR_INIT;
 }
@@ -136,7 +152,11 @@ uint8_t KNX_DL_Init(void)
   */
 
 /**
- *  @brief      Send a frame to the KNX bus. 
+ *  @brief      Send a frame to the KNX bus. The frame waits in the queue of
+ *              its priority until ::KNX_DL_TxTask sends it; the calling task
+ *              sleeps until the confirmation on ::KNX_DL_TX_NOTIFY_BIT of its
+ *              task notification, which it must not use for anything else.
+ *  @param      hdl: DL handle of the line.
  *  @param      Tx_FT: Frame Type
  *                      - 0: L_Data_Extended Frame
  *                      - 1: L_Data_Standard Frame
@@ -153,122 +173,295 @@ uint8_t KNX_DL_Init(void)
  *  @param      Tx_LG: Length of LSDU
  *  @retval     Error code, See \ref DL_Error_Code.
  */
-uint8_t KNX_DL_Data_req(uint8_t Tx_FT, uint8_t Tx_AT, uint16_t Tx_DA, uint8_t Tx_Pri, uint8_t *Tx_LSDU, uint8_t Tx_LG)
+uint8_t KNX_DL_Data_req(DL_Handle_t *hdl, uint8_t Tx_FT, uint8_t Tx_AT, uint16_t Tx_DA, uint8_t Tx_Pri, uint8_t *Tx_LSDU, uint8_t Tx_LG)
 {
-  uint8_t Tx_CTRL, Tx_ChkOct, i, ret;
-  uint16_t Tx_SA = KNX_DL_SA;
+  uint8_t Tx_CTRL, Tx_ChkOct, rank;
+  uint16_t Tx_SA = hdl->Addr.Individual;
+  KNX_Frame_t *tx;
+  DL_TxRequest_t request;
+  DL_TxRequest_t *req = &request;
+  DL_TxStats_t *stats;
+  uint16_t depth;
+  uint32_t notified = 0;
+  uint32_t cycles = KNX_GetCycles();
   
-  Tx_LPDU_Datas_length = 8 + Tx_LG;
-  Tx_CTRL = ((Tx_FT << 7) | BIT4 | (Tx_Pri << 2));
-  Tx_ChkOct = KNX_VerticalParity(Tx_LSDU, Tx_LG);
-  
-  Tx_LPDU_Datas[0] = (uint8_t)Tx_CTRL;
-  Tx_LPDU_Datas[1] = (uint8_t)(Tx_SA >> 8);
-  Tx_LPDU_Datas[2] = (uint8_t)(Tx_SA & (0xFF));
-  Tx_LPDU_Datas[3] = (uint8_t)(Tx_DA >> 8);
-  Tx_LPDU_Datas[4] = (uint8_t)(Tx_DA & (0xFF));
-  Tx_LPDU_Datas[5] = (uint8_t)((Tx_AT << 7) | (0/*3 bits LSDU?*/) | (Tx_LG & (0x0F)));
-  Tx_LPDU_Datas[6] = (uint8_t)Tx_LSDU[0];
-  for(i=0; i<Tx_LG; i++)
+  if(Tx_LG > FRAME_SIZE - 8U)
   {
-    Tx_LPDU_Datas[7+i] = (uint8_t)Tx_LSDU[i];
+    return DL_ERROR_REQUEST;
   }
-  Tx_LPDU_Datas[7+Tx_LG] = (uint8_t)Tx_ChkOct;
   
-  ret = KNX_Ph_Data_req(Tx_LPDU_Datas, Tx_LPDU_Datas_length);
-  if(ret == PH_ERROR_NONE)
+  /** The frame is built in a buffer of the pool and sent from there. */
+  tx = KNX_Frame_Alloc();
+  if(tx == NULL)
   {
-    return DL_ERROR_NONE;
+    return DL_ERROR_NO_BUFFER;
   }
-  else if(ret == PH_ERROR_DATA_CON_FAIL)
+  
+  tx->Length = 8 + Tx_LG;
+  /** A new frame: only its repetitions clear ::FRAME_CTRL_NOT_REPEATED. */
+  Tx_CTRL = ((Tx_FT << 7) | FRAME_CTRL_NOT_REPEATED | BIT4 | (Tx_Pri << 2));
+  
+  tx->Datas[0] = (uint8_t)Tx_CTRL;
+  tx->Datas[1] = (uint8_t)(Tx_SA >> 8);
+  tx->Datas[2] = (uint8_t)(Tx_SA & (0xFF));
+  tx->Datas[3] = (uint8_t)(Tx_DA >> 8);
+  tx->Datas[4] = (uint8_t)(Tx_DA & (0xFF));
+  tx->Datas[5] = (uint8_t)((Tx_AT << 7) | (0/*3 bits LSDU?*/) | (Tx_LG & (0x0F)));
+  tx->Datas[6] = (uint8_t)Tx_LSDU[0];
+  memcpy(&tx->Datas[7], Tx_LSDU, Tx_LG);
+  /** The check octet is the inverted XOR of all the octets before it. */
+  Tx_ChkOct = (uint8_t)~KNX_VerticalParity(tx->Datas, 7U + Tx_LG);
+  tx->Datas[7+Tx_LG] = (uint8_t)Tx_ChkOct;
+  
+  request.Frame = tx;
+  request.Task = xTaskGetCurrentTaskHandle();
+  request.Enqueued = KNX_GetMicros();
+  request.Aged = FALSE;
+  request.Result = DL_ERROR_TIMEOUT;
+  KNX_Timer_Init(&request.Aging, KNX_DL_AgingTimeout, (void *)&request);
+  
+  rank = KNX_DL_TX_RANK[Tx_Pri & 0x03U];
+  stats = &hdl->TxStats[rank];
+  /** Armed before the request is seen by ::KNX_DL_TxTask, which stops it. */
+  if(rank != 0U)
   {
-    return DL_ERROR_DATA_CON_FAIL;
+    KNX_Timer_Start(&KNX_TimerWheel, &request.Aging, KNX_DL_TX_AGING, 0);
   }
-  else
+  if(xQueueSend(hdl->TxQueues[rank], &req, KNX_MS_TO_TICKS(KNX_DEFAULT_TIMEOUT)) != pdTRUE)
   {
+    KNX_Timer_Stop(&KNX_TimerWheel, &request.Aging);
+    taskENTER_CRITICAL();
+    stats->Rejected++;
+    taskEXIT_CRITICAL();
+    KNX_Frame_Release(tx);
     return DL_ERROR_TIMEOUT;
   }
+  
+  depth = (uint16_t)uxQueueMessagesWaiting(hdl->TxQueues[rank]);
+  taskENTER_CRITICAL();
+  stats->Requests++;
+  if(depth > stats->MaxDepth)
+  {
+    stats->MaxDepth = depth;
+  }
+  hdl->Perf.TxFrames++;
+  hdl->Perf.TxCycles += KNX_GetCycles() - cycles;
+  taskEXIT_CRITICAL();
+  xSemaphoreGive(hdl->TxSemaphore);
+  
+  /** Sleep until ::KNX_DL_TxTask has sent the frame. Only its bit is
+      cleared: a notification given meanwhile by a timer or another task
+      wakes this loop up but stays pending for its own wait. */
+  while((notified & KNX_DL_TX_NOTIFY_BIT) == 0U)
+  {
+    xTaskNotifyWait(0, KNX_DL_TX_NOTIFY_BIT, &notified, portMAX_DELAY);
+  }
+  
+  KNX_Frame_Release(tx);
+  return request.Result;
 }
 
 /**
- *  @brief      Receive a frame from the KNX bus. 
+ *  @brief      Receive a frame from the KNX bus, fields decoded and LSDU
+ *              copied to the caller. Same as ::KNX_DL_Frame_rec, with a copy.
+ *  @param      hdl: DL handle of the line.
+ *  @param      Rx_FT: Frame Type, see ::KNX_DL_Data_req
+ *  @param      Rx_AT: Adrress Type
+ *  @param      Rx_SA: Source Address
+ *  @param      Rx_Pri: Priority of the data
+ *  @param      Rx_LSDU: Datas of user Link Layer, at least 15 octets
+ *  @param      Rx_LG: Length of LSDU, 0 for an extended frame
  *  @retval     Error code, See \ref DL_Error_Code.
  */
-uint8_t KNX_DL_Data_rec(uint8_t *Rx_FT, uint8_t *Rx_AT, uint16_t *Rx_SA, uint8_t *Rx_Pri, uint8_t *Rx_LSDU, uint8_t *Rx_LG)
+uint8_t KNX_DL_Data_rec(DL_Handle_t *hdl, uint8_t *Rx_FT, uint8_t *Rx_AT, uint16_t *Rx_SA, uint8_t *Rx_Pri, uint8_t *Rx_LSDU, uint8_t *Rx_LG)
 {
-  uint8_t Rx_CTRL, i;
-  uint16_t Rx_DA;
+  uint8_t ret;
+  KNX_Frame_t *rx;
+  
+  ret = KNX_DL_Frame_rec(hdl, &rx);
+  if(ret != DL_ERROR_NONE)
+  {
+    return ret;
+  }
+  
+  *Rx_FT = rx->Datas[0] >> 7;
+  *Rx_Pri = (rx->Datas[0] >> 2) & (0x03);
+  *Rx_SA = (rx->Datas[1] << 8) | rx->Datas[2];
+  *Rx_AT = 0;
+  *Rx_LG = 0;
+  
+  /** If Data Fomat is standard */
+  if(*Rx_FT == 1U)
+  {
+    *Rx_AT = rx->Datas[5] >> 7;
+    *Rx_LG = rx->Datas[5] & (0x0F);
+    memcpy(Rx_LSDU, &rx->Datas[7], *Rx_LG);
+  }
+  
+  KNX_Frame_Release(rx);
+  return DL_ERROR_NONE;
+}
+
+/**
+ *  @brief      Receive a frame from the KNX bus without copy. A standard frame
+ *              addressed to the device is acknowledged. The frame is then
+ *              handed to each consumer registered with ::KNX_DL_AddConsumer,
+ *              and to the caller. A repetition of a frame received within
+ *              ::KNX_DL_DUP_WINDOW is dropped, see \ref DL_Duplicates. The
+ *              fill level of the queues is checked on each call to enter or
+ *              leave ::DL_BUSY, see \ref DL_Backpressure.
+ *  @param      hdl: DL handle of the line.
+ *  @param      frame: the frame received, the caller owns its reference and
+ *              must give it back with ::KNX_Frame_Release.
+ *  @retval     Error code, See \ref DL_Error_Code. No frame is returned
+ *              unless ::DL_ERROR_NONE.
+ */
+uint8_t KNX_DL_Frame_rec(DL_Handle_t *hdl, KNX_Frame_t **frame)
+{
+  uint8_t ret;
+  KNX_Frame_t *rx;
+  uint32_t cycles;
+  
+  KNX_DL_Backpressure(hdl);
+  if(KNX_Ph_Frame_rec(hdl->Ph, &rx, KNX_DEFAULT_TIMEOUT) != PH_ERROR_NONE)
+  {
+    return DL_ERROR_TIMEOUT;
+  }
+  cycles = KNX_GetCycles();
+  
+  ret = KNX_DL_CheckFrame(hdl, rx);
+  if(ret == DL_ERROR_NONE && KNX_DL_IsDuplicate(hdl, rx) == TRUE)
+  {
+    ret = DL_ERROR_DUPLICATE;
+  }
+  if(ret != DL_ERROR_NONE)
+  {
+    KNX_Frame_Release(rx);
+  }
+  else
+  {
+    KNX_DL_Dispatch(hdl, rx);
+    KNX_DL_Backpressure(hdl);
+    *frame = rx;
+  }
+  
+  taskENTER_CRITICAL();
+  hdl->Perf.RxFrames++;
+  hdl->Perf.RxCycles += KNX_GetCycles() - cycles;
+  taskEXIT_CRITICAL();
+  
+  return ret;
+}
+
+/**
+ *  @brief      Transmit task of a line, created by ::KNX_DL_Init. It sends
+ *              the frames queued by ::KNX_DL_Data_req, the highest priority
+ *              first, see ::KNX_DL_TxSchedule, and renews the busy mode of
+ *              the TP-UART when ::DL_Handle_t::BusyTimer asks.
+ *  @param      argument: ::DL_Handle_t of the line.
+ */
+void KNX_DL_TxTask(void *argument)
+{
+  DL_Handle_t *hdl = (DL_Handle_t *)argument;
+  DL_TxRequest_t *req;
+  DL_TxStats_t *stats;
+  TaskHandle_t task;
+  uint32_t start, wait, latency;
+  uint8_t rank, ret;
   
-  if(KNX_Ph_Data_rec(Rx_LPDU_Datas, &Rx_LPDU_Datas_length) == PH_ERROR_NONE)
+  for(;;)
   {
-    if(Rx_LPDU_Datas_length < 7)
+    xSemaphoreTake(hdl->TxSemaphore, portMAX_DELAY);
+    
+    if(hdl->BusyRenew == TRUE)
     {
-      return DL_ERROR_FRAME;
+      hdl->BusyRenew = FALSE;
+      if(hdl->State == DL_BUSY)
+      {
+        KNX_Ph_ActivateBusyMode(hdl->Ph);
+        /** ::DL_BUSY left meanwhile, don't leave the TP-UART busy. */
+        if(hdl->State != DL_BUSY)
+        {
+          KNX_Ph_ResetBusyMode(hdl->Ph);
+        }
+      }
     }
     
-    Rx_CTRL = Rx_LPDU_Datas[0];
-    
-    if(((Rx_CTRL & BIT4) != BIT4) || ((Rx_CTRL & ~(0x03)) != Rx_CTRL))
+    rank = KNX_DL_TxSchedule(hdl);
+    if(rank >= DL_TX_PRIORITIES || xQueueReceive(hdl->TxQueues[rank], &req, 0) != pdTRUE)
     {
-      return DL_ERROR_FRAME;
+      continue;
     }
+    KNX_Timer_Stop(&KNX_TimerWheel, &req->Aging);
     
-    *Rx_FT = (Rx_CTRL >> 6);
-    *Rx_Pri = (Rx_CTRL >> 2) & (0x03);
+    start = KNX_GetMicros();
+    ret = KNX_Ph_Data_req(hdl->Ph, req->Frame->Datas, req->Frame->Length);
+    wait = start - req->Enqueued;
+    latency = KNX_GetMicros() - req->Enqueued;
     
-    /** If Data Fomat is standard */
-    if(*Rx_FT == 0x10)
+    stats = &hdl->TxStats[rank];
+    taskENTER_CRITICAL();
+    if(ret == PH_ERROR_NONE)
     {
-      *Rx_SA = (Rx_LPDU_Datas[1] << 8) | Rx_LPDU_Datas[2];
-      Rx_DA = (Rx_LPDU_Datas[3] << 8) | Rx_LPDU_Datas[4];
-      
-      if(Rx_DA != KNX_DL_SA)
-      {
-        return DL_ERROR_ADDRESS;
-      }
-      
-      /** If Checksum is incorrect */
-      if(KNX_VerticalParity(Rx_LPDU_Datas, Rx_LPDU_Datas_length-1) != Rx_LPDU_Datas[Rx_LPDU_Datas_length-1])
-      {
-        /** Send NACK */
-        KNX_Ph_SendData(U_AckInformation_Nack, KNX_DEFAULT_TIMEOUT);
-        return DL_ERROR_FRAME;
-      }
-      
-      *Rx_AT = Tx_LPDU_Datas[5] >> 7;
-      *Rx_LG = Tx_LPDU_Datas[5] & (0x0F);
-      /** If length is incorrect */
-      if(Rx_LPDU_Datas_length != *Rx_LG + 8)
-      {
-        /** Send NACK */
-        KNX_Ph_SendData(U_AckInformation_Nack, KNX_DEFAULT_TIMEOUT);
-        return DL_ERROR_FRAME;
-      }
-      
-      for(i=0; i<*Rx_LG; i++)
-      {
-        Rx_LSDU[i] = Rx_LPDU_Datas[7+i];
-      }
-      
-      /** If in busy mode */
-      if(KNX_DL_STATE == DL_BUSY)
-      {
-        /** Send BUSY */
-        KNX_Ph_SendData(U_AckInformation_Busy, KNX_DEFAULT_TIMEOUT);
-        return DL_ERROR_BUSY;        
-      }
-
-      /** Send ACK */
-      KNX_Ph_SendData(U_AckInformation_ACK, KNX_DEFAULT_TIMEOUT);
-      return DL_ERROR_NONE;        
+      stats->Sent++;
+      /** A failure returns at a timeout, not when the frame is on the bus:
+          only the frames confirmed make the latency. */
+      KNX_Histogram_Record(&hdl->Perf.TxLatency, latency);
     }
     else
     {
-      return DL_ERROR_NONE;
+      stats->Failed++;
+    }
+    stats->WaitSum += wait;
+    stats->LatencySum += latency;
+    if(wait > stats->WaitMax)
+    {
+      stats->WaitMax = wait;
     }
+    if(latency > stats->LatencyMax)
+    {
+      stats->LatencyMax = latency;
+    }
+    taskEXIT_CRITICAL();
+    
+    if(ret == PH_ERROR_NONE)
+    {
+      req->Result = DL_ERROR_NONE;
+    }
+    else if(ret == PH_ERROR_DATA_CON_FAIL)
+    {
+      req->Result = DL_ERROR_DATA_CON_FAIL;
+    }
+    else
+    {
+      req->Result = DL_ERROR_TIMEOUT;
+    }
+    
+    /** The request is gone once the bit is set. */
+    task = req->Task;
+    xTaskNotify(task, KNX_DL_TX_NOTIFY_BIT, eSetBits);
+  }
+}
+
+/**
+ *  @brief      Register a consumer of the frames received. Each frame given
+ *              by ::KNX_DL_Frame_rec is also sent to \b queue, with its own
+ *              reference; the consumer gives it back with ::KNX_Frame_Release.
+ *  @param      hdl: DL handle of the line.
+ *  @param      queue: FreeRTOS queue of items of type \c KNX_Frame_t*.
+ *  @retval     Error code, See \ref DL_Error_Code.
+ */
+uint8_t KNX_DL_AddConsumer(DL_Handle_t *hdl, QueueHandle_t queue)
+{
+  if((queue == NULL) || (hdl->ConsumersNb >= KNX_DL_MAX_CONSUMERS))
+  {
+    return DL_ERROR_REQUEST;
   }
   
-  return DL_ERROR_TIMEOUT;
+  hdl->Consumers[hdl->ConsumersNb] = queue;
+  hdl->ConsumersNb++;
+  
+  return DL_ERROR_NONE;
 }
 /**
   * @}
@@ -280,11 +473,179 @@ uint8_t KNX_DL_Data_rec(uint8_t *Rx_FT, uint8_t *Rx_AT, uint16_t *Rx_SA, uint8_t
 
 /**
  *  @brief      Getter of the status of the Data Link Layer. 
+ *  @param      hdl: DL handle of the line.
  *  @retval     Data Link Layer's status: ::DL_Status_t.
  */
-DL_Status_t KNX_DL_GetState(void)
+DL_Status_t KNX_DL_GetState(DL_Handle_t *hdl)
 {
-  return KNX_DL_STATE;
+  return hdl->State;
+}
+
+/**
+ *  @brief      Number of frames a consumer missed because its queue was full.
+ *  @param      hdl: DL handle of the line.
+ *  @retval     Counter summed over all the consumers.
+ */
+uint32_t KNX_DL_GetConsumerDrops(DL_Handle_t *hdl)
+{
+  return hdl->ConsumerDrops;
+}
+
+/**
+ *  @brief      Copy the counters of the transmit queues.
+ *  @param      hdl: DL handle of the line.
+ *  @param      stats: pointer to store the counters, from system to low
+ *              priority.
+ */
+void KNX_DL_GetTxStats(DL_Handle_t *hdl, DL_TxStats_t stats[DL_TX_PRIORITIES])
+{
+  uint8_t i;
+  
+  taskENTER_CRITICAL();
+  memcpy(stats, hdl->TxStats, sizeof(hdl->TxStats));
+  taskEXIT_CRITICAL();
+  
+  for(i=0; i<DL_TX_PRIORITIES; i++)
+  {
+    stats[i].Depth = (uint16_t)uxQueueMessagesWaiting(hdl->TxQueues[i]);
+  }
+}
+
+/**
+ *  @brief      Number of repetitions dropped because the frame had already
+ *              been received.
+ *  @param      hdl: DL handle of the line.
+ *  @retval     Counter since the initialization.
+ */
+uint32_t KNX_DL_GetDuplicateDrops(DL_Handle_t *hdl)
+{
+  return hdl->DupDrops;
+}
+
+/**
+ *  @brief      Restart the performance counters, e.g. at the end of a warm
+ *              up. The counters of the transmit queues are restarted too.
+ *  @param      hdl: DL handle of the line.
+ */
+void KNX_DL_ResetPerf(DL_Handle_t *hdl)
+{
+  taskENTER_CRITICAL();
+  memset(&hdl->Perf, 0, sizeof(hdl->Perf));
+  memset(hdl->TxStats, 0, sizeof(hdl->TxStats));
+  hdl->Perf.Since = KNX_GetTick();
+  taskEXIT_CRITICAL();
+}
+
+/**
+ *  @brief      Write the performance of the line as a single line of JSON,
+ *              to be tracked from release to release:
+ *              - \c ms: time covered by the counters;
+ *              - \c tx, \c tx_failed, \c tx_rejected, \c tx_per_s: frames
+ *                sent, not confirmed, refused for a full queue, and confirmed
+ *                per second;
+ *              - \c rx, \c rx_per_s: frames received;
+ *              - \c lat_us: request to confirmation of the frames
+ *                confirmed, \c p50, \c p99, \c p999, \c max and \c mean;
+ *              - \c tx_cycles, \c rx_cycles: cycles of the DL per frame
+ *                sent and received, ns on the host;
+ *              - \c pool: \c allocs, \c exhausted, \c max_in_use and
+ *                \c retain_failed of \ref KNX_Frame_Pool, shared by all
+ *                the lines;
+ *              - \c dup_drops, \c consumer_drops, \c busy_ms.
+ *  @param      hdl: DL handle of the line.
+ *  @param      buffer: where to write the line, NUL terminated.
+ *  @param      size: size of \b buffer.
+ *  @retval     Number of characters written, 0 if \b buffer is too small.
+ */
+uint16_t KNX_DL_Report(DL_Handle_t *hdl, char *buffer, uint16_t size)
+{
+  DL_TxStats_t tx[DL_TX_PRIORITIES];
+  KNX_Frame_Stats_t pool;
+  KNX_Histogram_t *lat = &hdl->Perf.TxLatency;
+  uint32_t sent = 0, failed = 0, rejected = 0;
+  uint32_t ms, p50, p99, p999, max, mean;
+  uint32_t txFrames, rxFrames;
+  uint64_t txCycles, rxCycles;
+  uint8_t i;
+  int n;
+  
+  KNX_DL_GetTxStats(hdl, tx);
+  KNX_Frame_GetStats(&pool);
+  for(i=0; i<DL_TX_PRIORITIES; i++)
+  {
+    sent += tx[i].Sent;
+    failed += tx[i].Failed;
+    rejected += tx[i].Rejected;
+  }
+  
+  taskENTER_CRITICAL();
+  ms = KNX_GetTick() - hdl->Perf.Since;
+  p50 = KNX_Histogram_Percentile(lat, 500);
+  p99 = KNX_Histogram_Percentile(lat, 990);
+  p999 = KNX_Histogram_Percentile(lat, 999);
+  max = lat->Max;
+  mean = KNX_Histogram_Mean(lat);
+  txFrames = hdl->Perf.TxFrames;
+  txCycles = hdl->Perf.TxCycles;
+  rxFrames = hdl->Perf.RxFrames;
+  rxCycles = hdl->Perf.RxCycles;
+  taskEXIT_CRITICAL();
+  
+  if(ms == 0U)
+  {
+    ms = 1;
+  }
+  
+  n = snprintf(buffer, size,
+               "{\"ms\":%lu,\"tx\":%lu,\"tx_failed\":%lu,\"tx_rejected\":%lu,"
+               "\"tx_per_s\":%lu,\"rx\":%lu,\"rx_per_s\":%lu,"
+               "\"lat_us\":{\"p50\":%lu,\"p99\":%lu,\"p999\":%lu,\"max\":%lu,\"mean\":%lu},"
+               "\"tx_cycles\":%lu,\"rx_cycles\":%lu,"
+               "\"pool\":{\"allocs\":%lu,\"exhausted\":%lu,\"max_in_use\":%u,\"retain_failed\":%lu},"
+               "\"dup_drops\":%lu,\"consumer_drops\":%lu,\"busy_ms\":%lu}\r\n",
+               (unsigned long)ms, (unsigned long)sent, (unsigned long)failed,
+               (unsigned long)rejected,
+               (unsigned long)((uint64_t)sent * 1000U / ms), (unsigned long)rxFrames,
+               (unsigned long)((uint64_t)rxFrames * 1000U / ms),
+               (unsigned long)p50, (unsigned long)p99, (unsigned long)p999,
+               (unsigned long)max, (unsigned long)mean,
+               (unsigned long)((txFrames != 0U) ? txCycles / txFrames : 0U),
+               (unsigned long)((rxFrames != 0U) ? rxCycles / rxFrames : 0U),
+               (unsigned long)pool.Allocs, (unsigned long)pool.Exhausted,
+               (unsigned int)pool.MaxInUse, (unsigned long)pool.RetainFailed,
+               (unsigned long)hdl->DupDrops, (unsigned long)hdl->ConsumerDrops,
+               (unsigned long)KNX_DL_GetBusyTime(hdl));
+  if((n < 0) || (n >= size))
+  {
+    return 0;
+  }
+  
+  return (uint16_t)n;
+}
+
+/**
+ *  @brief      Number of times the backpressure entered ::DL_BUSY.
+ *  @param      hdl: DL handle of the line.
+ *  @retval     Counter since the initialization.
+ */
+uint32_t KNX_DL_GetBusyEntries(DL_Handle_t *hdl)
+{
+  return hdl->BusyEntries;
+}
+
+/**
+ *  @brief      Time spent in ::DL_BUSY, the ongoing period included.
+ *  @param      hdl: DL handle of the line.
+ *  @retval     Time in ms since the initialization.
+ */
+uint32_t KNX_DL_GetBusyTime(DL_Handle_t *hdl)
+{
+  if(hdl->State == DL_BUSY)
+  {
+    return hdl->BusyTime + (KNX_GetTick() - hdl->BusySince);
+  }
+  
+  return hdl->BusyTime;
 }
 /**
   * @}
@@ -301,12 +662,270 @@ DL_Status_t KNX_DL_GetState(void)
 
 /**
  *  @brief      Set the status of Data Link Layer. 
+ *  @param      hdl: DL handle of the line.
  *  @param      state: the state.
  */
-static void     KNX_DL_SetState(DL_Status_t state)
+static void     KNX_DL_SetState(DL_Handle_t *hdl, DL_Status_t state)
+{
+  /** Change the ::DL_Handle_t::State to \b state */
+  hdl->State = state;
+}
+
+/**
+ *  @brief      Fill level of the deepest filled queue between the frame
+ *              queue of the PH and the queues of the consumers.
+ *  @param      hdl: DL handle of the line.
+ *  @retval     Fill level in percent.
+ */
+static uint32_t KNX_DL_FillLevel(DL_Handle_t *hdl)
+{
+  uint32_t level, waiting, size;
+  uint8_t i;
+  
+  level = KNX_Ph_GetFrameCount(hdl->Ph) * 100U / KNX_PH_FRAME_QUEUE_SIZE;
+  for(i=0; i<hdl->ConsumersNb; i++)
+  {
+    waiting = uxQueueMessagesWaiting(hdl->Consumers[i]);
+    size = waiting + uxQueueSpacesAvailable(hdl->Consumers[i]);
+    if(size != 0U && waiting * 100U / size > level)
+    {
+      level = waiting * 100U / size;
+    }
+  }
+  
+  return level;
+}
+
+/**
+ *  @brief      Enter ::DL_BUSY at ::KNX_DL_BUSY_HIGH_WATER and leave it at
+ *              ::KNX_DL_BUSY_LOW_WATER, switching the busy mode of the
+ *              TP-UART. The ack of each frame is decided by the RX interrupt
+ *              from the levels it sees, see ::KNX_PH_ACK_BUSY_LEVEL; this
+ *              hysteresis only spares the TP-UART a request per frame.
+ *  @param      hdl: DL handle of the line.
+ */
+static void     KNX_DL_Backpressure(DL_Handle_t *hdl)
+{
+  uint32_t level, tick;
+  
+  if(hdl->State != DL_NORMAL && hdl->State != DL_BUSY)
+  {
+    return;
+  }
+  
+  level = KNX_DL_FillLevel(hdl);
+  tick = KNX_GetTick();
+  
+  if(hdl->State == DL_NORMAL)
+  {
+    if(level >= KNX_DL_BUSY_HIGH_WATER)
+    {
+      KNX_DL_SetState(hdl, DL_BUSY);
+      KNX_Ph_ActivateBusyMode(hdl->Ph);
+      hdl->BusyEntries++;
+      hdl->BusySince = tick;
+      /** Renewed by ::KNX_DL_TxTask as long as the line stays busy. */
+      KNX_Timer_Start(&KNX_TimerWheel, &hdl->BusyTimer, KNX_DL_BUSY_REFRESH, KNX_DL_BUSY_REFRESH);
+    }
+  }
+  else if(level <= KNX_DL_BUSY_LOW_WATER)
+  {
+    KNX_DL_SetState(hdl, DL_NORMAL);
+    KNX_Timer_Stop(&KNX_TimerWheel, &hdl->BusyTimer);
+    hdl->BusyRenew = FALSE;
+    KNX_Ph_ResetBusyMode(hdl->Ph);
+    hdl->BusyTime += tick - hdl->BusySince;
+  }
+}
+
+/**
+ *  @brief      Choose the transmit queue to serve: the highest priority with
+ *              a frame waiting, unless a frame of a lower priority has waited
+ *              more than ::KNX_DL_TX_AGING.
+ *  @param      hdl: DL handle of the line.
+ *  @retval     Indice in ::DL_Handle_t::TxQueues, ::DL_TX_PRIORITIES if all
+ *              are empty.
+ */
+static uint8_t  KNX_DL_TxSchedule(DL_Handle_t *hdl)
+{
+  DL_TxRequest_t *req;
+  uint8_t rank, pick = DL_TX_PRIORITIES;
+  
+  for(rank=0; rank<DL_TX_PRIORITIES; rank++)
+  {
+    if(xQueuePeek(hdl->TxQueues[rank], &req, 0) != pdTRUE)
+    {
+      continue;
+    }
+    
+    if(pick == DL_TX_PRIORITIES)
+    {
+      pick = rank;
+    }
+    else if(req->Aged == TRUE)
+    {
+      /** Starvation protection: the frame too old goes first. */
+      hdl->TxStats[rank].Aged++;
+      return rank;
+    }
+  }
+  
+  return pick;
+}
+
+/**
+ *  @brief      Callback of ::DL_TxRequest_t::Aging, from the tick interrupt:
+ *              the request has waited ::KNX_DL_TX_AGING.
+ *  @param      timer: the timer expired.
+ *  @param      woken: not used, the request is only looked at by
+ *              ::KNX_DL_TxSchedule.
+ */
+static void     KNX_DL_AgingTimeout(KNX_Timer_t *timer, BaseType_t *woken)
+{
+  (void)woken;
+  ((DL_TxRequest_t *)timer->Context)->Aged = TRUE;
+}
+
+/**
+ *  @brief      Callback of ::DL_Handle_t::BusyTimer, from the tick
+ *              interrupt: wake up ::KNX_DL_TxTask to renew the busy mode.
+ *  @param      timer: the timer expired.
+ *  @param      woken: set if ::KNX_DL_TxTask must run.
+ */
+static void     KNX_DL_BusyTimeout(KNX_Timer_t *timer, BaseType_t *woken)
+{
+  DL_Handle_t *hdl = (DL_Handle_t *)timer->Context;
+  
+  hdl->BusyRenew = TRUE;
+  xSemaphoreGiveFromISR(hdl->TxSemaphore, woken);
+}
+
+/**
+ *  @brief      Hash of a frame (FNV-1a), the repeat flag and the checksum
+ *              left out so a repetition hashes like the original.
+ *  @param      frame: the frame.
+ *  @retval     The hash, never 0.
+ */
+static uint32_t KNX_DL_FrameHash(KNX_Frame_t *frame)
+{
+  uint32_t hash = 2166136261U;
+  uint16_t i;
+  
+  hash = (hash ^ (frame->Datas[0] | FRAME_CTRL_NOT_REPEATED)) * 16777619U;
+  for(i=1; i<frame->Length-1U; i++)
+  {
+    hash = (hash ^ frame->Datas[i]) * 16777619U;
+  }
+  
+  return (hash != 0U) ? hash : 1U;
+}
+
+/**
+ *  @brief      Look a frame up in ::DL_Handle_t::DupCache, then record it. A
+ *              frame flagged as repeated is a duplicate if the same frame was
+ *              received within ::KNX_DL_DUP_WINDOW: same hash, same CTRL
+ *              octet but the repeat bit, same source and destination. A
+ *              frame not flagged is always new, the same command can be sent
+ *              twice on purpose.
+ *  @param      hdl: DL handle of the line.
+ *  @param      frame: the frame received.
+ *  @retval     TRUE if the frame is dropped, FALSE otherwise.
+ */
+static uint8_t  KNX_DL_IsDuplicate(DL_Handle_t *hdl, KNX_Frame_t *frame)
+{
+  uint32_t hash = KNX_DL_FrameHash(frame);
+  uint32_t tick = KNX_GetTick();
+  DL_DupEntry_t *entry = &hdl->DupCache[hash & KNX_DL_DUP_CACHE_MASK];
+  uint16_t sa = (frame->Datas[1] << 8) | frame->Datas[2];
+  uint16_t da_octet = ((frame->Datas[0] & FRAME_CTRL_STANDARD) == FRAME_CTRL_STANDARD) ? FRAME_DA_OCTET : FRAME_EXT_DA_OCTET;
+  uint16_t da = (frame->Datas[da_octet] << 8) | frame->Datas[da_octet + 1U];
+  uint8_t ctrl = frame->Datas[0] | FRAME_CTRL_NOT_REPEATED;
+  
+  if((frame->Datas[0] & FRAME_CTRL_NOT_REPEATED) == 0U
+     && entry->Hash == hash && entry->Sa == sa && entry->Da == da && entry->Ctrl == ctrl
+     && tick - entry->Tick < KNX_DL_DUP_WINDOW)
+  {
+    hdl->DupDrops++;
+    return TRUE;
+  }
+  
+  entry->Hash = hash;
+  entry->Tick = tick;
+  entry->Sa = sa;
+  entry->Da = da;
+  entry->Ctrl = ctrl;
+  
+  return FALSE;
+}
+
+/**
+ *  @brief      Check a frame received. Only the standard frames addressed
+ *              to the device are checked. The ack was already sent by the RX
+ *              interrupt, which also drops the frames with a wrong check
+ *              octet, see ::KNX_Frame_t::Verdict.
+ *  @param      hdl: DL handle of the line.
+ *  @param      frame: the frame received.
+ *  @retval     Error code, See \ref DL_Error_Code.
+ */
+static uint8_t  KNX_DL_CheckFrame(DL_Handle_t *hdl, KNX_Frame_t *frame)
 {
-  /** Change the ::KNX_DL_STATE to \b state */
-  KNX_DL_STATE = state;
+  uint8_t Rx_CTRL;
+  uint16_t Rx_DA;
+  
+  /** The CTRL octet, the length and the check octet were validated byte
+      by byte by the RX interrupt. */
+  if(frame->Verdict != FRAME_VERDICT_OK)
+  {
+    return DL_ERROR_FRAME;
+  }
+  
+  Rx_CTRL = frame->Datas[0];
+  
+  /** If Data Fomat is extended, nothing more is checked. */
+  if((Rx_CTRL & FRAME_CTRL_STANDARD) != FRAME_CTRL_STANDARD)
+  {
+    return DL_ERROR_NONE;
+  }
+  
+  Rx_DA = (frame->Datas[FRAME_DA_OCTET] << 8) | frame->Datas[FRAME_DA_OCTET + 1U];
+  if(KNX_Addr_Match(&hdl->Addr, Rx_DA, frame->Datas[FRAME_AT_OCTET] & FRAME_AT_GROUP) == FALSE)
+  {
+    return DL_ERROR_ADDRESS;
+  }
+  
+  /** If the RX interrupt answered busy, the sender repeats the frame. The
+      state may have changed since, it is not what was answered. */
+  if(frame->Ack == U_AckInformation_Busy)
+  {
+    return DL_ERROR_BUSY;
+  }
+  
+  return DL_ERROR_NONE;
+}
+
+/**
+ *  @brief      Hand a frame to the registered consumers, one reference each.
+ *              A consumer whose queue is full, or refused a reference, misses
+ *              the frame.
+ *  @param      hdl: DL handle of the line.
+ *  @param      frame: the frame received.
+ */
+static void     KNX_DL_Dispatch(DL_Handle_t *hdl, KNX_Frame_t *frame)
+{
+  uint8_t i;
+  
+  for(i=0; i<hdl->ConsumersNb; i++)
+  {
+    if(KNX_Frame_Retain(frame) == FALSE)
+    {
+      hdl->ConsumerDrops++;
+    }
+    else if(xQueueSend(hdl->Consumers[i], &frame, 0) != pdPASS)
+    {
+      KNX_Frame_Release(frame);
+      hdl->ConsumerDrops++;
+    }
+  }
 }
 
 /**
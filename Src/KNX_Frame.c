@@ -0,0 +1,231 @@
+/**
+  ******************************************************************************
+  * @file       KNX_Frame.c
+  * @author     MA Dingjie
+  * @version    V1.0.0
+  * @date       17-October-2016
+  * @brief      KNX frame buffer pool.
+  *             This file provides functions to manage following functionalities:
+  *              + Initialization functions
+  *              + Allocation and reference counting, O(1) and interrupt safe
+  *              + Pool counters
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "KNX_Frame.h"
+
+/** @addtogroup KNX_Lib
+  * @{
+  */
+
+/** @defgroup KNX_Frame_Pool KNX Frame Pool
+  * @brief    Statically allocated frame buffers with reference counts, so a
+  *           frame is passed from the RX interrupt to the consumers without
+  *           being copied.
+  * @{
+  */
+
+/* Private variables ---------------------------------------------------------*/
+/** @defgroup KNX_Frame_Pool_Private_Variables KNX Frame Pool Private Variables
+  * @{
+  */
+/** \brief Storage of the buffers. */
+static KNX_Frame_t KNX_FRAME_POOL[KNX_FRAME_POOL_SIZE];
+/** \brief Head of the list of the free buffers. */
+static KNX_Frame_t *KNX_FRAME_FREE;
+/** \brief Counters of the pool. */
+static KNX_Frame_Stats_t KNX_FRAME_STATS;
+/** \brief TRUE once ::KNX_Frame_Init has been called. */
+static uint8_t KNX_FRAME_READY;
+/**
+  * @}
+  */
+
+/* Exported functions --------------------------------------------------------*/
+/** @defgroup KNX_Frame_Pool_Exported_Functions KNX Frame Pool Exported Functions
+  * @{
+  */
+
+/** @defgroup KNX_Frame_Pool_Exported_Functions_Group1 Initialization Functions
+  * @{
+  */
+
+/**
+  * @brief      Put all the buffers in the free list and clear the counters.
+  *             Must be called before the interrupts using the pool start.
+  *             The pool is shared by all the lines: only the first call does
+  *             something, the buffers already handed out stay valid.
+  */
+void KNX_Frame_Init(void)
+{
+  uint16_t i;
+  
+  if(KNX_FRAME_READY == TRUE)
+  {
+    return;
+  }
+
+  KNX_FRAME_FREE = NULL;
+  for(i=0; i<KNX_FRAME_POOL_SIZE; i++)
+  {
+    KNX_FRAME_POOL[i].RefCount = 0;
+    KNX_FRAME_POOL[i].Length = 0;
+    KNX_FRAME_POOL[i].Next = KNX_FRAME_FREE;
+    KNX_FRAME_FREE = &KNX_FRAME_POOL[i];
+  }
+  memset(&KNX_FRAME_STATS, 0, sizeof(KNX_FRAME_STATS));
+  KNX_FRAME_READY = TRUE;
+}
+/**
+  * @}
+  */
+
+/** @defgroup KNX_Frame_Pool_Exported_Functions_Group2 Allocation Functions
+  * @{
+  */
+
+/**
+  * @brief      Take a buffer from the pool, with one reference owned by the
+  *             caller.
+  * @retval     Pointer to the buffer, NULL if the pool is exhausted.
+  */
+KNX_Frame_t *KNX_Frame_Alloc(void)
+{
+  KNX_Frame_t *frame;
+  UBaseType_t mask;
+
+  mask = taskENTER_CRITICAL_FROM_ISR();
+  frame = KNX_FRAME_FREE;
+  if(frame != NULL)
+  {
+    KNX_FRAME_FREE = frame->Next;
+    frame->Next = NULL;
+    frame->RefCount = 1;
+    frame->Length = 0;
+    frame->Timestamp = 0;
+    frame->EndTimestamp = 0;
+    frame->Verdict = FRAME_VERDICT_OK;
+    frame->Ack = 0;
+
+    KNX_FRAME_STATS.Allocs++;
+    KNX_FRAME_STATS.InUse++;
+    if(KNX_FRAME_STATS.InUse > KNX_FRAME_STATS.MaxInUse)
+    {
+      KNX_FRAME_STATS.MaxInUse = KNX_FRAME_STATS.InUse;
+    }
+  }
+  else
+  {
+    KNX_FRAME_STATS.Exhausted++;
+  }
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+
+  return frame;
+}
+
+/**
+  * @brief      Add an owner to a buffer, before handing it to one more
+  *             consumer. A count at ::KNX_FRAME_REF_MAX would wrap to 0 and
+  *             free the buffer under its owners: the owner is refused and
+  *             counted in ::KNX_Frame_Stats_t::RetainFailed instead.
+  * @param      frame: the buffer.
+  * @retval     TRUE if the caller owns a reference, FALSE otherwise.
+  */
+uint8_t KNX_Frame_Retain(KNX_Frame_t *frame)
+{
+  UBaseType_t mask;
+  uint8_t ret = FALSE;
+
+  mask = taskENTER_CRITICAL_FROM_ISR();
+  if((frame->RefCount != 0U) && (frame->RefCount < KNX_FRAME_REF_MAX))
+  {
+    frame->RefCount++;
+    ret = TRUE;
+  }
+  else
+  {
+    KNX_FRAME_STATS.RetainFailed++;
+  }
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+
+  return ret;
+}
+
+/**
+  * @brief      Drop the reference of the caller, the buffer goes back to the
+  *             pool with its last owner.
+  * @param      frame: the buffer, NULL is ignored.
+  */
+void KNX_Frame_Release(KNX_Frame_t *frame)
+{
+  UBaseType_t mask;
+
+  if(frame == NULL)
+  {
+    return;
+  }
+
+  mask = taskENTER_CRITICAL_FROM_ISR();
+  if(frame->RefCount != 0U)
+  {
+    frame->RefCount--;
+    if(frame->RefCount == 0U)
+    {
+      frame->Next = KNX_FRAME_FREE;
+      KNX_FRAME_FREE = frame;
+      KNX_FRAME_STATS.InUse--;
+    }
+  }
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+/**
+  * @}
+  */
+
+/** @defgroup KNX_Frame_Pool_Exported_Functions_Group3 State Functions
+  * @{
+  */
+
+/**
+  * @brief      Copy the counters of the pool.
+  * @param      stats: pointer to store the counters.
+  */
+void KNX_Frame_GetStats(KNX_Frame_Stats_t *stats)
+{
+  UBaseType_t mask;
+
+  mask = taskENTER_CRITICAL_FROM_ISR();
+  *stats = KNX_FRAME_STATS;
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+/**
+  * @brief      Whether the pool has no buffer left, for the RX interrupt to
+  *             answer busy before a frame is lost. A single read of the
+  *             list, no lock needed.
+  * @retval     TRUE if the next ::KNX_Frame_Alloc fails, FALSE otherwise.
+  */
+uint8_t KNX_Frame_IsExhausted(void)
+{
+  return (KNX_FRAME_FREE == NULL) ? TRUE : FALSE;
+}
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
@@ -0,0 +1,215 @@
+/**
+  ******************************************************************************
+  * @file       KNX_Histogram.c
+  * @author     MA Dingjie
+  * @version    V1.0.0
+  * @date       17-October-2016
+  * @brief      Histograms of latencies.
+  *             This file provides functions to manage following functionalities:
+  *              + Initialization functions
+  *              + Record in O(1), percentiles
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <string.h>
+#include "KNX_Histogram.h"
+
+/** @addtogroup KNX_Lib
+  * @{
+  */
+
+/** @defgroup KNX_Histogram KNX Histogram
+  * @brief    Log-linear histograms: the percentiles of millions of latencies
+  *           in a fixed size, without sorting.
+  * @{
+  */
+
+/* Private function prototypes -----------------------------------------------*/
+static uint32_t KNX_Histogram_Bucket(uint32_t value);
+static uint32_t KNX_Histogram_Highest(uint32_t bucket);
+static uint32_t KNX_Histogram_Msb(uint32_t value);
+
+/* Exported functions --------------------------------------------------------*/
+/** @defgroup KNX_Histogram_Exported_Functions KNX Histogram Exported Functions
+  * @{
+  */
+
+/** @defgroup KNX_Histogram_Exported_Functions_Group1 Initialization Functions
+  * @{
+  */
+
+/**
+  * @brief      Empty a histogram.
+  * @param      hist: the histogram.
+  */
+void KNX_Histogram_Init(KNX_Histogram_t *hist)
+{
+  memset(hist, 0, sizeof(*hist));
+}
+/**
+  * @}
+  */
+
+/** @defgroup KNX_Histogram_Exported_Functions_Group2 Record and Read Functions
+  * @{
+  */
+
+/**
+  * @brief      Record a value.
+  * @param      hist: the histogram.
+  * @param      value: the value.
+  */
+void KNX_Histogram_Record(KNX_Histogram_t *hist, uint32_t value)
+{
+  if((hist->Count == 0U) || (value < hist->Min))
+  {
+    hist->Min = value;
+  }
+  if(value > hist->Max)
+  {
+    hist->Max = value;
+  }
+  hist->Sum += value;
+  hist->Count++;
+  hist->Buckets[KNX_Histogram_Bucket(value)]++;
+}
+
+/**
+  * @brief      Value below which a share of the values recorded lie.
+  * @param      hist: the histogram.
+  * @param      perMille: the share, in 1/1000: 500 for the median, 990
+  *             for p99, 999 for p99.9.
+  * @retval     Highest value of the bucket reaching the share, bounded by the
+  *             largest value recorded. 0 if the histogram is empty.
+  */
+uint32_t KNX_Histogram_Percentile(const KNX_Histogram_t *hist, uint32_t perMille)
+{
+  uint64_t rank;
+  uint64_t seen = 0;
+  uint32_t i, highest;
+
+  if(hist->Count == 0U)
+  {
+    return 0;
+  }
+
+  rank = ((uint64_t)hist->Count * perMille + 999U) / 1000U;
+  if(rank == 0U)
+  {
+    rank = 1;
+  }
+
+  for(i=0; i<KNX_HISTOGRAM_BUCKETS; i++)
+  {
+    seen += hist->Buckets[i];
+    if(seen >= rank)
+    {
+      break;
+    }
+  }
+
+  highest = KNX_Histogram_Highest(i);
+  return (highest < hist->Max) ? highest : hist->Max;
+}
+
+/**
+  * @brief      Mean of the values recorded.
+  * @param      hist: the histogram.
+  * @retval     The mean, 0 if the histogram is empty.
+  */
+uint32_t KNX_Histogram_Mean(const KNX_Histogram_t *hist)
+{
+  if(hist->Count == 0U)
+  {
+    return 0;
+  }
+
+  return (uint32_t)(hist->Sum / hist->Count);
+}
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/* Private functions ---------------------------------------------------------*/
+/** @defgroup KNX_Histogram_Private_Functions KNX Histogram Private Functions
+  * @{
+  */
+
+/**
+  * @brief      Bucket of a value: the value itself below
+  *             ::KNX_HISTOGRAM_LINEAR, else its power of 2 and the next
+  *             ::KNX_HISTOGRAM_SUB_BITS bits.
+  * @param      value: the value.
+  * @retval     Index of the bucket.
+  */
+static uint32_t KNX_Histogram_Bucket(uint32_t value)
+{
+  uint32_t msb, shift;
+
+  if(value < KNX_HISTOGRAM_LINEAR)
+  {
+    return value;
+  }
+
+  msb = KNX_Histogram_Msb(value);
+  shift = msb - KNX_HISTOGRAM_SUB_BITS;
+  return KNX_HISTOGRAM_LINEAR + (msb - KNX_HISTOGRAM_SUB_BITS - 1U) * KNX_HISTOGRAM_SUB
+         + ((value >> shift) - KNX_HISTOGRAM_SUB);
+}
+
+/**
+  * @brief      Highest value of a bucket.
+  * @param      bucket: index of the bucket.
+  * @retval     The value.
+  */
+static uint32_t KNX_Histogram_Highest(uint32_t bucket)
+{
+  uint32_t shift, low;
+
+  if(bucket < KNX_HISTOGRAM_LINEAR)
+  {
+    return bucket;
+  }
+
+  bucket -= KNX_HISTOGRAM_LINEAR;
+  shift = bucket / KNX_HISTOGRAM_SUB + 1U;
+  low = (KNX_HISTOGRAM_SUB + bucket % KNX_HISTOGRAM_SUB) << shift;
+  return low + ((1UL << shift) - 1U);
+}
+
+/**
+  * @brief      Position of the highest bit set.
+  * @param      value: the value, not 0.
+  * @retval     The position, 0 for the LSB.
+  */
+static uint32_t KNX_Histogram_Msb(uint32_t value)
+{
+#if defined(__GNUC__)
+  return 31U - (uint32_t)__builtin_clz(value);
+#else
+  uint32_t msb = 0;
+
+  while(value >>= 1)
+  {
+    msb++;
+  }
+  return msb;
+#endif
+}
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
@@ -0,0 +1,378 @@
+/**
+  ******************************************************************************
+  * @file       KNX_Log.c
+  * @author     MA Dingjie
+  * @version    V1.0.0
+  * @date       17-October-2016
+  * @brief      KNX debug messages with deferred formatting.
+  *             This file provides functions to manage following functionalities:
+  *              + Logging, from the tasks and the interrupts
+  *              + Encoding of the records for the debug UART
+  *              + Decoding and formatting on the host
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <string.h>
+#ifdef KNX_HOST
+#include <stdio.h>
+#endif
+#include "KNX_Log.h"
+#include "KNX_Aux.h"
+#include "cola.h"
+#include "debug.h"
+
+/** @addtogroup KNX_Lib
+  * @{
+  */
+
+/** @defgroup KNX_Log KNX Log
+  * @brief    The debug messages as an identifier, the time in us and a few
+  *           octets of arguments. Logging is a copy of some octets to
+  *           ::colaDebug, without any formatting, so it can be done from the
+  *           UART interrupts. The text is built only on the host from the
+  *           formats of ::KNX_LOG_MESSAGES, they are not in the firmware.
+  * @{
+  */
+
+/* Private constants ---------------------------------------------------------*/
+/** @defgroup KNX_Log_Private_Constants KNX Log Private Constants
+  * @{
+  */
+/** \brief Number of octets of arguments of each message. */
+static const uint8_t KNX_LOG_ARGS[KNX_LOG_COUNT] =
+{
+#define KNX_LOG_NARGS(id, args, format) args,
+  KNX_LOG_MESSAGES(KNX_LOG_NARGS)
+#undef KNX_LOG_NARGS
+};
+
+#ifdef KNX_HOST
+/** \brief Format of each message. */
+static const char * const KNX_LOG_FORMATS[KNX_LOG_COUNT] =
+{
+#define KNX_LOG_FORMAT(id, args, format) format,
+  KNX_LOG_MESSAGES(KNX_LOG_FORMAT)
+#undef KNX_LOG_FORMAT
+};
+#endif
+/**
+  * @}
+  */
+
+/* Private function prototypes -----------------------------------------------*/
+static uint8_t KNX_Log_Stuff(const uint8_t *payload, uint8_t length, uint8_t *wire);
+#ifdef KNX_HOST
+static uint8_t KNX_Log_Unstuff(const uint8_t *wire, uint16_t length, uint8_t *payload);
+#endif
+
+/* Exported functions --------------------------------------------------------*/
+/** @defgroup KNX_Log_Exported_Functions KNX Log Exported Functions
+  * @{
+  */
+
+/** @defgroup KNX_Log_Exported_Functions_Group1 Log Functions
+  * @{
+  */
+
+/**
+  * @brief      Log a message with at most one octet of argument.
+  * @param      id: the message.
+  * @param      arg: the argument, ignored if the message has none.
+  * @retval     ::LOG_OK, ::LOG_FULL, or ::LOG_UNKNOWN.
+  */
+uint8_t KNX_Log(KNX_Log_Id_t id, uint8_t arg)
+{
+  return KNX_Log_Write(id, &arg);
+}
+
+/**
+  * @brief      Log a message: store its identifier, the time and its
+  *             arguments in ::colaDebug. Can be called from an interrupt.
+  * @param      id: the message.
+  * @param      args: the octets of arguments of the message.
+  * @retval     ::LOG_OK, ::LOG_FULL, or ::LOG_UNKNOWN.
+  */
+uint8_t KNX_Log_Write(KNX_Log_Id_t id, const uint8_t *args)
+{
+  uint8_t record[KNX_LOG_RECORD_MAX];
+  uint32_t timestamp;
+  uint8_t nargs;
+
+  if((uint32_t)id >= (uint32_t)KNX_LOG_COUNT)
+  {
+    return LOG_UNKNOWN;
+  }
+
+  nargs = KNX_LOG_ARGS[id];
+  timestamp = KNX_GetMicros();
+  record[0] = (uint8_t)id;
+  record[1] = (uint8_t)timestamp;
+  record[2] = (uint8_t)(timestamp >> 8);
+  record[3] = (uint8_t)(timestamp >> 16);
+  record[4] = (uint8_t)(timestamp >> 24);
+  memcpy(&record[5], args, nargs);
+
+  if(cola_guardar_datos(&colaDebug, record, (uint16_t)(5U + nargs)) == 0)
+  {
+    return LOG_FULL;
+  }
+
+  return LOG_OK;
+}
+/**
+  * @}
+  */
+
+/** @defgroup KNX_Log_Exported_Functions_Group2 Stream Functions
+  * @{
+  */
+
+/**
+  * @brief      Start a stream, on the target before the first record is sent
+  *             and on the host before the first one is decoded.
+  * @param      stream: pointer to the stream.
+  */
+void KNX_Log_InitStream(KNX_Log_Stream_t *stream)
+{
+  stream->Last = 0;
+  stream->Time = 0;
+}
+
+/**
+  * @brief      Encode a record read from ::colaDebug for the debug UART. The
+  *             time becomes the difference with the previous record, signed
+  *             since an interrupt may store its record before the one of the
+  *             task it interrupted. The result is framed, it ends with
+  *             ::KNX_LOG_DELIMITER.
+  * @param      stream: pointer to the stream.
+  * @param      record: the record, as stored by ::KNX_Log_Write.
+  * @param      length: length of the record.
+  * @param      wire: buffer of ::KNX_LOG_WIRE_MAX octets for the result.
+  * @retval     Number of octets to send, 0 if the record is not valid.
+  */
+uint8_t KNX_Log_Encode(KNX_Log_Stream_t *stream, const uint8_t *record, uint16_t length, uint8_t *wire)
+{
+  uint8_t payload[KNX_LOG_PAYLOAD_MAX];
+  uint32_t timestamp, delta;
+  uint8_t nargs, n = 0;
+
+  if((length < 5U) || (record[0] >= (uint8_t)KNX_LOG_COUNT))
+  {
+    return 0;
+  }
+  nargs = KNX_LOG_ARGS[record[0]];
+  if(length != 5U + nargs)
+  {
+    return 0;
+  }
+
+  timestamp = (uint32_t)record[1] | ((uint32_t)record[2] << 8)
+            | ((uint32_t)record[3] << 16) | ((uint32_t)record[4] << 24);
+  delta = timestamp - stream->Last;
+  /** Zigzag: the sign in bit 0, so a small step back stays short. */
+  delta = (delta << 1) ^ (uint32_t)((int32_t)delta >> 31);
+  stream->Last = timestamp;
+
+  payload[n++] = record[0];
+  do
+  {
+    payload[n] = (uint8_t)(delta & 0x7FU);
+    delta >>= 7;
+    if(delta != 0U)
+    {
+      payload[n] |= 0x80U;
+    }
+    n++;
+  } while(delta != 0U);
+
+  memcpy(&payload[n], &record[5], nargs);
+
+  return KNX_Log_Stuff(payload, (uint8_t)(n + nargs), wire);
+}
+
+#ifdef KNX_HOST
+/**
+  * @brief      Decode the next record of the stream of the debug UART and
+  *             format it as a line of text, with the time since the start of
+  *             the stream in seconds. The octets up to the next
+  *             ::KNX_LOG_DELIMITER are a record; one which is not valid, cut
+  *             or run into another by octets lost on the line, gives a line
+  *             reporting it and the decoding goes on from the delimiter.
+  * @param      stream: pointer to the stream.
+  * @param      wire: the octets received.
+  * @param      length: number of octets received.
+  * @param      used: pointer to store the number of octets of the record and
+  *             its delimiter, 0 if the record is not complete yet.
+  * @param      text: buffer for the line.
+  * @param      size: size of \b text.
+  * @retval     Length of the line, 0 if there is none.
+  */
+uint16_t KNX_Log_Decode(KNX_Log_Stream_t *stream, const uint8_t *wire, uint16_t length, uint16_t *used, char *text, uint16_t size)
+{
+  uint8_t payload[KNX_LOG_PAYLOAD_MAX];
+  uint8_t args[KNX_LOG_ARGS_MAX] = {0};
+  uint32_t delta = 0;
+  uint16_t end, offset = 1;
+  uint8_t id, n, nargs, octet, shift = 0, i;
+  int res;
+
+  *used = 0;
+  for(end=0; (end < length) && (wire[end] != KNX_LOG_DELIMITER); end++)
+  {
+  }
+  if(end == length)
+  {
+    if(length >= KNX_LOG_WIRE_MAX)
+    {
+      /** No delimiter where one should be, skip up to the next one. */
+      *used = length;
+    }
+    return 0;
+  }
+  *used = (uint16_t)(end + 1U);
+  if(end == 0U)
+  {
+    /** Two delimiters in a row, nothing between. */
+    return 0;
+  }
+
+  n = KNX_Log_Unstuff(wire, end, payload);
+  id = (n != 0U) ? payload[0] : (uint8_t)KNX_LOG_COUNT;
+  if((n != 0U) && (id >= (uint8_t)KNX_LOG_COUNT))
+  {
+    res = snprintf(text, size, "[Log]Unknown message %02X\r\n", (unsigned int)id);
+    return (res < 0) ? 0U : (uint16_t)((res < (int)size) ? res : (int)size - 1);
+  }
+
+  /** The time, then exactly the arguments of the message. */
+  octet = 0x80U;
+  for(i=0; (i < 5U) && (offset < n) && ((octet & 0x80U) != 0U); i++)
+  {
+    octet = payload[offset];
+    offset++;
+    delta |= (uint32_t)(octet & 0x7FU) << shift;
+    shift += 7U;
+  }
+  nargs = (n != 0U) ? KNX_LOG_ARGS[id] : 0U;
+  if((n == 0U) || ((octet & 0x80U) != 0U) || (offset + nargs != n))
+  {
+    res = snprintf(text, size, "[Log]Bad record of %u octets\r\n", (unsigned int)end);
+    return (res < 0) ? 0U : (uint16_t)((res < (int)size) ? res : (int)size - 1);
+  }
+  memcpy(args, &payload[offset], nargs);
+
+  stream->Time += (uint64_t)(int64_t)(int32_t)((delta >> 1) ^ (0U - (delta & 1U)));
+
+  res = snprintf(text, size, "[%lu.%06lu] ", (unsigned long)(stream->Time / 1000000U),
+                 (unsigned long)(stream->Time % 1000000U));
+  if((res >= 0) && (res < (int)size))
+  {
+    i = (uint8_t)res;
+    res = snprintf(&text[i], size - i, KNX_LOG_FORMATS[id],
+                   (unsigned int)args[0], (unsigned int)args[1],
+                   (unsigned int)args[2], (unsigned int)args[3]);
+    res = (res < 0) ? (int)i : (int)i + res;
+  }
+  if((res >= 0) && (res < (int)size))
+  {
+    res += snprintf(&text[res], size - (uint16_t)res, "\r\n");
+  }
+
+  return (res < 0) ? 0U : (uint16_t)((res < (int)size) ? res : (int)size - 1);
+}
+#endif
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/* Private functions ---------------------------------------------------------*/
+/** @defgroup KNX_Log_Private_Functions KNX Log Private Functions
+  * @{
+  */
+
+/**
+  * @brief      Frame a record with COBS: each run of octets other than
+  *             ::KNX_LOG_DELIMITER is preceded by its length plus one, the
+  *             delimiters of the record are dropped, and the frame ends with
+  *             the delimiter.
+  * @param      payload: the record.
+  * @param      length: length of the record, below 254.
+  * @param      wire: buffer of \b length + 2 octets for the frame.
+  * @retval     Length of the frame.
+  */
+static uint8_t KNX_Log_Stuff(const uint8_t *payload, uint8_t length, uint8_t *wire)
+{
+  uint8_t code = 0, n = 1, i;
+
+  for(i=0; i<length; i++)
+  {
+    if(payload[i] == KNX_LOG_DELIMITER)
+    {
+      wire[code] = (uint8_t)(n - code);
+      code = n++;
+    }
+    else
+    {
+      wire[n++] = payload[i];
+    }
+  }
+  wire[code] = (uint8_t)(n - code);
+  wire[n++] = KNX_LOG_DELIMITER;
+
+  return n;
+}
+
+#ifdef KNX_HOST
+/**
+  * @brief      Undo the framing of ::KNX_Log_Stuff.
+  * @param      wire: the frame, without its delimiter.
+  * @param      length: length of the frame.
+  * @param      payload: buffer of ::KNX_LOG_PAYLOAD_MAX octets for the record.
+  * @retval     Length of the record, 0 if the frame is not valid.
+  */
+static uint8_t KNX_Log_Unstuff(const uint8_t *wire, uint16_t length, uint8_t *payload)
+{
+  uint16_t offset = 0, next;
+  uint8_t n = 0;
+
+  if(length > KNX_LOG_PAYLOAD_MAX + 1U)
+  {
+    return 0;
+  }
+  while(offset < length)
+  {
+    next = (uint16_t)(offset + wire[offset]);
+    if((wire[offset] == 0U) || (next > length))
+    {
+      return 0;
+    }
+    for(offset++; offset<next; offset++)
+    {
+      payload[n++] = wire[offset];
+    }
+    if(next < length)
+    {
+      payload[n++] = KNX_LOG_DELIMITER;
+    }
+  }
+
+  return n;
+}
+#endif
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
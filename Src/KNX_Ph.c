@@ -15,9 +15,19 @@
     
 /* Includes ------------------------------------------------------------------*/
 #include <stdio.h>
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
 #include "KNX_Ph.h"
 #include "KNX_Aux.h"
 #include "KNX_Ph_TPUart.h"
+#include "KNX_Ph_Buffer.h"
+#include "KNX_Ph_Capture.h"
+#include "KNX_Ph_Trace.h"
+#include "KNX_Frame.h"
+#include "KNX_Addr.h"
+#include "KNX_Log.h"
 #include "KNX_def.h"
 #include "cola.h"
 #include "debug.h"
@@ -39,34 +49,10 @@
 /** @defgroup KNX_PH_Sup_Private_Variables KNX_Ph_Sup Private Variables
   * @{
   */
-/** \brief Current state of KNX physical layer. */
-static PH_Status_t KNX_PH_STATE;
-/** \brief State Debug message sent in \ref Cola_Debug. */
-static unsigned char KNX_PH_STATE_DEBUGMSG[] = "[KNX PH]KNX_PH_STATE changed to XX.\r\n";
-/** \brief ::KNX_PH_STATE_DEBUGMSG digits indice. */
-#define KNX_PH_STATE_DEBUGMSG_INDICE ((uint8_t)32)
-/** \brief Sending Debug message sent in \ref Cola_Debug. */
-static unsigned char KNX_PH_SEND_DEBUGMSG[] = "[KNX PH]Data sent: XX\r\n";
-/** \brief ::KNX_PH_SEND_DEBUGMSG digits indice. */
-#define KNX_PH_SEND_DEBUGMSG_INDICE ((uint8_t)19)
-/** \brief Receiving Debug message sent in \ref Cola_Debug. */
-static unsigned char KNX_PH_RECEIVE_DEBUGMSG[] = "[KNX PH]Data received: XX\r\n";
-/** \brief ::KNX_PH_RECEIVE_DEBUGMSG digits indice. */
-#define KNX_PH_RECEIVE_DEBUGMSG_INDICE ((uint8_t)23)
-/** \brief Error Debug message sent in \ref Cola_Debug. */
-static unsigned char KNX_PH_ERROR_DEBUGMSG[] = "[KNX PH]Error code: XX\r\n";
-/** \brief ::KNX_PH_ERROR_DEBUGMSG digits indice. */
-#define KNX_PH_ERROR_DEBUGMSG_INDICE ((uint8_t)20)
-
-/** \brief flag for TPUART TX. */
-static uint8_t TPUART_TX_FLAG;
-/** \brief flag for TPUART RX. */
-static uint8_t TPUART_RX_FLAG;
-/** character received from UART */
-static unsigned char temp;
-
-/** \brief The current tick of timer. */
-TickType_t currentTick;
+/** \brief Mask applied to the indices of ::PH_Handle_t::FrameQueue. */
+#define KNX_PH_FRAME_QUEUE_MASK (KNX_PH_FRAME_QUEUE_SIZE - 1U)
+/** \brief Compilation fails if ::KNX_PH_FRAME_QUEUE_SIZE is not a power of 2. */
+typedef char KNX_Ph_FrameQueue_SizeCheck[((KNX_PH_FRAME_QUEUE_SIZE & KNX_PH_FRAME_QUEUE_MASK) == 0U) ? 1 : -1];
 
 /** \brief Cola defined in \ref Debug */
 t_cola colaDebug;
@@ -74,6 +60,29 @@ t_cola colaDebug;
   * @}
   */
 
+/* Private function prototypes -----------------------------------------------*/
+/** @defgroup KNX_PH_Sup_Private_Functions KNX_Ph_Sup Private Functions
+  * @{
+  */
+static void     KNX_Ph_SetState(PH_Handle_t *hph, PH_Status_t state);
+static void     KNX_Ph_DebugMessage(uint8_t data, DEBUG_Type_t type);
+static void     KNX_Ph_AssembleByte(PH_Handle_t *hph, uint8_t data, uint32_t timestamp);
+static void     KNX_Ph_InjectDatas(PH_Handle_t *hph, const uint8_t *datas, uint8_t length);
+static void     KNX_Ph_DropFrame(PH_Handle_t *hph);
+static void     KNX_Ph_CompleteFrame(PH_Handle_t *hph, KNX_Frame_t *frame);
+static void     KNX_Ph_PushFrame(PH_Handle_t *hph, KNX_Frame_t *frame);
+static void     KNX_Ph_CaptureDatas(PH_Handle_t *hph, uint32_t timestamp, uint8_t flags, const uint8_t *datas, uint16_t length);
+static void     KNX_Ph_Acknowledge(PH_Handle_t *hph, KNX_Frame_t *frame);
+static void     KNX_Ph_AckSent(PH_Handle_t *hph);
+static uint8_t  KNX_Ph_WaitTxDone(PH_Handle_t *hph, const KNX_Deadline_t *deadline);
+static uint8_t  KNX_Ph_Transmit(PH_Handle_t *hph, uint8_t *datas, uint16_t size);
+static uint8_t  KNX_Ph_SendDatas(PH_Handle_t *hph, uint8_t *datas, uint16_t size, uint32_t timeout);
+static uint16_t KNX_Ph_EncodeFrame(const uint8_t *frame, uint16_t length, uint8_t *stream);
+static void     KNX_Ph_FlushChannel(PH_Handle_t *hph, PH_Channel_t channel);
+/**
+  * @}
+  */
+
 /* External functions --------------------------------------------------------*/
 /** @defgroup   KNX_PH_Sup_External_Functions KNX PH External UART ISR Functions
   * @brief      External functions from \ref KNX_PH_TPUart module
@@ -81,50 +90,81 @@ t_cola colaDebug;
   */
 
 /**
-  * @brief      At the begin of interrupt.
+  * @brief      At the begin of interrupt, set ::PH_Handle_t::xHigherPriorityTaskWoken to pdFalse.
+  * @param      hph: PH handle of the line.
   */
-void knx_uart_isr_begin (void)
+void knx_uart_isr_begin (PH_Handle_t *hph)
 {
+  hph->IsrCycles = KNX_GetCycles();
+  hph->xHigherPriorityTaskWoken = pdFALSE;
 }
 
 /**
-  * @brief      At the end of interrupt.
+  * @brief      At the end of interrupt, yield from the UART interrupt.
+  * @param      hph: PH handle of the line.
   */
-void knx_uart_isr_end (void)
+void knx_uart_isr_end (PH_Handle_t *hph)
 {
+  uint32_t cycles = KNX_GetCycles() - hph->IsrCycles;
+  
+  if(cycles > hph->Stats.IsrCyclesMax)
+  {
+    hph->Stats.IsrCyclesMax = cycles;
+  }
+  portYIELD_FROM_ISR(hph->xHigherPriorityTaskWoken);
 }
 
 /**
-* @brief      TX mode.
+  * @brief      TX mode. An ack delayed by a transfer goes first. Then if a
+  *             task is waiting and the transfer is over, give
+  *             ::PH_Handle_t::TxSemaphore to wake it up.
+  * @param      hph: PH handle of the line.
   */
-void knx_uart_isr_tx(void)
+void knx_uart_isr_tx(PH_Handle_t *hph)
 {
-  if(TPUART_TX_FLAG == TRUE)
+  if(hph->AckPending == TRUE
+     && KNX_Ph_Transmit(hph, &hph->AckByte, 1) == TPUart_OK)
   {
-    
+    hph->AckPending = FALSE;
+    KNX_Ph_AckSent(hph);
+  }
+  
+  if(hph->TxFlag == TRUE && KNX_PH_TPUart_GetTxState(&hph->TPUart) == TPUart_OK)
+  {
+    hph->TxFlag = FALSE;
+    xSemaphoreGiveFromISR(hph->TxSemaphore, &hph->xHigherPriorityTaskWoken);
   }
 }
 
 /**
-  * @brief      RX mode
+  * @brief      RX mode. Hand every byte received to the frame assembly. With
+  *             the interrupt backend ::PH_Handle_t::RxByte holds the byte once the previous
+  *             reception is completed and the call arms the next one; with
+  *             the DMA backend each call copies the next byte received.
+  * @param      hph: PH handle of the line.
   */
-void knx_uart_isr_rx(void)
+void knx_uart_isr_rx(PH_Handle_t *hph)
 {
-  if(KNX_PH_TPUart_Receive(&temp, 1) == TPUart_OK)
-  {      
-    TPUART_RX_FLAG = TRUE;
+  while(KNX_PH_TPUart_Receive(&hph->TPUart, &hph->RxByte, 1) == TPUart_OK)
+  {
+    hph->RxTimestamp = KNX_PH_TPUart_GetRxTime(&hph->TPUart);
+    if(hph->Trace != NULL)
+    {
+      KNX_Ph_Trace_Record(hph->Trace, 0, hph->RxTimestamp, &hph->RxByte, 1);
+    }
+    KNX_Ph_AssembleByte(hph, hph->RxByte, hph->RxTimestamp);
   }
 }
-/**
-  * @}
-  */
 
-/* Private function prototypes -----------------------------------------------*/
-/** @defgroup KNX_PH_Sup_Private_Functions KNX_Ph_Sup Private Functions
-  * @{
+/**
+  * @brief      Idle line, given by the backends able to detect it: the frame
+  *             not completed so far will never be, drop it.
+  * @param      hph: PH handle of the line.
   */
-static void     KNX_Ph_SetState(PH_Status_t state);
-static void     KNX_Ph_DebugMessage(uint8_t data, DEBUG_Type_t type);
+void knx_uart_isr_idle(PH_Handle_t *hph)
+{
+  KNX_Ph_DropFrame(hph);
+}
 /**
   * @}
   */
@@ -139,29 +179,75 @@ static void     KNX_Ph_DebugMessage(uint8_t data, DEBUG_Type_t type);
   */
 
 /**
-  * @brief      Initialize the \ref KNX_PH module.
+  * @brief      Initialize the \ref KNX_PH module for a line. Several lines
+  *             run side by side, each with its own handle.
+  * @param      hph: PH handle of the line, ::PH_Handle_t::TPUart set by the
+  *             user and the rest zeroed before the first call.
   * @retval     Error code, See \ref PH_Error_Code.
   */
 
-uint8_t KNX_Ph_Init(void)
-{    
+uint8_t KNX_Ph_Init(PH_Handle_t *hph)
+{
+  uint8_t i;
+  
   /** Set state to ::PH_NOINIT */
-  KNX_Ph_SetState(PH_NOINIT);
+  KNX_Ph_SetState(hph, PH_NOINIT);
+  
+  /** Initialize the timer and the cycle counter, shared by all the lines. */
+  KNX_InitCycles();
+  if(KNX_GetTimerState() != TIMER_RUNNING)
+  {
+    KNX_InitTimer();
+    KNX_StartTimer();
+  }
   
-  /** Initialize the timer. */
-  KNX_InitTimer();
-  KNX_StartTimer();
+  /** The frame pool is shared by all the lines, only set up once. */
+  KNX_Frame_Init();
+  hph->TPUart.Parent = hph;
 
   /** Initialize TPUart. */
-  if(KNX_PH_TPUart_init() == TPUart_ERROR)
+  if(KNX_PH_TPUart_init(&hph->TPUart) == TPUart_ERROR)
   {
     KNX_Ph_DebugMessage(PH_ERROR_INIT, ERROR_DEBUG);
     
     /** \b If TPUart initialization failed, return ::PH_ERROR_INIT */
     return PH_ERROR_INIT;
   }
-  TPUART_RX_FLAG = FALSE;
-  TPUART_TX_FLAG = FALSE;
+  hph->TxFlag = FALSE;
+  
+  /** Create the semaphores the tasks sleep on. */
+  if(hph->TxSemaphore == NULL)
+  {
+    hph->TxSemaphore = xSemaphoreCreateBinary();
+    hph->TxMutex = xSemaphoreCreateMutex();
+    hph->FrameSemaphore = xSemaphoreCreateBinary();
+    for(i=0; i<PH_CHANNEL_NB; i++)
+    {
+      hph->RxChannels[i].Semaphore = xSemaphoreCreateBinary();
+    }
+  }
+  
+  for(i=0; i<PH_CHANNEL_NB; i++)
+  {
+    KNX_Ph_Buffer_Init(&hph->RxChannels[i].Buffer);
+  }
+  
+  /** Give back to the pool the frames left by a previous initialization. */
+  KNX_Frame_Release(hph->Assembler.Frame);
+  while(hph->FrameTail != hph->FrameHead)
+  {
+    KNX_Frame_Release(hph->FrameQueue[hph->FrameTail & KNX_PH_FRAME_QUEUE_MASK]);
+    hph->FrameTail++;
+  }
+  memset(&hph->Assembler, 0, sizeof(hph->Assembler));
+  memset(&hph->Stats, 0, sizeof(hph->Stats));
+  hph->AckPending = FALSE;
+  hph->TxPending = FALSE;
+  hph->FrameHead = 0;
+  hph->FrameTail = 0;
+  
+  /** Arm the first reception, the next ones are armed by ::knx_uart_isr_rx. */
+  KNX_PH_TPUart_Receive(&hph->TPUart, &hph->RxByte, 1);
   
   return PH_ERROR_NONE;
 }
@@ -175,24 +261,21 @@ uint8_t KNX_Ph_Init(void)
   */
 
 /**
-  * @brief      Send a data.
+  * @brief      Send a data. The calling task sleeps until the data has left
+  *             the UART.
+  * @param      hph: PH handle of the line.
   * @param      data: a \c uint8_t data.
   * @param      timeout: timeout duration.
   * @retval     Error code, See \ref PH_Error_Code.
   */
-uint8_t KNX_Ph_SendData(uint8_t data, uint32_t timeout)
-{  
-  /** Try to send the data */
-  currentTick = KNX_GetTick();
-  while(!KNX_CheckForTimeOut(&currentTick, &timeout))
+uint8_t KNX_Ph_SendData(PH_Handle_t *hph, uint8_t data, uint32_t timeout)
+{
+  if(KNX_Ph_SendDatas(hph, &data, 1, timeout) == PH_ERROR_NONE)
   {
-    if(KNX_PH_TPUart_Send(&data, 1) == TPUart_OK)
-    {
-      KNX_Ph_DebugMessage(data, SEND_DEBUG);
-      
-      /** \b If succeeded, return ::PH_ERROR_NONE. */
-      return PH_ERROR_NONE;
-    }
+    KNX_Ph_DebugMessage(data, SEND_DEBUG);
+    
+    /** \b If succeeded, return ::PH_ERROR_NONE. */
+    return PH_ERROR_NONE;
   }
   
   KNX_Ph_DebugMessage(PH_ERROR_TIMEOUT, ERROR_DEBUG);
@@ -203,26 +286,29 @@ uint8_t KNX_Ph_SendData(uint8_t data, uint32_t timeout)
 
 /**
   * @brief      Receive a data.
+  * @param      hph: PH handle of the line.
   * @param      data: a \c uint8_t data.
   * @param      timeout: timeout duration.
   * @retval     Error code, See \ref PH_Error_Code.
   */
-uint8_t KNX_Ph_RecData(uint8_t *data, uint32_t timeout)
-{        
+uint8_t KNX_Ph_RecData(PH_Handle_t *hph, uint8_t *data, uint32_t timeout)
+{
+  KNX_Deadline_t deadline;
+  
   /** Try to receive the data */
-  currentTick = KNX_GetTick();
-  while(!KNX_CheckForTimeOut(&currentTick, &timeout))
+  KNX_Deadline_Init(&deadline, timeout);
+  while((timeout = KNX_Deadline_Remaining(&deadline)) != 0U)
   {
-    if(TPUART_RX_FLAG == TRUE)
+    if(KNX_Ph_Buffer_Get(&hph->RxChannels[PH_CHANNEL_DATA].Buffer, data) == PH_BUFFER_OK)
     {
-      *data = temp;
       KNX_Ph_DebugMessage(*data, RECEIVE_DEBUG);
-      
-      TPUART_RX_FLAG = FALSE;
 
       /** \b If data received is the response expected. Return ::PH_ERROR_NONE. */
       return PH_ERROR_NONE;
     }
+    
+    /** Sleep until ::knx_uart_isr_rx stores a byte. */
+    xSemaphoreTake(hph->RxChannels[PH_CHANNEL_DATA].Semaphore, KNX_MS_TO_TICKS(timeout));
   }
   
   KNX_Ph_DebugMessage(PH_ERROR_TIMEOUT, ERROR_DEBUG);
@@ -232,29 +318,74 @@ uint8_t KNX_Ph_RecData(uint8_t *data, uint32_t timeout)
 }
 
 /**
-  * @brief      Wait for a response with timeout.
+  * @brief      Receive several datas at once. Wait until at least one byte is
+  *             available, then drain the receive buffer.
+  * @param      hph: PH handle of the line.
+  * @param      datas: buffer to store the datas.
+  * @param      length: in, the size of \b datas; out, number of bytes read.
+  * @param      timeout: timeout duration.
+  * @retval     Error code, See \ref PH_Error_Code.
+  */
+uint8_t KNX_Ph_RecDatas(PH_Handle_t *hph, uint8_t *datas, uint16_t *length, uint32_t timeout)
+{
+  uint16_t size = *length;
+  KNX_Deadline_t deadline;
+  
+  /** Try to receive the datas */
+  KNX_Deadline_Init(&deadline, timeout);
+  while((timeout = KNX_Deadline_Remaining(&deadline)) != 0U)
+  {
+    *length = KNX_Ph_Buffer_Read(&hph->RxChannels[PH_CHANNEL_DATA].Buffer, datas, size);
+    if(*length != 0U)
+    {
+      /** \b If datas received, return ::PH_ERROR_NONE. */
+      return PH_ERROR_NONE;
+    }
+    
+    /** Sleep until ::knx_uart_isr_rx stores a byte. */
+    xSemaphoreTake(hph->RxChannels[PH_CHANNEL_DATA].Semaphore, KNX_MS_TO_TICKS(timeout));
+  }
+  
+  KNX_Ph_DebugMessage(PH_ERROR_TIMEOUT, ERROR_DEBUG);
+
+  /** \b If timeout, return ::PH_ERROR_TIMEOUT. */
+  return PH_ERROR_TIMEOUT;
+}
+
+/**
+  * @brief      Wait for a response with timeout. Only the channel of the
+  *             response is read, see ::KNX_Ph_Classify.
+  * @param      hph: PH handle of the line.
   * @param      res: response got.
   * @param      timeout: timeout duration.
   * @retval     Error code, See \ref PH_Error_Code.
   */
-uint8_t KNX_Ph_WaitFor(uint8_t res, uint32_t timeout)
-{  
+uint8_t KNX_Ph_WaitFor(PH_Handle_t *hph, uint8_t res, uint32_t timeout)
+{
+  uint8_t data;
+  PH_RxChannel_t *channel = &hph->RxChannels[KNX_Ph_Classify(res)];
+  KNX_Deadline_t deadline;
+  
   /** Try to send the data */
-  currentTick = KNX_GetTick();
-  while(!KNX_CheckForTimeOut(&currentTick, &timeout))
+  KNX_Deadline_Init(&deadline, timeout);
+  while((timeout = KNX_Deadline_Remaining(&deadline)) != 0U)
   {
-    if(TPUART_RX_FLAG == TRUE)
+    if(KNX_Ph_Buffer_Get(&channel->Buffer, &data) == PH_BUFFER_OK)
     {
-      KNX_Ph_DebugMessage(temp, RECEIVE_DEBUG);
-      TPUART_RX_FLAG = FALSE;
+      KNX_Ph_DebugMessage(data, RECEIVE_DEBUG);
       
       /** \b If data received is the response expected. */
-      if(temp == res)
+      if(data == res)
       {
         /** Return ::PH_ERROR_NONE. */
         return PH_ERROR_NONE;
       }
     }
+    else
+    {
+      /** Sleep until ::knx_uart_isr_rx stores a byte in the channel. */
+      xSemaphoreTake(channel->Semaphore, KNX_MS_TO_TICKS(timeout));
+    }
   }
   
   KNX_Ph_DebugMessage(PH_ERROR_TIMEOUT, ERROR_DEBUG);
@@ -264,31 +395,41 @@ uint8_t KNX_Ph_WaitFor(uint8_t res, uint32_t timeout)
 }
 
 /**
-  * @brief      Wait for a type of response with mask and timeout.
+  * @brief      Wait for a type of response with mask and timeout. Only the
+  *             channel of the mask is read, see ::KNX_Ph_Classify.
+  * @param      hph: PH handle of the line.
   * @param      res: response got.
   * @param      resMask: mask of the response expected.
   * @param      timeout: timeout duration.
   * @retval     Error code, See \ref PH_Error_Code.
   */
-uint8_t KNX_Ph_WaitForWithMask(uint8_t *res, uint8_t resMask, uint32_t timeout)
-{  
+uint8_t KNX_Ph_WaitForWithMask(PH_Handle_t *hph, uint8_t *res, uint8_t resMask, uint32_t timeout)
+{
+  uint8_t data;
+  PH_RxChannel_t *channel = &hph->RxChannels[KNX_Ph_Classify(resMask)];
+  KNX_Deadline_t deadline;
+  
   /** Try to send the data */
-  currentTick = KNX_GetTick();
-  while(!KNX_CheckForTimeOut(&currentTick, &timeout))
+  KNX_Deadline_Init(&deadline, timeout);
+  while((timeout = KNX_Deadline_Remaining(&deadline)) != 0U)
   {
-    if(TPUART_RX_FLAG == TRUE)
+    if(KNX_Ph_Buffer_Get(&channel->Buffer, &data) == PH_BUFFER_OK)
     {
-      KNX_Ph_DebugMessage(temp, RECEIVE_DEBUG);
-      TPUART_RX_FLAG = FALSE;
+      KNX_Ph_DebugMessage(data, RECEIVE_DEBUG);
       
       /** \b If data received is the type of response expected. */
-      if((temp & resMask) == resMask)
+      if((data & resMask) == resMask)
       {
-        *res = temp;
+        *res = data;
         /** Return ::PH_ERROR_NONE. */
         return PH_ERROR_NONE;
       }
     }
+    else
+    {
+      /** Sleep until ::knx_uart_isr_rx stores a byte in the channel. */
+      xSemaphoreTake(channel->Semaphore, KNX_MS_TO_TICKS(timeout));
+    }
   }
   
   KNX_Ph_DebugMessage(PH_ERROR_TIMEOUT, ERROR_DEBUG);
@@ -296,6 +437,31 @@ uint8_t KNX_Ph_WaitForWithMask(uint8_t *res, uint8_t resMask, uint32_t timeout)
   /** \b If timeout, return ::PH_ERROR_TIMEOUT. */
   return PH_ERROR_RESPONSE;
 }
+
+/**
+  * @brief      Channel of a byte received outside a frame.
+  * @param      data: the byte, or a response or mask to wait for.
+  * @retval     The channel, see ::PH_Channel_t.
+  */
+PH_Channel_t KNX_Ph_Classify(uint8_t data)
+{
+  if(data == Reset_indication)
+  {
+    return PH_CHANNEL_RESET;
+  }
+  else if((data & State_indication_mask) == State_indication)
+  {
+    return PH_CHANNEL_STATE;
+  }
+  else if((data & L_Data_confirm_filter) == L_Data_confirm_failed)
+  {
+    return PH_CHANNEL_CONFIRM;
+  }
+  else
+  {
+    return PH_CHANNEL_DATA;
+  }
+}
 /**
   * @}
   */
@@ -307,20 +473,25 @@ uint8_t KNX_Ph_WaitForWithMask(uint8_t *res, uint8_t resMask, uint32_t timeout)
 /**
   * @brief      Request to reset the \ref KNX_PH module and waiting for the
   *             ::Reset_indication.
+  * @param      hph: PH handle of the line.
   * @retval     Error code, See \ref PH_Error_Code.
   */
-uint8_t KNX_Ph_Reset(void)
+uint8_t KNX_Ph_Reset(PH_Handle_t *hph)
 {
   uint8_t ret;
   uint32_t timeout = 6;
   
   /** Send ::Ph_Reset request. */
-  if(KNX_Ph_GetState() != PH_RESET)
+  if(KNX_Ph_GetState(hph) != PH_RESET)
   {
-    KNX_Ph_SetState(PH_RESET);
+    KNX_Ph_SetState(hph, PH_RESET);
   }
   
-  ret = KNX_Ph_SendData(U_Reset_request, KNX_DEFAULT_TIMEOUT);
+  /** The reset also ends the CRC mode of the TP-UART. */
+  hph->CrcMode = FALSE;
+  hph->TxPending = FALSE;
+  KNX_Ph_FlushChannel(hph, PH_CHANNEL_RESET);
+  ret = KNX_Ph_SendData(hph, U_Reset_request, KNX_DEFAULT_TIMEOUT);
   if(ret != PH_ERROR_NONE)
   {
     /** \b If encounter a problem, return ::PH_ERROR_REQUEST  */
@@ -328,11 +499,11 @@ uint8_t KNX_Ph_Reset(void)
   }
   
   /** Waiting for the ::Reset_indication. */
-  ret = KNX_Ph_WaitFor(Reset_indication, KNX_DEFAULT_TIMEOUT);
+  ret = KNX_Ph_WaitFor(hph, Reset_indication, KNX_DEFAULT_TIMEOUT);
   if(ret == PH_ERROR_NONE)
   {
     /** \b If receive the response, set state to ::PH_NORMAL. */
-    KNX_Ph_SetState(PH_NORMAL);
+    KNX_Ph_SetState(hph, PH_NORMAL);
 
     /** Return ::PH_ERROR_NONE. */
     return PH_ERROR_NONE;
@@ -347,15 +518,17 @@ uint8_t KNX_Ph_Reset(void)
 /**
   * @brief      Requests the internal communication state from the TP-UART-IC
   *             and waiting for the ::State_indication.
+  * @param      hph: PH handle of the line.
   * @param      res: response received.
   * @retval     Error code, See \ref PH_Error_Code.
   */
-uint8_t KNX_Ph_State(uint8_t *res)
+uint8_t KNX_Ph_State(PH_Handle_t *hph, uint8_t *res)
 {
   uint8_t ret;
   
   /** Send ::Ph_Reset request. */
-  ret = KNX_Ph_SendData(U_State_request, KNX_DEFAULT_TIMEOUT);
+  KNX_Ph_FlushChannel(hph, PH_CHANNEL_STATE);
+  ret = KNX_Ph_SendData(hph, U_State_request, KNX_DEFAULT_TIMEOUT);
   if(ret != PH_ERROR_NONE)
   {
     /** \b If encounter a problem, return ::PH_ERROR_REQUEST  */
@@ -363,7 +536,7 @@ uint8_t KNX_Ph_State(uint8_t *res)
   }
     
   /** Waiting for the ::State_indication. */
-  ret = KNX_Ph_WaitForWithMask(res, State_indication_mask, KNX_DEFAULT_TIMEOUT);
+  ret = KNX_Ph_WaitForWithMask(hph, res, State_indication_mask, KNX_DEFAULT_TIMEOUT);
   if(ret == PH_ERROR_NONE)
   {
     /** Return ::PH_ERROR_STATE. */
@@ -379,62 +552,144 @@ uint8_t KNX_Ph_State(uint8_t *res)
 }
 
 /**
-  * @brief      Send datas.
-  * @param      frame: frame to be sent.
-  * @param      length: number of octets in frame.
+  * @brief      Put the TP-UART in bus monitor mode: every frame and every
+  *             character of the bus is stored in \b capture with the time of
+  *             its first octet, nothing is acknowledged nor sent. Leave the
+  *             mode with ::KNX_Ph_Reset.
+  * @param      hph: PH handle of the line, in ::PH_NORMAL.
+  * @param      capture: ring to fill, read with ::KNX_Ph_Monitor_rec.
   * @retval     Error code, See \ref PH_Error_Code.
   */
-uint8_t KNX_Ph_Data_req(uint8_t *frame, uint16_t length)
+uint8_t KNX_Ph_ActivateBusmon(PH_Handle_t *hph, KNX_Ph_Capture_t *capture)
 {
-  uint8_t res;
-  uint16_t i;
+  if(KNX_Ph_GetState(hph) != PH_NORMAL || capture == NULL)
+  {
+    /** \b If the line is not in normal mode, return ::PH_ERROR_STATE  */
+    return PH_ERROR_STATE;
+  }
   
-  /** Send U_L_DataStart byte and CTRL byte. */
-  if(KNX_Ph_SendData(U_L_DataStart, KNX_DEFAULT_TIMEOUT) != PH_ERROR_NONE)
+  /** Capture from the first character the TP-UART forwards. */
+  KNX_Ph_Capture_Init(capture);
+  hph->Capture = capture;
+  KNX_Ph_SetState(hph, PH_MONITOR);
+  
+  if(KNX_Ph_SendData(hph, U_ActivateBusmon, KNX_DEFAULT_TIMEOUT) != PH_ERROR_NONE)
   {
+    KNX_Ph_SetState(hph, PH_NORMAL);
+    
     /** \b If encounter a problem, return ::PH_ERROR_REQUEST  */
     return PH_ERROR_REQUEST;
   }
   
-  if(KNX_Ph_SendData(frame[0], KNX_DEFAULT_TIMEOUT) != PH_ERROR_NONE)
+  return PH_ERROR_NONE;
+}
+
+/**
+  * @brief      Let the TP-UART answer busy to the frames addressed to the
+  *             device. It leaves the busy mode by itself after 700 ms, send
+  *             it again to stay.
+  * @param      hph: PH handle of the line.
+  * @retval     Error code, See \ref PH_Error_Code.
+  */
+uint8_t KNX_Ph_ActivateBusyMode(PH_Handle_t *hph)
+{
+  if(KNX_Ph_SendData(hph, U_ActivateBusyMode, KNX_DEFAULT_TIMEOUT) != PH_ERROR_NONE)
   {
-    /** \b If encounter a problem, return ::PH_ERROR_TIMEOUT  */
-    return PH_ERROR_TIMEOUT;
+    /** \b If encounter a problem, return ::PH_ERROR_REQUEST  */
+    return PH_ERROR_REQUEST;
   }
   
-  /** Send frame. */
-  for(i=1; i<length-1; i++)
+  return PH_ERROR_NONE;
+}
+
+/**
+  * @brief      Let the TP-UART acknowledge again the frames addressed to
+  *             the device.
+  * @param      hph: PH handle of the line.
+  * @retval     Error code, See \ref PH_Error_Code.
+  */
+uint8_t KNX_Ph_ResetBusyMode(PH_Handle_t *hph)
+{
+  if(KNX_Ph_SendData(hph, U_ResetBusyMode, KNX_DEFAULT_TIMEOUT) != PH_ERROR_NONE)
   {
-    /** Send U_L_DataContinue byte and the frame. */
-    if(KNX_Ph_SendData((U_L_DataContinue | i), KNX_DEFAULT_TIMEOUT) != PH_ERROR_NONE)
-    {
-      /** \b If encounter a problem, return ::PH_ERROR_TIMEOUT  */
-      return PH_ERROR_TIMEOUT;
-    }
-    
-    if(KNX_Ph_SendData(frame[i], KNX_DEFAULT_TIMEOUT) != PH_ERROR_NONE)
-    {
-      /** \b If encounter a problem, return ::PH_ERROR_TIMEOUT  */
-      return PH_ERROR_TIMEOUT;
-    }
+    /** \b If encounter a problem, return ::PH_ERROR_REQUEST  */
+    return PH_ERROR_REQUEST;
   }
   
-  /** Send U_L_DataEnd byte and CheckSum. */
-  if(KNX_Ph_SendData((U_L_DataEnd | (uint8_t)length), KNX_DEFAULT_TIMEOUT) != PH_ERROR_NONE)
+  return PH_ERROR_NONE;
+}
+
+/**
+  * @brief      Protect the frames received with a CRC-16-CCITT: the TP-UART
+  *             follows each frame with its CRC, high octet first, checked
+  *             by the RX interrupt as the octets arrive. A frame whose CRC
+  *             does not match is dropped. It lasts until ::KNX_Ph_Reset.
+  * @param      hph: PH handle of the line.
+  * @retval     Error code, See \ref PH_Error_Code.
+  */
+uint8_t KNX_Ph_ActivateCRC(PH_Handle_t *hph)
+{
+  if(KNX_Ph_SendData(hph, U_ActivateCRC, KNX_DEFAULT_TIMEOUT) != PH_ERROR_NONE)
   {
-    /** \b If encounter a problem, return ::PH_ERROR_TIMEOUT  */
-    return PH_ERROR_TIMEOUT;
+    /** \b If encounter a problem, return ::PH_ERROR_REQUEST  */
+    return PH_ERROR_REQUEST;
+  }
+  
+  hph->CrcMode = TRUE;
+  return PH_ERROR_NONE;
+}
+
+/**
+  * @brief      Send datas. A frame whose confirm timed out is still pending
+  *             in the TP-UART, its confirm is waited for first.
+  * @param      hph: PH handle of the line.
+  * @param      frame: frame to be sent.
+  * @param      length: number of octets in frame.
+  * @retval     Error code, See \ref PH_Error_Code.
+  */
+uint8_t KNX_Ph_Data_req(PH_Handle_t *hph, uint8_t *frame, uint16_t length)
+{
+  uint8_t res;
+  uint8_t stream[2 * FRAME_SIZE];
+  uint16_t size;
+  
+  if((frame == NULL) || (length < 2U) || (length > FRAME_SIZE))
+  {
+    /** \b If the frame can't be encoded, return ::PH_ERROR_REQUEST  */
+    return PH_ERROR_REQUEST;
+  }
+  
+  /** The TP-UART takes one frame at a time: the confirm of the frame sent
+      before must be consumed first, else it would be taken for the confirm
+      of this one. */
+  if(hph->TxPending == TRUE)
+  {
+    if(KNX_Ph_WaitForWithMask(hph, &res, L_Data_confirm_mask, KNX_PH_CONFIRM_TIMEOUT) != PH_ERROR_NONE)
+    {
+      /** \b If it never comes, the reset drops the frame of the TP-UART. */
+      if(KNX_Ph_Reset(hph) != PH_ERROR_NONE)
+      {
+        return PH_ERROR_TIMEOUT;
+      }
+    }
+    hph->TxPending = FALSE;
   }
   
-  if(KNX_Ph_SendData(frame[length-1], KNX_DEFAULT_TIMEOUT) != PH_ERROR_NONE)
+  /** Encode the whole service stream then send it in a single transfer. */
+  size = KNX_Ph_EncodeFrame(frame, length, stream);
+  KNX_Ph_FlushChannel(hph, PH_CHANNEL_CONFIRM);
+  if(KNX_Ph_SendDatas(hph, stream, size, KNX_DEFAULT_TIMEOUT) != PH_ERROR_NONE)
   {
     /** \b If encounter a problem, return ::PH_ERROR_TIMEOUT  */
     return PH_ERROR_TIMEOUT;
   }
+  hph->TxPending = TRUE;
   
-  /** Waiting for the ::L_Data_confirm_success. */
-  if(KNX_Ph_WaitForWithMask(&res, L_Data_confirm_mask, KNX_DEFAULT_TIMEOUT) == PH_ERROR_NONE)
+  /** Waiting for the ::L_Data_confirm_success, the frame stays pending on
+      a timeout. */
+  if(KNX_Ph_WaitForWithMask(hph, &res, L_Data_confirm_mask, KNX_PH_CONFIRM_TIMEOUT) == PH_ERROR_NONE)
   {
+    hph->TxPending = FALSE;
     if(res == L_Data_confirm_success)
     {
       /** Return ::PH_ERROR_NONE. */
@@ -454,26 +709,158 @@ uint8_t KNX_Ph_Data_req(uint8_t *frame, uint16_t length)
 }
 
 /**
-  * @brief      Receive datas.
-  * @param      frame: frame received.
+  * @brief      Receive a frame into a buffer of the caller. Same as
+  *             ::KNX_Ph_Frame_rec, with a copy.
+  * @param      hph: PH handle of the line.
+  * @param      frame: frame received, at least ::FRAME_SIZE octets.
   * @param      length: number of octets in frame.
   * @retval     Error code, See \ref PH_Error_Code.
   */
-uint8_t KNX_Ph_Data_rec(uint8_t *frame, uint16_t *length)
+uint8_t KNX_Ph_Data_rec(PH_Handle_t *hph, uint8_t *frame, uint16_t *length)
 {
+  KNX_Frame_t *rx;
+  
+  if(KNX_Ph_Frame_rec(hph, &rx, KNX_DEFAULT_TIMEOUT) != PH_ERROR_NONE)
+  {
+    /** \b If timeout, return ::PH_ERROR_TIMEOUT. */
+    return PH_ERROR_TIMEOUT;
+  }
+  
+  memcpy(frame, rx->Datas, rx->Length);
+  *length = rx->Length;
+  KNX_Frame_Release(rx);
+  
+  return PH_ERROR_NONE;
+}
+
+/**
+  * @brief      Receive a frame without copy. The frame has already been
+  *             assembled by the RX interrupt in a buffer of \ref KNX_Frame_Pool,
+  *             only complete frames are returned.
+  * @param      hph: PH handle of the line.
+  * @param      frame: the frame received, the caller owns its reference and
+  *             must give it back with ::KNX_Frame_Release.
+  * @param      timeout: timeout duration.
+  * @retval     Error code, See \ref PH_Error_Code.
+  */
+uint8_t KNX_Ph_Frame_rec(PH_Handle_t *hph, KNX_Frame_t **frame, uint32_t timeout)
+{
+  uint32_t tail;
+  KNX_Deadline_t deadline;
+  
+  /** Wait for a complete frame. */
+  KNX_Deadline_Init(&deadline, timeout);
+  while((timeout = KNX_Deadline_Remaining(&deadline)) != 0U)
+  {
+    tail = hph->FrameTail;
+    if(hph->FrameHead != tail)
+    {
+      KNX_MEMORY_BARRIER();
+      *frame = hph->FrameQueue[tail & KNX_PH_FRAME_QUEUE_MASK];
+      
+      /** The reference of the slot goes to the caller. */
+      KNX_MEMORY_BARRIER();
+      hph->FrameTail = tail + 1U;
+      
+      /** \b If a frame is received, return ::PH_ERROR_NONE. */
+      return PH_ERROR_NONE;
+    }
+    
+    /** Sleep until ::knx_uart_isr_rx completes a frame. */
+    xSemaphoreTake(hph->FrameSemaphore, KNX_MS_TO_TICKS(timeout));
+  }
+  
+  /** \b If timeout, return ::PH_ERROR_TIMEOUT. */
+  return PH_ERROR_TIMEOUT;
+}
+
+/**
+  * @brief      Receive a record of the bus in monitor mode, see
+  *             ::KNX_Ph_ActivateBusmon.
+  * @param      hph: PH handle of the line.
+  * @param      record: the record received.
+  * @param      timeout: timeout duration.
+  * @retval     Error code, See \ref PH_Error_Code.
+  */
+uint8_t KNX_Ph_Monitor_rec(PH_Handle_t *hph, KNX_Ph_Capture_Record_t *record, uint32_t timeout)
+{
+  KNX_Deadline_t deadline;
+  
+  if(KNX_Ph_GetState(hph) != PH_MONITOR)
+  {
+    /** \b If the line is not in monitor mode, return ::PH_ERROR_STATE. */
+    return PH_ERROR_STATE;
+  }
+  
+  /** Wait for a record. */
+  KNX_Deadline_Init(&deadline, timeout);
+  while((timeout = KNX_Deadline_Remaining(&deadline)) != 0U)
+  {
+    if(KNX_Ph_Capture_Get(hph->Capture, record) == PH_CAPTURE_OK)
+    {
+      /** \b If a record is received, return ::PH_ERROR_NONE. */
+      return PH_ERROR_NONE;
+    }
+    
+    /** Sleep until ::knx_uart_isr_rx stores a record. */
+    xSemaphoreTake(hph->FrameSemaphore, KNX_MS_TO_TICKS(timeout));
+  }
+  
+  /** \b If timeout, return ::PH_ERROR_TIMEOUT. */
+  return PH_ERROR_TIMEOUT;
+}
+
+/**
+  * @brief      Play a trace recorded by ::KNX_Ph_SetTrace back into the line:
+  *             the bytes received go through the frame assembly as if the
+  *             TP-UART had sent them, the bytes sent and the gaps are
+  *             skipped. The acks of the frames addressed to the device are
+  *             sent, clear the addresses with ::KNX_Ph_SetAddr first to
+  *             replay silently.
+  * @param      hph: PH handle of the line.
+  * @param      datas: the trace, from its header.
+  * @param      length: size of the trace.
+  * @param      speed: 1 for the timing of the recording, N for N times
+  *             faster, ::KNX_PH_REPLAY_FAST for no wait at all.
+  * @retval     Error code, See \ref PH_Error_Code.
+  */
+uint8_t KNX_Ph_Replay(PH_Handle_t *hph, const uint8_t *datas, uint32_t length, uint32_t speed)
+{
+  KNX_Ph_Trace_Cursor_t cursor;
+  KNX_Ph_Trace_Record_t record;
+  uint32_t start, elapsed;
+  uint64_t at;
   uint8_t ret;
   
-  /** Receive frame. */
-  for(*length=0; *length<FRAME_SIZE; *length++)
+  if(KNX_Ph_Trace_Open(&cursor, datas, length) != PH_TRACE_OK)
   {
-    ret = KNX_Ph_RecData(&frame[*length], KNX_DEFAULT_TIMEOUT);
-    if(ret != PH_ERROR_NONE)
+    /** \b If it's not a trace, return ::PH_ERROR_REQUEST. */
+    return PH_ERROR_REQUEST;
+  }
+  
+  start = KNX_GetTick();
+  while((ret = KNX_Ph_Trace_Next(&cursor, &record)) == PH_TRACE_OK)
+  {
+    if(record.Flags != 0U)
     {
-      return PH_ERROR_TIMEOUT;
+      continue;
+    }
+    
+    /** Sleep until the time of the record, scaled by \b speed. */
+    if(speed != KNX_PH_REPLAY_FAST)
+    {
+      at = record.Time / 1000U / speed;
+      elapsed = KNX_GetTick() - start;
+      if(at > elapsed)
+      {
+        vTaskDelay(KNX_MS_TO_TICKS((uint32_t)(at - elapsed)));
+      }
     }
+    KNX_Ph_InjectDatas(hph, record.Datas, record.Length);
   }
   
-  return PH_ERROR_NONE;
+  /** \b If the trace is cut, return ::PH_ERROR_REQUEST. */
+  return (ret == PH_TRACE_END) ? PH_ERROR_NONE : PH_ERROR_REQUEST;
 }
 /**
   * @}
@@ -485,11 +872,90 @@ uint8_t KNX_Ph_Data_rec(uint8_t *frame, uint16_t *length)
 
 /**
  *  @brief      Getter of the status of the physical layer. 
+ *  @param      hph: PH handle of the line.
  *  @retval     Physical Layer's status: ::PH_Status_t.
  */
-PH_Status_t KNX_Ph_GetState(void)
+PH_Status_t KNX_Ph_GetState(PH_Handle_t *hph)
 {
-  return KNX_PH_STATE;
+  return hph->State;
+}
+
+/**
+ *  @brief      Number of received bytes dropped because the receive buffer
+ *              was full.
+ *  @param      hph: PH handle of the line.
+ *  @retval     Overrun counter of the receive buffer.
+ */
+uint32_t KNX_Ph_GetRxOverruns(PH_Handle_t *hph)
+{
+  uint32_t overruns = 0;
+  uint8_t i;
+  
+  for(i=0; i<PH_CHANNEL_NB; i++)
+  {
+    overruns += KNX_Ph_Buffer_GetOverruns(&hph->RxChannels[i].Buffer);
+  }
+  
+  return overruns;
+}
+
+/**
+ *  @brief      Number of complete frames waiting for ::KNX_Ph_Frame_rec.
+ *  @param      hph: PH handle of the line.
+ *  @retval     Filling level of the frame queue, at most
+ *              ::KNX_PH_FRAME_QUEUE_SIZE.
+ */
+uint32_t KNX_Ph_GetFrameCount(PH_Handle_t *hph)
+{
+  return hph->FrameHead - hph->FrameTail;
+}
+
+/**
+ *  @brief      Copy the counters of the physical layer.
+ *  @param      hph: PH handle of the line.
+ *  @param      stats: pointer to store the counters.
+ */
+void KNX_Ph_GetStats(PH_Handle_t *hph, PH_Stats_t *stats)
+{
+  *stats = hph->Stats;
+  stats->RxOverruns = KNX_Ph_GetRxOverruns(hph);
+  if(hph->Capture != NULL)
+  {
+    stats->CaptureOverruns = KNX_Ph_Capture_GetOverruns(hph->Capture);
+  }
+}
+
+/**
+ *  @brief      Set the addresses the RX interrupt acknowledges. The ack is
+ *              sent as soon as the destination address is received.
+ *  @param      hph: PH handle of the line.
+ *  @param      addr: addresses of the device, NULL to acknowledge nothing.
+ */
+void KNX_Ph_SetAddr(PH_Handle_t *hph, const KNX_Addr_t *addr)
+{
+  hph->Addr = addr;
+}
+
+/**
+ *  @brief      Answer busy instead of ack to the frames addressed to the
+ *              device, while the upper layer can't take them.
+ *  @param      hph: PH handle of the line.
+ *  @param      busy: TRUE to answer busy, FALSE to ack.
+ */
+void KNX_Ph_SetAckBusy(PH_Handle_t *hph, uint8_t busy)
+{
+  hph->AckBusy = busy;
+}
+
+/**
+ *  @brief      Record every byte to and from the TP-UART in \b trace, with
+ *              its time in us. A task drains it with ::KNX_Ph_Trace_Read.
+ *  @param      hph: PH handle of the line.
+ *  @param      trace: trace started by ::KNX_Ph_Trace_Init, NULL to stop.
+ */
+void KNX_Ph_SetTrace(PH_Handle_t *hph, KNX_Ph_Trace_t *trace)
+{
+  hph->Trace = trace;
 }
 /**
   * @}
@@ -506,12 +972,13 @@ PH_Status_t KNX_Ph_GetState(void)
 
 /**
  *  @brief      Set the status of Physical layer. 
+ *  @param      hph: PH handle of the line.
  *  @param      state: the state.
  */
-static void     KNX_Ph_SetState(PH_Status_t state)
+static void     KNX_Ph_SetState(PH_Handle_t *hph, PH_Status_t state)
 {
-  /** Change the ::KNX_PH_STATE to \b state */
-  KNX_PH_STATE = state;
+  /** Change the ::hph->State to \b state */
+  hph->State = state;
   /** Send the debug message that the status has changed */
   KNX_Ph_DebugMessage(state, STATE_DEBUG);
 }
@@ -522,25 +989,528 @@ static void     KNX_Ph_SetState(PH_Status_t state)
  *  @param      type: the type of the message, see ::DEBUG_Type_t.
  */
 static void KNX_Ph_DebugMessage(uint8_t data, DEBUG_Type_t type)
-{ 
+{
+  /** Only the identifier of the message and \b data are logged, the text is
+    * formatted on the host, see \ref KNX_Log. */
   switch(type)
   {
     case STATE_DEBUG:
-      int2text(data, &KNX_PH_STATE_DEBUGMSG[KNX_PH_STATE_DEBUGMSG_INDICE]);
-      cola_guardar(&colaDebug, KNX_PH_STATE_DEBUGMSG);
+      KNX_Log(LOG_PH_STATE, data);
       break;
     case SEND_DEBUG:
-      int2text(data, &KNX_PH_SEND_DEBUGMSG[KNX_PH_SEND_DEBUGMSG_INDICE]);
-      cola_guardar(&colaDebug, KNX_PH_SEND_DEBUGMSG);
+      KNX_Log(LOG_PH_SEND, data);
       break;
     case RECEIVE_DEBUG:
-      int2text(data, &KNX_PH_RECEIVE_DEBUGMSG[KNX_PH_RECEIVE_DEBUGMSG_INDICE]);
-      cola_guardar(&colaDebug, KNX_PH_RECEIVE_DEBUGMSG);
+      KNX_Log(LOG_PH_RECEIVE, data);
       break;
     default:
-      int2text(data, &KNX_PH_ERROR_DEBUGMSG[KNX_PH_ERROR_DEBUGMSG_INDICE]);
-      cola_guardar(&colaDebug, KNX_PH_ERROR_DEBUGMSG);
+      KNX_Log(LOG_PH_ERROR, data);
+  }
+}
+
+/**
+ *  @brief      Hand bytes of a replay to the frame assembly, as the RX
+ *              interrupt would, then yield to the task woken if any.
+ *  @param      hph: PH handle of the line.
+ *  @param      datas: the bytes.
+ *  @param      length: number of bytes.
+ */
+static void KNX_Ph_InjectDatas(PH_Handle_t *hph, const uint8_t *datas, uint8_t length)
+{
+  BaseType_t woken;
+  uint32_t timestamp;
+  uint8_t i;
+  
+  taskENTER_CRITICAL();
+  hph->IsrCycles = KNX_GetCycles();
+  hph->xHigherPriorityTaskWoken = pdFALSE;
+  timestamp = KNX_GetMicros();
+  for(i=0; i<length; i++)
+  {
+    KNX_Ph_AssembleByte(hph, datas[i], timestamp);
+  }
+  woken = hph->xHigherPriorityTaskWoken;
+  taskEXIT_CRITICAL();
+  
+  if(woken != pdFALSE)
+  {
+    taskYIELD();
+  }
+}
+
+/**
+ *  @brief      Assemble the frames byte by byte, called from the RX interrupt.
+ *              A byte received outside a frame which is not a CTRL octet is a
+ *              service from the TP-UART and goes to its channel. A CTRL
+ *              octet takes a buffer from \ref KNX_Frame_Pool, the frame is
+ *              written in place and handed over as is. The end of a frame is
+ *              given by its length octet, a silence longer than
+ *              ::KNX_PH_FRAME_GAP_US between two bytes drops the frame not
+ *              completed. In CRC mode the CRC is computed octet by octet and
+ *              checked against the two octets following the frame.
+ *  @param      hph: PH handle of the line.
+ *  @param      data: the byte received.
+ *  @param      timestamp: us of the byte, see ::KNX_PH_TPUart_GetRxTime. With
+ *              the DMA backend, dated back from its place in the DMA ring.
+ */
+static void KNX_Ph_AssembleByte(PH_Handle_t *hph, uint8_t data, uint32_t timestamp)
+{
+  PH_Assembler_t *asm_rx = &hph->Assembler;
+  KNX_Frame_t *frame;
+  PH_RxChannel_t *channel;
+  
+  /** A silence ends the frame pending or the bytes being discarded. */
+  if(timestamp - asm_rx->LastByte > KNX_PH_FRAME_GAP_US)
+  {
+    KNX_Ph_DropFrame(hph);
   }
+  asm_rx->LastByte = timestamp;
+  
+  if(asm_rx->Discard == TRUE)
+  {
+    return;
+  }
+  
+  frame = asm_rx->Frame;
+  if(frame != NULL && frame->Length == asm_rx->Expected)
+  {
+    /** CRC mode, the frame is complete and its CRC is being received. */
+    asm_rx->CrcRx = (uint16_t)(asm_rx->CrcRx << 8) | data;
+    asm_rx->CrcOctets++;
+    if(asm_rx->CrcOctets == 2U)
+    {
+      asm_rx->Frame = NULL;
+      if(asm_rx->CrcRx == asm_rx->Crc)
+      {
+        KNX_Ph_CompleteFrame(hph, frame);
+      }
+      else
+      {
+        hph->Stats.RxFrameCrcErrors++;
+        KNX_Frame_Release(frame);
+      }
+    }
+    return;
+  }
+  
+  if(frame == NULL)
+  {
+    if((data & FRAME_CTRL_MASK) != FRAME_CTRL_DATA)
+    {
+      if(hph->State == PH_MONITOR)
+      {
+        /** In monitor mode, a character of the bus such as an ack. */
+        KNX_Ph_CaptureDatas(hph, timestamp, 0, &data, 1);
+        return;
+      }
+      
+      channel = &hph->RxChannels[KNX_Ph_Classify(data)];
+      if(KNX_Ph_Buffer_Put(&channel->Buffer, data) == PH_BUFFER_OK)
+      {
+        xSemaphoreGiveFromISR(channel->Semaphore, &hph->xHigherPriorityTaskWoken);
+      }
+      return;
+    }
+    
+    frame = KNX_Frame_Alloc();
+    if(frame == NULL)
+    {
+      /** \b If the pool is exhausted, drop the frame until the next silence. */
+      hph->Stats.RxFrameNoBuffer++;
+      asm_rx->Discard = TRUE;
+      return;
+    }
+    asm_rx->Frame = frame;
+    asm_rx->Expected = 0;
+    frame->Timestamp = timestamp;
+    asm_rx->Parity = 0;
+    asm_rx->Crc = KNX_CRC16_INIT;
+  }
+  
+  frame->Datas[frame->Length] = data;
+  frame->Length++;
+  frame->EndTimestamp = timestamp;
+  asm_rx->Parity ^= data;
+  asm_rx->Crc = KNX_Crc16_Update(asm_rx->Crc, data);
+  
+  /** The total length is known once the length octet is received. */
+  if(asm_rx->Expected == 0U)
+  {
+    if((frame->Datas[0] & FRAME_CTRL_STANDARD) == FRAME_CTRL_STANDARD)
+    {
+      if(frame->Length == FRAME_LENGTH_OCTET + 1U)
+      {
+        asm_rx->Expected = FRAME_OVERHEAD + (data & 0x0FU);
+      }
+    }
+    else if(frame->Length == FRAME_EXT_LENGTH_OCTET + 1U)
+    {
+      asm_rx->Expected = FRAME_EXT_OVERHEAD + data;
+    }
+    
+    if(asm_rx->Expected > FRAME_SIZE)
+    {
+      frame->Verdict |= FRAME_VERDICT_LENGTH;
+    }
+  }
+  
+  /** The ack is decided as soon as the destination address is known, a
+      faulty header is nacked. */
+  if(frame->Length == FRAME_ADDRESSED_LENGTH && hph->State != PH_MONITOR)
+  {
+    KNX_Ph_Acknowledge(hph, frame);
+  }
+  
+  if((frame->Verdict & FRAME_VERDICT_LENGTH) != 0U)
+  {
+    /** \b If the frame does not fit, drop it until the next silence. */
+    hph->Stats.RxFrameTooLong++;
+    KNX_Frame_Release(frame);
+    asm_rx->Frame = NULL;
+    asm_rx->Discard = TRUE;
+    return;
+  }
+  
+  if(frame->Length == asm_rx->Expected)
+  {
+    /** The check octet is the inverted XOR of the others, so the XOR of
+        all the octets is 0xFF. */
+    if(asm_rx->Parity != 0xFFU)
+    {
+      frame->Verdict |= FRAME_VERDICT_PARITY;
+    }
+    
+    if(hph->CrcMode == TRUE)
+    {
+      /** Wait for the CRC before handing the frame over. */
+      asm_rx->CrcRx = 0;
+      asm_rx->CrcOctets = 0;
+      return;
+    }
+    
+    asm_rx->Frame = NULL;
+    KNX_Ph_CompleteFrame(hph, frame);
+  }
+}
+
+/**
+ *  @brief      Hand a frame assembled over: to the capture ring in monitor
+ *              mode, to ::KNX_Ph_Frame_rec otherwise. Its verdict is known,
+ *              a faulty frame is dropped here.
+ *  @param      hph: PH handle of the line.
+ *  @param      frame: the frame assembled, its reference is taken over.
+ */
+static void KNX_Ph_CompleteFrame(PH_Handle_t *hph, KNX_Frame_t *frame)
+{
+  if(hph->State == PH_MONITOR)
+  {
+    /** In monitor mode the frame is copied to the capture ring, faulty or
+        not. */
+    KNX_Ph_CaptureDatas(hph, frame->Timestamp,
+                        (frame->Verdict == FRAME_VERDICT_OK) ? PH_CAPTURE_FRAME : (PH_CAPTURE_FRAME | PH_CAPTURE_PARITY),
+                        frame->Datas, frame->Length);
+    KNX_Frame_Release(frame);
+  }
+  else if(frame->Verdict != FRAME_VERDICT_OK)
+  {
+    hph->Stats.RxFrameParityErrors++;
+    KNX_Frame_Release(frame);
+  }
+  else
+  {
+    /** The reference of the assembler goes to the queue. */
+    KNX_Ph_PushFrame(hph, frame);
+  }
+}
+
+/**
+ *  @brief      Drop the frame being assembled and stop discarding, at the
+ *              end of a silence. Called from the RX interrupt.
+ *  @param      hph: PH handle of the line.
+ */
+static void KNX_Ph_DropFrame(PH_Handle_t *hph)
+{
+  KNX_Frame_t *frame = hph->Assembler.Frame;
+  
+  if(frame != NULL)
+  {
+    hph->Stats.RxFrameTruncated++;
+    if(hph->State == PH_MONITOR)
+    {
+      /** A bus monitor keeps what was received of the frame. */
+      KNX_Ph_CaptureDatas(hph, frame->Timestamp, PH_CAPTURE_FRAME | PH_CAPTURE_TRUNCATED,
+                          frame->Datas, frame->Length);
+    }
+    KNX_Frame_Release(frame);
+    hph->Assembler.Frame = NULL;
+  }
+  hph->Assembler.Discard = FALSE;
+}
+
+/**
+ *  @brief      Hand a complete frame to ::KNX_Ph_Frame_rec.
+ *  @param      hph: PH handle of the line.
+ *  @param      frame: the frame assembled, its reference is taken over.
+ */
+static void KNX_Ph_PushFrame(PH_Handle_t *hph, KNX_Frame_t *frame)
+{
+  uint32_t head = hph->FrameHead;
+  
+  if(head - hph->FrameTail >= KNX_PH_FRAME_QUEUE_SIZE)
+  {
+    /** \b If the queue is full, drop the frame. */
+    hph->Stats.RxFrameOverruns++;
+    KNX_Frame_Release(frame);
+    return;
+  }
+  
+  hph->FrameQueue[head & KNX_PH_FRAME_QUEUE_MASK] = frame;
+  
+  /** Publish the frame before moving the head. */
+  KNX_MEMORY_BARRIER();
+  hph->FrameHead = head + 1U;
+  hph->Stats.RxFrames++;
+  
+  xSemaphoreGiveFromISR(hph->FrameSemaphore, &hph->xHigherPriorityTaskWoken);
+}
+
+/**
+ *  @brief      Store a record of the bus in monitor mode and wake up
+ *              ::KNX_Ph_Monitor_rec. Called from the RX interrupt.
+ *  @param      hph: PH handle of the line.
+ *  @param      timestamp: reception of the first octet in us.
+ *  @param      flags: see \ref PH_Capture_Flags.
+ *  @param      datas: octets received.
+ *  @param      length: number of octets.
+ */
+static void KNX_Ph_CaptureDatas(PH_Handle_t *hph, uint32_t timestamp, uint8_t flags, const uint8_t *datas, uint16_t length)
+{
+  if(KNX_Ph_Capture_Put(hph->Capture, timestamp, flags, datas, length) == PH_CAPTURE_OK)
+  {
+    hph->Stats.Captured++;
+    xSemaphoreGiveFromISR(hph->FrameSemaphore, &hph->xHigherPriorityTaskWoken);
+  }
+}
+
+/**
+ *  @brief      Ack a frame addressed to the device, called from the RX
+ *              interrupt once its destination address is received. The look
+ *              up takes a constant time. A frame whose header is faulty
+ *              is nacked. If a transfer is ongoing the ack is sent by
+ *              ::knx_uart_isr_tx at its end.
+ *  @param      hph: PH handle of the line.
+ *  @param      frame: the frame being assembled.
+ */
+static void KNX_Ph_Acknowledge(PH_Handle_t *hph, KNX_Frame_t *frame)
+{
+  uint16_t da;
+  uint8_t group;
+  
+  if(hph->Addr == NULL)
+  {
+    return;
+  }
+  
+  if((frame->Datas[0] & FRAME_CTRL_STANDARD) == FRAME_CTRL_STANDARD)
+  {
+    da = (frame->Datas[FRAME_DA_OCTET] << 8) | frame->Datas[FRAME_DA_OCTET + 1U];
+    group = frame->Datas[FRAME_AT_OCTET] & FRAME_AT_GROUP;
+  }
+  else
+  {
+    da = (frame->Datas[FRAME_EXT_DA_OCTET] << 8) | frame->Datas[FRAME_EXT_DA_OCTET + 1U];
+    group = frame->Datas[FRAME_EXT_AT_OCTET] & FRAME_AT_GROUP;
+  }
+  
+  if(KNX_Addr_Match(hph->Addr, da, group) == FALSE)
+  {
+    return;
+  }
+  
+  /** Nack a frame the RX interrupt found wrong. Busy if the frame queue is
+      above its high water mark or the pool is empty: decided here, from the
+      levels seen by this interrupt, and not from the state the task last
+      set. */
+  if(frame->Verdict != FRAME_VERDICT_OK)
+  {
+    hph->AckByte = U_AckInformation_Nack;
+    hph->Stats.Nacks++;
+  }
+  else if((hph->AckBusy == TRUE)
+          || (hph->FrameHead - hph->FrameTail >= KNX_PH_ACK_BUSY_LEVEL)
+          || (KNX_Frame_IsExhausted() == TRUE))
+  {
+    hph->AckByte = U_AckInformation_Busy;
+    hph->Stats.AcksBusy++;
+  }
+  else
+  {
+    hph->AckByte = U_AckInformation_ACK;
+  }
+  /** The DL drops the frame later only if it was answered busy */
+  frame->Ack = hph->AckByte;
+  hph->AckCycles = hph->IsrCycles;
+  if(KNX_Ph_Transmit(hph, &hph->AckByte, 1) == TPUart_OK)
+  {
+    KNX_Ph_AckSent(hph);
+  }
+  else
+  {
+    hph->AckPending = TRUE;
+    hph->Stats.AckDeferred++;
+  }
+}
+
+/**
+ *  @brief      Count an ack handed to the UART and its delay.
+ *  @param      hph: PH handle of the line.
+ */
+static void KNX_Ph_AckSent(PH_Handle_t *hph)
+{
+  uint32_t cycles = KNX_GetCycles() - hph->AckCycles;
+  
+  hph->Stats.Acks++;
+  if(cycles > hph->Stats.AckCyclesMax)
+  {
+    hph->Stats.AckCyclesMax = cycles;
+  }
+}
+
+/**
+ *  @brief      Hand bytes to the TP-UART, and record them in the trace once
+ *              accepted. Called from the tasks and the UART interrupt.
+ *  @param      hph: PH handle of the line.
+ *  @param      datas: pointer to the datas.
+ *  @param      size: number of bytes.
+ *  @retval     See ::TPUart_Status_t.
+ */
+static uint8_t KNX_Ph_Transmit(PH_Handle_t *hph, uint8_t *datas, uint16_t size)
+{
+  uint8_t ret = KNX_PH_TPUart_Send(&hph->TPUart, datas, size);
+  
+  if(ret == TPUart_OK && hph->Trace != NULL)
+  {
+    KNX_Ph_Trace_Record(hph->Trace, PH_TRACE_TX, KNX_GetMicros(), datas, size);
+  }
+  
+  return ret;
+}
+
+/**
+ *  @brief      Send a block of datas in a single transfer, the UART interrupt
+ *              clocks the bytes out back to back. The calling task sleeps
+ *              until the last byte has left the UART, \b datas must stay
+ *              valid until then.
+ *  @param      hph: PH handle of the line.
+ *  @param      datas: pointer to the datas.
+ *  @param      size: number of bytes.
+ *  @param      timeout: timeout duration.
+ *  @retval     Error code, See \ref PH_Error_Code.
+ */
+static uint8_t KNX_Ph_SendDatas(PH_Handle_t *hph, uint8_t *datas, uint16_t size, uint32_t timeout)
+{
+  uint8_t ret = PH_ERROR_TIMEOUT;
+  uint8_t sent;
+  KNX_Deadline_t deadline;
+  
+  KNX_Deadline_Init(&deadline, timeout);
+  if(xSemaphoreTake(hph->TxMutex, KNX_MS_TO_TICKS(timeout)) == pdTRUE)
+  {
+    /** Wait for the end of a transfer still ongoing, send, then wait for
+        the end of this one. The RX interrupt may slip an ack in before the
+        send, wait again then. */
+    do
+    {
+      sent = TPUart_ERROR;
+      if(KNX_Ph_WaitTxDone(hph, &deadline) != PH_ERROR_NONE)
+      {
+        break;
+      }
+      taskENTER_CRITICAL();
+      sent = KNX_Ph_Transmit(hph, datas, size);
+      taskEXIT_CRITICAL();
+    } while(sent == TPUart_BUSY);
+    
+    if(sent == TPUart_OK)
+    {
+      ret = KNX_Ph_WaitTxDone(hph, &deadline);
+    }
+    xSemaphoreGive(hph->TxMutex);
+  }
+  
+  return ret;
+}
+
+/**
+ *  @brief      Encode a frame into the TP-UART service stream: each octet is
+ *              preceded by its U_L_DataStart, U_L_DataContinue or U_L_DataEnd
+ *              control byte.
+ *  @param      frame: frame to be sent.
+ *  @param      length: number of octets in frame, at least 2.
+ *  @param      stream: buffer of at least 2 * \b length bytes.
+ *  @retval     Number of bytes in \b stream.
+ */
+static uint16_t KNX_Ph_EncodeFrame(const uint8_t *frame, uint16_t length, uint8_t *stream)
+{
+  uint16_t i;
+  
+  /** U_L_DataStart byte and CTRL byte. */
+  stream[0] = U_L_DataStart;
+  stream[1] = frame[0];
+  
+  /** U_L_DataContinue byte and the frame. */
+  for(i=1; i<length-1; i++)
+  {
+    stream[2*i] = (uint8_t)(U_L_DataContinue | i);
+    stream[2*i + 1] = frame[i];
+  }
+  
+  /** U_L_DataEnd byte and CheckSum. */
+  stream[2*i] = (uint8_t)(U_L_DataEnd | (uint8_t)length);
+  stream[2*i + 1] = frame[length-1];
+  
+  return (uint16_t)(2 * length);
+}
+
+/**
+ *  @brief      Drop the bytes left in a channel before a new request, so an
+ *              old response can't be taken for the new one.
+ *  @param      hph: PH handle of the line.
+ *  @param      channel: the channel, see ::PH_Channel_t.
+ */
+static void KNX_Ph_FlushChannel(PH_Handle_t *hph, PH_Channel_t channel)
+{
+  KNX_Ph_Buffer_Flush(&hph->RxChannels[channel].Buffer);
+  xSemaphoreTake(hph->RxChannels[channel].Semaphore, 0);
+}
+
+/**
+ *  @brief      Sleep until the UART has no transfer ongoing. The state of the
+ *              UART is the reference, ::PH_Handle_t::TxSemaphore only wakes the task
+ *              up, so a semaphore given for an older transfer is harmless.
+ *  @param      hph: PH handle of the line.
+ *  @param      deadline: end of the wait, shared by the steps of a send.
+ *  @retval     Error code, See \ref PH_Error_Code.
+ */
+static uint8_t KNX_Ph_WaitTxDone(PH_Handle_t *hph, const KNX_Deadline_t *deadline)
+{
+  uint32_t timeout;
+  
+  /** Set the flag before checking, the end of the transfer can't be missed. */
+  hph->TxFlag = TRUE;
+  while(KNX_PH_TPUart_GetTxState(&hph->TPUart) != TPUart_OK)
+  {
+    timeout = KNX_Deadline_Remaining(deadline);
+    if(timeout == 0U)
+    {
+      hph->TxFlag = FALSE;
+      return PH_ERROR_TIMEOUT;
+    }
+    xSemaphoreTake(hph->TxSemaphore, KNX_MS_TO_TICKS(timeout));
+  }
+  hph->TxFlag = FALSE;
+  
+  return PH_ERROR_NONE;
 }
 /**
   * @}
@@ -0,0 +1,217 @@
+/**
+  ******************************************************************************
+  * @file       KNX_Ph_Buffer.c
+  * @author     MA Dingjie
+  * @version    V1.0.0
+  * @date       12-October-2016
+  * @brief      KNX Physical Layer receive ring buffer.
+  *             This file provides functions to manage following functionalities:
+  *              + Initialization functions
+  *              + Put from the interrupt and Get/Read from the tasks
+  *              + Filling level and overrun counters
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <string.h>
+#include "KNX_Ph_Buffer.h"
+#include "KNX_def.h"
+
+/** @addtogroup KNX_Lib
+  * @{
+  */
+
+/** @addtogroup KNX_PH
+  * @{
+  */
+
+/** @defgroup KNX_PH_Buffer KNX Physical Layer Ring Buffer
+  * @{
+  */
+
+/* Private constants ---------------------------------------------------------*/
+/** \brief Compilation fails if ::KNX_PH_BUFFER_SIZE is not a power of 2. */
+typedef char KNX_Ph_Buffer_SizeCheck[((KNX_PH_BUFFER_SIZE & KNX_PH_BUFFER_MASK) == 0U) ? 1 : -1];
+
+/* Exported functions --------------------------------------------------------*/
+/** @defgroup KNX_PH_Buffer_Exported_Functions KNX Physical Layer Ring Buffer Exported Functions
+  * @{
+  */
+
+/** @defgroup KNX_PH_Buffer_Exported_Functions_Group1 Initialization Functions
+  * @{
+  */
+
+/**
+  * @brief      Initialize a ring buffer, the counters are cleared as well.
+  * @param      buf: pointer to the ring buffer.
+  */
+void KNX_Ph_Buffer_Init(KNX_Ph_Buffer_t *buf)
+{
+  buf->Head = 0;
+  buf->Tail = 0;
+  buf->Overruns = 0;
+  buf->MaxLevel = 0;
+}
+
+/**
+  * @brief      Drop all the bytes waiting in the ring buffer. Must be called
+  *             from the consumer side.
+  * @param      buf: pointer to the ring buffer.
+  */
+void KNX_Ph_Buffer_Flush(KNX_Ph_Buffer_t *buf)
+{
+  buf->Tail = buf->Head;
+}
+/**
+  * @}
+  */
+
+/** @defgroup KNX_PH_Buffer_Exported_Functions_Group2 Put/Get Functions
+  * @{
+  */
+
+/**
+  * @brief      Store a byte, to be called by the producer only (UART ISR).
+  * @param      buf: pointer to the ring buffer.
+  * @param      data: the byte received.
+  * @retval     ::PH_BUFFER_OK, or ::PH_BUFFER_FULL if the byte was dropped.
+  */
+uint8_t KNX_Ph_Buffer_Put(KNX_Ph_Buffer_t *buf, uint8_t data)
+{
+  uint32_t head = buf->Head;
+  uint32_t level = head - buf->Tail;
+
+  if(level >= KNX_PH_BUFFER_SIZE)
+  {
+    /** \b If full, count the overrun and drop the byte. */
+    buf->Overruns++;
+    return PH_BUFFER_FULL;
+  }
+
+  buf->Datas[head & KNX_PH_BUFFER_MASK] = data;
+
+  /** Publish the byte before moving the ::KNX_Ph_Buffer_t::Head. */
+  KNX_MEMORY_BARRIER();
+  buf->Head = head + 1U;
+
+  if(level + 1U > buf->MaxLevel)
+  {
+    buf->MaxLevel = level + 1U;
+  }
+
+  return PH_BUFFER_OK;
+}
+
+/**
+  * @brief      Take the oldest byte, to be called by the consumer only.
+  * @param      buf: pointer to the ring buffer.
+  * @param      data: pointer to store the byte.
+  * @retval     ::PH_BUFFER_OK, or ::PH_BUFFER_EMPTY.
+  */
+uint8_t KNX_Ph_Buffer_Get(KNX_Ph_Buffer_t *buf, uint8_t *data)
+{
+  uint32_t tail = buf->Tail;
+
+  if(buf->Head == tail)
+  {
+    return PH_BUFFER_EMPTY;
+  }
+
+  KNX_MEMORY_BARRIER();
+  *data = buf->Datas[tail & KNX_PH_BUFFER_MASK];
+
+  /** Release the place only after the byte has been read. */
+  KNX_MEMORY_BARRIER();
+  buf->Tail = tail + 1U;
+
+  return PH_BUFFER_OK;
+}
+
+/**
+  * @brief      Drain up to \b size bytes at once, to be called by the consumer
+  *             only. The copy is done in at most two blocks.
+  * @param      buf: pointer to the ring buffer.
+  * @param      datas: pointer to the destination buffer.
+  * @param      size: max number of bytes to read.
+  * @retval     Number of bytes actually read.
+  */
+uint16_t KNX_Ph_Buffer_Read(KNX_Ph_Buffer_t *buf, uint8_t *datas, uint16_t size)
+{
+  uint32_t tail = buf->Tail;
+  uint32_t count = buf->Head - tail;
+  uint32_t first;
+
+  if(count > size)
+  {
+    count = size;
+  }
+
+  if(count == 0U)
+  {
+    return 0;
+  }
+
+  KNX_MEMORY_BARRIER();
+
+  /** Copy until the end of the storage, then the part wrapped around. */
+  first = KNX_PH_BUFFER_SIZE - (tail & KNX_PH_BUFFER_MASK);
+  if(first > count)
+  {
+    first = count;
+  }
+  memcpy(datas, &buf->Datas[tail & KNX_PH_BUFFER_MASK], first);
+  memcpy(&datas[first], buf->Datas, count - first);
+
+  KNX_MEMORY_BARRIER();
+  buf->Tail = tail + count;
+
+  return (uint16_t)count;
+}
+/**
+  * @}
+  */
+
+/** @defgroup KNX_PH_Buffer_Exported_Functions_Group3 State Functions
+  * @{
+  */
+
+/**
+  * @brief      Number of bytes waiting in the ring buffer.
+  * @param      buf: pointer to the ring buffer.
+  * @retval     Filling level.
+  */
+uint32_t KNX_Ph_Buffer_Count(KNX_Ph_Buffer_t *buf)
+{
+  return buf->Head - buf->Tail;
+}
+
+/**
+  * @brief      Number of bytes dropped since the initialization.
+  * @param      buf: pointer to the ring buffer.
+  * @retval     Overrun counter.
+  */
+uint32_t KNX_Ph_Buffer_GetOverruns(KNX_Ph_Buffer_t *buf)
+{
+  return buf->Overruns;
+}
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
@@ -0,0 +1,174 @@
+/**
+  ******************************************************************************
+  * @file       KNX_Ph_Capture.c
+  * @author     MA Dingjie
+  * @version    V1.0.0
+  * @date       17-October-2016
+  * @brief      KNX Physical Layer capture ring of the bus monitor mode.
+  *             This file provides functions to manage following functionalities:
+  *              + Initialization functions
+  *              + Put from the interrupt and Get from the tasks
+  *              + Filling level and overrun counters
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <string.h>
+#include "KNX_Ph_Capture.h"
+#include "KNX_def.h"
+
+/** @addtogroup KNX_Lib
+  * @{
+  */
+
+/** @addtogroup KNX_PH
+  * @{
+  */
+
+/** @defgroup KNX_PH_Capture KNX Physical Layer Capture Ring
+  * @{
+  */
+
+/* Private constants ---------------------------------------------------------*/
+/** \brief Compilation fails if ::KNX_PH_CAPTURE_SIZE is not a power of 2. */
+typedef char KNX_Ph_Capture_SizeCheck[((KNX_PH_CAPTURE_SIZE & KNX_PH_CAPTURE_MASK) == 0U) ? 1 : -1];
+
+/* Exported functions --------------------------------------------------------*/
+/** @defgroup KNX_PH_Capture_Exported_Functions KNX Physical Layer Capture Ring Exported Functions
+  * @{
+  */
+
+/** @defgroup KNX_PH_Capture_Exported_Functions_Group1 Initialization Functions
+  * @{
+  */
+
+/**
+  * @brief      Initialize a capture ring, the counters are cleared as well.
+  * @param      cap: pointer to the capture ring.
+  */
+void KNX_Ph_Capture_Init(KNX_Ph_Capture_t *cap)
+{
+  cap->Head = 0;
+  cap->Tail = 0;
+  cap->Overruns = 0;
+  cap->MaxLevel = 0;
+}
+/**
+  * @}
+  */
+
+/** @defgroup KNX_PH_Capture_Exported_Functions_Group2 Put/Get Functions
+  * @{
+  */
+
+/**
+  * @brief      Store a record, to be called by the producer only (UART ISR).
+  * @param      cap: pointer to the capture ring.
+  * @param      timestamp: reception of the first octet in us.
+  * @param      flags: see \ref PH_Capture_Flags.
+  * @param      datas: octets received.
+  * @param      length: number of octets, at most ::FRAME_SIZE.
+  * @retval     ::PH_CAPTURE_OK, or ::PH_CAPTURE_FULL if the record was dropped.
+  */
+uint8_t KNX_Ph_Capture_Put(KNX_Ph_Capture_t *cap, uint32_t timestamp, uint8_t flags, const uint8_t *datas, uint16_t length)
+{
+  uint32_t head = cap->Head;
+  uint32_t level = head - cap->Tail;
+  KNX_Ph_Capture_Record_t *record;
+
+  if(level >= KNX_PH_CAPTURE_SIZE)
+  {
+    /** \b If full, count the overrun and drop the record. */
+    cap->Overruns++;
+    return PH_CAPTURE_FULL;
+  }
+
+  record = &cap->Records[head & KNX_PH_CAPTURE_MASK];
+  record->Timestamp = timestamp;
+  record->Flags = flags;
+  record->Length = (uint8_t)length;
+  memcpy(record->Datas, datas, length);
+
+  /** Publish the record before moving the ::KNX_Ph_Capture_t::Head. */
+  KNX_MEMORY_BARRIER();
+  cap->Head = head + 1U;
+
+  if(level + 1U > cap->MaxLevel)
+  {
+    cap->MaxLevel = level + 1U;
+  }
+
+  return PH_CAPTURE_OK;
+}
+
+/**
+  * @brief      Take the oldest record, to be called by the consumer only.
+  * @param      cap: pointer to the capture ring.
+  * @param      record: pointer to store the record.
+  * @retval     ::PH_CAPTURE_OK, or ::PH_CAPTURE_EMPTY.
+  */
+uint8_t KNX_Ph_Capture_Get(KNX_Ph_Capture_t *cap, KNX_Ph_Capture_Record_t *record)
+{
+  uint32_t tail = cap->Tail;
+
+  if(cap->Head == tail)
+  {
+    return PH_CAPTURE_EMPTY;
+  }
+
+  KNX_MEMORY_BARRIER();
+  *record = cap->Records[tail & KNX_PH_CAPTURE_MASK];
+
+  /** Release the place only after the record has been read. */
+  KNX_MEMORY_BARRIER();
+  cap->Tail = tail + 1U;
+
+  return PH_CAPTURE_OK;
+}
+/**
+  * @}
+  */
+
+/** @defgroup KNX_PH_Capture_Exported_Functions_Group3 State Functions
+  * @{
+  */
+
+/**
+  * @brief      Number of records waiting in the capture ring.
+  * @param      cap: pointer to the capture ring.
+  * @retval     Filling level.
+  */
+uint32_t KNX_Ph_Capture_Count(KNX_Ph_Capture_t *cap)
+{
+  return cap->Head - cap->Tail;
+}
+
+/**
+  * @brief      Number of records dropped since the initialization.
+  * @param      cap: pointer to the capture ring.
+  * @retval     Overrun counter.
+  */
+uint32_t KNX_Ph_Capture_GetOverruns(KNX_Ph_Capture_t *cap)
+{
+  return cap->Overruns;
+}
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
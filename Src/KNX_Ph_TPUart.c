@@ -13,10 +13,12 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include <stdint.h>
-#include "stm32f4xx_hal.h"
-#include "KNX_Aux.h"
 #include "KNX_Ph_TPUart.h"
+
+#if KNX_PH_TPUART_BACKEND == KNX_PH_TPUART_IT
+#include <stdio.h>
 #include "stm32f4xx_hal.h"
+#include "KNX_Aux.h"
 
 /** @addtogroup KNX_Lib
   * @{
@@ -35,20 +37,10 @@
   * @brief      External functions to be used in \ref KNX_PH_Sup module
   * @{
   */
-extern void knx_uart_isr_begin (void);
-extern void knx_uart_isr_end (void);
-extern void knx_uart_isr_rx (void);
-extern void knx_uart_isr_tx (void);
-/**
-  * @}
-  */
-
-/* Private variables --------------------------------------------------------*/
-/** @defgroup KNX_PH_TPUART_Private_Variables KNX TPUart Private Variables
-  * @{
-  */
-/** \brief UART Handler */
-UART_HandleTypeDef knx_huart;
+extern void knx_uart_isr_begin (struct PH_Handle *hph);
+extern void knx_uart_isr_end (struct PH_Handle *hph);
+extern void knx_uart_isr_rx (struct PH_Handle *hph);
+extern void knx_uart_isr_tx (struct PH_Handle *hph);
 /**
   * @}
   */
@@ -64,31 +56,43 @@ UART_HandleTypeDef knx_huart;
   */
 
 /**
-  * @brief      Initialization of the uart handler ::knx_huart. 
+  * @brief      Initialization of the uart handler of a line.
+  * @param      htpuart: TPUart handle, ::TPUart_Handle_t::Instance and the
+  *             baud rate pin set by the user.
   * @retval     ::TPUart_OK for a successful initialization, while ::TPUart_ERROR
   *             for failed.        
   */
-uint8_t KNX_PH_TPUart_init(void)
+uint8_t KNX_PH_TPUart_init(TPUart_Handle_t *htpuart)
 {
-  knx_huart.Instance = USART3;
-  knx_huart.Init.BaudRate = 9600;
-  knx_huart.Init.WordLength = UART_WORDLENGTH_9B;
-  knx_huart.Init.StopBits = UART_STOPBITS_1;
-  knx_huart.Init.Parity = UART_PARITY_EVEN;
-  knx_huart.Init.Mode = UART_MODE_TX_RX;
-  knx_huart.Init.HwFlowCtl = UART_HWCONTROL_NONE;
-  knx_huart.Init.OverSampling = UART_OVERSAMPLING_16;
-  if (HAL_UART_Init(&knx_huart) != HAL_OK)
+  if(htpuart->Instance == NULL)
+  {
+    htpuart->Instance = USART3;
+    htpuart->BaudPort = GPIOD;
+    htpuart->BaudPin = GPIO_PIN_7;
+  }
+  
+  htpuart->huart.Instance = htpuart->Instance;
+  htpuart->huart.Init.BaudRate = 9600;
+  htpuart->huart.Init.WordLength = UART_WORDLENGTH_9B;
+  htpuart->huart.Init.StopBits = UART_STOPBITS_1;
+  htpuart->huart.Init.Parity = UART_PARITY_EVEN;
+  htpuart->huart.Init.Mode = UART_MODE_TX_RX;
+  htpuart->huart.Init.HwFlowCtl = UART_HWCONTROL_NONE;
+  htpuart->huart.Init.OverSampling = UART_OVERSAMPLING_16;
+  if (HAL_UART_Init(&htpuart->huart) != HAL_OK)
   {
     puts("***ERROR*** knx_uart failed to initiate \r\n");
     return TPUart_ERROR;
   }
   
-  __HAL_UART_ENABLE_IT(&knx_huart, UART_IT_RXNE);  /** Activate Flag Receptie */
-  __HAL_UART_ENABLE_IT(&knx_huart, UART_IT_TC);    /** Activate Flag TX       */
+  __HAL_UART_ENABLE_IT(&htpuart->huart, UART_IT_RXNE);  /** Activate Flag Receptie */
+  __HAL_UART_ENABLE_IT(&htpuart->huart, UART_IT_TC);    /** Activate Flag TX       */
   
-  /* Set the PD7 to 1 to make the baud rate of TP-UART2 to 9600 */
-  HAL_GPIO_WritePin(GPIOD, GPIO_PIN_7, GPIO_PIN_SET);
+  /* Set the baud rate pin to 1 to make the baud rate of TP-UART2 to 9600 */
+  if(htpuart->BaudPort != NULL)
+  {
+    HAL_GPIO_WritePin(htpuart->BaudPort, htpuart->BaudPin, GPIO_PIN_SET);
+  }
 
   return TPUart_OK;
 }
@@ -102,13 +106,14 @@ uint8_t KNX_PH_TPUart_init(void)
 
 /**
   * @brief      Send the data through UART.
+  * @param      htpuart: TPUart handle.
   * @param      data:  pointer to the data buffer.
   * @param      size:  amount of data to be sent.
   * @retval     ::TPUart_Status_t according to the status
   */
-uint8_t KNX_PH_TPUart_Send(uint8_t *data, uint16_t size)
+uint8_t KNX_PH_TPUart_Send(TPUart_Handle_t *htpuart, uint8_t *data, uint16_t size)
 {
-  if((&knx_huart)->gState == HAL_UART_STATE_READY)
+  if(htpuart->huart.gState == HAL_UART_STATE_READY)
   {
     if((data == NULL ) || (size == 0U)) 
     {
@@ -116,27 +121,27 @@ uint8_t KNX_PH_TPUart_Send(uint8_t *data, uint16_t size)
     }
   
     /* Process Locked */
-    if((&knx_huart)->Lock == HAL_LOCKED)
+    if(htpuart->huart.Lock == HAL_LOCKED)
     {
       return TPUart_BUSY;
     }
     else
     {
-      (&knx_huart)->Lock = HAL_LOCKED;
+      htpuart->huart.Lock = HAL_LOCKED;
     }
     
-    (&knx_huart)->pTxBuffPtr = data;
-    (&knx_huart)->TxXferSize = size;
-    (&knx_huart)->TxXferCount = size;
+    htpuart->huart.pTxBuffPtr = data;
+    htpuart->huart.TxXferSize = size;
+    htpuart->huart.TxXferCount = size;
 
-    (&knx_huart)->ErrorCode = HAL_UART_ERROR_NONE;
-    (&knx_huart)->gState = HAL_UART_STATE_BUSY_TX;
+    htpuart->huart.ErrorCode = HAL_UART_ERROR_NONE;
+    htpuart->huart.gState = HAL_UART_STATE_BUSY_TX;
     
     /* Process Unlocked */
-    (&knx_huart)->Lock = HAL_UNLOCKED;
+    htpuart->huart.Lock = HAL_UNLOCKED;
     
     /* Enable the UART Transmit data register empty Interrupt */
-    SET_BIT((&knx_huart)->Instance->CR1, USART_CR1_TXEIE);
+    SET_BIT(htpuart->huart.Instance->CR1, USART_CR1_TXEIE);
     
     return TPUart_OK;
   }
@@ -147,16 +152,34 @@ uint8_t KNX_PH_TPUart_Send(uint8_t *data, uint16_t size)
 
 }
 
+/**
+  * @brief      State of the transmission.
+  * @param      htpuart: TPUart handle.
+  * @retval     ::TPUart_OK if no transfer is ongoing, ::TPUart_BUSY otherwise.
+  */
+uint8_t KNX_PH_TPUart_GetTxState(TPUart_Handle_t *htpuart)
+{
+  if(htpuart->huart.gState == HAL_UART_STATE_READY)
+  {
+    return TPUart_OK;
+  }
+  else
+  {
+    return TPUart_BUSY;
+  }
+}
+
 /**
   * @brief      Receive the data through UART.
+  * @param      htpuart: TPUart handle.
   * @param      data:  pointer to the data buffer.
   * @param      size:  amount of data to be received.
   * @retval     ::TPUart_Status_t according to the status
   */
-uint8_t KNX_PH_TPUart_Receive(uint8_t *data, uint16_t size)
+uint8_t KNX_PH_TPUart_Receive(TPUart_Handle_t *htpuart, uint8_t *data, uint16_t size)
 {
   /* Check that a Rx process is not already ongoing */ 
-  if((&knx_huart)->RxState == HAL_UART_STATE_READY)
+  if(htpuart->huart.RxState == HAL_UART_STATE_READY)
   {
     if((data == NULL ) || (size == 0U)) 
     {
@@ -164,33 +187,33 @@ uint8_t KNX_PH_TPUart_Receive(uint8_t *data, uint16_t size)
     }
     
     /* Process Locked */
-    if((&knx_huart)->Lock == HAL_LOCKED)
+    if(htpuart->huart.Lock == HAL_LOCKED)
     {
       return TPUart_BUSY;
     }
     else
     {
-      (&knx_huart)->Lock = HAL_LOCKED;
+      htpuart->huart.Lock = HAL_LOCKED;
     }
     
-    (&knx_huart)->pRxBuffPtr = data;
-    (&knx_huart)->RxXferSize = size;
-    (&knx_huart)->RxXferCount = size;
+    htpuart->huart.pRxBuffPtr = data;
+    htpuart->huart.RxXferSize = size;
+    htpuart->huart.RxXferCount = size;
     
-    (&knx_huart)->ErrorCode = HAL_UART_ERROR_NONE;
-    (&knx_huart)->RxState = HAL_UART_STATE_BUSY_RX;
+    htpuart->huart.ErrorCode = HAL_UART_ERROR_NONE;
+    htpuart->huart.RxState = HAL_UART_STATE_BUSY_RX;
     
     /* Process Unlocked */
-    (&knx_huart)->Lock = HAL_UNLOCKED;
+    htpuart->huart.Lock = HAL_UNLOCKED;
     
     /* Enable the UART Parity Error Interrupt */
-    SET_BIT((&knx_huart)->Instance->CR1, USART_CR1_PEIE);
+    SET_BIT(htpuart->huart.Instance->CR1, USART_CR1_PEIE);
     
     /* Enable the UART Error Interrupt: (Frame error, noise error, overrun error) */
-    SET_BIT((&knx_huart)->Instance->CR3, USART_CR3_EIE);
+    SET_BIT(htpuart->huart.Instance->CR3, USART_CR3_EIE);
 
     /* Enable the UART Data Register not empty Interrupt */
-    SET_BIT((&knx_huart)->Instance->CR1, USART_CR1_RXNEIE);
+    SET_BIT(htpuart->huart.Instance->CR1, USART_CR1_RXNEIE);
     
     return TPUart_OK;
   }
@@ -199,6 +222,18 @@ uint8_t KNX_PH_TPUart_Receive(uint8_t *data, uint16_t size)
     return TPUart_BUSY; 
   }
 }
+
+/**
+  * @brief      Time at which the last byte given by ::KNX_PH_TPUart_Receive
+  *             came from the TP-UART.
+  * @param      htpuart: TPUart handle.
+  * @retval     us of the byte, see ::KNX_GetMicros: now, each byte comes with its own interrupt.
+  */
+uint32_t KNX_PH_TPUart_GetRxTime(TPUart_Handle_t *htpuart)
+{
+  (void)htpuart;
+  return KNX_GetMicros();
+}
 /**
   * @}
   */
@@ -208,19 +243,21 @@ uint8_t KNX_PH_TPUart_Receive(uint8_t *data, uint16_t size)
   */
 
 /**
-  * @brief      UART interrupt routines.
+  * @brief      UART interrupt routines of a line, to be called from its
+  *             USARTx_IRQHandler after HAL_UART_IRQHandler(&htpuart->huart).
+  * @param      htpuart: TPUart handle.
   */
-void TPUart_isr(void)
+void TPUart_isr(TPUart_Handle_t *htpuart)
 {  
-  knx_uart_isr_begin();
+  knx_uart_isr_begin(htpuart->Parent);
     
   /* UART in mode Receiver ---------------------------------------------------*/
-  knx_uart_isr_rx();
+  knx_uart_isr_rx(htpuart->Parent);
   
   /* UART in mode Transmitter ------------------------------------------------*/
-  knx_uart_isr_tx();
+  knx_uart_isr_tx(htpuart->Parent);
   
-  knx_uart_isr_end();
+  knx_uart_isr_end(htpuart->Parent);
 }
 /**
   * @}
@@ -241,3 +278,5 @@ void TPUart_isr(void)
 /**
   * @}
   */
+
+#endif /* KNX_PH_TPUART_BACKEND == KNX_PH_TPUART_IT */
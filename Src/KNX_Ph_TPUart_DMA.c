@@ -0,0 +1,359 @@
+/**
+  ******************************************************************************
+  * @file       KNX_PH_TPUart_DMA.c
+  * @author     MA Dingjie
+  * @version    V1.0.0
+  * @date       14-October-2016
+  * @brief      KNX Physical Layer communication via TP-UART, DMA backend.
+  *             Selected with ::KNX_PH_TPUART_BACKEND = ::KNX_PH_TPUART_DMA.
+  *             This file provides functions to manage following functionalities:
+  *              + Initialization functions
+  *              + Send and Receive messages functions
+  *
+  *             The reception runs continuously on a circular DMA buffer, the
+  *             bytes are handed to \ref KNX_PH_Sup from the half transfer,
+  *             transfer complete and idle line interrupts. The idle line
+  *             interrupt also flags the end of a frame. A transmission is a
+  *             single one-shot DMA transfer.
+  *
+  *             The bytes come in batches, so each byte is dated back from its
+  *             place in the buffer at 11 bits per character, and the gap
+  *             between two bytes of a frame is checked as with the interrupt
+  *             backend.
+  *
+  *             This backend can not meet the acknowledge deadline of the
+  *             TP-UART: the destination address is only seen at the next half
+  *             transfer, transfer complete or idle line interrupt, most of the
+  *             time after the end of the frame. The acknowledges set from the
+  *             reception with ::KNX_Ph_SetAddr need the interrupt backend; with
+  *             this one, let the TP-UART acknowledge its individual address
+  *             itself (U_SetAddress).
+  *
+  *             For each line, ::TPUart_isr must be called from the
+  *             USARTx_IRQHandler, after HAL_UART_IRQHandler(&htpuart->huart),
+  *             and from the IRQ handler of the reception stream, after
+  *             HAL_DMA_IRQHandler(&htpuart->hdma_rx). The handler of the
+  *             transmission stream only calls
+  *             HAL_DMA_IRQHandler(&htpuart->hdma_tx).
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "KNX_Ph_TPUart.h"
+
+#if KNX_PH_TPUART_BACKEND == KNX_PH_TPUART_DMA
+#include <stdio.h>
+#include "stm32f4xx_hal.h"
+#include "KNX_Aux.h"
+
+/** @addtogroup KNX_Lib
+  * @{
+  */
+
+/** @addtogroup KNX_PH
+  * @{
+  */
+
+/** @addtogroup KNX_PH_TPUart
+  * @{
+  */
+
+/* External functions --------------------------------------------------------*/
+/** @addtogroup KNX_PH_TPUart_External_Functions
+  * @{
+  */
+extern void knx_uart_isr_begin (struct PH_Handle *hph);
+extern void knx_uart_isr_end (struct PH_Handle *hph);
+extern void knx_uart_isr_rx (struct PH_Handle *hph);
+extern void knx_uart_isr_tx (struct PH_Handle *hph);
+extern void knx_uart_isr_idle (struct PH_Handle *hph);
+/**
+  * @}
+  */
+
+/* Exported functions --------------------------------------------------------*/
+/** @addtogroup KNX_PH_TPUart_Exported_Functions
+  * @{
+  */
+
+/** @addtogroup KNX_PH_TPUart_Exported_Functions_Group1
+  * @{
+  */
+
+/**
+  * @brief      Initialization of the uart handler of a line, of its DMA
+  *             streams, and start of the circular reception.
+  * @param      htpuart: TPUart handle, ::TPUart_Handle_t::Instance, the baud
+  *             rate pin and the DMA streams set by the user.
+  * @retval     ::TPUart_OK for a successful initialization, while ::TPUart_ERROR
+  *             for failed.
+  */
+uint8_t KNX_PH_TPUart_init(TPUart_Handle_t *htpuart)
+{
+  if(htpuart->Instance == NULL)
+  {
+    htpuart->Instance = USART3;
+    htpuart->BaudPort = GPIOD;
+    htpuart->BaudPin = GPIO_PIN_7;
+  }
+  
+  __HAL_RCC_DMA1_CLK_ENABLE();
+
+  /** Streams of USART3 by default, USART3_RX: DMA1 Stream 1 Channel 4 and
+      USART3_TX: DMA1 Stream 3 Channel 4. */
+  if(htpuart->hdma_rx.Instance == NULL)
+  {
+    htpuart->hdma_rx.Instance = DMA1_Stream1;
+    htpuart->hdma_rx.Init.Channel = DMA_CHANNEL_4;
+    HAL_NVIC_SetPriority(DMA1_Stream1_IRQn, 5, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Stream1_IRQn);
+  }
+  if(htpuart->hdma_tx.Instance == NULL)
+  {
+    htpuart->hdma_tx.Instance = DMA1_Stream3;
+    htpuart->hdma_tx.Init.Channel = DMA_CHANNEL_4;
+    HAL_NVIC_SetPriority(DMA1_Stream3_IRQn, 5, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Stream3_IRQn);
+  }
+
+  htpuart->hdma_rx.Init.Direction = DMA_PERIPH_TO_MEMORY;
+  htpuart->hdma_rx.Init.PeriphInc = DMA_PINC_DISABLE;
+  htpuart->hdma_rx.Init.MemInc = DMA_MINC_ENABLE;
+  htpuart->hdma_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+  htpuart->hdma_rx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+  htpuart->hdma_rx.Init.Mode = DMA_CIRCULAR;
+  htpuart->hdma_rx.Init.Priority = DMA_PRIORITY_HIGH;
+  htpuart->hdma_rx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+  if (HAL_DMA_Init(&htpuart->hdma_rx) != HAL_OK)
+  {
+    puts("***ERROR*** knx_uart rx dma failed to initiate \r\n");
+    return TPUart_ERROR;
+  }
+  __HAL_LINKDMA(&htpuart->huart, hdmarx, htpuart->hdma_rx);
+
+  htpuart->hdma_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+  htpuart->hdma_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+  htpuart->hdma_tx.Init.MemInc = DMA_MINC_ENABLE;
+  htpuart->hdma_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+  htpuart->hdma_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+  htpuart->hdma_tx.Init.Mode = DMA_NORMAL;
+  htpuart->hdma_tx.Init.Priority = DMA_PRIORITY_MEDIUM;
+  htpuart->hdma_tx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+  if (HAL_DMA_Init(&htpuart->hdma_tx) != HAL_OK)
+  {
+    puts("***ERROR*** knx_uart tx dma failed to initiate \r\n");
+    return TPUart_ERROR;
+  }
+  __HAL_LINKDMA(&htpuart->huart, hdmatx, htpuart->hdma_tx);
+
+  htpuart->huart.Instance = htpuart->Instance;
+  htpuart->huart.Init.BaudRate = 9600;
+  htpuart->huart.Init.WordLength = UART_WORDLENGTH_9B;
+  htpuart->huart.Init.StopBits = UART_STOPBITS_1;
+  htpuart->huart.Init.Parity = UART_PARITY_EVEN;
+  htpuart->huart.Init.Mode = UART_MODE_TX_RX;
+  htpuart->huart.Init.HwFlowCtl = UART_HWCONTROL_NONE;
+  htpuart->huart.Init.OverSampling = UART_OVERSAMPLING_16;
+  if (HAL_UART_Init(&htpuart->huart) != HAL_OK)
+  {
+    puts("***ERROR*** knx_uart failed to initiate \r\n");
+    return TPUart_ERROR;
+  }
+
+  /** Start the reception, it never stops: the DMA wraps around the buffer. */
+  htpuart->RxIndice = 0;
+  htpuart->RxTime = KNX_GetMicros();
+  htpuart->RxIdle = 0;
+  if (HAL_UART_Receive_DMA(&htpuart->huart, htpuart->RxBuffer, KNX_PH_TPUART_DMA_RX_SIZE) != HAL_OK)
+  {
+    puts("***ERROR*** knx_uart failed to start the reception \r\n");
+    return TPUart_ERROR;
+  }
+
+  __HAL_UART_ENABLE_IT(&htpuart->huart, UART_IT_IDLE);  /** Activate Flag Idle line */
+
+  /* Set the baud rate pin to 1 to make the baud rate of TP-UART2 to 9600 */
+  if(htpuart->BaudPort != NULL)
+  {
+    HAL_GPIO_WritePin(htpuart->BaudPort, htpuart->BaudPin, GPIO_PIN_SET);
+  }
+
+  return TPUart_OK;
+}
+/**
+  * @}
+  */
+
+/** @addtogroup KNX_PH_TPUart_Exported_Functions_Group2
+  * @{
+  */
+
+/**
+  * @brief      Send the data through UART in a single DMA transfer.
+  * @param      htpuart: TPUart handle.
+  * @param      data:  pointer to the data buffer, valid until the end of the
+  *             transfer.
+  * @param      size:  amount of data to be sent.
+  * @retval     ::TPUart_Status_t according to the status
+  */
+uint8_t KNX_PH_TPUart_Send(TPUart_Handle_t *htpuart, uint8_t *data, uint16_t size)
+{
+  if((data == NULL ) || (size == 0U))
+  {
+    return TPUart_ERROR;
+  }
+
+  if(HAL_UART_Transmit_DMA(&htpuart->huart, data, size) != HAL_OK)
+  {
+    return TPUart_BUSY;
+  }
+
+  return TPUart_OK;
+}
+
+/**
+  * @brief      State of the transmission.
+  * @param      htpuart: TPUart handle.
+  * @retval     ::TPUart_OK if no transfer is ongoing, ::TPUart_BUSY otherwise.
+  */
+uint8_t KNX_PH_TPUart_GetTxState(TPUart_Handle_t *htpuart)
+{
+  if(htpuart->huart.gState == HAL_UART_STATE_READY)
+  {
+    return TPUart_OK;
+  }
+  else
+  {
+    return TPUart_BUSY;
+  }
+}
+
+/**
+  * @brief      Take the bytes written by the reception DMA since the last
+  *             call. To be called from the interrupt only.
+  * @param      htpuart: TPUart handle.
+  * @param      data:  pointer to the data buffer.
+  * @param      size:  max amount of data to be received.
+  * @retval     ::TPUart_OK if at least one byte was copied, ::TPUart_BUSY if
+  *             nothing new was received.
+  * @note       The last byte copied is dated back from the bytes behind it in
+  *             the buffer, see ::KNX_PH_TPUart_GetRxTime.
+  */
+uint8_t KNX_PH_TPUart_Receive(TPUart_Handle_t *htpuart, uint8_t *data, uint16_t size)
+{
+  uint16_t head, n, backlog;
+  uint32_t now, time;
+
+  if((data == NULL ) || (size == 0U))
+  {
+    return TPUart_ERROR;
+  }
+
+  /** The DMA counter gives the position where the next byte will land. */
+  head = KNX_PH_TPUART_DMA_RX_SIZE - (uint16_t)__HAL_DMA_GET_COUNTER(&htpuart->hdma_rx);
+  if(head == KNX_PH_TPUART_DMA_RX_SIZE)
+  {
+    head = 0;
+  }
+
+  for(n = 0; (n < size) && (htpuart->RxIndice != head); n++)
+  {
+    data[n] = htpuart->RxBuffer[htpuart->RxIndice];
+    htpuart->RxIndice++;
+    if(htpuart->RxIndice == KNX_PH_TPUART_DMA_RX_SIZE)
+    {
+      htpuart->RxIndice = 0;
+    }
+  }
+
+  if(n != 0U)
+  {
+    /** The interrupt comes when the last byte of the buffer landed, or one
+        character after it at an idle line: each byte behind the one copied
+        came a character later. */
+    now = KNX_GetMicros();
+    backlog = (uint16_t)((head + KNX_PH_TPUART_DMA_RX_SIZE - htpuart->RxIndice) % KNX_PH_TPUART_DMA_RX_SIZE);
+    time = now - ((uint32_t)backlog + ((htpuart->RxIdle != 0U) ? 1U : 0U)) * KNX_PH_TPUART_CHAR_US;
+    /* Never before the byte handed over previously */
+    if(now - time > now - htpuart->RxTime)
+    {
+      time = htpuart->RxTime;
+    }
+    htpuart->RxTime = time;
+    return TPUart_OK;
+  }
+
+  return TPUart_BUSY;
+}
+
+/**
+  * @brief      Time at which the last byte given by ::KNX_PH_TPUart_Receive
+  *             came from the TP-UART.
+  * @param      htpuart: TPUart handle.
+  * @retval     us of the byte, see ::KNX_GetMicros.
+  */
+uint32_t KNX_PH_TPUart_GetRxTime(TPUart_Handle_t *htpuart)
+{
+  return htpuart->RxTime;
+}
+/**
+  * @}
+  */
+
+/** @addtogroup KNX_PH_TPUart_Exported_Functions_Group3
+  * @{
+  */
+
+/**
+  * @brief      UART and reception DMA interrupt routines of a line.
+  * @param      htpuart: TPUart handle.
+  */
+void TPUart_isr(TPUart_Handle_t *htpuart)
+{
+  uint8_t idle = 0;
+
+  knx_uart_isr_begin(htpuart->Parent);
+
+  /* Idle line: the TP-UART stopped talking, end of a frame ------------------*/
+  if(__HAL_UART_GET_FLAG(&htpuart->huart, UART_FLAG_IDLE))
+  {
+    __HAL_UART_CLEAR_IDLEFLAG(&htpuart->huart);
+    idle = 1;
+  }
+
+  /* UART in mode Receiver ---------------------------------------------------*/
+  htpuart->RxIdle = idle;
+  knx_uart_isr_rx(htpuart->Parent);
+
+  if(idle)
+  {
+    knx_uart_isr_idle(htpuart->Parent);
+  }
+
+  /* UART in mode Transmitter ------------------------------------------------*/
+  knx_uart_isr_tx(htpuart->Parent);
+
+  knx_uart_isr_end(htpuart->Parent);
+}
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#endif /* KNX_PH_TPUART_BACKEND == KNX_PH_TPUART_DMA */
@@ -0,0 +1,565 @@
+/**
+  ******************************************************************************
+  * @file       KNX_PH_TPUart_EMU.c
+  * @author     MA Dingjie
+  * @version    V1.0.0
+  * @date       17-October-2016
+  * @brief      KNX Physical Layer communication via an emulated TP-UART2.
+  *             Selected with ::KNX_PH_TPUART_BACKEND = ::KNX_PH_TPUART_EMU,
+  *             the default of the host builds.
+  *             This file provides functions to manage following functionalities:
+  *              + Initialization functions
+  *              + Send and Receive messages functions
+  *              + Emulated bus functions
+  *
+  *             The TP-UART2 is replaced by a task of the line, which stands
+  *             for both the chip and the UART interrupt. It serves the
+  *             services written by the host: U_Reset, U_State, U_ProductID,
+  *             U_ActivateBusmon, U_AckInformation, U_ActivateBusyMode,
+  *             U_ResetBusyMode, U_MxRstCnt, U_ActivateCRC, U_SetAddress
+  *             and U_L_Data, and answers with Reset_indication,
+  *             State_indication, the product ID and L_Data_confirm. The
+  *             frames of the bus are given by ::KNX_PH_TPUart_EmuBusFrame,
+  *             the frames sent go to ::TPUart_Emu_t::BusSend.
+  *
+  *             Both encodings of U_L_DataEnd are accepted: 0x40 | length as
+  *             in the datasheet, and 0x80 | length as sent by
+  *             \ref KNX_PH_Sup.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "KNX_Ph_TPUart.h"
+
+#if KNX_PH_TPUART_BACKEND == KNX_PH_TPUART_EMU
+#include <stdio.h>
+#include "KNX_Aux.h"
+
+/** @addtogroup KNX_Lib
+  * @{
+  */
+
+/** @addtogroup KNX_PH
+  * @{
+  */
+
+/** @addtogroup KNX_PH_TPUart
+  * @{
+  */
+
+/* Private constants ---------------------------------------------------------*/
+/** @defgroup KNX_PH_TPUart_EMU_Private_Constants KNX PH TPUart Emulator Private Constants
+  * @{
+  */
+#define EMU_SERVICE_MASK        ((uint8_t)0xC0U)    /*!< Bits of the L_Data services */
+#define EMU_L_DATA              ((uint8_t)0x80U)    /*!< U_L_DataStart/Continue/End  */
+#define EMU_L_DATA_END          ((uint8_t)0x40U)    /*!< U_L_DataEnd of the datasheet */
+#define EMU_L_DATA_INDEX        ((uint8_t)0x3FU)    /*!< Index or length of L_Data   */
+#define EMU_ACK_INFO_MASK       ((uint8_t)0xF8U)    /*!< Bits of U_AckInformation    */
+#define EMU_ACK_INFO            ((uint8_t)0x10U)    /*!< U_AckInformation, 0x10-0x17 */
+/**
+  * @}
+  */
+
+/* External functions --------------------------------------------------------*/
+/** @addtogroup KNX_PH_TPUart_External_Functions
+  * @{
+  */
+extern void knx_uart_isr_begin (struct PH_Handle *hph);
+extern void knx_uart_isr_end (struct PH_Handle *hph);
+extern void knx_uart_isr_rx (struct PH_Handle *hph);
+extern void knx_uart_isr_tx (struct PH_Handle *hph);
+/**
+  * @}
+  */
+
+/* Private function prototypes -----------------------------------------------*/
+static void KNX_PH_TPUart_EmuTask(void *argument);
+static void KNX_PH_TPUart_EmuService(TPUart_Handle_t *htpuart, uint8_t data);
+static void KNX_PH_TPUart_EmuLData(TPUart_Handle_t *htpuart, uint8_t data);
+static void KNX_PH_TPUart_EmuAnswer(TPUart_Handle_t *htpuart, uint8_t data);
+
+/* Exported functions --------------------------------------------------------*/
+/** @addtogroup KNX_PH_TPUart_Exported_Functions
+  * @{
+  */
+
+/** @addtogroup KNX_PH_TPUart_Exported_Functions_Group1
+  * @{
+  */
+
+/**
+  * @brief      Initialization of the emulated TP-UART of a line, the task of
+  *             the emulator is created on the first call.
+  * @param      htpuart: TPUart handle, ::TPUart_Emu_t::BusSend set by the
+  *             user.
+  * @retval     ::TPUart_OK for a successful initialization, while ::TPUart_ERROR
+  *             for failed.
+  */
+uint8_t KNX_PH_TPUart_init(TPUart_Handle_t *htpuart)
+{
+  TPUart_Emu_t *emu = &htpuart->Emu;
+
+  KNX_Ph_Buffer_Init(&emu->HostRx);
+  KNX_Ph_Buffer_Init(&emu->BusRx);
+  emu->TxData = NULL;
+  emu->TxSize = 0;
+  emu->TxBusy = FALSE;
+  emu->Busmon = FALSE;
+  emu->Busy = FALSE;
+  emu->Crc = FALSE;
+  emu->Ack = 0;
+  emu->Arguments = 0;
+  emu->FrameLength = 0;
+  emu->FrameEnd = FALSE;
+  emu->Pending = FALSE;
+  emu->Confirm = 0;
+
+  if(emu->Wake == NULL)
+  {
+    emu->Wake = xSemaphoreCreateBinary();
+    if(emu->Wake == NULL)
+    {
+      puts("***ERROR*** knx_uart emulator failed to initiate \r\n");
+      return TPUart_ERROR;
+    }
+    if(xTaskCreate(KNX_PH_TPUart_EmuTask, "KNX TPUart", KNX_PH_TPUART_EMU_STACK,
+                   (void *)htpuart, KNX_PH_TPUART_EMU_PRIORITY, &emu->Task) != pdPASS)
+    {
+      puts("***ERROR*** knx_uart emulator failed to initiate \r\n");
+      return TPUart_ERROR;
+    }
+  }
+
+  return TPUart_OK;
+}
+/**
+  * @}
+  */
+
+/** @addtogroup KNX_PH_TPUart_Exported_Functions_Group2
+  * @{
+  */
+
+/**
+  * @brief      Hand the data to the emulator, like a UART transfer.
+  * @param      htpuart: TPUart handle.
+  * @param      data:  pointer to the data buffer, valid until the end of the
+  *             transfer.
+  * @param      size:  amount of data to be sent.
+  * @retval     ::TPUart_Status_t according to the status
+  */
+uint8_t KNX_PH_TPUart_Send(TPUart_Handle_t *htpuart, uint8_t *data, uint16_t size)
+{
+  TPUart_Emu_t *emu = &htpuart->Emu;
+
+  if((data == NULL ) || (size == 0U))
+  {
+    return TPUart_ERROR;
+  }
+
+  if(emu->TxBusy == TRUE)
+  {
+    return TPUart_BUSY;
+  }
+
+  emu->TxData = data;
+  emu->TxSize = size;
+  emu->TxBusy = TRUE;
+  xSemaphoreGive(emu->Wake);
+
+  return TPUart_OK;
+}
+
+/**
+  * @brief      State of the transmission.
+  * @param      htpuart: TPUart handle.
+  * @retval     ::TPUart_OK if no transfer is ongoing, ::TPUart_BUSY otherwise.
+  */
+uint8_t KNX_PH_TPUart_GetTxState(TPUart_Handle_t *htpuart)
+{
+  return (htpuart->Emu.TxBusy == TRUE) ? TPUart_BUSY : TPUart_OK;
+}
+
+/**
+  * @brief      Take the bytes answered by the emulator. To be called from
+  *             the task of the emulator only, through ::TPUart_isr.
+  * @param      htpuart: TPUart handle.
+  * @param      data:  pointer to the data buffer.
+  * @param      size:  max amount of data to be received.
+  * @retval     ::TPUart_OK if at least one byte was copied, ::TPUart_BUSY if
+  *             nothing new was received.
+  */
+uint8_t KNX_PH_TPUart_Receive(TPUart_Handle_t *htpuart, uint8_t *data, uint16_t size)
+{
+  if((data == NULL ) || (size == 0U))
+  {
+    return TPUart_ERROR;
+  }
+
+  return (KNX_Ph_Buffer_Read(&htpuart->Emu.HostRx, data, size) != 0U) ? TPUart_OK : TPUart_BUSY;
+}
+
+/**
+  * @brief      Time at which the last byte given by ::KNX_PH_TPUart_Receive
+  *             came from the TP-UART.
+  * @param      htpuart: TPUart handle.
+  * @retval     us of the byte, see ::KNX_GetMicros: now, the emulator hands the bytes over as it answers.
+  */
+uint32_t KNX_PH_TPUart_GetRxTime(TPUart_Handle_t *htpuart)
+{
+  (void)htpuart;
+  return KNX_GetMicros();
+}
+/**
+  * @}
+  */
+
+/** @addtogroup KNX_PH_TPUart_Exported_Functions_Group3
+  * @{
+  */
+
+/**
+  * @brief      Interrupt routine of a line, called by the task of the
+  *             emulator each time it has something for the host.
+  * @param      htpuart: TPUart handle.
+  */
+void TPUart_isr(TPUart_Handle_t *htpuart)
+{
+  knx_uart_isr_begin(htpuart->Parent);
+
+  /* UART in mode Receiver ---------------------------------------------------*/
+  knx_uart_isr_rx(htpuart->Parent);
+
+  /* UART in mode Transmitter ------------------------------------------------*/
+  knx_uart_isr_tx(htpuart->Parent);
+
+  knx_uart_isr_end(htpuart->Parent);
+}
+/**
+  * @}
+  */
+
+/** @defgroup KNX_PH_TPUart_Exported_Functions_Group4 KNX TPUart Emulated Bus Functions
+  * @{
+  */
+
+/**
+  * @brief      Put a frame on the emulated bus of a line, the host receives
+  *             it as from a TP-UART2, followed by its CRC-16 once
+  *             U_ActivateCRC was sent. Usable from any task.
+  * @param      htpuart: TPUart handle.
+  * @param      frame: octets of the frame, CTRL to checksum.
+  * @param      length: number of octets, at most ::FRAME_SIZE.
+  * @retval     ::TPUart_OK if queued, ::TPUart_BUSY if the frames already
+  *             queued leave no room, ::TPUart_ERROR for a bad frame.
+  */
+uint8_t KNX_PH_TPUart_EmuBusFrame(TPUart_Handle_t *htpuart, const uint8_t *frame, uint16_t length)
+{
+  TPUart_Emu_t *emu = &htpuart->Emu;
+  uint16_t crc, i, size;
+
+  if((frame == NULL) || (length == 0U) || (length > FRAME_SIZE))
+  {
+    return TPUart_ERROR;
+  }
+
+  crc = KNX_Crc16(frame, length);
+
+  taskENTER_CRITICAL();
+  /** The ack of the previous frame is no longer of interest. */
+  emu->Ack = 0;
+  size = (emu->Crc == TRUE) ? (uint16_t)(length + 2U) : length;
+  if(KNX_PH_BUFFER_SIZE - KNX_Ph_Buffer_Count(&emu->BusRx) < size)
+  {
+    taskEXIT_CRITICAL();
+    return TPUart_BUSY;
+  }
+  for(i=0; i<length; i++)
+  {
+    KNX_Ph_Buffer_Put(&emu->BusRx, frame[i]);
+  }
+  if(emu->Crc == TRUE)
+  {
+    KNX_Ph_Buffer_Put(&emu->BusRx, (uint8_t)(crc >> 8));
+    KNX_Ph_Buffer_Put(&emu->BusRx, (uint8_t)crc);
+  }
+  taskEXIT_CRITICAL();
+
+  xSemaphoreGive(emu->Wake);
+
+  return TPUart_OK;
+}
+
+/**
+  * @brief      Acknowledge given by the host to the last frame of the bus.
+  *             In busy mode, the TP-UART2 answers busy in place of the host.
+  * @param      htpuart: TPUart handle.
+  * @retval     The U_AckInformation octet, 0 if none was given yet.
+  */
+uint8_t KNX_PH_TPUart_EmuGetAck(TPUart_Handle_t *htpuart)
+{
+  if((htpuart->Emu.Busy == TRUE) && (htpuart->Emu.Ack != 0U))
+  {
+    return U_AckInformation_Busy;
+  }
+  return htpuart->Emu.Ack;
+}
+
+/**
+  * @brief      Confirm the frame left pending by ::TPUart_Emu_t::BusSend,
+  *             the host receives its L_Data_confirm. Usable from any task.
+  * @param      htpuart: TPUart handle.
+  * @param      acked: TRUE if the frame was acknowledged.
+  */
+void KNX_PH_TPUart_EmuConfirm(TPUart_Handle_t *htpuart, uint8_t acked)
+{
+  htpuart->Emu.Confirm = (acked == TRUE) ? L_Data_confirm_success : L_Data_confirm_failed;
+  xSemaphoreGive(htpuart->Emu.Wake);
+}
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/* Private functions ---------------------------------------------------------*/
+/** @defgroup KNX_PH_TPUart_EMU_Private_Functions KNX PH TPUart Emulator Private Functions
+  * @{
+  */
+
+/**
+  * @brief      Task of the emulator. Serves the transfer of the host, then
+  *             forwards the frames of the bus, calling ::TPUart_isr whenever
+  *             there is something for the host.
+  * @param      argument: TPUart handle of the line.
+  */
+static void KNX_PH_TPUart_EmuTask(void *argument)
+{
+  TPUart_Handle_t *htpuart = (TPUart_Handle_t *)argument;
+  TPUart_Emu_t *emu = &htpuart->Emu;
+  uint8_t data;
+  uint32_t room;
+
+  for(;;)
+  {
+    xSemaphoreTake(emu->Wake, portMAX_DELAY);
+
+    do
+    {
+      /** The host doesn't touch the transfer while ::TPUart_Emu_t::TxBusy
+          is set, and the ack sent by the interrupt is served on the next
+          turn. */
+      while(emu->TxSize != 0U)
+      {
+        data = *emu->TxData;
+        emu->TxData++;
+        emu->TxSize--;
+        KNX_PH_TPUart_EmuService(htpuart, data);
+      }
+      emu->TxBusy = FALSE;
+      if(emu->Confirm != 0U)
+      {
+        if(emu->Pending == TRUE)
+        {
+          emu->Pending = FALSE;
+          KNX_PH_TPUart_EmuAnswer(htpuart, emu->Confirm);
+        }
+        emu->Confirm = 0;
+      }
+      TPUart_isr(htpuart);
+
+      /** Forward the bus by chunks fitting in the buffer of the host. */
+      room = KNX_PH_BUFFER_SIZE - KNX_Ph_Buffer_Count(&emu->HostRx);
+      while((room != 0U) && (KNX_Ph_Buffer_Get(&emu->BusRx, &data) == PH_BUFFER_OK))
+      {
+        KNX_Ph_Buffer_Put(&emu->HostRx, data);
+        room--;
+      }
+      TPUart_isr(htpuart);
+    } while((emu->TxBusy == TRUE) || (emu->Confirm != 0U)
+            || (KNX_Ph_Buffer_Count(&emu->BusRx) != 0U));
+  }
+}
+
+/**
+  * @brief      Serve one octet written by the host.
+  * @param      htpuart: TPUart handle.
+  * @param      data: the octet.
+  */
+static void KNX_PH_TPUart_EmuService(TPUart_Handle_t *htpuart, uint8_t data)
+{
+  TPUart_Emu_t *emu = &htpuart->Emu;
+
+  /** Argument octets of the previous service. */
+  if(emu->Arguments != 0U)
+  {
+    emu->Arguments--;
+    if(emu->Service == U_SetAddress)
+    {
+      emu->Address = (uint16_t)((emu->Address << 8) | data);
+    }
+    return;
+  }
+
+  /** Octet of the frame announced by the previous L_Data control byte. */
+  if(emu->Service == EMU_L_DATA)
+  {
+    emu->Service = U_None;
+    KNX_PH_TPUart_EmuLData(htpuart, data);
+    return;
+  }
+
+  /** In bus monitor mode, only a reset is listened to. */
+  if((emu->Busmon == TRUE) && (data != U_Reset_request))
+  {
+    return;
+  }
+
+  if(((data & EMU_SERVICE_MASK) == EMU_L_DATA)
+     || (((data & EMU_SERVICE_MASK) == EMU_L_DATA_END)
+         && ((data & EMU_L_DATA_INDEX) == emu->FrameLength + 1U)))
+  {
+    if((data & EMU_L_DATA_INDEX) == 0U)
+    {
+      emu->FrameLength = 0;
+    }
+    if((data & EMU_L_DATA_INDEX) == emu->FrameLength)
+    {
+      emu->FrameEnd = FALSE;
+      emu->Service = EMU_L_DATA;
+    }
+    else if((data & EMU_L_DATA_INDEX) == emu->FrameLength + 1U)
+    {
+      emu->FrameEnd = TRUE;
+      emu->Service = EMU_L_DATA;
+    }
+    else
+    {
+      /** Out of sequence, the frame is lost. */
+      emu->FrameLength = 0;
+    }
+    return;
+  }
+
+  if((data & EMU_ACK_INFO_MASK) == EMU_ACK_INFO)
+  {
+    emu->Ack = data;
+    return;
+  }
+
+  switch(data)
+  {
+    case U_Reset_request:
+      emu->Busmon = FALSE;
+      emu->Busy = FALSE;
+      emu->Crc = FALSE;
+      emu->Address = 0;
+      emu->FrameLength = 0;
+      emu->Pending = FALSE;
+      KNX_PH_TPUart_EmuAnswer(htpuart, Reset_indication);
+      break;
+    case U_State_request:
+      KNX_PH_TPUart_EmuAnswer(htpuart, State_indication);
+      break;
+    case U_ProductID_request:
+      KNX_PH_TPUart_EmuAnswer(htpuart, KNX_PH_TPUART_EMU_PRODUCT_ID);
+      break;
+    case U_ActivateBusmon:
+      emu->Busmon = TRUE;
+      break;
+    case U_ActivateBusyMode:
+      emu->Busy = TRUE;
+      break;
+    case U_ResetBusyMode:
+      emu->Busy = FALSE;
+      break;
+    case U_ActivateCRC:
+      emu->Crc = TRUE;
+      break;
+    case U_MxRstCnt:
+      emu->Service = data;
+      emu->Arguments = 1;
+      break;
+    case U_SetAddress:
+      emu->Service = data;
+      emu->Arguments = 2;
+      emu->Address = 0;
+      break;
+    default:
+      break;
+  }
+}
+
+/**
+  * @brief      Store an octet of the frame sent by the host, the last one
+  *             puts the frame on the bus and is confirmed.
+  * @param      htpuart: TPUart handle.
+  * @param      data: the octet.
+  */
+static void KNX_PH_TPUart_EmuLData(TPUart_Handle_t *htpuart, uint8_t data)
+{
+  TPUart_Emu_t *emu = &htpuart->Emu;
+  uint8_t sent = TPUart_OK;
+
+  if(emu->FrameLength >= FRAME_SIZE)
+  {
+    emu->FrameLength = 0;
+    return;
+  }
+  emu->Frame[emu->FrameLength] = data;
+  emu->FrameLength++;
+
+  if(emu->FrameEnd == TRUE)
+  {
+    /** One frame at a time on the bus, like the TP-UART2. */
+    if(emu->Pending == TRUE)
+    {
+      sent = TPUart_ERROR;
+    }
+    else if(emu->BusSend != NULL)
+    {
+      sent = emu->BusSend(htpuart, emu->Frame, emu->FrameLength);
+    }
+    emu->FrameLength = 0;
+    emu->FrameEnd = FALSE;
+    if(sent == TPUart_BUSY)
+    {
+      emu->Pending = TRUE;
+    }
+    else
+    {
+      KNX_PH_TPUart_EmuAnswer(htpuart, (sent == TPUart_OK) ? L_Data_confirm_success : L_Data_confirm_failed);
+    }
+  }
+}
+
+/**
+  * @brief      Answer an octet to the host.
+  * @param      htpuart: TPUart handle.
+  * @param      data: the octet.
+  */
+static void KNX_PH_TPUart_EmuAnswer(TPUart_Handle_t *htpuart, uint8_t data)
+{
+  KNX_Ph_Buffer_Put(&htpuart->Emu.HostRx, data);
+}
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#endif /* KNX_PH_TPUART_BACKEND == KNX_PH_TPUART_EMU */
@@ -0,0 +1,377 @@
+/**
+  ******************************************************************************
+  * @file       KNX_Ph_Trace.c
+  * @author     MA Dingjie
+  * @version    V1.0.0
+  * @date       17-October-2016
+  * @brief      KNX Physical Layer binary traces.
+  *             This file provides functions to manage following functionalities:
+  *              + Initialization functions
+  *              + Recording, from the UART interrupt and the tasks
+  *              + Reading back a trace from memory
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "KNX_Ph_Trace.h"
+
+/** @addtogroup KNX_Lib
+  * @{
+  */
+
+/** @addtogroup KNX_PH
+  * @{
+  */
+
+/** @defgroup KNX_PH_Trace KNX Physical Layer Trace
+  * @brief    Every byte to and from the TP-UART with its time, in a compact
+  *           binary format, see \ref PH_Trace_Format. Written to a ring by
+  *           \ref KNX_PH_Sup, read back by ::KNX_Ph_Replay.
+  * @{
+  */
+
+/* Private constants ---------------------------------------------------------*/
+/** @defgroup KNX_PH_Trace_Private_Constants KNX PH Trace Private Constants
+  * @{
+  */
+/** \brief First octets of a trace. */
+static const uint8_t KNX_PH_TRACE_MAGIC[PH_TRACE_HEADER_SIZE - 1U] = {'K', 'N', 'X', 'T'};
+/**
+  * @}
+  */
+
+/* Private function prototypes -----------------------------------------------*/
+static void    KNX_Ph_Trace_Close(KNX_Ph_Trace_t *trace);
+static uint8_t KNX_Ph_Trace_Write(KNX_Ph_Trace_t *trace, uint8_t header, uint32_t delta, const uint8_t *datas, uint8_t length);
+
+/* Exported functions --------------------------------------------------------*/
+/** @defgroup KNX_PH_Trace_Exported_Functions KNX PH Trace Exported Functions
+  * @{
+  */
+
+/** @defgroup KNX_PH_Trace_Exported_Functions_Group1 Initialization Functions
+  * @{
+  */
+
+/**
+  * @brief      Start a trace: empty the ring and write the header of the
+  *             format. Must be called before the trace is given to a line.
+  * @param      trace: pointer to the trace.
+  * @param      timestamp: start of the trace in us, see ::KNX_GetMicros.
+  */
+void KNX_Ph_Trace_Init(KNX_Ph_Trace_t *trace, uint32_t timestamp)
+{
+  trace->Tail = 0;
+  trace->Last = timestamp;
+  trace->OpenLength = 0;
+  trace->Lost = FALSE;
+  trace->Records = 0;
+  trace->Drops = 0;
+
+  memcpy(trace->Datas, KNX_PH_TRACE_MAGIC, sizeof(KNX_PH_TRACE_MAGIC));
+  trace->Datas[PH_TRACE_HEADER_SIZE - 1U] = PH_TRACE_VERSION;
+  trace->Head = PH_TRACE_HEADER_SIZE;
+}
+/**
+  * @}
+  */
+
+/** @defgroup KNX_PH_Trace_Exported_Functions_Group2 Record Functions
+  * @{
+  */
+
+/**
+  * @brief      Record bytes exchanged with the TP-UART. They join the record
+  *             being gathered if they go the same way and follow it within
+  *             ::KNX_PH_TRACE_COALESCE. Usable from tasks and interrupts.
+  * @param      trace: pointer to the trace.
+  * @param      flags: ::PH_TRACE_TX for bytes sent, 0 for bytes received.
+  * @param      timestamp: time of the bytes in us.
+  * @param      datas: the bytes.
+  * @param      length: number of bytes.
+  */
+void KNX_Ph_Trace_Record(KNX_Ph_Trace_t *trace, uint8_t flags, uint32_t timestamp, const uint8_t *datas, uint16_t length)
+{
+  UBaseType_t mask;
+  uint16_t i;
+
+  mask = taskENTER_CRITICAL_FROM_ISR();
+  for(i=0; i<length; i++)
+  {
+    if((trace->OpenLength != 0U)
+       && ((flags != trace->OpenFlags) || (trace->OpenLength == PH_TRACE_RECORD_MAX)
+           || (timestamp - trace->OpenLast > KNX_PH_TRACE_COALESCE)))
+    {
+      KNX_Ph_Trace_Close(trace);
+    }
+    if(trace->OpenLength == 0U)
+    {
+      trace->OpenFlags = flags;
+      trace->OpenTime = timestamp;
+    }
+    trace->Open[trace->OpenLength] = datas[i];
+    trace->OpenLength++;
+    trace->OpenLast = timestamp;
+  }
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+/**
+  * @brief      Write the record being gathered to the ring, e.g. before the
+  *             trace is drained for the last time.
+  * @param      trace: pointer to the trace.
+  */
+void KNX_Ph_Trace_Flush(KNX_Ph_Trace_t *trace)
+{
+  UBaseType_t mask;
+
+  mask = taskENTER_CRITICAL_FROM_ISR();
+  if(trace->OpenLength != 0U)
+  {
+    KNX_Ph_Trace_Close(trace);
+  }
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+/**
+  * @brief      Drain the trace, to be called by a single task. The octets
+  *             come in order, header first, and can be stored as they are.
+  * @param      trace: pointer to the trace.
+  * @param      datas: where to copy the octets.
+  * @param      size: max number of octets.
+  * @retval     Number of octets copied.
+  */
+uint32_t KNX_Ph_Trace_Read(KNX_Ph_Trace_t *trace, uint8_t *datas, uint32_t size)
+{
+  uint32_t tail = trace->Tail;
+  uint32_t n, i;
+
+  n = trace->Head - tail;
+  if(n > size)
+  {
+    n = size;
+  }
+
+  KNX_MEMORY_BARRIER();
+  for(i=0; i<n; i++)
+  {
+    datas[i] = trace->Datas[(tail + i) & KNX_PH_TRACE_MASK];
+  }
+
+  /** Release the place only after the octets have been read. */
+  KNX_MEMORY_BARRIER();
+  trace->Tail = tail + n;
+
+  return n;
+}
+
+/**
+  * @brief      Number of records lost because the ring was full, each run
+  *             of them is marked by a ::PH_TRACE_GAP record.
+  * @param      trace: pointer to the trace.
+  * @retval     Counter since ::KNX_Ph_Trace_Init.
+  */
+uint32_t KNX_Ph_Trace_GetDrops(KNX_Ph_Trace_t *trace)
+{
+  return trace->Drops;
+}
+/**
+  * @}
+  */
+
+/** @defgroup KNX_PH_Trace_Exported_Functions_Group3 Read Back Functions
+  * @{
+  */
+
+/**
+  * @brief      Start reading a trace stored in memory.
+  * @param      cursor: the position to initialize.
+  * @param      datas: the trace, from its header.
+  * @param      length: size of the trace.
+  * @retval     ::PH_TRACE_OK, or ::PH_TRACE_FORMAT if it's not a trace of
+  *             this version.
+  */
+uint8_t KNX_Ph_Trace_Open(KNX_Ph_Trace_Cursor_t *cursor, const uint8_t *datas, uint32_t length)
+{
+  if((datas == NULL) || (length < PH_TRACE_HEADER_SIZE)
+     || (memcmp(datas, KNX_PH_TRACE_MAGIC, sizeof(KNX_PH_TRACE_MAGIC)) != 0)
+     || (datas[PH_TRACE_HEADER_SIZE - 1U] != PH_TRACE_VERSION))
+  {
+    return PH_TRACE_FORMAT;
+  }
+
+  cursor->Datas = datas;
+  cursor->Length = length;
+  cursor->Offset = PH_TRACE_HEADER_SIZE;
+  cursor->Time = 0;
+
+  return PH_TRACE_OK;
+}
+
+/**
+  * @brief      Read the next record of a trace.
+  * @param      cursor: the position, moved past the record.
+  * @param      record: pointer to store the record, its bytes stay in the
+  *             trace.
+  * @retval     ::PH_TRACE_OK, ::PH_TRACE_END at the end of the trace, or
+  *             ::PH_TRACE_FORMAT for a record cut or malformed.
+  */
+uint8_t KNX_Ph_Trace_Next(KNX_Ph_Trace_Cursor_t *cursor, KNX_Ph_Trace_Record_t *record)
+{
+  uint32_t offset = cursor->Offset;
+  uint32_t delta = 0;
+  uint8_t header, octet, shift = 0, i;
+
+  if(offset >= cursor->Length)
+  {
+    return PH_TRACE_END;
+  }
+
+  header = cursor->Datas[offset];
+  offset++;
+
+  /** Time since the previous record, 7 bits per octet. */
+  for(i=0; i<PH_TRACE_DELTA_MAX; i++)
+  {
+    if(offset >= cursor->Length)
+    {
+      return PH_TRACE_FORMAT;
+    }
+    octet = cursor->Datas[offset];
+    offset++;
+    delta |= (uint32_t)(octet & 0x7FU) << shift;
+    shift += 7U;
+    if((octet & 0x80U) == 0U)
+    {
+      break;
+    }
+  }
+  if(i == PH_TRACE_DELTA_MAX)
+  {
+    return PH_TRACE_FORMAT;
+  }
+
+  record->Flags = header & (PH_TRACE_TX | PH_TRACE_GAP);
+  record->Length = ((header & PH_TRACE_GAP) != 0U) ? 0U : (header & PH_TRACE_LENGTH);
+  if((((header & PH_TRACE_GAP) == 0U) && (record->Length == 0U))
+     || (offset + record->Length > cursor->Length))
+  {
+    return PH_TRACE_FORMAT;
+  }
+  record->Datas = &cursor->Datas[offset];
+  cursor->Time += delta;
+  record->Time = cursor->Time;
+  cursor->Offset = offset + record->Length;
+
+  return PH_TRACE_OK;
+}
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/* Private functions ---------------------------------------------------------*/
+/** @defgroup KNX_PH_Trace_Private_Functions KNX PH Trace Private Functions
+  * @{
+  */
+
+/**
+  * @brief      Write the record gathered to the ring, after the gap left
+  *             by records lost if any. Called under the critical section.
+  * @param      trace: pointer to the trace.
+  */
+static void KNX_Ph_Trace_Close(KNX_Ph_Trace_t *trace)
+{
+  if(trace->Lost == TRUE
+     && KNX_Ph_Trace_Write(trace, PH_TRACE_GAP, trace->OpenTime - trace->Last, NULL, 0) == PH_TRACE_OK)
+  {
+    trace->Last = trace->OpenTime;
+    trace->Lost = FALSE;
+  }
+
+  if(trace->Lost == FALSE
+     && KNX_Ph_Trace_Write(trace, trace->OpenFlags | trace->OpenLength,
+                           trace->OpenTime - trace->Last, trace->Open, trace->OpenLength) == PH_TRACE_OK)
+  {
+    trace->Last = trace->OpenTime;
+    trace->Records++;
+  }
+  else
+  {
+    trace->Drops++;
+    trace->Lost = TRUE;
+  }
+
+  trace->OpenLength = 0;
+}
+
+/**
+  * @brief      Write a record to the ring, whole or not at all.
+  * @param      trace: pointer to the trace.
+  * @param      header: header octet of the record.
+  * @param      delta: time since the previous record in us.
+  * @param      datas: the bytes.
+  * @param      length: number of bytes.
+  * @retval     ::PH_TRACE_OK, or ::PH_TRACE_FULL.
+  */
+static uint8_t KNX_Ph_Trace_Write(KNX_Ph_Trace_t *trace, uint8_t header, uint32_t delta, const uint8_t *datas, uint8_t length)
+{
+  uint8_t record[1U + PH_TRACE_DELTA_MAX];
+  uint32_t head = trace->Head;
+  uint8_t n = 0, i;
+
+  record[n++] = header;
+  do
+  {
+    record[n] = (uint8_t)(delta & 0x7FU);
+    delta >>= 7;
+    if(delta != 0U)
+    {
+      record[n] |= 0x80U;
+    }
+    n++;
+  } while(delta != 0U);
+
+  if(KNX_PH_TRACE_SIZE - (head - trace->Tail) < (uint32_t)n + length)
+  {
+    return PH_TRACE_FULL;
+  }
+
+  for(i=0; i<n; i++)
+  {
+    trace->Datas[(head + i) & KNX_PH_TRACE_MASK] = record[i];
+  }
+  head += n;
+  for(i=0; i<length; i++)
+  {
+    trace->Datas[(head + i) & KNX_PH_TRACE_MASK] = datas[i];
+  }
+
+  /** Publish the record before moving the ::KNX_Ph_Trace_t::Head. */
+  KNX_MEMORY_BARRIER();
+  trace->Head = head + length;
+
+  return PH_TRACE_OK;
+}
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
@@ -0,0 +1,342 @@
+/**
+  ******************************************************************************
+  * @file       KNX_Timer.c
+  * @author     MA Dingjie
+  * @version    V1.0.0
+  * @date       17-October-2016
+  * @brief      KNX software timers.
+  *             This file provides functions to manage following functionalities:
+  *              + Initialization functions
+  *              + Arming and cancelling timers, from tasks and interrupts
+  *              + Expiry of the timers from the tick interrupt
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "KNX_Timer.h"
+#include "KNX_def.h"
+
+/** @addtogroup KNX_Lib
+  * @{
+  */
+
+/** @defgroup KNX_Timer KNX Timer
+  * @brief    Any number of timers on a hierarchical wheel, see
+  *           \ref KNX_Timer_Wheel, advanced by ::KNX_systick_isr. The
+  *           repetitions, ack windows and cyclic sends each arm their own.
+  * @{
+  */
+
+/* Exported variables --------------------------------------------------------*/
+/** @defgroup KNX_Timer_Exported_Variables KNX Timer Exported Variables
+  * @{
+  */
+/** \brief Wheel advanced by the tick of \ref KNX_Aux. */
+KNX_Timer_Wheel_t KNX_TimerWheel;
+/**
+  * @}
+  */
+
+/* Private function prototypes -----------------------------------------------*/
+static void KNX_Timer_Place(KNX_Timer_Wheel_t *wheel, KNX_Timer_t *timer);
+static void KNX_Timer_Unlink(KNX_Timer_t *timer);
+static void KNX_Timer_Cascade(KNX_Timer_Wheel_t *wheel, uint32_t level);
+
+/* Exported functions --------------------------------------------------------*/
+/** @defgroup KNX_Timer_Exported_Functions KNX Timer Exported Functions
+  * @{
+  */
+
+/** @defgroup KNX_Timer_Exported_Functions_Group1 Initialization Functions
+  * @{
+  */
+
+/**
+  * @brief      Empty a wheel. ::KNX_TimerWheel needs no call, zeroed at
+  *             start up.
+  * @param      wheel: pointer to the wheel.
+  */
+void KNX_Timer_InitWheel(KNX_Timer_Wheel_t *wheel)
+{
+  memset(wheel, 0, sizeof(KNX_Timer_Wheel_t));
+}
+
+/**
+  * @brief      Initialize a timer, not armed.
+  * @param      timer: pointer to the timer.
+  * @param      callback: called at each expiry, ::KNX_Timer_Notify to wake
+  *             up a task.
+  * @param      context: for the callback.
+  */
+void KNX_Timer_Init(KNX_Timer_t *timer, KNX_Timer_Callback_t callback, void *context)
+{
+  timer->Next = NULL;
+  timer->Link = NULL;
+  timer->Expiry = 0;
+  timer->Period = 0;
+  timer->Callback = callback;
+  timer->Context = context;
+}
+/**
+  * @}
+  */
+
+/** @defgroup KNX_Timer_Exported_Functions_Group2 Operation Functions
+  * @{
+  */
+
+/**
+  * @brief      Arm a timer, again if it already was. Usable from tasks,
+  *             interrupts and the callbacks.
+  * @param      wheel: pointer to the wheel.
+  * @param      timer: pointer to the timer.
+  * @param      ticks: ticks before the first expiry, at least 1.
+  * @param      period: ticks between the next expiries, 0 for none.
+  * @retval     Error code, See \ref KNX_Timer_Error_Code.
+  */
+uint8_t KNX_Timer_Start(KNX_Timer_Wheel_t *wheel, KNX_Timer_t *timer, uint32_t ticks, uint32_t period)
+{
+  UBaseType_t mask;
+
+  if(ticks == 0U || timer->Callback == NULL)
+  {
+    return TIMER_ERROR_PARAM;
+  }
+
+  mask = taskENTER_CRITICAL_FROM_ISR();
+  if(timer->Link != NULL)
+  {
+    KNX_Timer_Unlink(timer);
+    wheel->Armed--;
+  }
+  timer->Expiry = wheel->Now + ticks;
+  timer->Period = period;
+  KNX_Timer_Place(wheel, timer);
+  wheel->Armed++;
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+
+  return TIMER_ERROR_NONE;
+}
+
+/**
+  * @brief      Cancel a timer. Usable from tasks, interrupts and the
+  *             callbacks.
+  * @param      wheel: pointer to the wheel.
+  * @param      timer: pointer to the timer.
+  * @retval     ::TIMER_ERROR_NONE, or ::TIMER_ERROR_IDLE if the timer was
+  *             not armed, e.g. it has just expired.
+  */
+uint8_t KNX_Timer_Stop(KNX_Timer_Wheel_t *wheel, KNX_Timer_t *timer)
+{
+  UBaseType_t mask;
+  uint8_t ret = TIMER_ERROR_IDLE;
+
+  mask = taskENTER_CRITICAL_FROM_ISR();
+  if(timer->Link != NULL)
+  {
+    KNX_Timer_Unlink(timer);
+    wheel->Armed--;
+    ret = TIMER_ERROR_NONE;
+  }
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+
+  return ret;
+}
+
+/**
+  * @brief      Check if a timer is armed.
+  * @param      timer: pointer to the timer.
+  * @retval     TRUE or FALSE.
+  */
+uint8_t KNX_Timer_IsArmed(KNX_Timer_t *timer)
+{
+  return (timer->Link != NULL) ? TRUE : FALSE;
+}
+
+/**
+  * @brief      Ticks left before the expiry of a timer.
+  * @param      wheel: pointer to the wheel.
+  * @param      timer: pointer to the timer.
+  * @retval     Ticks left, 0 if not armed.
+  */
+uint32_t KNX_Timer_Remaining(KNX_Timer_Wheel_t *wheel, KNX_Timer_t *timer)
+{
+  UBaseType_t mask;
+  uint32_t ret = 0;
+
+  mask = taskENTER_CRITICAL_FROM_ISR();
+  if(timer->Link != NULL)
+  {
+    ret = timer->Expiry - wheel->Now;
+  }
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+
+  return ret;
+}
+
+/**
+  * @brief      Advance a wheel by a tick and call back the timers expired,
+  *             from the tick interrupt. A periodic timer is armed again
+  *             before its callback. With no timer armed, the wheels are
+  *             empty and only the count of ticks moves.
+  * @param      wheel: pointer to the wheel.
+  */
+void KNX_Timer_Tick(KNX_Timer_Wheel_t *wheel)
+{
+  BaseType_t woken = pdFALSE;
+  UBaseType_t mask;
+  KNX_Timer_t *timer;
+  uint32_t now, level;
+
+  mask = taskENTER_CRITICAL_FROM_ISR();
+  now = wheel->Now + 1U;
+  wheel->Now = now;
+  if(wheel->Armed == 0U)
+  {
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+    return;
+  }
+
+  /** Each wheel turning over moves down the next slot of the one above. */
+  for(level=1; level<KNX_TIMER_LEVELS; level++)
+  {
+    if((now & (((uint32_t)1 << (KNX_TIMER_SLOT_BITS * level)) - 1U)) != 0U)
+    {
+      break;
+    }
+    KNX_Timer_Cascade(wheel, level);
+  }
+
+  /** Take the timers one at a time, a callback may arm or cancel any. */
+  while((timer = wheel->Slots[0][now & KNX_TIMER_SLOT_MASK]) != NULL)
+  {
+    KNX_Timer_Unlink(timer);
+    if(timer->Period != 0U)
+    {
+      timer->Expiry = now + timer->Period;
+      KNX_Timer_Place(wheel, timer);
+    }
+    else
+    {
+      wheel->Armed--;
+    }
+    wheel->Expired++;
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+
+    timer->Callback(timer, &woken);
+
+    mask = taskENTER_CRITICAL_FROM_ISR();
+  }
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+
+  portYIELD_FROM_ISR(woken);
+}
+
+/**
+  * @brief      Callback waking up the task in ::KNX_Timer_t::Context, which
+  *             waits with ulTaskNotifyTake.
+  * @param      timer: the timer expired.
+  * @param      woken: set if the task must run.
+  */
+void KNX_Timer_Notify(KNX_Timer_t *timer, BaseType_t *woken)
+{
+  vTaskNotifyGiveFromISR((TaskHandle_t)timer->Context, woken);
+}
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/* Private functions ---------------------------------------------------------*/
+/** @defgroup KNX_Timer_Private_Functions KNX Timer Private Functions
+  * @{
+  */
+
+/**
+  * @brief      Put a timer in the slot of its expiry, on the first wheel
+  *             spanning its delay. Called under the critical section.
+  * @param      wheel: pointer to the wheel.
+  * @param      timer: pointer to the timer.
+  */
+static void KNX_Timer_Place(KNX_Timer_Wheel_t *wheel, KNX_Timer_t *timer)
+{
+  uint32_t expiry = timer->Expiry;
+  uint32_t delta = expiry - wheel->Now;
+  uint32_t level = 0;
+  KNX_Timer_t **slot;
+
+  /** Beyond the last wheel, wait at its end and be placed again. */
+  if(delta > KNX_TIMER_SPAN)
+  {
+    delta = KNX_TIMER_SPAN;
+    expiry = wheel->Now + KNX_TIMER_SPAN;
+  }
+  while(delta >= ((uint32_t)1 << (KNX_TIMER_SLOT_BITS * (level + 1U))))
+  {
+    level++;
+  }
+
+  slot = &wheel->Slots[level][(expiry >> (KNX_TIMER_SLOT_BITS * level)) & KNX_TIMER_SLOT_MASK];
+  timer->Next = *slot;
+  if(timer->Next != NULL)
+  {
+    timer->Next->Link = &timer->Next;
+  }
+  *slot = timer;
+  timer->Link = slot;
+}
+
+/**
+  * @brief      Take a timer out of its slot. Called under the critical
+  *             section.
+  * @param      timer: pointer to the timer, armed.
+  */
+static void KNX_Timer_Unlink(KNX_Timer_t *timer)
+{
+  *timer->Link = timer->Next;
+  if(timer->Next != NULL)
+  {
+    timer->Next->Link = timer->Link;
+  }
+  timer->Next = NULL;
+  timer->Link = NULL;
+}
+
+/**
+  * @brief      Place again the timers of the current slot of a wheel, they
+  *             all go to the wheels below. Called under the critical section.
+  * @param      wheel: pointer to the wheel.
+  * @param      level: the wheel, from 1.
+  */
+static void KNX_Timer_Cascade(KNX_Timer_Wheel_t *wheel, uint32_t level)
+{
+  KNX_Timer_t **slot = &wheel->Slots[level][(wheel->Now >> (KNX_TIMER_SLOT_BITS * level)) & KNX_TIMER_SLOT_MASK];
+  KNX_Timer_t *timer = *slot;
+  KNX_Timer_t *next;
+
+  *slot = NULL;
+  while(timer != NULL)
+  {
+    next = timer->Next;
+    KNX_Timer_Place(wheel, timer);
+    timer = next;
+  }
+}
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
@@ -12,12 +12,10 @@
   */
 
 /* Includes ------------------------------------------------------------------*/
-/* Scheduler includes. */
-#include "FreeRTOS.h"
-#include "semphr.h"
-
 /* Demo application includes. */
+#include <string.h>
 #include "cola.h"
+#include "KNX_def.h"
 #include "stdio.h"
 
 /** @addtogroup KNX_Lib
@@ -32,6 +30,10 @@
   * @{
   */
 
+/* Private function prototypes -----------------------------------------------*/
+static void cola_escribir (t_cola *p, uint32_t indice, const uint8_t *datos, uint32_t l);
+static void cola_copiar (t_cola *p, uint32_t indice, uint8_t *datos, uint32_t l);
+
 /* Exported functions --------------------------------------------------------*/
 /** @defgroup Cola_Exported_Functions Cola Exported Functions
   * @{
@@ -47,11 +49,10 @@
   *             which will be used to store and read information.
   */
 void cola_init(t_cola *p){
-  p->cabeza = 0;
+  p->reserva = 0;
   p->cola = 0;
-  p->items = 0;
-  p->huecos = COLA_SIZE;
-  p->mutex = xSemaphoreCreateMutex();
+  p->cabeza = 0;
+  p->perdidos = 0;
 }
 /**
   * @}
@@ -62,55 +63,112 @@ void cola_init(t_cola *p){
   */
 
 /**
-  * @brief      Save the message into the end of cola's buffer. If at the end,
-  *             restart form and cover the head of it.
+  * @brief      Save the message into the end of cola's buffer. Never blocks,
+  *             usable from tasks and interrupts: if the message doesn't fit
+  *             it is dropped and counted.
   * @param      p: pointer to a t_cola in which we will stroe the message.
-  * @param      msg: pointer to the message buffer.
+  * @param      msg: pointer to the message buffer, ended by '\n'.
   * @retval     1 for success, 0 for error
   */
 int16_t cola_guardar (t_cola *p, unsigned char *msg){
-  int16_t i,l,res = 1;
+  const unsigned char *fin;
+
+  /*Calcular la longitud del mensaje, \n incluido*/
+  fin = memchr(msg, '\n', COLA_RECORD_MAX);
+  if(fin == NULL)
+  {
+    return 0;
+  }
+
+  return cola_guardar_datos(p, msg, (uint16_t)(fin - msg + 1));
+}
 
-  /*Calcular la longitud del mensaje en l*/
-  for (l = 0; msg[l] != '\n'; l++)
+/**
+  * @brief      Save a record of any bytes, '\n' included. Never blocks,
+  *             usable from tasks and interrupts: if the record doesn't fit
+  *             it is dropped and counted.
+  * @param      p: pointer to a t_cola in which we will stroe the record.
+  * @param      datos: pointer to the bytes.
+  * @param      l: number of bytes, from 1 to ::COLA_RECORD_MAX.
+  * @retval     1 for success, 0 for error
+  */
+int16_t cola_guardar_datos (t_cola *p, const uint8_t *datos, uint16_t l){
+  uint32_t reserva, nueva, perdidos, total = COLA_HEADER_SIZE + (uint32_t)l;
+
+  if(l == 0U || l > COLA_RECORD_MAX)
   {
+    return 0;
   }
-  l++;
-  xSemaphoreTake(p->mutex, portMAX_DELAY /* (TickType_t)10 */ );
 
-  if(l < p->huecos)
+  /** Reserve the place, one more writer copying. */
+  do
   {
-    for(i = 0; i<l; i++)
+    reserva = p->reserva;
+    if(total > COLA_SIZE - ((reserva - p->cabeza) & COLA_INDEX_MASK))
     {
-      /*guardar msg[i] en la cola p*/
-      p->datos [ p->cola ] = msg[i];
-      p->cola++;
-
-      if(p->cola >= COLA_SIZE)
+      do
       {
-       p->cola = 0;
-      }
+        perdidos = p->perdidos;
+      } while(!KNX_CAS(&p->perdidos, perdidos, perdidos + 1U));
 
-      p->huecos--;
-      p->items++;
+      return 0;
     }
-  }
-  else
+    nueva = (reserva & ~COLA_INDEX_MASK) + COLA_WRITER + ((reserva + total) & COLA_INDEX_MASK);
+  } while(!KNX_CAS(&p->reserva, reserva, nueva));
+
+  /** The length, least significant octet first, then the bytes. */
+  p->datos[reserva & COLA_MASK] = (uint8_t)l;
+  p->datos[(reserva + 1U) & COLA_MASK] = (uint8_t)(l >> 8);
+  cola_escribir(p, reserva + COLA_HEADER_SIZE, datos, l);
+
+  /** Leave, the last writer publishes every place reserved. */
+  do
+  {
+    reserva = p->reserva;
+    nueva = reserva - COLA_WRITER;
+  } while(!KNX_CAS(&p->reserva, reserva, nueva));
+
+  if((nueva & ~COLA_INDEX_MASK) == 0U)
   {
-    res = 0;
+    /** A writer leaving later may publish first, #cola only moves forward. */
+    nueva &= COLA_INDEX_MASK;
+    do
+    {
+      reserva = p->cola;
+      if(((nueva - reserva) & COLA_INDEX_MASK) > COLA_SIZE)
+      {
+        break;
+      }
+    } while(!KNX_CAS(&p->cola, reserva, nueva));
   }
 
-  xSemaphoreGive(p->mutex);
+  return 1;
+}
 
-  return res;
+/**
+  * @brief      Length of the next record, without taking it.
+  * @param      p: pointer to the t_cola.
+  * @retval     Number of bytes of the record, 0 if p doesn't contain any.
+  */
+uint16_t cola_peek (t_cola *p){
+  uint32_t cabeza = p->cabeza;
+
+  if(((p->cola - cabeza) & COLA_INDEX_MASK) == 0U)
+  {
+    return 0;
+  }
+  KNX_MEMORY_BARRIER();
+
+  return (uint16_t)(p->datos[cabeza & COLA_MASK] | (p->datos[(cabeza + 1U) & COLA_MASK] << 8));
 }
 
 /**
-  * @brief      Read the message from the cola.
+  * @brief      Read the message from the cola, by a single task.
   * @param      p: pointer to the t_cola from where we will read the message.
   * @param      msg: pointer to the buffer to take the message.
   * @param      l: the max size of the buffer msg.
-  * @retval     -1: if the message length from p depass the max size of msg.
+  * @retval     -1: if the message length from p depass the max size of msg,
+  *             the message is skipped.
   *             0: if p doesn't contain any message.
   *             >0: the length of the message successfully stored into msg.
   */
@@ -122,59 +180,43 @@ El valor de retorno sera:
 1,2 o mas si cabe; l_de_p serEel valor de la longitud del mensaje*/
 int16_t cola_leer (t_cola *p, unsigned char *msg, uint32_t l){
 
-  int16_t i, res, l_de_p, Ndatos;
-
-  xSemaphoreTake(p->mutex, portMAX_DELAY /* (TickType_t)10 */ );
-
-  Ndatos = COLA_SIZE - p->huecos;
+  uint32_t cabeza = p->cabeza;
+  uint16_t l_de_p;
+  int16_t res;
 
-  /*Calcular la longitud del mensaje que se va a sacar de la cola p en l*/
-  for(l_de_p = 0, i = p->cabeza; l_de_p <= Ndatos; l_de_p++)
+  /*Longitud del mensaje que se va a sacar de la cola p*/
+  l_de_p = cola_peek(p);
+  if(l_de_p == 0U)
   {
-    if(p->datos[i] == '\n')
-    {
-        break;
-    }
-    i++;
-    if(i == COLA_SIZE)
-    {
-       i = 0;
-    }
+    return 0;
   }
 
-  if((Ndatos == 0 )||( p->datos[i] != '\n'))
+  if(l_de_p > l)
   {
-    res = 0;
+    res = -1;
   }
   else
   {
-    l_de_p++;   // Contabilizar \n
-    if(l_de_p > l)
-    {
-      res = -1;
-    }
-    else
-    {
-      res = l_de_p;
-      for(i = 0; i<l_de_p; i++)
-      {
-        /*copiar msg[i] de la cola p al mensaje*/
-        msg[i] = p->datos [ p->cabeza ];
-        p->cabeza++;
-        if(p->cabeza >= COLA_SIZE)
-        {
-          p->cabeza = 0;
-        }
-        p->huecos++;
-      }
-    }
+    res = (int16_t)l_de_p;
+    cola_copiar(p, cabeza + COLA_HEADER_SIZE, msg, l_de_p);
   }
 
-  xSemaphoreGive(p->mutex);
+  /** Release the place only after the message has been read. */
+  KNX_MEMORY_BARRIER();
+  p->cabeza = (cabeza + COLA_HEADER_SIZE + l_de_p) & COLA_INDEX_MASK;
 
   return res;
 }
 
+/**
+  * @brief      Number of messages dropped because the cola was full.
+  * @param      p: pointer to the t_cola.
+  * @retval     Counter since #cola_init.
+  */
+uint32_t cola_perdidos (t_cola *p){
+  return p->perdidos;
+}
+
 /**
   * @}
   */
@@ -183,6 +225,54 @@ int16_t cola_leer (t_cola *p, unsigned char *msg, uint32_t l){
   * @}
   */
 
+/* Private functions ---------------------------------------------------------*/
+/** @defgroup Cola_Private_Functions Cola Private Functions
+  * @{
+  */
+
+/**
+  * @brief      Copy bytes into the buffer from a free running indice, in
+  *             two parts when they wrap around.
+  * @param      p: pointer to the t_cola.
+  * @param      indice: where to write.
+  * @param      datos: the bytes.
+  * @param      l: number of bytes.
+  */
+static void cola_escribir (t_cola *p, uint32_t indice, const uint8_t *datos, uint32_t l){
+  uint32_t i = indice & COLA_MASK;
+  uint32_t n = COLA_SIZE - i;
+
+  if(n > l)
+  {
+    n = l;
+  }
+  memcpy(&p->datos[i], datos, n);
+  memcpy(&p->datos[0], datos + n, l - n);
+}
+
+/**
+  * @brief      Copy bytes out of the buffer from a free running indice, in
+  *             two parts when they wrap around.
+  * @param      p: pointer to the t_cola.
+  * @param      indice: where to read.
+  * @param      datos: where to copy the bytes.
+  * @param      l: number of bytes.
+  */
+static void cola_copiar (t_cola *p, uint32_t indice, uint8_t *datos, uint32_t l){
+  uint32_t i = indice & COLA_MASK;
+  uint32_t n = COLA_SIZE - i;
+
+  if(n > l)
+  {
+    n = l;
+  }
+  memcpy(datos, &p->datos[i], n);
+  memcpy(datos + n, &p->datos[0], l - n);
+}
+/**
+  * @}
+  */
+
 /**
   * @}
   */
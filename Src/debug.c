@@ -17,12 +17,15 @@
 #include "semphr.h"
 #include "cola.h"
 #include "debug.h"
-#include "debug_UART.h"
+#include "debug_uart.h"
 #include "KNX_Ph_TPUart.h"
 #include "KNX_Aux.h"
 #include "KNX_Ph.h"
+#include "KNX_Log.h"
 #include "KNX_def.h"
+#ifndef KNX_HOST
 #include "stm32f4xx_hal.h"
+#endif
 #include <stdio.h>
 #include <string.h>
     
@@ -46,11 +49,18 @@
 /** \brief Current state of debug RX. */
 //static RX_DEBUG_Status_t KNX_PH_STATE;
 
-/** \brief Error message put in ::DebugTask */
-static const char *msg_error = "***ERROR*** cola_leer() = -1 ????? \r\n" ;
-
+/** \brief The record read from ::colaDebug */
+static uint8_t record[KNX_LOG_RECORD_MAX];
 /** \brief The buffer to store the message */
 static unsigned char buffer[BUFFER_SIZE];
+/** \brief The stream of records sent */
+static KNX_Log_Stream_t stream;
+#ifdef KNX_HOST
+/** \brief The stream decoded, the host prints the text */
+static KNX_Log_Stream_t decoder;
+/** \brief The text of the record sent */
+static char text[128];
+#endif
 /** \brief The indice of the ::buffer */
 __IO uint16_t buffer_indice;
 /** \brief The maximum value of the ::buffer_indice */
@@ -154,7 +164,7 @@ uint32_t DebugInit(void)
 {
   //KNX_PH_STATE = RX_DEBUG_IDLE;
   
-  //inicializar cola+mutex para almacenar mensajes
+  //inicializar cola para almacenar mensajes
   cola_init(&colaDebug);
   DEBUG_TX_FLAG = FALSE;
   
@@ -182,7 +192,7 @@ uint32_t DebugInit(void)
   if(debug_uart_init())
   {
     //KNX_PH_STATE = RX_DEBUG_KNX;
-    cola_guardar(&colaDebug, "\r\n");
+    KNX_Log(LOG_DEBUG_START, 0);
 
     return PH_Debug_ERROR_NONE;
   }
@@ -202,42 +212,68 @@ uint32_t DebugInit(void)
 
 /**
   * @brief      Debug task. Check whether new messages are stored in ::colaDebug.
-  *             If yes, send the new message through UART.
+  *             If yes, send the new message through UART, in the binary form
+  *             of \ref KNX_Log, or as text on the host.
   * @param      argument:  argument of the task.
   */
 void DebugTask(void * argument)
 {
   /* USER CODE BEGIN DebugTask */
-  int i, res_leer;
+  int16_t res_leer;
+  uint32_t invalidos = 0, reportados = 0, nuevos;
+  uint8_t length;
+#ifdef KNX_HOST
+  uint16_t used, n;
+#endif
+
+  KNX_Log_InitStream(&stream);
+#ifdef KNX_HOST
+  KNX_Log_InitStream(&decoder);
+#endif
 
   /* Infinite loop */
-  //cola_guardar(&colaDebug, "Mensaje desde DebugTask ... inicializando\r\n");
   for(;;)
   {
-    res_leer = cola_leer(&colaDebug, buffer, BUFFER_SIZE);
+    res_leer = cola_leer(&colaDebug, record, KNX_LOG_RECORD_MAX);
     while (res_leer == 0) {
     vTaskDelay( 5 );
-    res_leer = cola_leer(&colaDebug, buffer, BUFFER_SIZE);
+    res_leer = cola_leer(&colaDebug, record, KNX_LOG_RECORD_MAX);
     }
-    if (res_leer == -1)
+
+    /** Messages that are not records of \ref KNX_Log are dropped, they
+      * are reported with the ones lost because the cola was full. */
+    length = (res_leer > 0) ? KNX_Log_Encode(&stream, record, (uint16_t)res_leer, buffer) : 0U;
+    if(length == 0U)
     {
-      //copiar en buffer mensaje de error
-      for(i=0; msg_error[i] != '\n'; i++){
-          buffer[i] = msg_error[i];
-      }
-      res_leer = i;
+      invalidos++;
+    }
+    nuevos = cola_perdidos(&colaDebug) + invalidos - reportados;
+    if((nuevos != 0U)
+       && (KNX_Log(LOG_DEBUG_LOST, (nuevos > 0xFFU) ? 0xFFU : (uint8_t)nuevos) == LOG_OK))
+    {
+      reportados += nuevos;
+    }
+    if(length == 0U)
+    {
+      continue;
     }
 
+#ifdef KNX_HOST
+    /** No UART on the host, the record is printed as text at once. */
+    n = KNX_Log_Decode(&decoder, buffer, length, &used, text, sizeof(text));
+    debug_uart_send((unsigned char *)text, n);
+#else
     //Activar transmisin de la UART para transmitir el mensaje
     //almacenado en buffer que es de res_leer caracteres
     buffer_indice=0;
-    buffer_indice_max = res_leer - 1;
+    buffer_indice_max = length - 1U;
     DEBUG_TX_FLAG = TRUE;
     debug_uart_send(&buffer[buffer_indice], 1);
 
     //Esperar a que la UART nos de permiso para continuar ..
     //Significa que el mensaje del buffer ya se ha enviado completamente
     xSemaphoreTake( semaforo_debug_isruart, portMAX_DELAY /* (TickType_t)10 */ );
+#endif
   }
 }
 
@@ -245,10 +281,11 @@ void DebugTask(void * argument)
   * @brief      Debug RX task. Receive the buffer character by character. If the 
   *             buffer fits in the format as "/XX/" (XX: two digits of
   *             hexadecimal), then transmit it to TPUart.
-  * @param      argument:  argument of the task.
+  * @param      argument:  ::PH_Handle_t of the line to transmit to.
   */
 void DebugRXTask(void * argument)
 {
+  PH_Handle_t *hph = (PH_Handle_t *)argument;
   uint8_t byte, res;
   
   for(;;)
@@ -276,7 +313,7 @@ void DebugRXTask(void * argument)
           continue;
         }
 
-        res = KNX_Ph_SendData(byte, KNX_DEFAULT_TIMEOUT);
+        res = KNX_Ph_SendData(hph, byte, KNX_DEFAULT_TIMEOUT);
         RX_buffer_indice = 0;
       }
     }
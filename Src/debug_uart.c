@@ -14,7 +14,11 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include <stdint.h>
+#ifdef KNX_HOST
+#include <stdio.h>
+#else
 #include "stm32f4xx_hal.h"
+#endif
 #include "FreeRTOS.h"
 #include "debug_uart.h"
 
@@ -47,8 +51,10 @@ extern void debug_uart_isr_tx (void);
 /** @defgroup Debug_UART_External_Variables Debug UART External Variables
   * @{
   */
+#ifndef KNX_HOST
 /** \brief UART Handler */
 UART_HandleTypeDef debug_huart;
+#endif
 /**
   * @}
   */
@@ -63,11 +69,15 @@ UART_HandleTypeDef debug_huart;
   */
 
 /**
-  * @brief      Initialization of the uart handler ::debug_huart. 
+  * @brief      Initialization of the uart handler ::debug_huart. On the host
+  *             the messages go to stdout, nothing to initialize.
   * @retval     1 for success, 0 for fail. 
   */
 uint8_t debug_uart_init(void)
 {
+#ifdef KNX_HOST
+  return 1;
+#else
   debug_huart.Instance = USART2;
   debug_huart.Init.BaudRate = 9600;
   debug_huart.Init.WordLength = UART_WORDLENGTH_8B;
@@ -86,6 +96,7 @@ uint8_t debug_uart_init(void)
   __HAL_UART_ENABLE_IT(&debug_huart, UART_IT_TC);  /** Activate Flag TX       */
   
   return 1;
+#endif
 }
 /**
   * @}
@@ -100,7 +111,8 @@ uint8_t debug_uart_init(void)
   */
 
 /**
-  * @brief      Send the data through UART.
+  * @brief      Send the data through UART. On the host, written to stdout
+  *             at once.
   * @param      data:  pointer to the data buffer.
   * @param      size:  lenghth of the buffer.
   */
@@ -111,6 +123,10 @@ Debug_Uart_Status_t debug_uart_send(uint8_t *data, uint16_t size)
     return Debug_Uart_ERROR;
   }
   
+#ifdef KNX_HOST
+  fwrite(data, 1, size, stdout);
+  fflush(stdout);
+#else
   /* Process Locked */
   if((&debug_huart)->Lock == HAL_LOCKED)
   {
@@ -133,17 +149,22 @@ Debug_Uart_Status_t debug_uart_send(uint8_t *data, uint16_t size)
 
   /* Enable the UART Transmit data register empty Interrupt */
   SET_BIT((&debug_huart)->Instance->CR1, USART_CR1_TXEIE);
+#endif
 
   return Debug_Uart_OK;
 }
 
 /**
-  * @brief      Receive the data through UART.
+  * @brief      Receive the data through UART. Nothing is ever received on
+  *             the host.
   * @param      data:  pointer to the data buffer.
   * @param      size:  lenghth of the buffer.
   */
 Debug_Uart_Status_t debug_uart_receive (uint8_t *data, uint16_t size)
 {
+#ifdef KNX_HOST
+  return Debug_Uart_BUSY;
+#else
   /* Check that a Rx process is not already ongoing */ 
   if((&debug_huart)->RxState == HAL_UART_STATE_READY)
   {
@@ -187,6 +208,7 @@ Debug_Uart_Status_t debug_uart_receive (uint8_t *data, uint16_t size)
   {
     return Debug_Uart_BUSY; 
   }
+#endif
 }
 
 /**